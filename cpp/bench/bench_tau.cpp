@@ -0,0 +1,196 @@
+// ==============================================================================
+// bench_tau.cpp - Микробенчмарк вычисления правил: дерево против байткода
+// ==============================================================================
+//
+// Сравнивает rule::rule_solve (обход Expression) с tau::solve по Program,
+// скомпилированной rule::rule_program, отдельно и с общими проверками
+// (tau::Predicates + PredicateMemo). Правила — Sigma из tests/fixtures/sigma,
+// файлы/каталоги из аргументов командной строки и сгенерированные правила
+// Chainsaw с условием EventID: N (Field == число); документы — синтетические
+// события создания процесса с разными EventID. Результаты всех способов сверяются.
+//
+// ==============================================================================
+
+#include <chainsaw/rule.hpp>
+#include <chainsaw/tau.hpp>
+#include <chainsaw/value.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace rule = chainsaw::rule;
+namespace tau = chainsaw::tau;
+using chainsaw::Value;
+
+namespace {
+
+void load_rules(const fs::path& path, std::vector<rule::Rule>& rules) {
+    if (fs::is_directory(path)) {
+        for (const auto& entry : fs::recursive_directory_iterator(path)) {
+            auto ext = entry.path().extension();
+            if (entry.is_regular_file() && (ext == ".yml" || ext == ".yaml")) {
+                load_rules(entry.path(), rules);
+            }
+        }
+        return;
+    }
+    auto result = rule::load(rule::Kind::Sigma, path);
+    if (!result) {
+        return;
+    }
+    for (auto& r : result.rules) {
+        rules.push_back(std::move(r));
+    }
+}
+
+/// Правила Chainsaw вида EventID: N и CommandLine: '*...*' во временном каталоге
+void load_event_id_rules(std::vector<rule::Rule>& rules) {
+    const std::int64_t event_ids[] = {1, 3, 4624, 4688, 4698, 7045};
+    const char* fragments[] = {"whoami", "-enc", "backup", "rundll32", "vssadmin",
+                               "certutil", "bitsadmin", "-contentproc", "mimikatz", "net user"};
+    fs::path dir = fs::temp_directory_path() / "chainsaw_bench_tau";
+    fs::create_directories(dir);
+    std::size_t n = 0;
+    for (auto event_id : event_ids) {
+        for (const char* fragment : fragments) {
+            fs::path path = dir / ("rule_" + std::to_string(n++) + ".yml");
+            std::ofstream out(path);
+            out << "title: EventID " << event_id << " " << fragment << "\n"
+                << "group: Bench\ndescription: Bench\nauthors:\n  - Bench\n"
+                << "kind: evtx\nlevel: low\nstatus: stable\ntimestamp: TimeCreated\n"
+                << "fields:\n  - name: Event ID\n    to: EventID\n"
+                << "filter:\n  condition: selection\n  selection:\n"
+                << "    EventID: " << event_id << "\n"
+                << "    CommandLine: '*" << fragment << "*'\n";
+            out.close();
+            auto result = rule::load(rule::Kind::Chainsaw, path);
+            for (auto& r : result.rules) {
+                rules.push_back(std::move(r));
+            }
+        }
+    }
+    fs::remove_all(dir);
+}
+
+Value make_event(std::int64_t event_id, const char* image, const char* command_line,
+                 const char* parent) {
+    Value event = Value::make_object();
+    event.set("EventID", Value(event_id));
+    event.set("Image", Value(std::string(image)));
+    event.set("CommandLine", Value(std::string(command_line)));
+    event.set("ParentImage", Value(std::string(parent)));
+    event.set("User", Value(std::string("CORP\\alice")));
+    return event;
+}
+
+template <typename Solve>
+double ns_per_document(const std::vector<tau::ValueDocument>& docs, Solve solve,
+                       std::size_t& hits) {
+    constexpr int ITERATIONS = 200'000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        for (const auto& doc : docs) {
+            hits += solve(doc);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(ITERATIONS) * static_cast<double>(docs.size()));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<rule::Rule> rules;
+    load_rules(fs::path(__FILE__).parent_path().parent_path() / "tests" / "fixtures" / "sigma",
+               rules);
+    for (int i = 1; i < argc; ++i) {
+        load_rules(argv[i], rules);
+    }
+    load_event_id_rules(rules);
+
+    std::vector<tau::Program> programs;
+    std::vector<tau::Program> shared_programs;
+    auto predicates = std::make_shared<tau::Predicates>();
+    std::size_t instructions = 0;
+    for (const auto& r : rules) {
+        programs.push_back(rule::rule_program(r));
+        shared_programs.push_back(rule::rule_program(r, predicates));
+        instructions += programs.back().size();
+    }
+    tau::PredicateMemo memo(*predicates);
+
+    const Value events[] = {
+        make_event(1, "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe",
+                   "powershell.exe -Nop -w hidden -encodedcommand SQBFAFgA",
+                   "C:\\Windows\\explorer.exe"),
+        make_event(4688, "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe",
+                   "powershell.exe -File C:\\scripts\\backup.ps1",
+                   "C:\\Windows\\System32\\svchost.exe"),
+        make_event(1, "C:\\Windows\\System32\\cmd.exe", "cmd.exe /c whoami /all",
+                   "C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe"),
+        make_event(4688, "C:\\Program Files\\Mozilla Firefox\\firefox.exe",
+                   "\"C:\\Program Files\\Mozilla Firefox\\firefox.exe\" -contentproc",
+                   "C:\\Program Files\\Mozilla Firefox\\firefox.exe"),
+    };
+    std::vector<tau::ValueDocument> docs(std::begin(events), std::end(events));
+
+    std::size_t tree_hits = 0;
+    std::size_t program_hits = 0;
+    std::size_t shared_hits = 0;
+    double tree = ns_per_document(
+        docs,
+        [&rules](const tau::Document& doc) {
+            std::size_t matched = 0;
+            for (const auto& r : rules) {
+                matched += rule::rule_solve(r, doc) ? 1u : 0u;
+            }
+            return matched;
+        },
+        tree_hits);
+    double program = ns_per_document(
+        docs,
+        [&programs](const tau::Document& doc) {
+            std::size_t matched = 0;
+            for (const auto& p : programs) {
+                matched += tau::solve(p, doc) ? 1u : 0u;
+            }
+            return matched;
+        },
+        program_hits);
+    double shared = ns_per_document(
+        docs,
+        [&shared_programs, &memo](const tau::Document& doc) {
+            std::size_t matched = 0;
+            memo.clear();
+            for (const auto& p : shared_programs) {
+                matched += tau::solve(p, doc, memo) ? 1u : 0u;
+            }
+            return matched;
+        },
+        shared_hits);
+
+    // Результаты по каждому правилу
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+        for (const auto& doc : docs) {
+            bool expected = rule::rule_solve(rules[i], doc);
+            mismatches += expected != tau::solve(programs[i], doc) ? 1u : 0u;
+            mismatches += expected != tau::solve(shared_programs[i], doc) ? 1u : 0u;
+        }
+    }
+
+    std::printf("rules %zu, instructions %zu, shared predicates %zu, documents %zu\n",
+                rules.size(), instructions, predicates->size(), docs.size());
+    std::printf("%-10s %14s\n", "solver", "ns/document");
+    std::printf("%-10s %14.1f\n", "tree", tree);
+    std::printf("%-10s %14.1f\n", "program", program);
+    std::printf("%-10s %14.1f\n", "shared", shared);
+    std::printf("speedup %.2fx/%.2fx, hits %zu/%zu/%zu, mismatches %zu\n", tree / program,
+                tree / shared, tree_hits, program_hits, shared_hits, mismatches);
+    return mismatches == 0 && tree_hits == program_hits && tree_hits == shared_hits ? 0 : 1;
+}
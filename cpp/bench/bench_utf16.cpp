@@ -0,0 +1,88 @@
+// ==============================================================================
+// bench_utf16.cpp - Микробенчмарк перекодирования UTF-16LE → UTF-8
+// ==============================================================================
+//
+// Сравнивает io::utf16le_to_utf8 (векторные ASCII-отрезки) с посимвольной
+// реализацией, которую раньше содержал каждый парсер. Наборы строк — типичные
+// для артефактов: короткие имена, пути, командные строки, кириллица.
+//
+// ==============================================================================
+
+#include <chainsaw/utf16.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Прежняя посимвольная реализация (для сравнения)
+std::string utf16le_to_utf8_scalar(const std::uint8_t* data, std::size_t byte_len) {
+    std::string result;
+    result.reserve(byte_len / 2);
+    for (std::size_t i = 0; i + 1 < byte_len; i += 2) {
+        auto unit = static_cast<std::uint16_t>(data[i] | (data[i + 1] << 8));
+        if (unit == 0) {
+            break;
+        }
+        if (unit < 0x80) {
+            result.push_back(static_cast<char>(unit));
+        } else if (unit < 0x800) {
+            result.push_back(static_cast<char>(0xC0 | (unit >> 6)));
+            result.push_back(static_cast<char>(0x80 | (unit & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xE0 | (unit >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((unit >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (unit & 0x3F)));
+        }
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> encode(const std::u16string& text) {
+    std::vector<std::uint8_t> bytes;
+    for (char16_t unit : text) {
+        bytes.push_back(static_cast<std::uint8_t>(unit & 0xFF));
+        bytes.push_back(static_cast<std::uint8_t>(unit >> 8));
+    }
+    return bytes;
+}
+
+template <typename Convert>
+double ns_per_string(const std::vector<std::uint8_t>& bytes, Convert convert,
+                     std::size_t& checksum) {
+    constexpr int ITERATIONS = 2'000'000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        checksum += convert(bytes.data(), bytes.size()).size();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ITERATIONS;
+}
+
+}  // namespace
+
+int main() {
+    const std::pair<const char*, std::u16string> cases[] = {
+        {"name", u"Security-Auditing"},
+        {"path", u"C:\\Windows\\System32\\WindowsPowerShell\\v1.0\\powershell.exe"},
+        {"command line",
+         u"powershell.exe -NoProfile -ExecutionPolicy Bypass -Command \"Get-ChildItem "
+         u"-Path C:\\Users\\Administrator\\AppData\\Local\\Temp -Recurse | Where-Object "
+         u"{ $_.LastWriteTime -gt (Get-Date).AddDays(-7) } | Remove-Item -Force\" "
+         u"-WindowStyle Hidden -NonInteractive"},
+        {"cyrillic", u"Служба журнала событий"},
+    };
+
+    std::size_t checksum = 0;
+    std::printf("%-16s %12s %12s %8s\n", "input", "scalar ns", "simd ns", "speedup");
+    for (const auto& [label, text] : cases) {
+        auto bytes = encode(text);
+        double scalar = ns_per_string(bytes, utf16le_to_utf8_scalar, checksum);
+        double simd = ns_per_string(bytes, chainsaw::io::utf16le_to_utf8, checksum);
+        std::printf("%-16s %12.1f %12.1f %7.2fx\n", label, scalar, simd, scalar / simd);
+    }
+    std::printf("checksum %zu\n", checksum);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// ==============================================================================
+// chainsaw/aho_corasick.hpp - Автомат Ахо-Корасик для SearchAhoCorasick
+// ==============================================================================
+//
+// MOD-0009 tau (Tau Engine)
+//
+// Назначение:
+// - Один проход по значению поля вместо проверки каждого паттерна отдельно
+// - Паттерны Contains, StartsWith, EndsWith и Exact в одном автомате
+// - Регистр: ASCII case folding (как icontains/iequals)
+//
+// Устройство:
+// - ДКА с полной таблицей переходов по классам байтов: байты, не входящие ни
+//   в один паттерн, образуют один класс, поэтому таблица мала
+// - StartsWith и Exact совпадают только пока автомат не переходил по
+//   суффиксной ссылке (глубина состояния равна числу прочитанных байтов)
+// - EndsWith и Exact проверяются по состоянию после последнего байта
+//
+// Соответствие Rust:
+// - tau_engine::core::parser::Search::AhoCorasick (крейт aho-corasick)
+//
+// ==============================================================================
+
+#ifndef CHAINSAW_AHO_CORASICK_HPP
+#define CHAINSAW_AHO_CORASICK_HPP
+
+#include <array>
+#include <chainsaw/tau.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace chainsaw::tau {
+
+class AhoCorasick {
+public:
+    /// Построить автомат по записям SearchAhoCorasick
+    AhoCorasick(const std::vector<MatchTypeEntry>& entries, bool ignore_case);
+
+    /// Совпала ли хотя бы одна запись (останавливается на первом совпадении)
+    bool find_any(std::string_view text) const;
+
+    /// Отметить все совпавшие записи: matched[i] — запись entries[i]
+    void find_all(std::string_view text, std::vector<bool>& matched) const;
+
+    /// Число состояний автомата
+    std::size_t states() const { return depth_.size(); }
+
+private:
+    /// Флаги состояния (с учётом цепочки суффиксных ссылок для Contains/EndsWith)
+    enum : std::uint8_t {
+        CONTAINS = 1,     // в цепочке есть Contains
+        STARTS_WITH = 2,  // в самом состоянии есть StartsWith
+        ENDS_WITH = 4,    // в цепочке есть EndsWith
+        EXACT = 8,        // в самом состоянии есть Exact
+    };
+
+    /// Следующее состояние
+    std::uint32_t step(std::uint32_t state, unsigned char byte) const {
+        return delta_[state * classes_count_ + classes_[byte]];
+    }
+
+    /// Отметить записи состояния и его цепочки
+    void mark(std::uint32_t state, bool anchored, bool at_end, std::vector<bool>& matched) const;
+
+    std::array<std::uint16_t, 256> classes_{};
+    std::size_t classes_count_ = 1;
+    std::vector<std::uint32_t> delta_;
+    std::vector<std::uint32_t> depth_;
+    std::vector<std::uint8_t> flags_;
+
+    // Записи, оканчивающиеся в состоянии: outputs_[output_begin_[s]..output_begin_[s + 1])
+    std::vector<std::uint32_t> output_begin_;
+    std::vector<std::uint32_t> outputs_;
+    // Ближайшее по суффиксным ссылкам состояние с записями (0 — нет)
+    std::vector<std::uint32_t> dict_;
+
+    std::vector<MatchType> types_;
+    // Записи с пустым значением (в автомат не входят)
+    std::vector<std::uint32_t> empty_;
+    // Пустой Contains/StartsWith/EndsWith совпадает с любым значением
+    bool always_ = false;
+    // Пустой Exact совпадает с пустым значением
+    bool empty_exact_ = false;
+    // Только StartsWith/Exact: после потери привязки к началу совпадений нет
+    bool anchored_only_ = true;
+};
+
+}  // namespace chainsaw::tau
+
+#endif  // CHAINSAW_AHO_CORASICK_HPP
@@ -0,0 +1,77 @@
+// ==============================================================================
+// chainsaw/detection_cache.hpp - Кэш документов детектирований на диске
+// ==============================================================================
+//
+// MOD-0012 hunt (--cache-to-disk, SPEC-SLICE-012 FACT-027..029)
+//
+// Назначение:
+// - Документы детектирований и агрегаций не держатся в памяти до вывода: Hunter
+//   дописывает их компактным JSON во временный файл, детектирование хранит только
+//   смещения и размеры записей (KindCached, CachedRecord)
+// - Для вывода файл отображается в память, запись копируется из отображения
+//
+// Устройство:
+// - Файлы hunt обрабатываются параллельно: запись в кэш идёт под мьютексом,
+//   смещение — позиция конца файла на момент записи
+// - Чтение — из любого потока (вывод форматируется в потоках hunt): запись
+//   копируется под тем же мьютексом из отображения файла; запись за его концом
+//   сбрасывает буфер файла, если ещё в нём, и читается из файла, а сам файл
+//   отображается заново, только когда вырос вдвое с прошлого отображения
+// - Временный файл удаляется при разрушении кэша
+//
+// ==============================================================================
+
+#ifndef CHAINSAW_DETECTION_CACHE_HPP
+#define CHAINSAW_DETECTION_CACHE_HPP
+
+#include <chainsaw/platform.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace chainsaw::hunt {
+
+/// Временный файл записей детектирований (append-only)
+class DetectionCache {
+public:
+    /// Создать временный файл кэша
+    /// При ошибке выбрасывает std::runtime_error
+    DetectionCache();
+
+    /// Закрыть и удалить файл
+    ~DetectionCache();
+
+    DetectionCache(const DetectionCache&) = delete;
+    DetectionCache& operator=(const DetectionCache&) = delete;
+
+    /// Дописать запись (потокобезопасно)
+    /// @return Смещение записи в файле
+    /// При ошибке записи выбрасывает std::runtime_error
+    std::size_t append(std::string_view record);
+
+    /// Прочитать запись, дописанную append() (потокобезопасно)
+    /// @return Копия записи
+    /// При ошибке чтения выбрасывает std::runtime_error
+    std::string read(std::size_t offset, std::size_t size);
+
+    /// Путь к временному файлу
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+    std::FILE* file_ = nullptr;
+    std::mutex mutex_;  // file_, размеры, mapping_ и reader_
+    std::size_t size_ = 0;
+    std::size_t flushed_ = 0;   // записано в файл, а не в буфер
+    std::size_t remap_at_ = 0;  // размер, при котором отобразить файл заново
+
+    platform::MappedFile mapping_;
+    std::FILE* reader_ = nullptr;  // без отображения
+};
+
+}  // namespace chainsaw::hunt
+
+#endif  // CHAINSAW_DETECTION_CACHE_HPP
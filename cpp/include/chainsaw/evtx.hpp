@@ -27,22 +27,77 @@
 #ifndef CHAINSAW_EVTX_HPP
 #define CHAINSAW_EVTX_HPP
 
+#include <array>
+#include <chainsaw/platform.hpp>
 #include <chainsaw/value.hpp>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <shared_mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace chainsaw::evtx {
 
+enum class BinXmlToken : std::uint8_t;
+
+/// Токен шаблона Binary XML (имена уже разрешены через таблицу строк чанка)
+struct BinXmlTemplateToken {
+    BinXmlToken token;                     // Тип токена
+    std::string text;                      // Имя элемента/атрибута или значение Value
+    std::uint16_t substitution_index = 0;  // Индекс для NormalSubstitution
+};
+
+/// Скомпилированный каркас шаблона (определение в evtx.cpp)
+struct BinXmlSkeleton;
+
+/// Кеши чанка: строки, шаблоны по смещению определения (определение в evtx.cpp)
+struct BinXmlChunkCaches;
+
 /// Структура для хранения шаблона Binary XML
 struct BinXmlTemplate {
-    std::string xml_template;            // Шаблон XML с placeholder'ами ${N}
-    std::size_t substitution_count = 0;  // Количество подстановок
+    std::array<std::uint8_t, 16> guid{};      // GUID шаблона из определения
+    std::uint64_t hash = 0;                   // Хеш GUID + потока токенов
+    std::vector<BinXmlTemplateToken> tokens;  // Поток токенов с подстановками
+    std::size_t substitution_count = 0;       // Количество слотов (max индекс + 1)
+
+    /// Каркас Value с таблицей слотов; nullptr — шаблон разворачивается по токенам
+    std::shared_ptr<const BinXmlSkeleton> skeleton;
+};
+
+/// Общий кеш скомпилированных шаблонов Binary XML
+///
+/// Смещения строк в определении шаблона относятся к чанку, поэтому ключ —
+/// GUID шаблона + хеш потока токенов с уже разрешёнными именами. Один и тот же
+/// шаблон компилируется один раз и переиспользуется всеми чанками и файлами
+/// (Security.evtx разных машин используют одни и те же провайдеры).
+/// Потокобезопасен.
+class BinXmlTemplateCache {
+public:
+    /// Кеш процесса
+    static BinXmlTemplateCache& global();
+
+    /// Найти эквивалентный шаблон или скомпилировать и сохранить новый
+    /// @param tmpl Шаблон с заполненными guid и tokens
+    /// @return Разделяемый скомпилированный шаблон
+    std::shared_ptr<const BinXmlTemplate> intern(BinXmlTemplate tmpl);
+
+    /// Количество скомпилированных шаблонов
+    std::size_t size() const;
+
+    /// Очистить кеш (шаблоны, уже выданные парсерам, остаются валидными)
+    void clear();
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::uint64_t, std::vector<std::shared_ptr<const BinXmlTemplate>>>
+        templates_;
+    std::size_t size_ = 0;
 };
 
 // ============================================================================
@@ -98,6 +153,39 @@ struct RecordHeader {
     std::uint64_t timestamp;  // Windows FILETIME
 };
 
+/// Окно времени записей по FILETIME заголовка (границы исключаются, как --from/--to)
+///
+/// Время в заголовке — момент записи события в журнал, а не System/TimeCreated:
+/// границу --from передают с запасом (written_after_bound)
+struct EvtxTimeWindow {
+    std::optional<std::uint64_t> from;
+    std::optional<std::uint64_t> to;
+
+    /// Окно не ограничено
+    bool unbounded() const { return !from && !to; }
+
+    /// Время заголовка попадает в окно
+    bool contains(std::uint64_t filetime) const {
+        return (!from || filetime > *from) && (!to || filetime < *to);
+    }
+};
+
+/// Запас границы --from по времени заголовка записи: 24 часа в единицах FILETIME
+///
+/// Обычно запись попадает в журнал не раньше System/TimeCreated, но у пересланных
+/// и собранных событий, источников с расходящимися часами и при переводе часов
+/// время заголовка бывает раньше. Расхождение в пределах запаса не теряет записи:
+/// они декодируются, и --from проверяется по TimeCreated. Записи с большим
+/// расхождением пропускаются без проверки TimeCreated — hunt и search сообщают об
+/// этом, когда граница включена.
+constexpr std::uint64_t WRITTEN_AFTER_MARGIN = 24ULL * 3600 * 10000000ULL;
+
+/// Граница окна для --from (FILETIME): записи, записанные в журнал не позже неё,
+/// созданы раньше from (при расхождении часов меньше WRITTEN_AFTER_MARGIN)
+inline std::uint64_t written_after_bound(std::uint64_t from) {
+    return from > WRITTEN_AFTER_MARGIN ? from - WRITTEN_AFTER_MARGIN : 0;
+}
+
 // ============================================================================
 // EVTX Record - запись события
 // ============================================================================
@@ -114,6 +202,10 @@ struct EvtxRecord {
 
     /// ID записи в логе
     std::uint64_t record_id;
+
+    /// Полный документ, если data построен по проекции полей (пусто — data полный)
+    /// Валиден, пока жив парсер
+    std::function<Value()> full;
 };
 
 // ============================================================================
@@ -202,21 +294,46 @@ private:
 /// SPEC-SLICE-007 FACT-003, FACT-004
 class EvtxParser {
 public:
-    EvtxParser() = default;
-    ~EvtxParser() = default;
+    EvtxParser();
+    ~EvtxParser();
 
     // Non-copyable
     EvtxParser(const EvtxParser&) = delete;
     EvtxParser& operator=(const EvtxParser&) = delete;
 
     // Movable
-    EvtxParser(EvtxParser&&) noexcept = default;
-    EvtxParser& operator=(EvtxParser&&) noexcept = default;
+    EvtxParser(EvtxParser&&) noexcept;
+    EvtxParser& operator=(EvtxParser&&) noexcept;
+
+    /// Количество потоков декодирования чанков (применяется при следующем load)
+    ///
+    /// При threads > 1 чанки декодируются пулом потоков с собственными кешами
+    /// строк и шаблонов; next() по-прежнему выдаёт записи в порядке файла.
+    void set_threads(std::size_t threads) { threads_ = threads; }
+
+    /// Окно времени: записи вне окна (по FILETIME заголовка) не декодируются и не
+    /// выдаются, чанки без записей в окне пропускаются целиком (при следующем load)
+    void set_time_window(EvtxTimeWindow window) { window_ = window; }
+
+    /// Проекция полей: строить в EvtxRecord::data только нужные ключи
+    /// (применяется при следующем load; nullptr — все поля)
+    void set_projection(std::shared_ptr<const FieldProjection> projection) {
+        projection_ = std::move(projection);
+    }
+
+    /// Строить контейнеры EvtxRecord::data в арене парсера вместо кучи
+    ///
+    /// Документ действителен до следующего next() (при threads > 1 — до перехода
+    /// к следующему чанку, т.е. тоже до следующего next()); сохранить его дольше —
+    /// Value::owned(). Полный документ из EvtxRecord::full строится в куче.
+    void set_value_arena(bool enabled) { value_arena_ = enabled; }
 
     /// Загрузить EVTX файл
     /// @param path Путь к файлу
+    /// @param memory_map Отобразить файл в память (false — чтение чанками через ifstream;
+    ///                   также используется, если отображение недоступно)
     /// @return true при успехе
-    bool load(const std::filesystem::path& path);
+    bool load(const std::filesystem::path& path, bool memory_map = true);
 
     /// Получить следующую запись
     /// @param record Запись (заполняется при успехе)
@@ -232,15 +349,23 @@ public:
     /// Проверить, достигнут ли конец файла
     bool eof() const { return eof_; }
 
+    /// Файл отображён в память (иначе читается чанками через ifstream)
+    bool memory_mapped() const { return mapping_.is_open(); }
+
     /// Итераторы для range-based for
     EvtxRecordIterator begin() { return EvtxRecordIterator(this); }
     EvtxRecordIterator end() { return EvtxRecordIterator(this, true); }
 
 private:
     std::filesystem::path path_;
-    std::ifstream file_;
+    platform::MappedFile mapping_;  // Основной режим: записи — срезы отображения
+    std::ifstream file_;            // Fallback: чанк читается в chunk_buffer_
     std::optional<EvtxError> error_;
 
+    // Данные текущего чанка (срез mapping_ или chunk_buffer_)
+    std::span<const std::uint8_t> chunk_;
+    std::shared_ptr<std::vector<std::uint8_t>> chunk_buffer_;
+
     // Состояние парсинга
     std::uint64_t file_size_ = 0;
     std::uint64_t current_chunk_ = 0;
@@ -249,26 +374,35 @@ private:
     std::uint64_t chunk_end_offset_ = 0;
     bool eof_ = false;
 
-    // Кеш строк чанка (для template substitution)
-    std::unordered_map<std::uint32_t, std::string> string_cache_;
+    // Параллельное декодирование: пул потоков и записи текущего чанка
+    class ChunkPipeline;
+    std::shared_ptr<const FieldProjection> projection_;
+    EvtxTimeWindow window_;
+    std::size_t threads_ = 1;
+    std::size_t chunk_count_ = 0;
+    std::unique_ptr<ChunkPipeline> pipeline_;
+    std::unique_ptr<ValueArena> decoded_arena_;  // Арена записей decoded_
+    std::vector<EvtxRecord> decoded_;
+    std::size_t decoded_index_ = 0;
+
+    // Кеши текущего чанка (строки и шаблоны; сами шаблоны — из BinXmlTemplateCache)
+    std::shared_ptr<BinXmlChunkCaches> caches_;
 
-    // Кеш шаблонов чанка (BUGFIX: должен сохраняться между записями)
-    std::unordered_map<std::uint32_t, BinXmlTemplate> template_cache_;
+    // Арена документа при последовательном чтении (сбрасывается в next())
+    bool value_arena_ = false;
+    std::unique_ptr<ValueArena> arena_;
 
     // Методы парсинга
+    const FieldProjection* projection() const;
+    bool is_open() const;
     bool read_file_header();
     bool read_chunk_header();
     bool read_record(EvtxRecord& record);
+    bool next_decoded(EvtxRecord& record);
 
-    // Binary XML парсинг
-    Value parse_binxml(const std::vector<std::uint8_t>& data);
-
-    // Утилиты чтения
-    template <typename T>
-    bool read_value(T& value);
-
-    bool read_bytes(void* buffer, std::size_t size);
-    std::string read_utf16_string(const std::vector<std::uint8_t>& data, std::size_t& offset,
+    // Утилиты чтения (fallback без отображения)
+    bool read_bytes(std::uint64_t offset, void* buffer, std::size_t size);
+    std::string read_utf16_string(std::span<const std::uint8_t> data, std::size_t& offset,
                                   std::size_t char_count);
 
 public:
@@ -292,6 +426,11 @@ public:
 /// @return Значение поля или nullptr
 const Value* find_with_aliases(const Value& value, std::string_view key);
 
+/// Поле документа — System/TimeCreated (SystemTime), в том числе через алиасы
+/// Это время создания события; с FILETIME заголовка записи сравнивается с запасом
+/// (written_after_bound)
+bool is_time_created_field(std::string_view key);
+
 /// Найти поле по пути (разделитель ".")
 /// @param value JSON документ
 /// @param path Путь к полю (например "Event.System.EventID")
@@ -22,6 +22,7 @@
 
 #include <chainsaw/reader.hpp>
 #include <chainsaw/rule.hpp>
+#include <chainsaw/rule_index.hpp>
 #include <chainsaw/search.hpp>  // DateTime
 #include <chainsaw/tau.hpp>
 #include <chainsaw/value.hpp>
@@ -42,6 +43,7 @@ namespace chainsaw::hunt {
 // Forward declarations
 class Hunter;
 class HunterBuilder;
+class DetectionCache;
 
 // Reuse DateTime from search module
 using DateTime = search::DateTime;
@@ -149,6 +151,8 @@ enum class MapperMode {
     Full   // с cast и container
 };
 
+class MapperCache;
+
 /// Mapper — преобразование полей документа
 /// Соответствует hunt.rs:568-714
 class Mapper {
@@ -176,23 +180,87 @@ public:
     /// Преобразовать значение поля
     /// @param doc Исходный документ
     /// @param key Имя поля
-    /// @return Преобразованное значение или nullopt
-    std::optional<Value> find(const tau::Document& doc, std::string_view key) const;
+    /// @return Ссылка на значение doc (переименование) или вычисленное значение
+    ///         (cast, container); пустой результат — поля нет
+    tau::FieldRef find(const tau::Document& doc, std::string_view key) const;
+
+    /// Преобразовать значение поля по разобранному пути: отображение ищется по
+    /// номеру ключа пути, без хеширования строки
+    tau::FieldRef resolve(const tau::Document& doc, const tau::FieldPath& path) const;
+
+    /// find/resolve с результатами документа в cache: контейнер разбирается и
+    /// поле вычисляется один раз до cache.clear(); ссылки действительны до него
+    tau::FieldRef find(const tau::Document& doc, std::string_view key, MapperCache& cache) const;
+    tau::FieldRef resolve(const tau::Document& doc, const tau::FieldPath& path,
+                          MapperCache& cache) const;
 
 private:
+    /// Поиск по string_view без создания std::string
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+    template <typename T>
+    using KeyMap = std::unordered_map<std::string, T, KeyHash, std::equal_to<>>;
+
+    /// Отображение поля: путь в документе, контейнер, приведение типа
+    /// (Fast mode — только путь)
+    struct Entry {
+        tau::FieldPath to;
+        std::optional<rule::Container> container;
+        tau::FieldPath container_field;
+        std::uint32_t container_slot = 0;  // общий для одинаковых контейнеров
+        std::optional<tau::ModSym> cast;
+    };
+
+    static constexpr std::size_t NOT_MAPPED = static_cast<std::size_t>(-1);
+
+    /// Позиция отображения поля с ключом key в entries_ (NOT_MAPPED — нет)
+    std::size_t entry_index(const ValueKey& key) const;
+
+    /// Значение поля по отображению (cache — результаты документа или nullptr)
+    tau::FieldRef apply(const tau::Document& doc, std::size_t index, MapperCache* cache) const;
+
+    /// Вычислить значение поля по отображению
+    tau::FieldRef compute(const tau::Document& doc, const Entry& entry, MapperCache* cache) const;
+
     std::vector<rule::Field> fields_;
     MapperMode mode_ = MapperMode::None;
 
-    // Fast mode: from -> to
-    std::unordered_map<std::string, std::string> fast_map_;
+    std::vector<Entry> entries_;
+    // from -> позиция в entries_
+    KeyMap<std::size_t> by_name_;
+    // номер ключа from (ValueKey) -> позиция в entries_ + 1 (0 — поле не отображается)
+    std::vector<std::uint32_t> by_key_;
+    // число различных контейнеров (поле, формат, параметры KV)
+    std::size_t containers_ = 0;
+};
 
-    // Full mode: from -> (to, container, cast)
-    struct FullEntry {
-        std::string to;
-        std::optional<rule::Container> container;
-        std::optional<tau::ModSym> cast;
+/// Результаты Mapper для одного документа: разобранные контейнеры и значения
+/// отображённых полей
+///
+/// Фильтр группы, preconditions и правила читают одни поля много раз; с
+/// кэшем JSON/KV контейнер разбирается, а cast вычисляется один раз на
+/// документ. Один кэш — для одного Mapper; clear() — перед каждым документом
+/// (дешёвый: меняется поколение, память не освобождается).
+class MapperCache {
+public:
+    /// Забыть результаты: следующий документ
+    void clear();
+
+private:
+    friend class Mapper;
+
+    struct Slot {
+        std::uint32_t generation = 0;
+        tau::FieldRef value;
     };
-    std::unordered_map<std::string, FullEntry> full_map_;
+
+    std::vector<Slot> entries_;     // по позиции в Mapper::entries_
+    std::vector<Slot> containers_;  // разобранный контейнер, по Entry::container_slot
+    std::uint32_t generation_ = 1;
 };
 
 /// MappedDocument — Document wrapper с применённым Mapper
@@ -200,12 +268,17 @@ class MappedDocument : public tau::Document {
 public:
     MappedDocument(const tau::Document& doc, const Mapper& mapper) : doc_(doc), mapper_(mapper) {}
 
-    std::optional<Value> find(std::string_view key) const override;
+    /// С кэшем результатов документа (очищается вызывающим)
+    MappedDocument(const tau::Document& doc, const Mapper& mapper, MapperCache& cache)
+        : doc_(doc), mapper_(mapper), cache_(&cache) {}
+
+    tau::FieldRef lookup(std::string_view key) const override;
+    tau::FieldRef resolve(const tau::FieldPath& path) const override;
 
 private:
     const tau::Document& doc_;
     const Mapper& mapper_;
-    mutable std::unordered_map<std::string, Value> container_cache_;
+    MapperCache* cache_ = nullptr;
 };
 
 // ============================================================================
@@ -219,6 +292,10 @@ struct HuntKindGroup {
     rule::Kind kind = rule::Kind::Sigma;              // тип правил
     std::unordered_map<UUID, tau::Expression, UUID::Hash> preconditions;
 
+    // Скомпилированные filter и preconditions (tau::Program)
+    tau::Program program;
+    std::unordered_map<UUID, tau::Program, UUID::Hash> precondition_programs;
+
     HuntKindGroup() = default;
     HuntKindGroup(HuntKindGroup&&) = default;
     HuntKindGroup& operator=(HuntKindGroup&&) = default;
@@ -230,6 +307,7 @@ struct HuntKindGroup {
 struct HuntKindRule {
     std::optional<rule::Aggregate> aggregate;  // агрегация
     rule::Filter filter;                       // фильтр правила
+    tau::Program program;                      // скомпилированный filter
 
     HuntKindRule() = default;
     HuntKindRule(HuntKindRule&&) = default;
@@ -248,11 +326,11 @@ using HuntKind = std::variant<HuntKindGroup, HuntKindRule>;
 /// Hunt — конфигурация одного hunt
 /// Соответствует hunt.rs:733-750
 struct Hunt {
-    UUID id{};              // уникальный идентификатор
-    std::string group;      // название группы
-    HuntKind kind;          // тип hunt
-    Mapper mapper;          // преобразование полей
-    std::string timestamp;  // поле timestamp
+    UUID id{};                 // уникальный идентификатор
+    std::string group;         // название группы
+    HuntKind kind;             // тип hunt
+    Mapper mapper;             // преобразование полей
+    tau::FieldPath timestamp;  // поле timestamp
 
     io::DocumentKind file = io::DocumentKind::Unknown;  // тип файлов
 
@@ -305,12 +383,18 @@ struct KindAggregate {
     std::vector<Document> documents;
 };
 
+/// Запись документа в DetectionCache
+struct CachedRecord {
+    std::size_t offset;
+    std::size_t size;
+};
+
 /// Kind::Cached — кешированный документ (cache-to-disk)
 struct KindCached {
     io::DocumentKind kind;
     std::string path;
-    std::size_t offset;
-    std::size_t size;
+    std::vector<CachedRecord> records;  // документ; у агрегации — её документы по порядку
+    bool aggregate = false;
 };
 
 /// Kind — вариант типа результата
@@ -358,6 +442,17 @@ public:
     /// Пропускать ошибки чтения/парсинга
     HunterBuilder& skip_errors(bool skip);
 
+    /// Количество потоков обработки файла: декодирование EVTX чанков и
+    /// сопоставление документов в конвейере hunt
+    HunterBuilder& num_threads(std::size_t threads);
+
+    /// Документов в пакете конвейера hunt (по умолчанию 256)
+    HunterBuilder& batch_size(std::size_t documents);
+
+    /// Детектированиям нужны документы (по умолчанию да); false — только hits,
+    /// документы не собираются и не пишутся в кэш (вывод таблицей)
+    HunterBuilder& documents(bool keep);
+
     /// Установить timezone
     HunterBuilder& timezone(std::string tz);
 
@@ -380,6 +475,9 @@ private:
     std::optional<bool> preprocess_;
     std::optional<DateTime> from_;
     std::optional<bool> skip_errors_;
+    std::optional<std::size_t> num_threads_;
+    std::optional<std::size_t> batch_size_;
+    std::optional<bool> documents_;
     std::optional<std::string> timezone_;
     std::optional<DateTime> to_;
 };
@@ -397,14 +495,40 @@ public:
 
     /// Выполнить hunt по файлу
     /// @param path Путь к файлу
-    /// @param cache_file Опциональный файл для кеширования
+    /// @param cache Кэш на диске (nullptr — документы в памяти): документы
+    ///        собранных детектирований записываются в него, детектирования — KindCached
+    /// @param threads Потоки обработки файла (0 — num_threads()); больше одного —
+    ///        конвейер: текущий поток читает файл и собирает детектирования по
+    ///        порядку документов, threads - 1 потоков сопоставляют пакеты документов;
+    ///        для EVTX threads / 2 потоков декодируют чанки, threads - threads / 2
+    ///        сопоставляют
     /// @return Вектор результатов детектирования
     struct HuntResult {
         bool ok = false;
         std::vector<Detections> detections;
         std::string error;
     };
-    HuntResult hunt(const std::filesystem::path& path, std::FILE* cache_file = nullptr) const;
+    HuntResult hunt(const std::filesystem::path& path, DetectionCache* cache = nullptr,
+                    std::size_t threads = 0) const;
+
+    /// Приёмник детектирований: вызывается в потоке hunt_each по мере нахождения;
+    /// false — остановить hunt файла
+    using DetectionSink = std::function<bool(Detections&&)>;
+
+    /// Выполнить hunt по файлу, передавая детектирования в sink сразу: отдельные —
+    /// по порядку документов, агрегации с окном — при закрытии окна, остальные
+    /// агрегации — после чтения файла. HuntResult::detections остаётся пустым;
+    /// остановка приёмником — не ошибка (ok = true). При ошибке файла (ok = false)
+    /// детектирования, уже переданные в sink, не отзываются: вывод файла частичный
+    ///
+    /// Отдельные детектирования приёмник получает с документом (KindIndividual) и
+    /// в кэш они не пишутся. Документы агрегаций ждут конца файла или закрытия
+    /// окна. Без кэша они в памяти — собранные или ссылкой на запись EVTX,
+    /// удерживающей буфер и кеши её чанка, — и память растёт с их числом; с кэшем
+    /// каждый документ пишется в него один раз, в памяти остаются смещение и
+    /// размер записи (CachedRecord), а агрегация приходит как KindCached
+    HuntResult hunt_each(const std::filesystem::path& path, const DetectionSink& sink,
+                         DetectionCache* cache = nullptr, std::size_t threads = 0) const;
 
     /// Получить расширения файлов для hunt
     std::unordered_set<std::string> extensions() const;
@@ -421,6 +545,19 @@ public:
     /// Getter для skip_errors
     bool skip_errors() const { return skip_errors_; }
 
+    /// Getter для num_threads
+    std::size_t num_threads() const { return num_threads_; }
+
+    /// Getter для batch_size
+    std::size_t batch_size() const { return batch_size_; }
+
+    /// Getter для documents
+    bool documents() const { return documents_; }
+
+    /// Пропускаются ли записи EVTX по времени заголовка (--from по System/TimeCreated):
+    /// записи, попавшие в журнал раньше from больше чем на WRITTEN_AFTER_MARGIN, не читаются
+    bool skips_evtx_by_written_time() const { return evtx_written_after_.has_value(); }
+
 private:
     friend class HunterBuilder;
 
@@ -429,13 +566,52 @@ private:
     /// Проверить, нужно ли пропустить документ по времени
     bool should_skip(const DateTime& timestamp) const;
 
+    /// Совпадения одного документа: вычисляются в потоках конвейера, детектирования
+    /// и агрегации из них собираются по порядку документов
+    struct DocumentMatch;
+    /// Рабочие буферы сопоставления, по одному на поток
+    struct MatchScratch;
+
+    /// Сопоставить документ со всеми hunts (документ не изменяется)
+    void match_document(const io::Document& doc, io::DocumentKind kind, MatchScratch& scratch,
+                        DocumentMatch& out) const;
+
+    /// Конвейер hunt: пакеты документов из reader сопоставляются в matchers
+    /// потоках, collect получает документы по порядку (false — остановиться)
+    /// @return false, если collect остановил конвейер
+    bool run_pipeline(io::Reader& reader, io::DocumentKind kind, std::size_t matchers,
+                      const std::function<bool(io::Document&, DocumentMatch&)>& collect) const;
+
     std::vector<Hunt> hunts_;
     std::vector<std::string> fields_;  // для preprocessing
     std::unordered_map<UUID, rule::Rule, UUID::Hash> rules_;
 
+    /// Правило со скомпилированным фильтром
+    struct CompiledRule {
+        UUID id;
+        const rule::Rule* rule;
+        tau::Program program;
+    };
+    /// Правила в порядке обхода rules_ (порядок совпадений не меняется)
+    std::vector<CompiledRule> compiled_;
+    /// Отбор правил для документа группы (номера в compiled_)
+    RuleIndex index_;
+    /// Общие проверки фильтров групп, preconditions и правил: вычисляются
+    /// не больше одного раза на документ группы
+    std::shared_ptr<const tau::Predicates> predicates_;
+
     bool load_unknown_ = false;
     bool preprocess_ = false;
     bool skip_errors_ = false;
+    std::size_t num_threads_ = 1;
+    std::size_t batch_size_ = 256;
+    bool documents_ = true;
+
+    /// Поля, на которые ссылаются hunts (nullptr — Reader собирает документ целиком)
+    std::shared_ptr<const FieldProjection> projection_;
+
+    /// Записи EVTX, записанные не позже этого FILETIME, вне --from у всех hunts
+    std::optional<std::uint64_t> evtx_written_after_;
 
     std::optional<DateTime> from_;
     std::optional<DateTime> to_;
@@ -446,16 +622,31 @@ private:
 // ============================================================================
 
 /// Сериализовать Detections в JSON
+/// @param cache Кэш, из которого читаются документы KindCached
 std::string detections_to_json(const Detections& det, const std::vector<Hunt>& hunts,
                                const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
-                               bool local_time = false);
+                               bool local_time = false, DetectionCache* cache = nullptr);
 
 /// Сериализовать Detections в JSONL (одна строка)
 std::string detections_to_jsonl(const Detections& det, const std::vector<Hunt>& hunts,
                                 const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
-                                bool local_time = false);
+                                bool local_time = false, DetectionCache* cache = nullptr);
+
+/// Начало таблицы детектирований: рамка и заголовки колонок
+std::string format_table_header();
+
+/// Строка таблицы одного детектирования (параметры — как у format_table)
+/// @return Строка с переводом строки; пусто, если у детектирования нет hits
+std::string format_table_row(const Detections& det, const std::vector<Hunt>& hunts,
+                             const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
+                             std::uint32_t column_width = 0, bool full = false,
+                             bool metadata = false, bool local_time = false);
+
+/// Конец таблицы детектирований: нижняя рамка
+std::string format_table_footer();
 
-/// Форматировать таблицу детектирований
+/// Форматировать таблицу детектирований: format_table_header(), строки
+/// format_table_row() и format_table_footer()
 /// @param detections Вектор детектирований
 /// @param hunts Список hunts
 /// @param rules Правила
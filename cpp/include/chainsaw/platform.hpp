@@ -10,13 +10,20 @@
 // - Единый слой преобразования путей и кодировок
 // - Определение TTY для stdout/stderr
 // - Платформенные утилиты (temp files, env)
+// - Отображение файлов в память (mmap / MapViewOfFile)
+// - Пул потоков для независимых задач (файлы hunt/search/dump)
 //
 // ==============================================================================
 
 #ifndef CHAINSAW_PLATFORM_HPP
 #define CHAINSAW_PLATFORM_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -60,6 +67,83 @@ const char* rule_prefix();
 /// FACT-011, FACT-012: соответствует tempfile::tempfile() в Rust
 std::filesystem::path make_temp_file(std::string_view prefix);
 
+// ----------------------------------------------------------------------------
+// Отображение файлов в память
+// ----------------------------------------------------------------------------
+
+/// Read-only отображение файла в память
+///
+/// POSIX: mmap(PROT_READ, MAP_PRIVATE), Windows: CreateFileMapping + MapViewOfFile.
+/// Дескрипторы закрываются сразу после отображения, отображение живёт до close()
+/// или разрушения объекта. Пустые файлы не отображаются (open() возвращает false).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Non-copyable
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Movable
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /// Отобразить файл целиком
+    /// @return false, если отображение недоступно (вызывающий читает файл буферами)
+    bool open(const std::filesystem::path& path);
+
+    /// Снять отображение
+    void close();
+
+    bool is_open() const { return data_ != nullptr; }
+    const std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    /// Содержимое файла
+    std::span<const std::uint8_t> bytes() const { return {data_, size_}; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// ----------------------------------------------------------------------------
+// Пул потоков
+// ----------------------------------------------------------------------------
+
+/// Пул потоков для независимых задач 0..count-1
+///
+/// Задачи раздаются очередям потоков по кругу. Поток берёт свои задачи с начала
+/// очереди (по возрастанию номера), а опустевший — забирает самую раннюю задачу
+/// чужой очереди (work stealing), поэтому большой файл не задерживает остальные,
+/// а украденная задача ближе всего к окну.
+/// Окно ограничивает забегание вперёд: задача i начинается, только когда
+/// задачи до i - window отпущены release(). Так результаты, ждущие вывода
+/// по порядку, не копятся без предела; самая ранняя задача всегда допущена.
+class TaskPool {
+public:
+    /// Запустить threads потоков (не меньше одного); window 0 — без окна
+    TaskPool(std::size_t count, std::size_t threads, std::size_t window,
+             std::function<void(std::size_t)> task);
+
+    /// Отменить неначатые задачи и дождаться потоков
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /// Результат задачи index обработан: окно сдвигается за неё
+    void release(std::size_t index);
+
+    /// Не начинать новые задачи (начатые доработают)
+    void cancel();
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
 // ----------------------------------------------------------------------------
 // Информация о платформе
 // ----------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include <chainsaw/value.hpp>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -103,6 +104,9 @@ struct Document {
 
     /// Timestamp записи (если применимо)
     std::optional<std::string> timestamp;
+
+    /// Полный документ, если data собран по проекции полей (валиден, пока жив Reader)
+    std::function<Value()> materialize;
 };
 
 // ----------------------------------------------------------------------------
@@ -148,6 +152,30 @@ struct ReaderResult {
     explicit operator bool() const { return ok; }
 };
 
+/// Параметры открытия Reader
+struct ReaderOptions {
+    /// Пробовать fallback для неизвестных расширений
+    bool load_unknown = false;
+
+    /// Возвращать пустой Reader вместо ошибки
+    bool skip_errors = false;
+
+    /// Потоки декодирования чанков EVTX (0/1 — последовательно)
+    std::size_t evtx_threads = 1;
+
+    /// Записи EVTX, записанные в журнал не позже этого момента (FILETIME заголовка),
+    /// не декодируются и не выдаются; для --from — evtx::written_after_bound()
+    std::optional<std::uint64_t> evtx_written_after;
+
+    /// Поля, которые нужны потребителю (nullptr — все); остальные могут отсутствовать
+    /// в Document::data до вызова Document::materialize
+    std::shared_ptr<const FieldProjection> projection;
+
+    /// Строить документы EVTX в арене читателя: Document::data действителен до
+    /// следующего next() (сохранить дольше — Value::owned())
+    bool value_arena = false;
+};
+
 /// Унифицированный интерфейс чтения файлов разных форматов
 ///
 /// Использование:
@@ -185,6 +213,11 @@ public:
     static ReaderResult open(const std::filesystem::path& file, bool load_unknown = false,
                              bool skip_errors = false);
 
+    /// Открыть файл и создать Reader с полным набором параметров
+    /// @param file Путь к файлу
+    /// @param options Параметры открытия (см. ReaderOptions)
+    static ReaderResult open(const std::filesystem::path& file, const ReaderOptions& options);
+
     // -------------------------------------------------------------------------
     // Итерация
     // -------------------------------------------------------------------------
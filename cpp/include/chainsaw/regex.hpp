@@ -0,0 +1,142 @@
+// ==============================================================================
+// chainsaw/regex.hpp - Регулярные выражения с линейным временем поиска
+// ==============================================================================
+//
+// MOD-0009 tau (общий движок для tau, search, shimcache и sigma)
+//
+// Назначение:
+// - Замена std::regex: компиляция без рекурсивного разбора libstdc++ и поиск
+//   без экспоненциального перебора
+// - Одинаковые паттерны из разных правил компилируются один раз (compile_regex)
+//
+// Устройство:
+// - Разбор паттерна → НКА Томпсона (байтовые множества, split, jmp, assert)
+// - Поиск — ленивый ДКА: состояние — множество позиций НКА, переходы
+//   достраиваются при первом проходе и кэшируются; время поиска линейно
+// - Кэш ДКА ограничен по размеру и сбрасывается при переполнении
+// - Префильтр: самая длинная подстрока, обязательная для совпадения,
+//   ищется до запуска ДКА (SSE2: сравнение первого и последнего байта);
+//   паттерн из одной подстроки ДКА не запускает
+//
+// Синтаксис (подмножество ECMAScript и Rust regex, используемое правилами):
+// - Литералы и экранирование, '.', классы [...] (диапазоны, отрицание,
+//   \d \w \s, [:alpha:] и т.п.), \xHH, \uHHHH
+// - Группы (...), (?:...), (?P<name>...), (?<name>...); альтернатива |
+// - Квантификаторы * + ? {n} {n,} {n,m} и их ленивые формы
+// - Якоря ^ $ \b \B; флаги (?i) (?s) (?m) (?-i) и (?i:...)
+// - Обратные ссылки и lookaround не поддерживаются (ошибка компиляции,
+//   как в Rust regex)
+//
+// Семантика совпадает с std::regex (ECMAScript) на std::string:
+// - Поиск по байтам; '.' — любой байт, кроме '\n' и '\r'
+// - Регистр: ASCII case folding
+// - \uHHHH вне ASCII — байты UTF-8 (std::regex обрезает до одного байта)
+//
+// ==============================================================================
+
+#ifndef CHAINSAW_REGEX_HPP
+#define CHAINSAW_REGEX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chainsaw::tau {
+
+/// Ошибка компиляции регулярного выражения
+class RegexError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class Regex {
+public:
+    /// Скомпилировать паттерн
+    /// @throws RegexError при синтаксической ошибке или неподдерживаемой конструкции
+    explicit Regex(std::string_view pattern, bool ignore_case = false);
+    ~Regex();
+
+    Regex(Regex&&) noexcept;
+    Regex& operator=(Regex&&) noexcept;
+    Regex(const Regex&) = delete;
+    Regex& operator=(const Regex&) = delete;
+
+    /// Есть ли совпадение в любом месте текста (как std::regex_search)
+    /// Потокобезопасен: несколько кэшей ДКА на конкурирующие потоки, при занятости
+    /// всех поиск идёт по временному
+    bool search(std::string_view text) const;
+
+    const std::string& pattern() const { return pattern_; }
+    bool ignore_case() const { return ignore_case_; }
+
+    /// Обязательная подстрока префильтра (пусто — не выделена)
+    /// В нижнем регистре, если сравнивается без учёта регистра
+    const std::string& literal() const { return literal_; }
+
+private:
+    enum class Op : std::uint8_t { Bytes, Split, Jmp, Assert, Match };
+    enum class Assertion : std::uint8_t {
+        BeginText,
+        EndText,
+        BeginLine,
+        EndLine,
+        WordBoundary,
+        NotWordBoundary,
+    };
+
+    /// Инструкция НКА
+    struct Inst {
+        Op op;
+        Assertion assertion;  // Op::Assert
+        std::uint32_t x;      // Bytes: индекс множества; Split: первая ветвь; Jmp: цель
+        std::uint32_t y;      // Split: вторая ветвь
+        std::uint32_t next;   // Bytes, Assert: следующая инструкция
+    };
+
+    struct Node;
+    class Parser;
+    class Compiler;
+    struct Literals;
+    struct Cache;
+
+    /// Поиск с заданным кэшем ДКА
+    bool run(Cache& cache, std::string_view text) const;
+
+    std::string pattern_;
+    bool ignore_case_;
+
+    std::vector<Inst> program_;
+    std::vector<std::array<std::uint64_t, 4>> sets_;  // байтовые множества (bitset 256)
+    std::uint32_t start_ = 0;
+
+    // Классы байтов: байты, неразличимые для всех множеств и якорей
+    std::array<std::uint8_t, 256> classes_{};
+    std::size_t classes_count_ = 1;
+
+    // Какие признаки предыдущего байта влияют на якоря
+    bool track_word_ = false;
+    bool track_line_ = false;
+
+    // Префильтр
+    std::string literal_;
+    bool literal_icase_ = false;
+    bool literal_only_ = false;  // совпадение — ровно наличие literal_
+
+    std::unique_ptr<Cache[]> caches_;  // CACHE_SLOTS кэшей ДКА
+};
+
+using RegexPtr = std::shared_ptr<const Regex>;
+
+/// Скомпилировать паттерн через общий кэш: одинаковые паттерны (с тем же
+/// ignore_case) разделяют один объект, пока он где-то используется
+/// @throws RegexError как конструктор Regex
+RegexPtr compile_regex(std::string_view pattern, bool ignore_case = false);
+
+}  // namespace chainsaw::tau
+
+#endif  // CHAINSAW_REGEX_HPP
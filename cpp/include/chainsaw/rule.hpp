@@ -23,7 +23,9 @@
 
 #include <chainsaw/reader.hpp>
 #include <chainsaw/tau.hpp>
+#include <chrono>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -98,6 +100,8 @@ struct Field {
 struct Aggregate {
     tau::Pattern count;               // паттерн для подсчёта
     std::vector<std::string> fields;  // поля для группировки
+    /// Скользящее окно по времени события (Sigma timeframe); nullopt — весь файл
+    std::optional<std::chrono::seconds> timeframe;
 };
 
 // ============================================================================
@@ -209,6 +213,12 @@ const std::string& rule_name(const Rule& r);
 /// Соответствует Rule::solve() в mod.rs:70-79
 bool rule_solve(const Rule& r, const tau::Document& doc);
 
+/// Скомпилировать фильтр правила: solve(rule_program(r), doc) == rule_solve(r, doc)
+tau::Program rule_program(const Rule& r);
+
+/// Скомпилировать фильтр правила с общими проверками (tau::Predicates)
+tau::Program rule_program(const Rule& r, const std::shared_ptr<tau::Predicates>& shared);
+
 /// Получить статус правила
 /// Соответствует Rule::status() в mod.rs:81-88
 Status rule_status(const Rule& r);
@@ -0,0 +1,102 @@
+// ==============================================================================
+// chainsaw/rule_index.hpp - Индекс правил по обязательным равенствам полей
+// ==============================================================================
+//
+// MOD-0012 hunt (отбор правил-кандидатов для документа)
+//
+// Назначение:
+// - Почти все правила EVTX требуют точного значения EventID, Provider или
+//   Channel; вместо проверки каждого правила документ ищется в хеш-таблице
+//   по значению поля и проверяется только против найденных правил
+// - Правила без обязательного равенства проверяются всегда (residual)
+//
+// Устройство:
+// - Из выражения правила выделяются равенства, без которых оно ложно:
+//   Exact-поиск (с учётом регистра или без), сравнение поля с числом
+//   (EventID: 4688) внутри And и одинаковое поле во всех ветвях Or
+// - Для правила выбирается поле, общее для наибольшего числа правил, — так
+//   индекс обходится немногими полями
+// - Значение поля документа сравнивается так же, как в Search: массив —
+//   любой элемент, числа — текстом (tau::value_to_string); с числом правила —
+//   после tau::value_to_double, ключ — десятичный текст числа (number_key)
+//
+// ==============================================================================
+
+#ifndef CHAINSAW_RULE_INDEX_HPP
+#define CHAINSAW_RULE_INDEX_HPP
+
+#include <chainsaw/tau.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace chainsaw::hunt {
+
+/// Обязательное равенство: выражение может быть истинным, только если
+/// значение поля совпадает с одной из строк
+struct Equality {
+    tau::FieldPath field;
+    std::vector<std::string> exact;   // с учётом регистра
+    std::vector<std::string> folded;  // без учёта регистра (ASCII lowercase)
+    std::vector<std::string> numeric;  // число (number_key), как сравнивает tau
+
+    std::size_t size() const { return exact.size() + folded.size() + numeric.size(); }
+};
+
+/// Ключ числа для равенств numeric: кратчайший десятичный текст double
+/// ("4688" для целых), -0 — как 0
+std::string number_key(double value);
+
+/// Обязательные равенства выражения, не больше одного на поле
+std::vector<Equality> required_equalities(const tau::Expression& expression);
+
+class RuleIndex {
+public:
+    /// Пустой индекс: кандидатов нет
+    RuleIndex() = default;
+
+    /// Построить индекс: filters[i] — фильтр правила i (nullptr — правило
+    /// не разбирается и проверяется всегда)
+    explicit RuleIndex(const std::vector<const tau::Expression*>& filters);
+
+    /// Номера правил, которые могут совпасть с документом, по возрастанию
+    void candidates(const tau::Document& document, std::vector<std::uint32_t>& out) const;
+
+    /// Число правил в хеш-таблицах и проверяемых всегда
+    std::size_t indexed() const { return indexed_; }
+    std::size_t residual() const { return residual_.size(); }
+
+private:
+    /// Поиск по string_view без создания std::string
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+    using Postings =
+        std::unordered_map<std::string, std::vector<std::uint32_t>, KeyHash, std::equal_to<>>;
+
+    struct Field {
+        tau::FieldPath path;
+        Postings exact;
+        Postings folded;
+        Postings numeric;
+    };
+
+    /// Добавить правила, совпадающие по значению (массив — по элементам)
+    void collect(const Field& field, const Value& value, std::string& folded,
+                 std::vector<std::uint32_t>& out) const;
+
+    std::vector<Field> fields_;
+    std::vector<std::uint32_t> residual_;
+    std::size_t indexed_ = 0;
+};
+
+}  // namespace chainsaw::hunt
+
+#endif  // CHAINSAW_RULE_INDEX_HPP
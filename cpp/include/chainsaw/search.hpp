@@ -23,10 +23,10 @@
 #include <chainsaw/tau.hpp>
 #include <chainsaw/value.hpp>
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <optional>
-#include <regex>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -64,6 +64,9 @@ struct DateTime {
 
     /// Конвертировать в строку ISO 8601
     std::string to_string() const;
+
+    /// Конвертировать в Windows FILETIME (100 нс с 1601-01-01; раньше — 0)
+    std::uint64_t to_filetime() const;
 };
 
 // ============================================================================
@@ -76,7 +79,7 @@ struct DateTime {
 /// @param patterns Скомпилированные regex паттерны
 /// @param match_any true = OR семантика, false = AND семантика
 /// @return true если документ соответствует
-bool value_matches_patterns(const Value& value, const std::vector<std::regex>& patterns,
+bool value_matches_patterns(const Value& value, const std::vector<tau::RegexPtr>& patterns,
                             bool match_any);
 
 // ============================================================================
@@ -152,6 +155,9 @@ public:
     /// Пропускать ошибки чтения/парсинга
     SearcherBuilder& skip_errors(bool skip);
 
+    /// Количество потоков декодирования файла (EVTX чанки)
+    SearcherBuilder& num_threads(std::size_t threads);
+
     /// Собрать Searcher
     /// @return Результат с Searcher или ошибкой
     struct BuildResult {
@@ -173,6 +179,7 @@ private:
     std::optional<std::string> timestamp_;
     bool load_unknown_ = false;
     bool skip_errors_ = false;
+    std::size_t num_threads_ = 1;
 };
 
 // ============================================================================
@@ -189,10 +196,12 @@ public:
 
     /// Выполнить поиск по файлу
     /// @param path Путь к файлу
+    /// @param threads Потоки декодирования файла (0 — num_threads())
     /// @return Вектор найденных документов
     ///
     /// SPEC-SLICE-011: итерирует по документам, проверяет соответствие
-    std::vector<SearchResult> search(const std::filesystem::path& path) const;
+    std::vector<SearchResult> search(const std::filesystem::path& path,
+                                     std::size_t threads = 0) const;
 
     /// Проверить соответствие одного документа
     /// @param doc Документ для проверки
@@ -210,12 +219,19 @@ public:
         return timestamp_.has_value() && (from_.has_value() || to_.has_value());
     }
 
+    /// Пропускаются ли записи EVTX по времени заголовка (--from по System/TimeCreated):
+    /// записи, попавшие в журнал раньше from больше чем на WRITTEN_AFTER_MARGIN, не читаются
+    bool skips_evtx_by_written_time() const;
+
     /// Getter для load_unknown
     bool load_unknown() const { return load_unknown_; }
 
     /// Getter для skip_errors
     bool skip_errors() const { return skip_errors_; }
 
+    /// Getter для num_threads
+    std::size_t num_threads() const { return num_threads_; }
+
 private:
     friend class SearcherBuilder;
 
@@ -234,7 +250,7 @@ private:
     bool matches_time_filter(const Value& value) const;
 
     // Скомпилированные regex паттерны
-    std::vector<std::regex> regex_patterns_;
+    std::vector<tau::RegexPtr> regex_patterns_;
 
     // Tau expression (combined AND/OR)
     std::optional<tau::Expression> tau_expression_;
@@ -248,6 +264,7 @@ private:
     bool match_any_ = false;
     bool load_unknown_ = false;
     bool skip_errors_ = false;
+    std::size_t num_threads_ = 1;
 };
 
 // ============================================================================
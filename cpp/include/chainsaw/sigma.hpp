@@ -19,9 +19,11 @@
 #ifndef CHAINSAW_SIGMA_HPP
 #define CHAINSAW_SIGMA_HPP
 
+#include <chrono>
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
@@ -49,6 +51,7 @@ struct LogSource {
 struct SigmaAggregate {
     std::string count;                // ">=5", ">10", etc.
     std::vector<std::string> fields;  // поля для группировки
+    std::optional<std::chrono::seconds> timeframe;  // detection.timeframe (nullopt — весь файл)
 };
 
 // ============================================================================
@@ -163,6 +166,14 @@ std::vector<std::string> get_unsupported_modifiers(
 /// Соответствует sigma.rs:182-197
 bool is_condition_unsupported(const std::string& condition);
 
+// ============================================================================
+// Timeframe
+// ============================================================================
+
+/// Разбирает detection.timeframe: целое число и единица s, m, h или d ("5m", "24h")
+/// Возвращает nullopt для пустого, нулевого или нераспознанного значения
+std::optional<std::chrono::seconds> parse_timeframe(std::string_view value);
+
 // ============================================================================
 // Load function — main entry point
 // ============================================================================
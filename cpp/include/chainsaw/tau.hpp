@@ -21,16 +21,17 @@
 #define CHAINSAW_TAU_HPP
 
 #include <algorithm>
+#include <chainsaw/regex.hpp>
 #include <chainsaw/value.hpp>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
-#include <regex>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -123,8 +124,8 @@ struct PatternAny {};
 
 /// Паттерн: regex match
 struct PatternRegex {
-    std::regex regex;
-    std::string pattern;  // оригинальный паттерн для копирования
+    RegexPtr regex;       // из общего кэша compile_regex
+    std::string pattern;  // оригинальный паттерн для вывода
 };
 
 /// Паттерн: substring contains
@@ -163,8 +164,8 @@ struct SearchAny {};
 
 /// Поиск: regex match
 struct SearchRegex {
-    std::regex regex;
-    std::string pattern;  // оригинальный паттерн для копирования
+    RegexPtr regex;       // из общего кэша compile_regex
+    std::string pattern;  // оригинальный паттерн для вывода
     bool ignore_case;
 };
 
@@ -174,13 +175,20 @@ struct MatchTypeEntry {
     std::string value;
 };
 
+class AhoCorasick;
+
 /// Поиск: multi-pattern DFA (Aho-Corasick)
-/// В C++ реализуем упрощённо через std::string операции с case folding
+/// Автомат строится при оптимизации (shake) и при разборе parse_kv; без автомата
+/// записи проверяются по одной
 struct SearchAhoCorasick {
     std::vector<MatchTypeEntry> match_types;
     bool ignore_case;
+    std::shared_ptr<const AhoCorasick> automaton;  // общий для копий выражения
 };
 
+/// Построить автомат для записей поиска
+void compile(SearchAhoCorasick& search);
+
 /// Поиск: case-sensitive contains
 struct SearchContains {
     std::string value;
@@ -205,6 +213,41 @@ struct SearchStartsWith {
 using Search = std::variant<SearchAny, SearchRegex, SearchAhoCorasick, SearchContains,
                             SearchEndsWith, SearchExact, SearchStartsWith>;
 
+// ============================================================================
+// FieldPath - путь к полю документа
+// ============================================================================
+
+/// Путь к полю (разделитель "."), разобранный один раз при загрузке правила:
+/// сегменты и путь целиком интернированы (ValueKey), поиск в документе не
+/// разбирает строку и не выделяет память
+class FieldPath {
+public:
+    FieldPath() = default;
+
+    /// Разобрать путь (неявно: узлы выражений создаются из строк)
+    FieldPath(std::string path);
+    FieldPath(const char* path) : FieldPath(std::string(path)) {}
+
+    /// Исходная строка пути
+    const std::string& str() const { return path_; }
+    operator const std::string&() const { return path_; }
+
+    /// Путь целиком как ключ (для таблиц отображения полей)
+    const ValueKey& key() const { return key_; }
+
+    /// Сегменты пути; пустой путь — поле не найдётся
+    const std::vector<ValueKey>& segments() const { return segments_; }
+
+    bool empty() const { return path_.empty(); }
+
+    bool operator==(std::string_view other) const { return path_ == other; }
+
+private:
+    std::string path_;
+    ValueKey key_;
+    std::vector<ValueKey> segments_;
+};
+
 // ============================================================================
 // Expression - AST выражений
 // ============================================================================
@@ -234,18 +277,18 @@ struct ExprNegate {
 
 /// Field access
 struct ExprField {
-    std::string name;
+    FieldPath name;
 };
 
 /// Cast (int(field), str(field), flt(field))
 struct ExprCast {
-    std::string field;
+    FieldPath field;
     ModSym mod;
 };
 
 /// Nested object access
 struct ExprNested {
-    std::string field;
+    FieldPath field;
     ExpressionPtr inner;
 };
 
@@ -258,13 +301,13 @@ struct ExprMatch {
 /// Search (search strategy on field)
 struct ExprSearch {
     Search search;
-    std::string field;
+    FieldPath field;
     bool cast_to_str;
 };
 
 /// Matrix (multi-field match)
 struct ExprMatrix {
-    std::vector<std::string> fields;
+    std::vector<FieldPath> fields;
     std::vector<std::pair<std::vector<Pattern>, bool>> rows;
 };
 
@@ -355,13 +398,53 @@ struct Detection {
 // Document - интерфейс документа для solver
 // ============================================================================
 
+/// Результат поиска поля: ссылка на значение внутри документа или значение,
+/// вычисленное при поиске (приведение типа, разбор контейнера)
+///
+/// Ссылка действительна, пока жив документ; вычисленное значение хранится в
+/// самом FieldRef.
+class FieldRef {
+public:
+    /// Поле не найдено
+    FieldRef() = default;
+
+    /// Ссылка на значение документа (nullptr — поле не найдено)
+    explicit FieldRef(const Value* borrowed) : borrowed_(borrowed) {}
+
+    /// Вычисленное значение
+    explicit FieldRef(Value owned) : owned_(std::move(owned)) {}
+
+    bool has_value() const { return owned_.has_value() || borrowed_ != nullptr; }
+    explicit operator bool() const { return has_value(); }
+
+    const Value* get() const { return owned_ ? &*owned_ : borrowed_; }
+    const Value& operator*() const { return *get(); }
+    const Value* operator->() const { return get(); }
+
+private:
+    const Value* borrowed_ = nullptr;
+    std::optional<Value> owned_;
+};
+
 /// Document trait - абстрактный интерфейс для поиска полей в документе
 class Document {
 public:
     virtual ~Document() = default;
 
-    /// Найти значение по ключу (поддержка dot-notation)
-    virtual std::optional<Value> find(std::string_view key) const = 0;
+    /// Найти значение по ключу (поддержка dot-notation) без копирования
+    virtual FieldRef lookup(std::string_view key) const = 0;
+
+    /// Найти значение по разобранному пути (по умолчанию — по строке пути)
+    virtual FieldRef resolve(const FieldPath& path) const { return lookup(path.str()); }
+
+    /// Копия найденного значения
+    std::optional<Value> find(std::string_view key) const {
+        auto found = lookup(key);
+        if (!found) {
+            return std::nullopt;
+        }
+        return *found;
+    }
 };
 
 /// ValueDocument - Document wrapper для Value
@@ -369,7 +452,8 @@ class ValueDocument : public Document {
 public:
     explicit ValueDocument(const Value& value) : value_(value) {}
 
-    std::optional<Value> find(std::string_view key) const override;
+    FieldRef lookup(std::string_view key) const override;
+    FieldRef resolve(const FieldPath& path) const override;
 
 private:
     const Value& value_;
@@ -385,6 +469,145 @@ bool solve(const Detection& detection, const Document& document);
 /// Решить Expression против Document
 bool solve(const Expression& expression, const Document& document);
 
+// ============================================================================
+// Program - байткод выражения
+// ============================================================================
+
+class Predicates;
+class PredicateMemo;
+
+/// Expression, скомпилированное в плоский массив инструкций
+///
+/// Узлы And/Or/Not в массив не попадают: у каждой проверки два адреса
+/// перехода — для истинного и ложного результата (short-circuit), поэтому
+/// вычисление — цикл по массиву без рекурсии и std::visit. Проверки без
+/// своей инструкции (Matrix, Cast, сравнения) вычисляются деревом.
+/// Результат solve(Program) совпадает с solve() исходного выражения.
+class Program {
+public:
+    /// Пустая программа: истинна для любого документа
+    Program() = default;
+
+    Program(Program&&) = default;
+    Program& operator=(Program&&) = default;
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    /// Число инструкций
+    std::size_t size() const { return code_.size(); }
+
+private:
+    friend Program compile_program(const Expression& expression,
+                                   const std::shared_ptr<Predicates>& shared);
+    friend bool solve(const Program& program, const Document& document);
+    friend bool solve(const Program& program, const Document& document, PredicateMemo& memo);
+
+    enum class Op : std::uint8_t {
+        Const,             // arg: результат (0/1)
+        Exists,            // поле есть и не null
+        SearchAny,         // поле есть (массив — непустой)
+        SearchRegex,       // arg: regexes_
+        SearchAho,         // arg: automata_
+        SearchContains,    // arg: strings_
+        SearchEndsWith,    // arg: strings_
+        SearchExact,       // arg: strings_
+        SearchStartsWith,  // arg: strings_
+        Match,             // arg: patterns_
+        Compare,           // arg: patterns_ (Field <op> число, без обхода массива)
+        Nested,            // arg: nested_
+        Tree,              // arg: leaves_
+        Shared,            // arg: номер проверки в shared_
+    };
+
+    /// Инструкция: проверка и адреса перехода; адрес size() — выражение
+    /// истинно, size() + 1 — ложно
+    struct Inst {
+        Op op;
+        std::uint32_t field;  // индекс в fields_
+        std::uint32_t arg;
+        std::uint32_t on_true;
+        std::uint32_t on_false;
+    };
+
+    class Compiler;
+
+    /// Выполнить программу (memo — результаты общих проверок или nullptr)
+    bool run(const Document& document, PredicateMemo* memo) const;
+
+    /// Выполнить одну проверку
+    bool test(const Inst& inst, const Document& document, PredicateMemo* memo) const;
+
+    std::vector<Inst> code_;
+    std::vector<FieldPath> fields_;
+    std::vector<std::string> strings_;
+    std::vector<RegexPtr> regexes_;
+    std::vector<std::shared_ptr<const AhoCorasick>> automata_;
+    std::vector<Pattern> patterns_;
+    std::vector<Expression> leaves_;
+    std::vector<Program> nested_;
+    std::shared_ptr<const Predicates> shared_;
+};
+
+/// Общие атомарные проверки (Search, Match, Exists) нескольких программ
+///
+/// Одинаковые проверки разных правил (`Image|endswith: \powershell.exe`,
+/// `EventID: 4688`) хранятся один раз, программы ссылаются на них по номеру.
+/// С PredicateMemo каждая проверка вычисляется для документа не больше
+/// одного раза, сколько бы правил её ни читали.
+class Predicates {
+public:
+    Predicates() = default;
+
+    Predicates(const Predicates&) = delete;
+    Predicates& operator=(const Predicates&) = delete;
+
+    /// Число различных проверок
+    std::size_t size() const { return pool_.size(); }
+
+private:
+    friend class Program;
+
+    Program pool_;  // по инструкции на проверку; адреса перехода не используются
+    std::unordered_map<std::string, std::uint32_t> index_;   // ключ проверки -> номер
+    std::unordered_map<std::string, std::uint32_t> fields_;  // поле -> pool_.fields_
+};
+
+/// Результаты общих проверок для одного документа (битовые множества)
+class PredicateMemo {
+public:
+    /// Память для всех проверок набора (набор после компиляции программ)
+    explicit PredicateMemo(const Predicates& predicates);
+
+    /// Забыть результаты: следующий документ или другое отображение полей
+    void clear();
+
+private:
+    friend class Program;
+
+    std::vector<std::uint64_t> known_;
+    std::vector<std::uint64_t> value_;
+};
+
+/// Скомпилировать Expression (после coalesce/shake/rewrite/matrix)
+Program compile_program(const Expression& expression);
+
+/// Скомпилировать Expression; атомарные проверки добавляются в shared
+/// (nullptr — без общих проверок)
+Program compile_program(const Expression& expression, const std::shared_ptr<Predicates>& shared);
+
+/// Скомпилировать Detection (identifiers подставляются, как в solve)
+Program compile_program(const Detection& detection);
+
+/// Скомпилировать Detection с общими проверками
+Program compile_program(const Detection& detection, const std::shared_ptr<Predicates>& shared);
+
+/// Решить скомпилированное выражение против Document
+bool solve(const Program& program, const Document& document);
+
+/// Решить против Document; общие проверки берутся из memo или вычисляются и
+/// запоминаются (memo должен быть очищен для нового документа)
+bool solve(const Program& program, const Document& document, PredicateMemo& memo);
+
 // ============================================================================
 // Parser - парсинг выражений
 // ============================================================================
@@ -442,6 +665,14 @@ Expression update_fields(Expression expr,
 /// ASCII lowercase (для case-insensitive сравнения)
 std::string ascii_lowercase(std::string_view str);
 
+/// Строка, с которой сравнивает Search: строка как есть, числа и bool —
+/// текстом, null — "null"
+std::string value_to_string(const Value& value);
+
+/// Число, с которым сравнивают числовые Pattern F* и Field <op> число: double, целые
+/// и строки (std::stod); остальное — nullopt
+std::optional<double> value_to_double(const Value& value);
+
 /// Case-insensitive string contains
 bool icontains(std::string_view haystack, std::string_view needle);
 
@@ -0,0 +1,42 @@
+// ==============================================================================
+// chainsaw/utf16.hpp - Перекодирование UTF-16LE → UTF-8
+// ==============================================================================
+//
+// MOD-0007 formats (общий код парсеров EVTX, HVE, MFT и shimcache)
+//
+// Назначение:
+// - Одна реализация перекодирования строк Windows (UTF-16LE) в UTF-8
+// - Быстрый путь для ASCII-отрезков на SSE2/AVX2 (выбор AVX2 во время выполнения),
+//   скалярная реализация для остальных платформ и не-ASCII символов
+//
+// Правила перекодирования:
+// - Суррогатная пара → 4 байта UTF-8
+// - Одиночный суррогат пропускается
+// - NUL внутри строки копируется как есть (обрезка по NUL — utf16le_length)
+//
+// ==============================================================================
+
+#ifndef CHAINSAW_UTF16_HPP
+#define CHAINSAW_UTF16_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace chainsaw::io {
+
+/// Длина строки в кодовых единицах до первого NUL (не больше units)
+/// @param data Данные UTF-16LE (не меньше units * 2 байт)
+std::size_t utf16le_length(const std::uint8_t* data, std::size_t units);
+
+/// Дописать в out ровно units кодовых единиц UTF-16LE, перекодированных в UTF-8
+/// @param data Данные UTF-16LE (не меньше units * 2 байт)
+void append_utf16le(std::string& out, const std::uint8_t* data, std::size_t units);
+
+/// Строка UTF-16LE до первого NUL в UTF-8
+/// @param byte_len Размер данных в байтах; нечётный или нулевой — пустая строка
+std::string utf16le_to_utf8(const std::uint8_t* data, std::size_t byte_len);
+
+}  // namespace chainsaw::io
+
+#endif  // CHAINSAW_UTF16_HPP
@@ -11,6 +11,10 @@
 // - Каноническое представление документа для pipeline (Value enum)
 // - Конверсия из/в RapidJSON Value
 // - Явная типизация чисел: UInt64 → Int64 → Double (FACT-027)
+// - Арена для контейнеров документа (ValueArena): массивы и объекты одного
+//   документа выделяются сдвигом указателя и освобождаются сбросом арены
+// - Компактные объекты (ValueObject): плоский массив пар с интернированными
+//   ключами (ValueKey) вместо хеш-таблицы
 //
 // Соответствие Rust:
 // - upstream/chainsaw/src/value.rs:8-18 (Value enum)
@@ -22,10 +26,18 @@
 #ifndef CHAINSAW_VALUE_HPP
 #define CHAINSAW_VALUE_HPP
 
+#include <atomic>
 #include <cstdint>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -58,11 +70,293 @@ namespace chainsaw {
 
 class Value;
 
+// ----------------------------------------------------------------------------
+// ValueArena - память для контейнеров документа
+// ----------------------------------------------------------------------------
+//
+// Массивы и объекты Value (узлы, буферы, блоки shared_ptr) берут память из
+// ресурса текущего потока: по умолчанию это куча, внутри ValueArena::Scope —
+// арена. Дерево из арены действительно до reset() или разрушения арены;
+// Value::owned() переносит его в кучу. Строки длиннее SSO по-прежнему в куче.
+//
+
+namespace detail {
+/// Ресурс для новых контейнеров Value в этом потоке (nullptr — куча)
+inline thread_local std::pmr::memory_resource* value_resource = nullptr;
+}  // namespace detail
+
+/// Аллокатор контейнеров Value: запоминает ресурс потока при создании контейнера
+template <typename T>
+class ValueAllocator {
+public:
+    using value_type = T;
+
+    ValueAllocator() noexcept
+        : resource_(detail::value_resource ? detail::value_resource
+                                           : std::pmr::new_delete_resource()) {}
+
+    explicit ValueAllocator(std::pmr::memory_resource* resource) noexcept : resource_(resource) {}
+
+    template <typename U>
+    ValueAllocator(const ValueAllocator<U>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /// Копия контейнера живёт в памяти текущего потока, а не в памяти оригинала
+    ValueAllocator select_on_container_copy_construction() const { return ValueAllocator(); }
+
+    std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
+    /// Контейнер в куче (не в арене)
+    bool on_heap() const noexcept { return resource_ == std::pmr::new_delete_resource(); }
+
+    template <typename U>
+    bool operator==(const ValueAllocator<U>& other) const noexcept {
+        return resource_ == other.resource();
+    }
+
+private:
+    std::pmr::memory_resource* resource_;
+};
+
+/// Арена: выделение сдвигом указателя, освобождение — только сбросом целиком
+///
+/// Блоки сохраняются между документами, поэтому после первых записей
+/// декодирование не обращается к malloc за контейнерами.
+class ValueArena : public std::pmr::memory_resource {
+public:
+    /// Контейнеры Value, создаваемые в этом потоке, пока жив Scope, — в resource
+    class Scope {
+    public:
+        explicit Scope(std::pmr::memory_resource* resource) : previous_(detail::value_resource) {
+            detail::value_resource = resource;
+        }
+        ~Scope() { detail::value_resource = previous_; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::pmr::memory_resource* previous_;
+    };
+
+    explicit ValueArena(std::size_t block_size = 64 * 1024) : block_size_(block_size) {}
+
+    ValueArena(const ValueArena&) = delete;
+    ValueArena& operator=(const ValueArena&) = delete;
+
+    /// Освободить всё выделенное (значения из арены становятся недействительными)
+    void reset();
+
+    /// Занято байт (с учётом выравнивания, без незаполненных хвостов блоков)
+    std::size_t used() const { return used_; }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    /// Перейти к следующему блоку (или выделить отдельный для крупного запроса)
+    void* allocate_slow(std::size_t bytes, std::size_t alignment);
+
+    std::size_t block_size_;
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::vector<std::unique_ptr<std::byte[]>> large_;  ///< Освобождаются при reset()
+    std::size_t block_ = 0;                            ///< Текущий блок
+    std::byte* ptr_ = nullptr;
+    std::byte* end_ = nullptr;
+    std::size_t used_ = 0;
+};
+
+// ----------------------------------------------------------------------------
+// ValueKey - интернированный ключ объекта
+// ----------------------------------------------------------------------------
+
+/// Ключ объекта — номер строки в глобальной таблице: сравнение ключей сводится
+/// к сравнению чисел
+///
+/// Таблица общая для всех потоков: строки не освобождаются до конца работы
+/// программы. Имена полей повторяются от документа к документу, а ключи из
+/// данных (GUID, пути) — нет, поэтому в таблице не больше MAX_INTERNED строк;
+/// следующие ключи хранят свой текст сами и сравниваются по тексту.
+class ValueKey {
+public:
+    /// Предел таблицы ключей
+    static constexpr std::size_t MAX_INTERNED = std::size_t{1} << 18;
+
+    /// Номер неинтернированного ключа
+    static constexpr std::uint32_t UNINTERNED = ~std::uint32_t{0};
+
+    /// Пустой ключ ("")
+    ValueKey() = default;
+
+    /// Интернировать строку (после MAX_INTERNED — ключ с собственным текстом)
+    explicit ValueKey(std::string_view text);
+
+    ValueKey(const ValueKey& other) : bits_(other.bits_) {
+        if (!other.interned()) {
+            bits_ = own(other.owned());
+        }
+    }
+    ValueKey(ValueKey&& other) noexcept : bits_(std::exchange(other.bits_, EMPTY)) {}
+    ValueKey& operator=(const ValueKey& other) {
+        if (this != &other) {
+            *this = ValueKey(other);
+        }
+        return *this;
+    }
+    ValueKey& operator=(ValueKey&& other) noexcept {
+        std::swap(bits_, other.bits_);
+        return *this;
+    }
+    ~ValueKey() {
+        if (!interned()) {
+            delete &owned();
+        }
+    }
+
+    /// Ключ уже интернированной строки (таблица не пополняется)
+    static std::optional<ValueKey> find(std::string_view text);
+
+    /// Текст ключа
+    const std::string& str() const;
+
+    /// Ключ из таблицы (иначе текст хранится в ключе)
+    bool interned() const { return (bits_ & 1) != 0; }
+
+    /// Номер в таблице; UNINTERNED — ключ вне таблицы
+    std::uint32_t id() const {
+        return interned() ? static_cast<std::uint32_t>(bits_ >> 1) : UNINTERNED;
+    }
+
+    bool operator==(const ValueKey& other) const {
+        return bits_ == other.bits_ || (!interned() && !other.interned() &&
+                                        owned() == other.owned());
+    }
+
+private:
+    /// Номер n хранится как 2n + 1, собственный текст — указателем (чётным)
+    static constexpr std::uintptr_t EMPTY = 1;
+
+    struct Id {
+        std::uint32_t value;
+    };
+    explicit ValueKey(Id id) : bits_((std::uintptr_t{id.value} << 1) | 1) {}
+
+    static std::uintptr_t own(std::string_view text) {
+        return reinterpret_cast<std::uintptr_t>(new std::string(text));
+    }
+    const std::string& owned() const { return *reinterpret_cast<const std::string*>(bits_); }
+
+    std::uintptr_t bits_ = EMPTY;
+};
+
 /// Тип для массива значений
-using ValueArray = std::vector<Value>;
+using ValueArray = std::vector<Value, ValueAllocator<Value>>;
 
-/// Тип для объекта (map string -> Value)
-using ValueObject = std::unordered_map<std::string, Value>;
+// ----------------------------------------------------------------------------
+// ValueObject - объект (ключ → Value)
+// ----------------------------------------------------------------------------
+//
+// SPEC-SLICE-005 FACT-026: объект неупорядоченный, порядок обхода — порядок
+// std::unordered_map<std::string, Value> после тех же вставок. Пары хранятся в
+// порядке вставки; порядок обхода вычисляется один раз на набор ключей (форму
+// объекта) и кешируется, поэтому JSON вывод совпадает с прежним представлением.
+// Кеш форм ограничен: порядок остальных форм хранит сам объект.
+//
+
+/// Объект: плоский массив (ключ, значение) с линейным поиском по номеру ключа
+/// (для больших объектов — по индексу). Удаление ключей не поддерживается.
+class ValueObject {
+public:
+    struct Entry;
+    template <bool Const>
+    class basic_iterator;
+
+    using key_type = std::string;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    using allocator_type = ValueAllocator<Entry>;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    ValueObject() = default;
+    explicit ValueObject(const allocator_type& alloc) : entries_(alloc) {}
+    ValueObject(std::initializer_list<std::pair<const std::string, Value>> init);
+    ValueObject(const ValueObject& other);
+    ValueObject(const ValueObject& other, const allocator_type& alloc);
+    ValueObject(ValueObject&& other) noexcept;
+    ValueObject& operator=(const ValueObject& other);
+    ValueObject& operator=(ValueObject&& other) noexcept;
+    ~ValueObject();
+
+    size_type size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    allocator_type get_allocator() const { return entries_.get_allocator(); }
+    void reserve(size_type n) { entries_.reserve(n); }
+    void clear();
+
+    /// Значение по ключу (вставляет Null, если ключа нет)
+    Value& operator[](const ValueKey& key);
+    Value& operator[](std::string_view key) { return (*this)[ValueKey(key)]; }
+
+    /// Значение по ключу (nullptr, если ключа нет)
+    Value* lookup(const ValueKey& key);
+    const Value* lookup(const ValueKey& key) const;
+    const Value* lookup(std::string_view key) const;
+
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    size_type count(std::string_view key) const { return lookup(key) ? 1 : 0; }
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /// Предел общего кеша порядков обхода (формы объектов из данных его не растят)
+    static constexpr size_type ORDER_CACHE_BYTES = size_type{4} << 20;
+
+    /// Занято в общем кеше порядков обхода, байт (не больше ORDER_CACHE_BYTES)
+    static size_type order_cache_bytes();
+
+private:
+    /// Большие объекты ищут ключ по индексу (номер ключа → позиция)
+    static constexpr size_type INDEX_THRESHOLD = 64;
+    using Index = std::unordered_map<std::uint32_t, std::uint32_t>;
+
+    /// Позиция ключа в entries_ (size() — нет ключа)
+    size_type position(const ValueKey& key) const;
+    size_type position(std::string_view key) const;
+
+    /// Порядок обхода: позиции entries_ (nullptr — порядок вставки)
+    const std::uint32_t* order() const;
+
+    /// Порядок обхода из общего кеша, который можно разделить с копией
+    const std::uint32_t* shared_order() const;
+
+    /// Позиция ключа в порядке обхода
+    size_type order_position(size_type index) const;
+
+    void build_index();
+
+    /// Забыть порядок обхода (ключи изменились)
+    void reset_order();
+
+    std::vector<Entry, allocator_type> entries_;
+    std::unique_ptr<Index> index_;
+    mutable std::atomic<const std::uint32_t*> order_{nullptr};
+    /// Порядок, не попавший в общий кеш (order_ указывает на него); владеет объект
+    mutable std::atomic<std::uint32_t*> own_order_{nullptr};
+};
 
 /// Каноническое представление документа
 /// Аналог Rust Value enum (value.rs:8-18)
@@ -110,11 +404,13 @@ public:
     /// Создать String значение из C-строки
     explicit Value(const char* v) : data_(std::string(v)) {}
 
-    /// Создать Array значение
-    explicit Value(Array v) : data_(std::make_shared<Array>(std::move(v))) {}
+    /// Создать Array значение (блок shared_ptr — в памяти самого массива)
+    explicit Value(Array v)
+        : data_(std::allocate_shared<Array>(ValueAllocator<Array>(v.get_allocator()),
+                                            std::move(v))) {}
 
-    /// Создать Object значение
-    explicit Value(Object v) : data_(std::make_shared<Object>(std::move(v))) {}
+    /// Создать Object значение (блок shared_ptr — в памяти самого объекта)
+    explicit Value(Object v);
 
     // -------------------------------------------------------------------------
     // Статические фабричные методы
@@ -259,30 +555,20 @@ public:
     // -------------------------------------------------------------------------
 
     /// Установить поле объекта (только если is_object())
-    void set(const std::string& key, Value v) {
+    void set(std::string_view key, Value v) {
         if (auto* obj = get_object_mut()) {
             (*obj)[key] = std::move(v);
         }
     }
 
     /// Получить поле объекта по ключу (nullptr если не найдено или не объект)
-    const Value* get(const std::string& key) const {
-        if (const auto* obj = get_object()) {
-            auto it = obj->find(key);
-            if (it != obj->end()) {
-                return &it->second;
-            }
-        }
-        return nullptr;
-    }
+    const Value* get(std::string_view key) const;
+
+    /// Получить поле объекта по интернированному ключу
+    const Value* get(const ValueKey& key) const;
 
     /// Проверить наличие ключа в объекте
-    bool has(const std::string& key) const {
-        if (const auto* obj = get_object()) {
-            return obj->find(key) != obj->end();
-        }
-        return false;
-    }
+    bool has(std::string_view key) const { return get(key) != nullptr; }
 
     /// Размер объекта (0 если не объект)
     std::size_t object_size() const {
@@ -292,6 +578,14 @@ public:
         return 0;
     }
 
+    // -------------------------------------------------------------------------
+    // Владение памятью
+    // -------------------------------------------------------------------------
+
+    /// Значение, не ссылающееся на арену: контейнеры из арены копируются в кучу
+    /// (порядок обхода объектов сохраняется), поддеревья в куче разделяются
+    Value owned() const;
+
     // -------------------------------------------------------------------------
     // Конверсия из RapidJSON
     // -------------------------------------------------------------------------
@@ -323,6 +617,156 @@ private:
     }
 };
 
+// ----------------------------------------------------------------------------
+// ValueObject - определения, которым нужен полный Value
+// ----------------------------------------------------------------------------
+
+struct ValueObject::Entry {
+    /// Значение создаётся на месте (Null)
+    explicit Entry(ValueKey k) : key(std::move(k)) {}
+
+    ValueKey key;
+    Value value;
+};
+
+/// Итератор объекта: элементы — пары (текст ключа, значение) в порядке обхода
+template <bool Const>
+class ValueObject::basic_iterator {
+public:
+    using entry_pointer = std::conditional_t<Const, const Entry*, Entry*>;
+    using value_reference = std::conditional_t<Const, const Value&, Value&>;
+    using reference = std::pair<const std::string&, value_reference>;
+    using value_type = reference;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    /// Для it->first / it->second
+    struct pointer {
+        reference pair;
+        const reference* operator->() const { return &pair; }
+    };
+
+    basic_iterator() = default;
+    basic_iterator(entry_pointer entries, const std::uint32_t* order, std::size_t pos)
+        : entries_(entries), order_(order), pos_(pos) {}
+
+    operator basic_iterator<true>() const
+        requires(!Const)
+    {
+        return {entries_, order_, pos_};
+    }
+
+    reference operator*() const {
+        auto& item = entry();
+        return {item.key.str(), item.value};
+    }
+    pointer operator->() const { return {**this}; }
+
+    /// Интернированный ключ элемента
+    const ValueKey& key() const { return entry().key; }
+
+    basic_iterator& operator++() {
+        ++pos_;
+        return *this;
+    }
+    basic_iterator operator++(int) {
+        auto copy = *this;
+        ++pos_;
+        return copy;
+    }
+
+    bool operator==(const basic_iterator& other) const { return pos_ == other.pos_; }
+
+private:
+    auto& entry() const { return entries_[order_ ? order_[pos_] : pos_]; }
+
+    entry_pointer entries_ = nullptr;
+    const std::uint32_t* order_ = nullptr;
+    std::size_t pos_ = 0;
+};
+
+inline Value::Value(Object v)
+    : data_(std::allocate_shared<Object>(ValueAllocator<Object>(v.get_allocator()),
+                                         std::move(v))) {}
+
+inline Value* ValueObject::lookup(const ValueKey& key) {
+    auto pos = position(key);
+    return pos < entries_.size() ? &entries_[pos].value : nullptr;
+}
+
+inline const Value* ValueObject::lookup(const ValueKey& key) const {
+    auto pos = position(key);
+    return pos < entries_.size() ? &entries_[pos].value : nullptr;
+}
+
+inline ValueObject::size_type ValueObject::position(const ValueKey& key) const {
+    if (index_ && key.interned()) {
+        auto it = index_->find(key.id());
+        return it != index_->end() ? it->second : entries_.size();
+    }
+    size_type pos = 0;
+    while (pos < entries_.size() && !(entries_[pos].key == key)) {
+        ++pos;
+    }
+    return pos;
+}
+
+inline const Value* Value::get(const ValueKey& key) const {
+    const auto* obj = get_object();
+    return obj ? obj->lookup(key) : nullptr;
+}
+
+inline const Value* Value::get(std::string_view key) const {
+    const auto* obj = get_object();
+    return obj ? obj->lookup(key) : nullptr;
+}
+
+// ----------------------------------------------------------------------------
+// FieldProjection - проекция полей документа
+// ----------------------------------------------------------------------------
+
+/// Дерево путей к полям (разделитель "."), которые нужны потребителю документа
+///
+/// Путь включает всё своё поддерево. Декодеры могут не строить ключи вне
+/// проекции; ключи внутри проекции строятся так же, как без неё.
+class FieldProjection {
+public:
+    /// Все поля (без ограничений)
+    FieldProjection() = default;
+
+    /// Только перечисленные пути
+    explicit FieldProjection(const std::vector<std::string>& paths);
+
+    FieldProjection(FieldProjection&&) = default;
+    FieldProjection& operator=(FieldProjection&&) = default;
+    FieldProjection(const FieldProjection&) = delete;
+    FieldProjection& operator=(const FieldProjection&) = delete;
+
+    /// Нужно всё поддерево
+    bool all() const { return all_; }
+
+    /// Не нужно ни одно поле
+    bool empty() const { return !all_ && children_.empty(); }
+
+    /// Проекция значения по ключу (пустая, если ключ не нужен)
+    const FieldProjection& child(std::string_view key) const;
+
+private:
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+
+    /// Добавить путь (оставшиеся сегменты)
+    void include(std::string_view path);
+
+    bool all_ = true;
+    std::unordered_map<std::string, std::unique_ptr<FieldProjection>, KeyHash, std::equal_to<>>
+        children_;
+};
+
 }  // namespace chainsaw
 
 #if defined(__GNUC__) && !defined(__clang__)
@@ -22,7 +22,9 @@
 #include <cctype>
 #include <chainsaw/hve.hpp>
 #include <chainsaw/platform.hpp>
+#include <chainsaw/regex.hpp>
 #include <chainsaw/shimcache.hpp>
+#include <chainsaw/utf16.hpp>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
@@ -66,54 +68,6 @@ std::chrono::system_clock::time_point filetime_to_timepoint(std::uint64_t fileti
                                                  std::chrono::microseconds{unix_micros}};
 }
 
-/// Конвертировать UTF-16LE в UTF-8
-std::string utf16le_to_utf8(const std::uint8_t* data, std::size_t byte_len) {
-    if (byte_len == 0 || byte_len % 2 != 0) {
-        return {};
-    }
-    std::string result;
-    result.reserve(byte_len / 2);
-    for (std::size_t i = 0; i < byte_len; i += 2) {
-        std::uint16_t wchar = read_u16_le(data + i);
-        if (wchar == 0)
-            break;
-        if (wchar < 0x80) {
-            result.push_back(static_cast<char>(wchar));
-        } else if (wchar < 0x800) {
-            result.push_back(static_cast<char>(0xC0 | (wchar >> 6)));
-            result.push_back(static_cast<char>(0x80 | (wchar & 0x3F)));
-        } else if (wchar >= 0xD800 && wchar <= 0xDBFF) {
-            // High surrogate - handle surrogate pairs for characters above U+FFFF
-            if (i + 2 < byte_len) {
-                std::uint16_t low_surrogate = read_u16_le(data + i + 2);
-                if (low_surrogate >= 0xDC00 && low_surrogate <= 0xDFFF) {
-                    // Valid surrogate pair
-                    std::uint32_t codepoint =
-                        0x10000 + ((static_cast<std::uint32_t>(wchar - 0xD800) << 10) |
-                                   (low_surrogate - 0xDC00));
-                    // 4-byte UTF-8
-                    result.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
-                    result.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
-                    result.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
-                    result.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
-                    i += 2;  // Skip low surrogate in next iteration
-                    continue;
-                }
-            }
-            // Invalid surrogate pair - skip
-            continue;
-        } else if (wchar >= 0xDC00 && wchar <= 0xDFFF) {
-            // Lone low surrogate - skip
-            continue;
-        } else {
-            result.push_back(static_cast<char>(0xE0 | (wchar >> 12)));
-            result.push_back(static_cast<char>(0x80 | ((wchar >> 6) & 0x3F)));
-            result.push_back(static_cast<char>(0x80 | (wchar & 0x3F)));
-        }
-    }
-    return result;
-}
-
 /// Привести строку к нижнему регистру
 std::string to_lowercase(const std::string& str) {
     std::string result = str;
@@ -261,7 +215,7 @@ std::vector<ShimcacheEntry> parse_windows10_cache_from_offset(
         // Path (UTF-16LE)
         if (index + path_size > bytes.size())
             break;
-        std::string path = utf16le_to_utf8(&bytes[index], path_size);
+        std::string path = io::utf16le_to_utf8(&bytes[index], path_size);
         index += path_size;
 
         // Last modified timestamp
@@ -384,7 +338,7 @@ std::vector<ShimcacheEntry> parse_windows7x64_cache(const std::vector<std::uint8
         // Read path
         std::string path;
         if (path_offset + path_size <= bytes.size()) {
-            path = utf16le_to_utf8(&bytes[path_offset], path_size);
+            path = io::utf16le_to_utf8(&bytes[path_offset], path_size);
             // Remove \??\ prefix
             if (path.size() >= 4 && path.substr(0, 4) == "\\??\\") {
                 path = path.substr(4);
@@ -469,7 +423,7 @@ std::vector<ShimcacheEntry> parse_windows7x86_cache(const std::vector<std::uint8
 
         std::string path;
         if (path_offset + path_size <= bytes.size()) {
-            path = utf16le_to_utf8(&bytes[path_offset], path_size);
+            path = io::utf16le_to_utf8(&bytes[path_offset], path_size);
             if (path.size() >= 4 && path.substr(0, 4) == "\\??\\") {
                 path = path.substr(4);
             }
@@ -550,7 +504,7 @@ std::vector<ShimcacheEntry> parse_windows8_cache(const std::vector<std::uint8_t>
         // Path
         if (index + path_size > bytes.size())
             break;
-        std::string path = utf16le_to_utf8(&bytes[index], path_size);
+        std::string path = io::utf16le_to_utf8(&bytes[index], path_size);
         index += path_size;
 
         // Package length
@@ -1177,12 +1131,12 @@ std::variant<std::vector<TimelineEntity>, ShimcacheError>
 ShimcacheAnalyser::amcache_shimcache_timeline(const std::vector<std::string>& regex_patterns,
                                               bool ts_near_pair_matching) {
     // Компилируем regex паттерны
-    std::vector<std::regex> regexes;
+    std::vector<tau::RegexPtr> regexes;
     regexes.reserve(regex_patterns.size());
     for (const auto& pattern : regex_patterns) {
         try {
-            regexes.emplace_back(pattern, std::regex::icase);
-        } catch (const std::regex_error& e) {
+            regexes.push_back(tau::compile_regex(pattern, true));
+        } catch (const tau::RegexError& e) {
             impl_->last_error = ShimcacheError{ShimcacheErrorKind::ParseError,
                                                std::string("Invalid regex pattern: ") + e.what()};
             return *impl_->last_error;
@@ -1246,7 +1200,7 @@ ShimcacheAnalyser::amcache_shimcache_timeline(const std::vector<std::string>& re
         std::string path_lower = to_lowercase(path);
 
         for (const auto& re : regexes) {
-            if (std::regex_search(path_lower, re)) {
+            if (re->search(path_lower)) {
                 if (entry.last_modified_ts) {
                     entity.timestamp = TimelineTimestamp::make_exact(*entry.last_modified_ts,
                                                                      TimestampType::PatternMatch);
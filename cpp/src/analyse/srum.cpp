@@ -195,7 +195,7 @@ std::optional<SrumDbInfo> SrumAnalyser::parse_srum_database() {
     std::map<std::string, TableDetails> table_data_details;
 
     // SPEC-SLICE-017 FACT-042: Process each extension
-    for (auto& [table_guid, extension] : *srum_ext_obj) {
+    for (const auto& [table_guid, extension] : *srum_ext_obj) {
         auto* ext_obj = extension.get_object();
         if (!ext_obj)
             continue;
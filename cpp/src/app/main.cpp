@@ -16,6 +16,7 @@
 // ==============================================================================
 
 #include "chainsaw/cli.hpp"
+#include "chainsaw/detection_cache.hpp"
 #include "chainsaw/discovery.hpp"
 #include "chainsaw/hunt.hpp"
 #include "chainsaw/output.hpp"
@@ -27,15 +28,24 @@
 #include "chainsaw/srum.hpp"
 #include "chainsaw/tau.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -64,13 +74,211 @@ void print_banner(chainsaw::output::Writer& writer, bool no_banner, bool quiet)
     writer.write_line(chainsaw::output::Stream::Stderr, "");
 }
 
+// ----------------------------------------------------------------------------
+// Потоки декодирования файлов (--num-threads; 0 — по числу CPU)
+// ----------------------------------------------------------------------------
+
+std::size_t decode_threads(const chainsaw::cli::GlobalOptions& global) {
+    if (global.num_threads > 0) {
+        return static_cast<std::size_t>(global.num_threads);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// ----------------------------------------------------------------------------
+// Параллельная обработка файлов (--num-threads)
+// ----------------------------------------------------------------------------
+
+/// Результаты одного файла: рабочий поток добавляет, главный забирает по порядку.
+/// Неотданные результаты ограничены по объёму: файл, до которого вывод ещё не
+/// дошёл, ждёт, пока главный поток не начнёт его забирать
+template <typename T>
+class FileResults {
+public:
+    /// Добавить результат; false — вывод остановлен, файл можно не дочитывать
+    bool push(T item, std::size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [this] { return stopped_ || pending_ < BUDGET; });
+        if (stopped_) {
+            return false;
+        }
+        pending_ += bytes;
+        items_.emplace_back(std::move(item), bytes);
+        ready_.notify_one();
+        return true;
+    }
+
+    /// Файл обработан
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        ready_.notify_one();
+    }
+
+    /// Следующий результат; false — файл обработан и результаты кончились
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front().first);
+        pending_ -= items_.front().second;
+        items_.pop_front();
+        space_.notify_one();
+        return true;
+    }
+
+    /// Вывод остановлен: результаты отбрасываются, рабочий поток не ждёт
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        items_.clear();
+        space_.notify_one();
+    }
+
+private:
+    static constexpr std::size_t BUDGET = 16u << 20;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<std::pair<T, std::size_t>> items_;
+    std::size_t pending_ = 0;
+    bool closed_ = false;
+    bool stopped_ = false;
+};
+
+/// Обработать файлы пулом потоков: produce(file, threads, emit) читает файл и
+/// передаёт результаты в emit(item, bytes), consume(file, item) выводит их в
+/// порядке files — вывод совпадает с последовательным. Потоков на файлы не
+/// больше, чем файлов; остальные потоки декодируют файл изнутри (EVTX чанки).
+/// @return false, если consume вернул false (обработка прекращена)
+template <typename T, typename Produce, typename Consume>
+bool for_each_file(const std::vector<std::filesystem::path>& files, std::size_t threads,
+                   Produce produce, Consume consume) {
+    const std::size_t workers = std::max<std::size_t>(1, std::min(threads, files.size()));
+    const std::size_t decode = std::max<std::size_t>(1, threads / workers);
+
+    // Один поток на файлы: обработка в текущем потоке, результаты выводятся сразу
+    if (workers == 1) {
+        for (const auto& file : files) {
+            bool stopped = false;
+            produce(file, decode, [&](T item, std::size_t) {
+                stopped = stopped || !consume(file, std::move(item));
+                return !stopped;
+            });
+            if (stopped) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<FileResults<T>> results(files.size());
+    std::vector<std::exception_ptr> errors(files.size());
+
+    chainsaw::platform::TaskPool pool(files.size(), workers, workers * 2, [&](std::size_t i) {
+        try {
+            produce(files[i], decode, [&results, i](T item, std::size_t bytes) {
+                return results[i].push(std::move(item), bytes);
+            });
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+        results[i].close();
+    });
+
+    // При выходе (в том числе досрочном) освободить ждущие рабочие потоки до join
+    struct Stop {
+        std::vector<FileResults<T>>& results;
+        ~Stop() {
+            for (auto& file : results) {
+                file.stop();
+            }
+        }
+    } stop{results};
+
+    T item;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        while (results[i].pop(item)) {
+            if (!consume(files[i], std::move(item))) {
+                return false;
+            }
+        }
+        pool.release(i);
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // Выполнение команд (заглушки для )
 // ----------------------------------------------------------------------------
 
+/// Порция вывода dump одного файла
+struct DumpChunk {
+    std::string text;
+    std::string warning;  // --skip-errors: предупреждение после текста
+    std::string error;    // ошибка файла: вывод прекращается
+};
+
+/// Порция вывода hunt одного файла: отформатированные детектирования
+struct HuntChunk {
+    std::string text;
+    std::size_t count = 0;  // детектирований в text
+    bool first = false;     // первая порция файла
+    bool failed = false;    // ошибка файла после text
+    std::string error;
+};
+
+/// Размер порции вывода dump и hunt
+constexpr std::size_t OUTPUT_CHUNK_BYTES = 256u << 10;
+
+/// Разделитель документов JSON-массива (перед каждым, кроме первого)
+constexpr std::string_view JSON_SEPARATOR = ",\n";
+
+/// Дописать документ в формате dump (--json, --jsonl или YAML)
+void append_dump_document(const chainsaw::cli::DumpCommand& cmd,
+                          const chainsaw::io::Document& doc, std::string& text) {
+    // SPEC-SLICE-013 FACT-015, FACT-016: Извлечение данных из Document
+    // Для всех типов Document данные находятся в doc.data
+
+    // Конвертируем Value в RapidJSON для вывода
+    rapidjson::Document rjdoc;
+    doc.data.to_rapidjson(rjdoc, rjdoc.GetAllocator());
+
+    rapidjson::StringBuffer buffer;
+    if (cmd.json) {
+        // SPEC-SLICE-013 FACT-006, FACT-009: JSON массив с pretty-printing;
+        // разделитель у первого документа снимает вывод
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
+        rj_writer.SetIndent(' ', 2);
+        rjdoc.Accept(rj_writer);
+        text += JSON_SEPARATOR;
+        text.append(buffer.GetString(), buffer.GetSize());
+    } else if (cmd.jsonl) {
+        // SPEC-SLICE-013 FACT-007: JSONL — compact JSON по строкам
+        rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
+        rjdoc.Accept(rj_writer);
+        text.append(buffer.GetString(), buffer.GetSize());
+        text += '\n';
+    } else {
+        // SPEC-SLICE-013 FACT-008: YAML формат (default) — разделитель "---"
+        // YAML-like pretty JSON output
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
+        rj_writer.SetIndent(' ', 2);
+        rjdoc.Accept(rj_writer);
+        text += "---\n";
+        text.append(buffer.GetString(), buffer.GetSize());
+        text += '\n';
+    }
+}
+
 int run_dump(const chainsaw::cli::DumpCommand& cmd, const chainsaw::cli::GlobalOptions& global,
              chainsaw::output::Writer& writer) {
-    (void)global;
     using namespace chainsaw;
 
     // SPEC-SLICE-013 FACT-001: Dump требует хотя бы один path
@@ -153,69 +361,45 @@ int run_dump(const chainsaw::cli::DumpCommand& cmd, const chainsaw::cli::GlobalO
     // SPEC-SLICE-013 FACT-009: Флаг для запятой между элементами JSON
     bool first = true;
 
-    // SPEC-SLICE-013 FACT-010, FACT-011: Последовательная обработка файлов и документов
-    for (const auto& file : files) {
+    // SPEC-SLICE-013 FACT-010, FACT-011: Файлы читаются параллельно, документы
+    // выводятся в порядке файлов и внутри файла — как при последовательной обработке
+    auto dump_file = [&cmd](const std::filesystem::path& file, std::size_t threads,
+                            auto&& emit) {
         // Открываем Reader
-        auto result = io::Reader::open(file, cmd.load_unknown, cmd.skip_errors);
+        io::ReaderOptions reader_options;
+        reader_options.load_unknown = cmd.load_unknown;
+        reader_options.skip_errors = cmd.skip_errors;
+        reader_options.evtx_threads = threads;
+        reader_options.value_arena = true;  // Документ форматируется сразу
+        auto result = io::Reader::open(file, reader_options);
         if (!result.ok) {
+            DumpChunk chunk;
             if (cmd.skip_errors) {
-                writer.warn("failed to load file '" + platform::path_to_utf8(file) + "' - " +
-                            result.error.message);
-                continue;
+                chunk.warning = "failed to load file '" + platform::path_to_utf8(file) + "' - " +
+                                result.error.message;
+            } else {
+                chunk.error = result.error.format();
             }
-            writer.error(result.error.format());
-            return 1;
+            emit(std::move(chunk), 0);
+            return;
         }
 
         if (!result.reader) {
-            continue;
+            return;
         }
 
         auto& reader = *result.reader;
 
-        // Итерация по документам
+        // Итерация по документам; текст передаётся порциями
+        DumpChunk chunk;
         io::Document doc;
         while (reader.next(doc)) {
-            // SPEC-SLICE-013 FACT-015, FACT-016: Извлечение данных из Document
-            // Для всех типов Document данные находятся в doc.data
-
-            // Конвертируем Value в RapidJSON для вывода
-            rapidjson::Document rjdoc;
-            doc.data.to_rapidjson(rjdoc, rjdoc.GetAllocator());
-
-            if (cmd.json) {
-                // SPEC-SLICE-013 FACT-006, FACT-009: JSON массив с pretty-printing
-                if (first) {
-                    first = false;
-                } else {
-                    out->write_line(output::Stream::Stdout, ",");
+            append_dump_document(cmd, doc, chunk.text);
+            if (chunk.text.size() >= OUTPUT_CHUNK_BYTES) {
+                std::size_t bytes = chunk.text.size();
+                if (!emit(std::exchange(chunk, DumpChunk{}), bytes)) {
+                    return;
                 }
-
-                // Pretty JSON
-                rapidjson::StringBuffer buffer;
-                rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
-                rj_writer.SetIndent(' ', 2);
-                rjdoc.Accept(rj_writer);
-                out->write(output::Stream::Stdout,
-                           std::string_view(buffer.GetString(), buffer.GetSize()));
-            } else if (cmd.jsonl) {
-                // SPEC-SLICE-013 FACT-007: JSONL — compact JSON по строкам
-                rapidjson::StringBuffer buffer;
-                rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
-                rjdoc.Accept(rj_writer);
-                out->write_line(output::Stream::Stdout,
-                                std::string_view(buffer.GetString(), buffer.GetSize()));
-            } else {
-                // SPEC-SLICE-013 FACT-008: YAML формат (default) — разделитель "---"
-                out->write_line(output::Stream::Stdout, "---");
-
-                // YAML-like pretty JSON output
-                rapidjson::StringBuffer buffer;
-                rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
-                rj_writer.SetIndent(' ', 2);
-                rjdoc.Accept(rj_writer);
-                out->write_line(output::Stream::Stdout,
-                                std::string_view(buffer.GetString(), buffer.GetSize()));
             }
         }
 
@@ -223,13 +407,37 @@ int run_dump(const chainsaw::cli::DumpCommand& cmd, const chainsaw::cli::GlobalO
         const auto& err = reader.last_error();
         if (err.has_value()) {
             if (cmd.skip_errors) {
-                writer.warn("failed to parse document '" + platform::path_to_utf8(file) + "' - " +
-                            err->message);
+                chunk.warning = "failed to parse document '" + platform::path_to_utf8(file) +
+                                "' - " + err->message;
             } else {
-                writer.error(err->format());
-                return 1;
+                chunk.error = err->format();
             }
         }
+        std::size_t bytes = chunk.text.size();
+        emit(std::move(chunk), bytes);
+    };
+
+    bool completed = for_each_file<DumpChunk>(
+        files, decode_threads(global), dump_file,
+        [&](const std::filesystem::path&, DumpChunk chunk) {
+            std::string_view text = chunk.text;
+            // SPEC-SLICE-013 FACT-009: у первого документа JSON нет разделителя
+            if (cmd.json && first && !text.empty()) {
+                text.remove_prefix(JSON_SEPARATOR.size());
+                first = false;
+            }
+            out->write(output::Stream::Stdout, text);
+            if (!chunk.warning.empty()) {
+                writer.warn(chunk.warning);
+            }
+            if (!chunk.error.empty()) {
+                writer.error(chunk.error);
+                return false;
+            }
+            return true;
+        });
+    if (!completed) {
+        return 1;
     }
 
     // SPEC-SLICE-013 FACT-006: JSON формат заканчивается "]"
@@ -243,7 +451,6 @@ int run_dump(const chainsaw::cli::DumpCommand& cmd, const chainsaw::cli::GlobalO
 
 int run_hunt(const chainsaw::cli::HuntCommand& cmd, const chainsaw::cli::GlobalOptions& global,
              chainsaw::output::Writer& writer) {
-    (void)global;
     using namespace chainsaw;
 
     // SPEC-SLICE-012: строим Hunter через builder
@@ -285,8 +492,12 @@ int run_hunt(const chainsaw::cli::HuntCommand& cmd, const chainsaw::cli::GlobalO
         builder.mappings(cmd.mapping);
     }
 
-    // Опции
-    builder.load_unknown(cmd.load_unknown).skip_errors(cmd.skip_errors);
+    // Опции; таблица (вывод по умолчанию) документы детектирований не показывает
+    const bool table = !cmd.json && !cmd.jsonl;
+    builder.load_unknown(cmd.load_unknown)
+        .skip_errors(cmd.skip_errors)
+        .num_threads(decode_threads(global))
+        .documents(!table);
 
     // Time filtering
     if (cmd.from.has_value()) {
@@ -314,6 +525,11 @@ int run_hunt(const chainsaw::cli::HuntCommand& cmd, const chainsaw::cli::GlobalO
     }
     auto& hunter = *build_result.hunter;
 
+    if (hunter.skips_evtx_by_written_time()) {
+        writer.info("EVTX records written to the log more than 24 hours before --from are "
+                    "skipped without checking TimeCreated");
+    }
+
     // Собираем расширения для discovery
     io::DiscoveryOptions disc_opt;
     disc_opt.skip_errors = cmd.skip_errors;
@@ -326,54 +542,108 @@ int run_hunt(const chainsaw::cli::HuntCommand& cmd, const chainsaw::cli::GlobalO
     // Находим файлы
     auto files = io::discover_files(cmd.paths, disc_opt);
 
+    // SPEC-SLICE-012 FACT-027: документы, ждущие вывода, — во временном файле.
+    // Отдельные детектирования выводятся сразу, поэтому в кэш идут документы
+    // агрегаций до конца файла или закрытия окна
+    std::unique_ptr<hunt::DetectionCache> cache;
+    if (cmd.cache_to_disk && !table) {
+        try {
+            cache = std::make_unique<hunt::DetectionCache>();
+        } catch (const std::exception& e) {
+            writer.error(std::string("Failed to create cache on disk - ") + e.what());
+            return 1;
+        }
+    }
+
     // Статистика
     std::size_t total_detections = 0;
     std::size_t files_with_detections = 0;
-    std::vector<hunt::Detections> all_detections;
 
-    // Итерируем по файлам
-    for (const auto& file : files) {
-        auto hunt_result = hunter.hunt(file);
-        if (!hunt_result.ok) {
-            if (cmd.skip_errors) {
-                continue;
+    // Детектирования форматируются в потоке hunt по мере нахождения и выводятся
+    // порциями в порядке файлов: в памяти — не больше порций в очереди вывода
+    auto format = [&cmd, &hunter, &cache](const hunt::Detections& det, std::string& text) {
+        if (cmd.json) {
+            text += hunt::detections_to_json(det, hunter.hunts(), hunter.rules(), cmd.local,
+                                             cache.get());
+            text += '\n';
+        } else if (cmd.jsonl) {
+            text += hunt::detections_to_jsonl(det, hunter.hunts(), hunter.rules(), cmd.local,
+                                              cache.get());
+        } else {
+            text += hunt::format_table_row(det, hunter.hunts(), hunter.rules(),
+                                           cmd.column_width.value_or(0), cmd.full, cmd.metadata,
+                                           cmd.local);
+        }
+    };
+
+    auto hunt_file = [&hunter, &cache, &format](const std::filesystem::path& file,
+                                                std::size_t threads, auto&& emit) {
+        HuntChunk chunk;
+        chunk.first = true;
+        bool stopped = false;
+        auto sink = [&](hunt::Detections&& det) {
+            format(det, chunk.text);
+            ++chunk.count;
+            if (chunk.text.size() >= OUTPUT_CHUNK_BYTES) {
+                std::size_t bytes = chunk.text.size();
+                stopped = !emit(std::exchange(chunk, HuntChunk{}), bytes);
             }
-            writer.error(hunt_result.error);
-            return 1;
+            return !stopped;
+        };
+        auto hunt_result = hunter.hunt_each(file, sink, cache.get(), threads);
+        if (stopped) {
+            return;
         }
-
-        if (hunt_result.detections.empty()) {
-            continue;
+        if (!hunt_result.ok) {
+            chunk.failed = true;
+            chunk.error = std::move(hunt_result.error);
         }
-
-        ++files_with_detections;
-        total_detections += hunt_result.detections.size();
-
-        for (auto& det : hunt_result.detections) {
-            if (cmd.json) {
-                // JSON format
-                std::string json_str =
-                    hunt::detections_to_json(det, hunter.hunts(), hunter.rules(), cmd.local);
-                writer.write_line(output::Stream::Stdout, json_str);
-            } else if (cmd.jsonl) {
-                // JSONL format
-                std::string jsonl_str =
-                    hunt::detections_to_jsonl(det, hunter.hunts(), hunter.rules(), cmd.local);
-                writer.write(output::Stream::Stdout, jsonl_str);
-            } else {
-                // Collect for table output
-                all_detections.push_back(std::move(det));
-            }
+        std::size_t bytes = chunk.text.size();
+        emit(std::move(chunk), bytes);
+    };
+
+    // Таблица открывается перед первой строкой
+    bool table_open = false;
+    auto close_table = [&] {
+        if (table_open) {
+            writer.write(output::Stream::Stdout, hunt::format_table_footer());
+            table_open = false;
         }
-    }
+    };
+
+    // Строки файла выводятся до его ошибки: с --skip-errors файл, прерванный
+    // ошибкой, остаётся в выводе частично и учитывается, если строки из него записаны
+    bool file_written = false;
+    bool completed = for_each_file<HuntChunk>(
+        files, decode_threads(global), hunt_file,
+        [&](const std::filesystem::path&, HuntChunk chunk) {
+            if (chunk.first) {
+                file_written = false;
+            }
+            if (chunk.count > 0) {
+                if (!file_written) {
+                    ++files_with_detections;
+                    file_written = true;
+                }
+                total_detections += chunk.count;
+                if (table && !table_open) {
+                    writer.write(output::Stream::Stdout, hunt::format_table_header());
+                    table_open = true;
+                }
+                writer.write(output::Stream::Stdout, chunk.text);
+            }
 
-    // Table output (default)
-    if (!cmd.json && !cmd.jsonl && !all_detections.empty()) {
-        std::string table =
-            hunt::format_table(all_detections, hunter.hunts(), hunter.rules(),
-                               cmd.column_width.value_or(0), cmd.full, cmd.metadata, cmd.local);
-        writer.write(output::Stream::Stdout, table);
+            if (chunk.failed && !cmd.skip_errors) {
+                close_table();
+                writer.error(chunk.error);
+                return false;
+            }
+            return true;
+        });
+    if (!completed) {
+        return 1;
     }
+    close_table();
 
     // SPEC-SLICE-012 FACT-025: статистика в stderr
     writer.info(std::string("[+] ") + std::to_string(total_detections) + " detections in " +
@@ -488,7 +758,6 @@ int run_lint(const chainsaw::cli::LintCommand& cmd, const chainsaw::cli::GlobalO
 
 int run_search(const chainsaw::cli::SearchCommand& cmd, const chainsaw::cli::GlobalOptions& global,
                chainsaw::output::Writer& writer) {
-    (void)global;
     using namespace chainsaw;
 
     // SPEC-SLICE-011: строим Searcher через builder
@@ -516,7 +785,8 @@ int run_search(const chainsaw::cli::SearchCommand& cmd, const chainsaw::cli::Glo
     builder.ignore_case(cmd.ignore_case)
         .match_any(cmd.match_any)
         .load_unknown(cmd.load_unknown)
-        .skip_errors(cmd.skip_errors);
+        .skip_errors(cmd.skip_errors)
+        .num_threads(decode_threads(global));
 
     // Time filtering
     if (cmd.timestamp.has_value()) {
@@ -547,6 +817,11 @@ int run_search(const chainsaw::cli::SearchCommand& cmd, const chainsaw::cli::Glo
     }
     auto& searcher = *build_result.searcher;
 
+    if (searcher.skips_evtx_by_written_time()) {
+        writer.info("EVTX records written to the log more than 24 hours before --from are "
+                    "skipped without checking TimeCreated");
+    }
+
     // Собираем расширения для discovery
     io::DiscoveryOptions disc_opt;
     disc_opt.skip_errors = cmd.skip_errors;
@@ -575,62 +850,67 @@ int run_search(const chainsaw::cli::SearchCommand& cmd, const chainsaw::cli::Glo
         writer.write(output::Stream::Stdout, "[");
     }
 
-    // Итерируем по файлам
-    for (const auto& file : files) {
-        auto hits = searcher.search(file);
-        if (hits.empty()) {
-            continue;
-        }
+    // Файлы обрабатываются параллельно, результаты выводятся в порядке файлов
+    auto search_file = [&searcher](const std::filesystem::path& file, std::size_t threads,
+                                   auto&& emit) { emit(searcher.search(file, threads), 0); };
 
-        ++files_with_hits;
-        total_hits += hits.size();
+    for_each_file<std::vector<search::SearchResult>>(
+        files, decode_threads(global), search_file,
+        [&](const std::filesystem::path&, std::vector<search::SearchResult> hits) {
+            if (hits.empty()) {
+                return true;
+            }
 
-        for (auto& hit : hits) {
-            if (cmd.json) {
-                // JSON array format
-                rapidjson::Document doc;
-                hit.data.to_rapidjson(doc, doc.GetAllocator());
+            ++files_with_hits;
+            total_hits += hits.size();
 
-                rapidjson::StringBuffer buffer;
-                rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
-                doc.Accept(rj_writer);
+            for (auto& hit : hits) {
+                if (cmd.json) {
+                    // JSON array format
+                    rapidjson::Document doc;
+                    hit.data.to_rapidjson(doc, doc.GetAllocator());
 
-                if (!first_json) {
-                    writer.write(output::Stream::Stdout, ",");
-                }
-                first_json = false;
-                writer.write(output::Stream::Stdout,
-                             std::string_view(buffer.GetString(), buffer.GetSize()));
-            } else if (cmd.jsonl) {
-                // JSONL format: один объект на строку
-                rapidjson::Document doc;
-                hit.data.to_rapidjson(doc, doc.GetAllocator());
-
-                rapidjson::StringBuffer buffer;
-                rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
-                doc.Accept(rj_writer);
-
-                writer.write_line(output::Stream::Stdout,
-                                  std::string_view(buffer.GetString(), buffer.GetSize()));
-            } else {
-                // YAML-like format (default)
-                // SPEC-SLICE-011 FACT-014: YAML формат по умолчанию
-                writer.write_line(output::Stream::Stdout, "---");
+                    rapidjson::StringBuffer buffer;
+                    rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
+                    doc.Accept(rj_writer);
 
-                // Сериализуем в JSON, затем выводим как YAML-like
-                rapidjson::Document doc;
-                hit.data.to_rapidjson(doc, doc.GetAllocator());
+                    if (!first_json) {
+                        writer.write(output::Stream::Stdout, ",");
+                    }
+                    first_json = false;
+                    writer.write(output::Stream::Stdout,
+                                 std::string_view(buffer.GetString(), buffer.GetSize()));
+                } else if (cmd.jsonl) {
+                    // JSONL format: один объект на строку
+                    rapidjson::Document doc;
+                    hit.data.to_rapidjson(doc, doc.GetAllocator());
+
+                    rapidjson::StringBuffer buffer;
+                    rapidjson::Writer<rapidjson::StringBuffer> rj_writer(buffer);
+                    doc.Accept(rj_writer);
+
+                    writer.write_line(output::Stream::Stdout,
+                                      std::string_view(buffer.GetString(), buffer.GetSize()));
+                } else {
+                    // YAML-like format (default)
+                    // SPEC-SLICE-011 FACT-014: YAML формат по умолчанию
+                    writer.write_line(output::Stream::Stdout, "---");
+
+                    // Сериализуем в JSON, затем выводим как YAML-like
+                    rapidjson::Document doc;
+                    hit.data.to_rapidjson(doc, doc.GetAllocator());
 
-                rapidjson::StringBuffer buffer;
-                rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
-                rj_writer.SetIndent(' ', 2);
-                doc.Accept(rj_writer);
+                    rapidjson::StringBuffer buffer;
+                    rapidjson::PrettyWriter<rapidjson::StringBuffer> rj_writer(buffer);
+                    rj_writer.SetIndent(' ', 2);
+                    doc.Accept(rj_writer);
 
-                writer.write_line(output::Stream::Stdout,
-                                  std::string_view(buffer.GetString(), buffer.GetSize()));
+                    writer.write_line(output::Stream::Stdout,
+                                      std::string_view(buffer.GetString(), buffer.GetSize()));
+                }
             }
-        }
-    }
+            return true;
+        });
 
     if (cmd.json) {
         writer.write_line(output::Stream::Stdout, "]");
@@ -16,6 +16,7 @@
 #include "chainsaw/platform.hpp"
 
 #include <cstring>
+#include <limits>
 #include <sstream>
 
 namespace chainsaw::cli {
@@ -34,6 +35,30 @@ bool starts_with(const char* str, const char* prefix) {
     return std::strncmp(str, prefix, std::strlen(prefix)) == 0;
 }
 
+/// Разобрать значение --num-threads (usize в clap)
+/// @return Пустая строка при успехе, иначе сообщение об ошибке в стиле clap
+std::string parse_num_threads(const char* value, int& out) {
+    const char* reason = nullptr;
+    long long parsed = 0;
+    if (*value == '\0') {
+        reason = "cannot parse integer from empty string";
+    }
+    for (const char* p = value; reason == nullptr && *p != '\0'; ++p) {
+        if (*p < '0' || *p > '9') {
+            reason = "invalid digit found in string";
+        } else if ((parsed = parsed * 10 + (*p - '0')) > std::numeric_limits<int>::max()) {
+            reason = "number too large to fit in target type";
+        }
+    }
+    if (reason != nullptr) {
+        return std::string("error: invalid value '") + value +
+               "' for '--num-threads <NUM_THREADS>': " + reason +
+               "\n\nFor more information, try '--help'.\n";
+    }
+    out = static_cast<int>(parsed);
+    return "";
+}
+
 }  // anonymous namespace
 
 // ----------------------------------------------------------------------------
@@ -213,8 +238,26 @@ ParseResult parse(int argc, char** argv) {
             result.global.verbose++;
         } else if (str_eq(arg, "-q")) {
             result.global.quiet = true;
-        } else if (starts_with(arg, "--num-threads")) {
-            // STUB: парсинг значения
+        } else if (str_eq(arg, "--num-threads") || starts_with(arg, "--num-threads=")) {
+            // --num-threads <NUM_THREADS> или --num-threads=<NUM_THREADS>
+            const char* value = nullptr;
+            if (arg[13] == '=') {
+                value = arg + 14;  // strlen("--num-threads=")
+            } else if (i + 1 < argc) {
+                value = argv[++i];
+            } else {
+                result.diagnostic.exit_code = 2;
+                result.diagnostic.stderr_message =
+                    "error: a value is required for '--num-threads <NUM_THREADS>' but none was "
+                    "supplied\n\nFor more information, try '--help'.\n";
+                return result;
+            }
+            auto error = parse_num_threads(value, result.global.num_threads);
+            if (!error.empty()) {
+                result.diagnostic.exit_code = 2;
+                result.diagnostic.stderr_message = std::move(error);
+                return result;
+            }
         } else if (str_eq(arg, "-h") || str_eq(arg, "--help")) {
             result.ok = true;
             result.command = HelpCommand{};
@@ -0,0 +1,105 @@
+// ==============================================================================
+// detection_cache.cpp - Кэш документов детектирований на диске
+// ==============================================================================
+//
+// MOD-0012 hunt (--cache-to-disk)
+//
+// ==============================================================================
+
+#include <chainsaw/detection_cache.hpp>
+#include <stdexcept>
+#include <system_error>
+
+namespace chainsaw::hunt {
+
+namespace {
+
+std::FILE* open_file(const std::filesystem::path& path, bool write) {
+#ifdef _WIN32
+    return _wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+    return std::fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+bool seek(std::FILE* file, std::size_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+}  // namespace
+
+DetectionCache::DetectionCache() : path_(platform::make_temp_file("chainsaw_cache")) {
+    file_ = open_file(path_, true);
+    if (file_ == nullptr) {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+        throw std::runtime_error("Failed to open cache file " + platform::path_to_utf8(path_));
+    }
+}
+
+DetectionCache::~DetectionCache() {
+    mapping_.close();
+    if (reader_ != nullptr) {
+        std::fclose(reader_);
+    }
+    std::fclose(file_);
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+std::size_t DetectionCache::append(std::string_view record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::fwrite(record.data(), 1, record.size(), file_) != record.size()) {
+        throw std::runtime_error("Failed to write cache file " + platform::path_to_utf8(path_));
+    }
+    std::size_t offset = size_;
+    size_ += record.size();
+    return offset;
+}
+
+std::string DetectionCache::read(std::size_t offset, std::size_t size) {
+    if (size == 0) {
+        return {};
+    }
+
+    // Отображение заменяется при повторном чтении: копия делается под мьютексом
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (offset + size <= mapping_.size()) {
+        return {reinterpret_cast<const char*>(mapping_.data()) + offset, size};
+    }
+
+    // Запись ещё в буфере файла
+    if (offset + size > flushed_) {
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Failed to flush cache file " +
+                                     platform::path_to_utf8(path_));
+        }
+        flushed_ = size_;
+    }
+
+    // Файл отображается заново, когда вырос вдвое: хвост за отображением читается
+    // из файла, поэтому чтения вперемешку с записями не переотображают его каждый раз
+    if (size_ >= remap_at_) {
+        remap_at_ = 2 * size_;
+        mapping_.open(path_);
+        if (offset + size <= mapping_.size()) {
+            return {reinterpret_cast<const char*>(mapping_.data()) + offset, size};
+        }
+    }
+
+    if (reader_ == nullptr) {
+        reader_ = open_file(path_, false);
+    }
+    std::string record(size, '\0');
+    if (reader_ == nullptr || !seek(reader_, offset) ||
+        std::fread(record.data(), 1, size, reader_) != size) {
+        throw std::runtime_error("Failed to read cache file " + platform::path_to_utf8(path_));
+    }
+    return record;
+}
+
+}  // namespace chainsaw::hunt
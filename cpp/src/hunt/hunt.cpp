@@ -8,19 +8,26 @@
 // ==============================================================================
 
 #include <algorithm>
+#include <chainsaw/detection_cache.hpp>
+#include <chainsaw/evtx.hpp>
 #include <chainsaw/hunt.hpp>
 #include <chainsaw/platform.hpp>
 #include <chainsaw/sigma.hpp>
 #include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
 #include <functional>
+#include <mutex>
 #include <random>
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <sstream>
+#include <thread>
 #include <yaml-cpp/yaml.h>
 
 namespace chainsaw::hunt {
@@ -322,6 +329,88 @@ MappingResult load_mapping(const std::filesystem::path& path) {
 // Mapper implementation
 // ============================================================================
 
+namespace {
+
+// Одинаковые контейнеры разных полей разбираются один раз
+std::string container_key(const rule::Container& container) {
+    std::string key = container.field;
+    key += '\0';
+    key += container.format == rule::ContainerFormat::Json ? 'j' : 'k';
+    if (container.kv_params) {
+        key += container.kv_params->delimiter;
+        key += '\0';
+        key += container.kv_params->separator;
+        key += container.kv_params->trim ? 't' : '-';
+    }
+    return key;
+}
+
+// Разобрать контейнер документа в объект (KV: первое вхождение ключа);
+// пустой результат — поля нет, оно не строка или не разбирается
+tau::FieldRef parse_container(const tau::Document& doc, const tau::FieldPath& field,
+                              const rule::Container& container) {
+    // Get the container field value
+    auto container_val = doc.resolve(field);
+    if (!container_val || !container_val->is_string()) {
+        return tau::FieldRef();
+    }
+
+    // Parse container based on format
+    if (container.format == rule::ContainerFormat::Json) {
+        rapidjson::Document json_doc;
+        json_doc.Parse(container_val->as_string().data());
+        if (json_doc.HasParseError()) {
+            return tau::FieldRef();
+        }
+        return tau::FieldRef(Value::from_rapidjson(json_doc));
+    }
+
+    // Parse key-value pairs
+    if (!container.kv_params) {
+        return tau::FieldRef();
+    }
+    const auto& kv = *container.kv_params;
+    std::string_view str = container_val->as_string();
+    Value pairs = Value::make_object();
+
+    // Split by delimiter
+    std::size_t pos = 0;
+    while (pos < str.size()) {
+        std::size_t delim_pos = str.find(kv.delimiter, pos);
+        std::string_view item;
+        if (delim_pos == std::string_view::npos) {
+            item = str.substr(pos);
+            pos = str.size();
+        } else {
+            item = str.substr(pos, delim_pos - pos);
+            pos = delim_pos + kv.delimiter.size();
+        }
+
+        // Trim if needed
+        if (kv.trim) {
+            while (!item.empty() && std::isspace(static_cast<unsigned char>(item.front()))) {
+                item.remove_prefix(1);
+            }
+            while (!item.empty() && std::isspace(static_cast<unsigned char>(item.back()))) {
+                item.remove_suffix(1);
+            }
+        }
+
+        // Split by separator
+        std::size_t sep_pos = item.find(kv.separator);
+        if (sep_pos != std::string_view::npos) {
+            std::string_view k = item.substr(0, sep_pos);
+            std::string_view v = item.substr(sep_pos + kv.separator.size());
+            if (!pairs.has(k)) {
+                pairs.set(k, Value(std::string(v)));
+            }
+        }
+    }
+    return tau::FieldRef(std::move(pairs));
+}
+
+}  // namespace
+
 Mapper Mapper::from(std::vector<rule::Field> fields) {
     Mapper mapper;
     mapper.fields_ = std::move(fields);
@@ -342,176 +431,217 @@ Mapper Mapper::from(std::vector<rule::Field> fields) {
 
     if (has_full) {
         mapper.mode_ = MapperMode::Full;
-        for (const auto& field : mapper.fields_) {
-            FullEntry entry;
-            entry.to = field.to;
-            entry.container = field.container;
-            entry.cast = field.cast;
-            mapper.full_map_[field.from] = std::move(entry);
-        }
     } else if (has_fast) {
         mapper.mode_ = MapperMode::Fast;
-        for (const auto& field : mapper.fields_) {
-            mapper.fast_map_[field.from] = field.to;
-        }
     } else {
         mapper.mode_ = MapperMode::None;
+        return mapper;
+    }
+
+    // Пути разбираются здесь, один раз; повторный from заменяет прежний
+    std::unordered_map<std::string, std::uint32_t> containers;
+    for (const auto& field : mapper.fields_) {
+        Entry entry;
+        entry.to = field.to;
+        if (mapper.mode_ == MapperMode::Full) {
+            entry.container = field.container;
+            if (field.container) {
+                entry.container_field = field.container->field;
+                auto slot = static_cast<std::uint32_t>(containers.size());
+                entry.container_slot =
+                    containers.try_emplace(container_key(*field.container), slot).first->second;
+            }
+            entry.cast = field.cast;
+        }
+
+        std::size_t index = mapper.entries_.size();
+        mapper.entries_.push_back(std::move(entry));
+        mapper.by_name_[field.from] = index;
+
+        // Ключ вне таблицы ключей ищется по имени (entry_index)
+        ValueKey key(field.from);
+        if (!key.interned()) {
+            continue;
+        }
+        std::uint32_t id = key.id();
+        if (id >= mapper.by_key_.size()) {
+            mapper.by_key_.resize(id + 1, 0);
+        }
+        mapper.by_key_[id] = static_cast<std::uint32_t>(index + 1);
     }
+    mapper.containers_ = containers.size();
 
     return mapper;
 }
 
-std::optional<Value> Mapper::find(const tau::Document& doc, std::string_view key) const {
-    std::string key_str(key);
+tau::FieldRef Mapper::find(const tau::Document& doc, std::string_view key) const {
+    if (mode_ != MapperMode::None) {
+        auto it = by_name_.find(key);
+        if (it != by_name_.end()) {
+            return apply(doc, it->second, nullptr);
+        }
+    }
+    return doc.lookup(key);
+}
 
-    switch (mode_) {
-    case MapperMode::None:
-        return doc.find(key);
+std::size_t Mapper::entry_index(const ValueKey& key) const {
+    if (!key.interned()) {
+        // Ключ вне таблицы ключей не попал в by_key_
+        auto it = by_name_.find(key.str());
+        return it != by_name_.end() ? it->second : NOT_MAPPED;
+    }
+    std::uint32_t id = key.id();
+    return id < by_key_.size() && by_key_[id] != 0 ? by_key_[id] - 1 : NOT_MAPPED;
+}
 
-    case MapperMode::Fast: {
-        auto it = fast_map_.find(key_str);
-        if (it != fast_map_.end()) {
-            return doc.find(it->second);
-        }
-        return doc.find(key);
+tau::FieldRef Mapper::resolve(const tau::Document& doc, const tau::FieldPath& path) const {
+    std::size_t index = entry_index(path.key());
+    if (index != NOT_MAPPED) {
+        return apply(doc, index, nullptr);
     }
+    return doc.resolve(path);
+}
 
-    case MapperMode::Full: {
-        auto it = full_map_.find(key_str);
-        if (it == full_map_.end()) {
-            return doc.find(key);
+tau::FieldRef Mapper::find(const tau::Document& doc, std::string_view key,
+                           MapperCache& cache) const {
+    if (mode_ != MapperMode::None) {
+        auto it = by_name_.find(key);
+        if (it != by_name_.end()) {
+            return apply(doc, it->second, &cache);
         }
+    }
+    return doc.lookup(key);
+}
 
-        const auto& entry = it->second;
-
-        // Handle container
-        if (entry.container.has_value()) {
-            // Get the container field value
-            auto container_val = doc.find(entry.container->field);
-            if (!container_val || !container_val->is_string()) {
-                return std::nullopt;
-            }
+tau::FieldRef Mapper::resolve(const tau::Document& doc, const tau::FieldPath& path,
+                              MapperCache& cache) const {
+    std::size_t index = entry_index(path.key());
+    if (index != NOT_MAPPED) {
+        return apply(doc, index, &cache);
+    }
+    return doc.resolve(path);
+}
 
-            // Parse container based on format
-            if (entry.container->format == rule::ContainerFormat::Json) {
-                // Parse JSON
-                rapidjson::Document json_doc;
-                json_doc.Parse(container_val->as_string().data());
-                if (json_doc.HasParseError()) {
-                    return std::nullopt;
-                }
-                // Look up the target field in parsed JSON
-                Value json_val = Value::from_rapidjson(json_doc);
-                const Value* result = json_val.get(entry.to);
-                if (result) {
-                    return *result;
-                }
-                return std::nullopt;
-            } else if (entry.container->format == rule::ContainerFormat::Kv) {
-                // Parse key-value pairs
-                if (!entry.container->kv_params) {
-                    return std::nullopt;
-                }
-                const auto& kv = *entry.container->kv_params;
-                std::string_view str = container_val->as_string();
-
-                // Split by delimiter
-                std::size_t pos = 0;
-                while (pos < str.size()) {
-                    std::size_t delim_pos = str.find(kv.delimiter, pos);
-                    std::string_view item;
-                    if (delim_pos == std::string_view::npos) {
-                        item = str.substr(pos);
-                        pos = str.size();
-                    } else {
-                        item = str.substr(pos, delim_pos - pos);
-                        pos = delim_pos + kv.delimiter.size();
-                    }
+tau::FieldRef Mapper::apply(const tau::Document& doc, std::size_t index,
+                            MapperCache* cache) const {
+    if (cache == nullptr) {
+        return compute(doc, entries_[index], nullptr);
+    }
+    if (cache->entries_.size() != entries_.size()) {
+        cache->entries_.assign(entries_.size(), {});
+        cache->containers_.assign(containers_, {});
+    }
 
-                    // Trim if needed
-                    if (kv.trim) {
-                        while (!item.empty() &&
-                               std::isspace(static_cast<unsigned char>(item.front()))) {
-                            item.remove_prefix(1);
-                        }
-                        while (!item.empty() &&
-                               std::isspace(static_cast<unsigned char>(item.back()))) {
-                            item.remove_suffix(1);
-                        }
-                    }
+    // Значение хранится в кэше; вызывающему — ссылка на него
+    auto& slot = cache->entries_[index];
+    if (slot.generation != cache->generation_) {
+        slot.value = compute(doc, entries_[index], cache);
+        slot.generation = cache->generation_;
+    }
+    return tau::FieldRef(slot.value.get());
+}
 
-                    // Split by separator
-                    std::size_t sep_pos = item.find(kv.separator);
-                    if (sep_pos != std::string_view::npos) {
-                        std::string_view k = item.substr(0, sep_pos);
-                        std::string_view v = item.substr(sep_pos + kv.separator.size());
-                        if (k == entry.to) {
-                            return Value(std::string(v));
-                        }
-                    }
-                }
-                return std::nullopt;
+tau::FieldRef Mapper::compute(const tau::Document& doc, const Entry& entry,
+                              MapperCache* cache) const {
+    // Handle container
+    if (entry.container.has_value()) {
+        // Разобранный контейнер: из кэша документа или разбирается здесь
+        tau::FieldRef local;
+        const Value* parsed = nullptr;
+        if (cache != nullptr) {
+            auto& slot = cache->containers_[entry.container_slot];
+            if (slot.generation != cache->generation_) {
+                slot.value = parse_container(doc, entry.container_field, *entry.container);
+                slot.generation = cache->generation_;
             }
+            parsed = slot.value.get();
+        } else {
+            local = parse_container(doc, entry.container_field, *entry.container);
+            parsed = local.get();
+        }
+        if (parsed == nullptr) {
+            return tau::FieldRef();
         }
 
-        // Handle cast
-        auto val = doc.find(entry.to);
-        if (!val) {
-            return std::nullopt;
+        // Look up the target field in parsed container
+        const Value* result = parsed->get(entry.to.str());
+        if (result == nullptr) {
+            return tau::FieldRef();
         }
+        return cache != nullptr ? tau::FieldRef(result) : tau::FieldRef(*result);
+    }
 
-        if (entry.cast.has_value()) {
-            switch (*entry.cast) {
-            case tau::ModSym::Int:
-                if (val->is_string()) {
-                    try {
-                        std::int64_t i = std::stoll(std::string(val->as_string()));
-                        return Value(i);
-                    } catch (...) {
-                        return val;
-                    }
-                }
-                return val;
+    // Handle cast
+    auto val = doc.resolve(entry.to);
+    if (!val) {
+        return val;
+    }
 
-            case tau::ModSym::Str:
-                // Convert to string
-                if (val->is_string()) {
+    if (entry.cast.has_value()) {
+        switch (*entry.cast) {
+        case tau::ModSym::Int:
+            if (val->is_string()) {
+                try {
+                    std::int64_t i = std::stoll(std::string(val->as_string()));
+                    return tau::FieldRef(Value(i));
+                } catch (...) {
                     return val;
-                } else if (val->is_int()) {
-                    return Value(std::to_string(val->as_int()));
-                } else if (val->is_double()) {
-                    return Value(std::to_string(val->as_double()));
-                } else if (val->is_bool()) {
-                    return Value(val->as_bool() ? "true" : "false");
                 }
-                return val;
+            }
+            return val;
 
-            case tau::ModSym::Flt:
-                if (val->is_string()) {
-                    try {
-                        double d = std::stod(std::string(val->as_string()));
-                        return Value(d);
-                    } catch (...) {
-                        return val;
-                    }
-                }
+        case tau::ModSym::Str:
+            // Convert to string
+            if (val->is_string()) {
                 return val;
+            } else if (val->is_int()) {
+                return tau::FieldRef(Value(std::to_string(val->as_int())));
+            } else if (val->is_double()) {
+                return tau::FieldRef(Value(std::to_string(val->as_double())));
+            } else if (val->is_bool()) {
+                return tau::FieldRef(Value(val->as_bool() ? "true" : "false"));
+            }
+            return val;
+
+        case tau::ModSym::Flt:
+            if (val->is_string()) {
+                try {
+                    double d = std::stod(std::string(val->as_string()));
+                    return tau::FieldRef(Value(d));
+                } catch (...) {
+                    return val;
+                }
             }
+            return val;
         }
-
-        return val;
-    }
     }
 
-    return std::nullopt;
+    return val;
 }
 
 // ============================================================================
 // MappedDocument implementation
 // ============================================================================
 
-std::optional<Value> MappedDocument::find(std::string_view key) const {
-    return mapper_.find(doc_, key);
+void MapperCache::clear() {
+    if (++generation_ == 0) {
+        // Поколение переполнилось: старые отметки могут совпасть
+        for (auto& slot : entries_) {
+            slot.generation = 0;
+        }
+        for (auto& slot : containers_) {
+            slot.generation = 0;
+        }
+        generation_ = 1;
+    }
+}
+
+tau::FieldRef MappedDocument::lookup(std::string_view key) const {
+    return cache_ != nullptr ? mapper_.find(doc_, key, *cache_) : mapper_.find(doc_, key);
+}
+
+tau::FieldRef MappedDocument::resolve(const tau::FieldPath& path) const {
+    return cache_ != nullptr ? mapper_.resolve(doc_, path, *cache_) : mapper_.resolve(doc_, path);
 }
 
 // ============================================================================
@@ -526,6 +656,180 @@ bool Hunt::is_aggregation() const {
     return rule_kind.aggregate.has_value();
 }
 
+// ============================================================================
+// Проекция полей
+// ============================================================================
+//
+// Reader собирает из документа только поля, на которые ссылаются hunts
+// (фильтры, preconditions, агрегации, timestamp и цели Mapper). Документ
+// для детектирования материализуется полностью (Document::materialize).
+//
+
+namespace {
+
+void insert_fields(std::unordered_set<std::string>& fields, const tau::Expression& expr) {
+    auto found = tau::extract_fields(expr);
+    fields.insert(found.begin(), found.end());
+}
+
+void insert_fields(std::unordered_set<std::string>& fields, const tau::Detection& detection) {
+    insert_fields(fields, detection.expression);
+    for (const auto& [name, expr] : detection.identifiers) {
+        insert_fields(fields, expr);
+    }
+}
+
+void insert_rule_fields(std::unordered_set<std::string>& fields, const rule::Rule& rule) {
+    std::visit(
+        [&fields](const auto& r) {
+            using T = std::decay_t<decltype(r)>;
+            if constexpr (std::is_same_v<T, rule::ChainsawRule>) {
+                std::visit([&fields](const auto& filter) { insert_fields(fields, filter); },
+                           r.filter);
+            } else {
+                insert_fields(fields, r.detection);
+            }
+        },
+        rule);
+    const auto& aggregate = rule::rule_aggregate(rule);
+    if (aggregate.has_value()) {
+        fields.insert(aggregate->fields.begin(), aggregate->fields.end());
+    }
+}
+
+/// Поля документа, которые читает hunt (с учётом Mapper)
+void insert_hunt_fields(std::unordered_set<std::string>& fields, const Hunt& hunt,
+                        const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules) {
+    std::unordered_set<std::string> keys;
+    keys.insert(hunt.timestamp);
+
+    if (std::holds_alternative<HuntKindGroup>(hunt.kind)) {
+        const auto& group_kind = std::get<HuntKindGroup>(hunt.kind);
+        insert_fields(keys, group_kind.filter);
+        for (const auto& [rid, precondition] : group_kind.preconditions) {
+            insert_fields(keys, precondition);
+        }
+        for (const auto& [rid, rule] : rules) {
+            if (rule::rule_is_kind(rule, group_kind.kind) &&
+                group_kind.exclusions.count(rid) == 0) {
+                insert_rule_fields(keys, rule);
+            }
+        }
+    } else {
+        const auto& rule_kind = std::get<HuntKindRule>(hunt.kind);
+        std::visit([&keys](const auto& filter) { insert_fields(keys, filter); }, rule_kind.filter);
+        if (rule_kind.aggregate.has_value()) {
+            keys.insert(rule_kind.aggregate->fields.begin(), rule_kind.aggregate->fields.end());
+        }
+    }
+
+    // Mapper ищет ключ в документе как есть либо по полю назначения/контейнеру
+    fields.insert(keys.begin(), keys.end());
+    for (const auto& field : hunt.mapper.fields()) {
+        if (keys.count(field.from) == 0) {
+            continue;
+        }
+        fields.insert(field.container.has_value() ? field.container->field : field.to);
+    }
+}
+
+/// Проекция для Reader (nullptr — нужны все поля)
+std::shared_ptr<const FieldProjection> referenced_fields(
+    const std::vector<Hunt>& hunts, const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules) {
+    if (hunts.empty()) {
+        return nullptr;
+    }
+    std::unordered_set<std::string> fields;
+    for (const auto& hunt : hunts) {
+        insert_hunt_fields(fields, hunt, rules);
+    }
+    // Пустой путь — весь документ
+    if (fields.count(std::string()) > 0) {
+        return nullptr;
+    }
+    std::vector<std::string> paths(fields.begin(), fields.end());
+    std::sort(paths.begin(), paths.end());
+    return std::make_shared<const FieldProjection>(paths);
+}
+
+/// Поле документа, из которого hunt берёт timestamp (nullopt — через контейнер/cast)
+std::optional<std::string> timestamp_field(const Hunt& hunt) {
+    std::optional<std::string> field = hunt.timestamp;
+    for (const auto& mapped : hunt.mapper.fields()) {
+        if (mapped.from != hunt.timestamp) {
+            continue;
+        }
+        if (mapped.container.has_value() || mapped.cast.has_value()) {
+            field.reset();
+        } else {
+            field = mapped.to;
+        }
+    }
+    return field;
+}
+
+/// Граница --from для заголовков записей EVTX (nullopt — не применяется)
+///
+/// Если все EVTX hunts берут timestamp из TimeCreated, запись, записанная в журнал
+/// раньше from больше чем на запас (evtx::written_after_bound), пропускается всеми;
+/// записи ближе к границе декодируются и проверяются по TimeCreated.
+std::optional<std::uint64_t> evtx_written_after(const std::vector<Hunt>& hunts,
+                                                const std::optional<DateTime>& from) {
+    if (!from.has_value()) {
+        return std::nullopt;
+    }
+    for (const auto& hunt : hunts) {
+        if (hunt.file != io::DocumentKind::Evtx) {
+            continue;
+        }
+        auto field = timestamp_field(hunt);
+        if (!field || !evtx::is_time_created_field(*field)) {
+            return std::nullopt;
+        }
+    }
+    return evtx::written_after_bound(from->to_filetime());
+}
+
+/// Дописать документ в кэш компактным JSON (SPEC-SLICE-012 FACT-029)
+/// @param buffer Буфер сериализации, переиспользуется между вызовами
+CachedRecord cache_document(DetectionCache& cache, const Value& data,
+                            rapidjson::StringBuffer& buffer) {
+    rapidjson::Document json;
+    data.to_rapidjson(json, json.GetAllocator());
+    buffer.Clear();
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    json.Accept(writer);
+    return {cache.append({buffer.GetString(), buffer.GetSize()}), buffer.GetSize()};
+}
+
+/// Подготовить документ к хранению после следующего next(): заменить собранный
+/// по проекции полным, перенести построенный в арене читателя в кучу
+void materialize(io::Document& doc) {
+    if (doc.materialize) {
+        doc.data = doc.materialize();
+        doc.materialize = nullptr;
+    } else {
+        doc.data = doc.data.owned();
+    }
+}
+
+/// Выражение фильтра правила для RuleIndex (nullptr — identifiers не подставлены)
+const tau::Expression* rule_expression(const rule::Rule& rule) {
+    auto from_detection = [](const tau::Detection& detection) -> const tau::Expression* {
+        return detection.identifiers.empty() ? &detection.expression : nullptr;
+    };
+    if (const auto* sigma = std::get_if<rule::SigmaRule>(&rule)) {
+        return from_detection(sigma->detection);
+    }
+    const auto& filter = std::get<rule::ChainsawRule>(rule).filter;
+    if (const auto* detection = std::get_if<tau::Detection>(&filter)) {
+        return from_detection(*detection);
+    }
+    return &std::get<tau::Expression>(filter);
+}
+
+}  // namespace
+
 // ============================================================================
 // HunterBuilder implementation
 // ============================================================================
@@ -574,6 +878,21 @@ HunterBuilder& HunterBuilder::skip_errors(bool skip) {
     return *this;
 }
 
+HunterBuilder& HunterBuilder::num_threads(std::size_t threads) {
+    num_threads_ = threads;
+    return *this;
+}
+
+HunterBuilder& HunterBuilder::batch_size(std::size_t documents) {
+    batch_size_ = documents;
+    return *this;
+}
+
+HunterBuilder& HunterBuilder::documents(bool keep) {
+    documents_ = keep;
+    return *this;
+}
+
 HunterBuilder& HunterBuilder::timezone(std::string tz) {
     timezone_ = std::move(tz);
     return *this;
@@ -620,6 +939,12 @@ HunterBuilder::BuildResult HunterBuilder::build() {
                     hunt_kind.filter = tau::clone(std::get<tau::Expression>(chainsaw.filter));
                 }
 
+                std::visit(
+                    [&hunt_kind](const auto& filter) {
+                        hunt_kind.program = tau::compile_program(filter);
+                    },
+                    hunt_kind.filter);
+
                 Hunt hunt;
                 hunt.id = uuid;
                 hunt.group = chainsaw.group;
@@ -635,6 +960,9 @@ HunterBuilder::BuildResult HunterBuilder::build() {
         }
     }
 
+    // Одинаковые проверки групп и правил Sigma компилируются один раз
+    auto predicates = std::make_shared<tau::Predicates>();
+
     // Process mappings
     if (mappings_.has_value()) {
         auto& mapping_paths = *mappings_;
@@ -669,6 +997,7 @@ HunterBuilder::BuildResult HunterBuilder::build() {
 
                 // Build preconditions map for this group (clone expressions)
                 std::unordered_map<UUID, tau::Expression, UUID::Hash> preconds;
+                std::unordered_map<UUID, tau::Program, UUID::Hash> precond_programs;
                 if (mapping.extensions.has_value() &&
                     mapping.extensions->preconditions.has_value()) {
                     for (const auto& precond : *mapping.extensions->preconditions) {
@@ -688,6 +1017,8 @@ HunterBuilder::BuildResult HunterBuilder::build() {
 
                                 if (matched) {
                                     preconds.emplace(rid, tau::clone(precond.filter));
+                                    precond_programs.emplace(
+                                        rid, tau::compile_program(precond.filter, predicates));
                                 }
                             }
                         }
@@ -698,9 +1029,11 @@ HunterBuilder::BuildResult HunterBuilder::build() {
 
                 HuntKindGroup hunt_kind;
                 hunt_kind.exclusions = std::move(exclusions);
+                hunt_kind.program = tau::compile_program(group.filter, predicates);
                 hunt_kind.filter = std::move(group.filter);
                 hunt_kind.kind = mapping.rules;
                 hunt_kind.preconditions = std::move(preconds);
+                hunt_kind.precondition_programs = std::move(precond_programs);
 
                 Hunt hunt;
                 hunt.id = group.id;
@@ -721,12 +1054,28 @@ HunterBuilder::BuildResult HunterBuilder::build() {
         }
     }
 
+    // Фильтры правил компилируются один раз и индексируются по обязательным
+    // равенствам полей (EventID, Provider, Channel, ...)
+    hunter->compiled_.reserve(hunter->rules_.size());
+    std::vector<const tau::Expression*> filters;
+    for (const auto& [rid, rule] : hunter->rules_) {
+        hunter->compiled_.push_back({rid, &rule, rule::rule_program(rule, predicates)});
+        filters.push_back(rule_expression(rule));
+    }
+    hunter->index_ = RuleIndex(filters);
+    hunter->predicates_ = std::move(predicates);
+
     // Copy settings
     hunter->load_unknown_ = load_unknown_.value_or(false);
     hunter->preprocess_ = preprocess_.value_or(false);
     hunter->skip_errors_ = skip_errors_.value_or(false);
+    hunter->num_threads_ = num_threads_.value_or(1);
+    hunter->batch_size_ = std::max<std::size_t>(1, batch_size_.value_or(256));
+    hunter->documents_ = documents_.value_or(true);
     hunter->from_ = from_;
     hunter->to_ = to_;
+    hunter->projection_ = referenced_fields(hunter->hunts_, hunter->rules_);
+    hunter->evtx_written_after_ = evtx_written_after(hunter->hunts_, from_);
 
     result.ok = true;
     result.hunter = std::move(hunter);
@@ -748,276 +1097,785 @@ bool Hunter::should_skip(const DateTime& timestamp) const {
     return false;
 }
 
-Hunter::HuntResult Hunter::hunt(const std::filesystem::path& path, std::FILE* cache_file) const {
-    HuntResult result;
-    result.ok = false;
+// ============================================================================
+// Сопоставление документа
+// ============================================================================
 
-    // Open file using Reader
-    auto reader_result = io::Reader::open(path, load_unknown_, skip_errors_);
-    if (!reader_result) {
-        if (skip_errors_) {
-            result.ok = true;
-            return result;
+struct Hunter::DocumentMatch {
+    /// Документ попал в агрегацию правила
+    struct Aggregation {
+        std::pair<UUID, UUID> key;  // (hunt, правило)
+        const rule::Aggregate* aggregate;
+        DateTime timestamp;
+        std::optional<std::string> group;  // ключ группы (nullopt — нет поля агрегации)
+    };
+
+    std::vector<Hit> hits;
+    std::vector<Aggregation> aggregations;
+    std::optional<std::string> error;  // hunt файла прекращается
+
+    void clear() {
+        hits.clear();
+        aggregations.clear();
+        error.reset();
+    }
+};
+
+struct Hunter::MatchScratch {
+    MatchScratch(const tau::Predicates& predicates, std::size_t hunts)
+        : memo(predicates), mapper_caches(hunts) {}
+
+    std::vector<std::uint32_t> candidates;
+    tau::PredicateMemo memo;
+    // Разобранные контейнеры и поля документа, по кэшу на Mapper каждого hunt
+    std::vector<MapperCache> mapper_caches;
+};
+
+namespace {
+
+/// Ключ группы агрегации: значения полей с длинами, равенство ключей — равенство
+/// всех значений по порядку (nullopt — поле отсутствует или не строка)
+std::optional<std::string> aggregate_group(const MappedDocument& mapped,
+                                           const std::vector<std::string>& fields) {
+    std::string group;
+    for (const auto& field : fields) {
+        auto val = mapped.lookup(field);
+        if (!val || !val->is_string()) {
+            return std::nullopt;
         }
-        result.error = reader_result.error.message;
-        return result;
+        auto text = val->as_string();
+        auto size = static_cast<std::uint32_t>(text.size());
+        group.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        group.append(text);
     }
+    return group;
+}
 
-    auto& reader = *reader_result.reader;
-    io::DocumentKind file_kind = reader.kind();
+}  // namespace
 
-    // Aggregation state
-    struct AggregateState {
-        const rule::Aggregate* aggregate = nullptr;
-        std::unordered_map<std::size_t, std::vector<UUID>> docs;  // hash -> doc IDs
-    };
+void Hunter::match_document(const io::Document& doc, io::DocumentKind kind,
+                            MatchScratch& scratch, DocumentMatch& out) const {
+    out.clear();
 
-    // Custom hash for pair<UUID, UUID>
-    auto pair_hash = [](const std::pair<UUID, UUID>& p) -> std::size_t {
-        return UUID::Hash{}(p.first) ^ (UUID::Hash{}(p.second) << 1);
-    };
-    std::unordered_map<std::pair<UUID, UUID>, AggregateState, decltype(pair_hash)> aggregates(
-        16, pair_hash);
+    for (std::size_t hunt_index = 0; hunt_index < hunts_.size(); ++hunt_index) {
+        const auto& hunt = hunts_[hunt_index];
 
-    std::unordered_map<UUID, std::pair<Value, DateTime>, UUID::Hash> stored_docs;
-    std::size_t cache_offset = 0;
+        // SPEC-SLICE-012 FACT-011: проверка hunt.file == document.kind
+        if (hunt.file != kind) {
+            continue;
+        }
 
-    // Iterate through documents
-    io::Document doc;
-    while (reader.next(doc)) {
-        UUID document_id = UUID::generate();
+        // Create mapped document
+        tau::ValueDocument value_doc(doc.data);
+        MapperCache& mapper_cache = scratch.mapper_caches[hunt_index];
+        mapper_cache.clear();
+        MappedDocument mapped(value_doc, hunt.mapper, mapper_cache);
 
-        // Check document kind matches hunt
-        std::vector<Hit> hits;
+        // Extract timestamp (SPEC-SLICE-012 FACT-012)
+        auto ts_val = mapped.resolve(hunt.timestamp);
+        if (!ts_val || !ts_val->is_string()) {
+            continue;
+        }
 
-        for (const auto& hunt : hunts_) {
-            // SPEC-SLICE-012 FACT-011: проверка hunt.file == document.kind
-            if (hunt.file != file_kind) {
+        auto timestamp = DateTime::parse(ts_val->as_string());
+        if (!timestamp) {
+            if (skip_errors_) {
                 continue;
             }
+            out.error =
+                std::string("failed to parse timestamp: ") + std::string(ts_val->as_string());
+            return;
+        }
 
-            // Create mapped document
-            tau::ValueDocument value_doc(doc.data);
-            MappedDocument mapped(value_doc, hunt.mapper);
+        // Time filtering (SPEC-SLICE-012 FACT-013)
+        if (should_skip(*timestamp)) {
+            continue;
+        }
 
-            // Extract timestamp (SPEC-SLICE-012 FACT-012)
-            auto ts_val = mapped.find(hunt.timestamp);
-            if (!ts_val || !ts_val->is_string()) {
+        // Match based on hunt kind
+        if (std::holds_alternative<HuntKindGroup>(hunt.kind)) {
+            const auto& group_kind = std::get<HuntKindGroup>(hunt.kind);
+
+            // SPEC-SLICE-012 FACT-020: сначала проверяем group filter
+            scratch.memo.clear();
+            if (!tau::solve(group_kind.program, mapped, scratch.memo)) {
                 continue;
             }
 
-            auto timestamp = DateTime::parse(ts_val->as_string());
-            if (!timestamp) {
-                if (skip_errors_) {
+            // Check candidate rules (остальные не совпадут по индексируемым полям)
+            index_.candidates(mapped, scratch.candidates);
+            for (std::uint32_t candidate : scratch.candidates) {
+                const auto& [rid, rule_ptr, program] = compiled_[candidate];
+                const auto& rule = *rule_ptr;
+
+                // SPEC-SLICE-012: проверка типа правила
+                if (!rule::rule_is_kind(rule, group_kind.kind)) {
                     continue;
                 }
-                result.error =
-                    std::string("failed to parse timestamp: ") + std::string(ts_val->as_string());
-                return result;
+
+                // SPEC-SLICE-012 FACT-006: проверка exclusions
+                if (group_kind.exclusions.count(rid) > 0) {
+                    continue;
+                }
+
+                // SPEC-SLICE-012 FACT-007: проверка preconditions
+                auto precond_it = group_kind.precondition_programs.find(rid);
+                if (precond_it != group_kind.precondition_programs.end()) {
+                    if (!tau::solve(precond_it->second, mapped, scratch.memo)) {
+                        continue;
+                    }
+                }
+
+                // Check rule
+                if (!tau::solve(program, mapped, scratch.memo)) {
+                    continue;
+                }
+
+                // Check for aggregation (поля агрегации входят в проекцию документа)
+                const auto& agg = rule::rule_aggregate(rule);
+                if (agg.has_value()) {
+                    out.aggregations.push_back({std::make_pair(hunt.id, rid), &(*agg), *timestamp,
+                                                aggregate_group(mapped, agg->fields)});
+                } else {
+                    out.hits.push_back(Hit{hunt.id, rid, *timestamp});
+                }
             }
+        } else {
+            // HuntKindRule
+            const auto& rule_kind = std::get<HuntKindRule>(hunt.kind);
 
-            // Time filtering (SPEC-SLICE-012 FACT-013)
-            if (should_skip(*timestamp)) {
+            // SPEC-SLICE-012 FACT-019: проверка фильтра правила
+            if (!tau::solve(rule_kind.program, mapped)) {
                 continue;
             }
 
-            // Match based on hunt kind
-            if (std::holds_alternative<HuntKindGroup>(hunt.kind)) {
-                const auto& group_kind = std::get<HuntKindGroup>(hunt.kind);
+            if (rule_kind.aggregate.has_value()) {
+                out.aggregations.push_back({std::make_pair(hunt.id, hunt.id),
+                                            &(*rule_kind.aggregate), *timestamp,
+                                            aggregate_group(mapped, rule_kind.aggregate->fields)});
+            } else {
+                out.hits.push_back(Hit{hunt.id, hunt.id, *timestamp});
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Агрегация
+// ============================================================================
+
+namespace {
 
-                // SPEC-SLICE-012 FACT-020: сначала проверяем group filter
-                if (!tau::solve(group_kind.filter, mapped)) {
-                    continue;
+using RuleKey = std::pair<UUID, UUID>;  // (hunt, правило)
+
+struct RuleKeyHash {
+    std::size_t operator()(const RuleKey& key) const {
+        return UUID::Hash{}(key.first) ^ (UUID::Hash{}(key.second) << 1);
+    }
+};
+
+/// Документ агрегации: собранный, ссылка на запись файла, которая собирается
+/// заново только для вывода (Document::materialize), или запись DetectionCache
+struct StoredDocument {
+    Value data;
+    std::function<Value()> materialize;
+    std::optional<CachedRecord> cached;
+    DateTime timestamp;
+
+    Value value() const { return materialize ? materialize() : data; }
+};
+
+/// Число документов группы удовлетворяет count (SPEC-SLICE-012 FACT-023)
+bool count_matches(const tau::Pattern& pattern, std::size_t count) {
+    if (const auto* p = std::get_if<tau::PatternEqual>(&pattern)) {
+        return count == static_cast<std::size_t>(p->value);
+    }
+    if (const auto* p = std::get_if<tau::PatternGreaterThan>(&pattern)) {
+        return count > static_cast<std::size_t>(p->value);
+    }
+    if (const auto* p = std::get_if<tau::PatternGreaterThanOrEqual>(&pattern)) {
+        return count >= static_cast<std::size_t>(p->value);
+    }
+    if (const auto* p = std::get_if<tau::PatternLessThan>(&pattern)) {
+        return count < static_cast<std::size_t>(p->value);
+    }
+    if (const auto* p = std::get_if<tau::PatternLessThanOrEqual>(&pattern)) {
+        return count <= static_cast<std::size_t>(p->value);
+    }
+    return false;
+}
+
+/// Агрегации с окном времени (Sigma timeframe) в потоке документов файла.
+///
+/// События группы хранятся по времени, пока попадают в окно. Для > и >=
+/// детектирование выдаётся, как только событий в окне [t - timeframe, t] стало
+/// достаточно, после чего окно группы очищается. Для =, < и <= окно отсчитывается
+/// от первого события группы и проверяется при закрытии: пришло событие позже
+/// окна или файл закончился; событие, опоздавшее к уже закрытому окну, попадает
+/// в следующее. Опустевшие группы удаляются, а когда групп
+/// становится вдвое больше, чем после прошлой очистки, окна, закончившиеся до
+/// самого позднего события файла, закрываются — память пропорциональна событиям
+/// в открытых окнах, а не всем событиям файла.
+class WindowedAggregates {
+public:
+    using Emit = std::function<void(const RuleKey&, std::vector<StoredDocument>&&)>;
+
+    explicit WindowedAggregates(Emit emit) : emit_(std::move(emit)) {}
+
+    void add(const RuleKey& key, const rule::Aggregate& aggregate, std::string group,
+             StoredDocument document) {
+        auto [it, inserted] = index_.try_emplace(key, rules_.size());
+        if (inserted) {
+            rules_.push_back({key, &aggregate, {}});
+        }
+        RuleWindows& rule = rules_[it->second];
+
+        std::uint64_t time = document.timestamp.to_filetime();
+        latest_ = std::max(latest_, time);
+        auto [group_it, created] = rule.groups.try_emplace(std::move(group));
+        auto& events = group_it->second;
+        if (created) {
+            ++groups_;
+        }
+
+        std::vector<Closed> closed;
+        if (!grows(aggregate.count)) {
+            while (!events.empty() && time > events.front().time + span(aggregate)) {
+                close_front(rule, events, closed);
+            }
+        }
+
+        // События почти всегда приходят по времени: место вставки ищется с конца
+        auto pos = events.end();
+        while (pos != events.begin() && std::prev(pos)->time > time) {
+            --pos;
+        }
+        events.insert(pos, Event{time, sequence_++, std::move(document)});
+
+        if (grows(aggregate.count)) {
+            expire(aggregate, events, events.back().time);
+            if (count_matches(aggregate.count, events.size())) {
+                closed.push_back({events.front().sequence, &rule, take(events, events.size())});
+            }
+        }
+        if (events.empty()) {
+            rule.groups.erase(group_it);
+        }
+        emit(closed);
+
+        if (groups_ > sweep_at_) {
+            sweep();
+        }
+    }
+
+    /// Закрыть все окна (конец файла)
+    void flush() {
+        std::vector<Closed> closed;
+        for (auto& rule : rules_) {
+            for (auto& [group, events] : rule.groups) {
+                while (!events.empty()) {
+                    close_front(rule, events, closed);
                 }
+            }
+            rule.groups.clear();
+        }
+        emit(closed);
+    }
 
-                // Check all matching rules
-                for (const auto& [rid, rule] : rules_) {
-                    // SPEC-SLICE-012: проверка типа правила
-                    if (!rule::rule_is_kind(rule, group_kind.kind)) {
-                        continue;
-                    }
+private:
+    struct Event {
+        std::uint64_t time;     // FILETIME
+        std::uint64_t sequence;  // порядковый номер события в файле
+        StoredDocument document;
+    };
 
-                    // SPEC-SLICE-012 FACT-006: проверка exclusions
-                    if (group_kind.exclusions.count(rid) > 0) {
-                        continue;
-                    }
+    struct RuleWindows {
+        RuleKey key;
+        const rule::Aggregate* aggregate;
+        std::unordered_map<std::string, std::deque<Event>> groups;
+    };
 
-                    // SPEC-SLICE-012 FACT-007: проверка preconditions
-                    auto precond_it = group_kind.preconditions.find(rid);
-                    if (precond_it != group_kind.preconditions.end()) {
-                        if (!tau::solve(precond_it->second, mapped)) {
-                            continue;
-                        }
-                    }
+    /// Закрытое окно, которое прошло проверку count
+    struct Closed {
+        std::uint64_t sequence;  // первое событие окна — порядок вывода
+        const RuleWindows* rule;
+        std::vector<StoredDocument> documents;
+    };
 
-                    // Check rule
-                    if (!rule::rule_solve(rule, mapped)) {
-                        continue;
-                    }
+    static bool grows(const tau::Pattern& count) {
+        return std::holds_alternative<tau::PatternGreaterThan>(count) ||
+               std::holds_alternative<tau::PatternGreaterThanOrEqual>(count);
+    }
 
-                    // Check for aggregation
-                    const auto& agg = rule::rule_aggregate(rule);
-                    if (agg.has_value()) {
-                        // Store document for aggregation
-                        stored_docs[document_id] = {doc.data, *timestamp};
-
-                        // Compute hash of aggregate fields
-                        std::size_t hash = 0;
-                        bool skip = false;
-                        for (const auto& field : agg->fields) {
-                            auto val = mapped.find(field);
-                            if (val && val->is_string()) {
-                                hash ^= std::hash<std::string>{}(std::string(val->as_string()));
-                            } else {
-                                skip = true;
-                                break;
-                            }
-                        }
-                        if (skip)
-                            continue;
-
-                        auto key = std::make_pair(hunt.id, rid);
-                        auto& state = aggregates[key];
-                        state.aggregate = &(*agg);
-                        state.docs[hash].push_back(document_id);
-                    } else {
-                        hits.push_back(Hit{hunt.id, rid, *timestamp});
+    static std::uint64_t span(const rule::Aggregate& aggregate) {
+        constexpr std::uint64_t TICKS_PER_SECOND = 10'000'000;
+        return static_cast<std::uint64_t>(aggregate.timeframe->count()) * TICKS_PER_SECOND;
+    }
+
+    static std::vector<StoredDocument> take(std::deque<Event>& events, std::size_t count) {
+        std::vector<StoredDocument> documents;
+        documents.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            documents.push_back(std::move(events.front().document));
+            events.pop_front();
+        }
+        return documents;
+    }
+
+    /// Убрать события раньше now - timeframe
+    static void expire(const rule::Aggregate& aggregate, std::deque<Event>& events,
+                       std::uint64_t now) {
+        while (!events.empty() && events.front().time + span(aggregate) < now) {
+            events.pop_front();
+        }
+    }
+
+    /// Закрыть окно от первого события группы и проверить count
+    void close_front(const RuleWindows& rule, std::deque<Event>& events,
+                     std::vector<Closed>& closed) const {
+        std::uint64_t end = events.front().time + span(*rule.aggregate);
+        std::size_t count = 0;
+        while (count < events.size() && events[count].time <= end) {
+            ++count;
+        }
+        if (count_matches(rule.aggregate->count, count)) {
+            closed.push_back({events.front().sequence, &rule, take(events, count)});
+        } else {
+            events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(count));
+        }
+    }
+
+    /// Закрыть окна, закончившиеся до самого позднего события файла
+    void sweep() {
+        std::vector<Closed> closed;
+        groups_ = 0;
+        for (auto& rule : rules_) {
+            for (auto it = rule.groups.begin(); it != rule.groups.end();) {
+                auto& events = it->second;
+                if (grows(rule.aggregate->count)) {
+                    expire(*rule.aggregate, events, latest_);
+                } else {
+                    while (!events.empty() &&
+                           events.front().time + span(*rule.aggregate) < latest_) {
+                        close_front(rule, events, closed);
                     }
                 }
-            } else {
-                // HuntKindRule
-                const auto& rule_kind = std::get<HuntKindRule>(hunt.kind);
-
-                // SPEC-SLICE-012 FACT-019: проверка фильтра правила
-                bool hit = false;
-                if (std::holds_alternative<tau::Detection>(rule_kind.filter)) {
-                    hit = tau::solve(std::get<tau::Detection>(rule_kind.filter), mapped);
+                if (events.empty()) {
+                    it = rule.groups.erase(it);
                 } else {
-                    hit = tau::solve(std::get<tau::Expression>(rule_kind.filter), mapped);
+                    ++groups_;
+                    ++it;
                 }
+            }
+        }
+        sweep_at_ = std::max(MIN_SWEEP, 2 * groups_);
+        emit(closed);
+    }
 
-                if (hit) {
-                    if (rule_kind.aggregate.has_value()) {
-                        // Store document for aggregation
-                        stored_docs[document_id] = {doc.data, *timestamp};
-
-                        // Compute hash of aggregate fields
-                        std::size_t hash = 0;
-                        bool skip = false;
-                        for (const auto& field : rule_kind.aggregate->fields) {
-                            auto val = mapped.find(field);
-                            if (val && val->is_string()) {
-                                hash ^= std::hash<std::string>{}(std::string(val->as_string()));
-                            } else {
-                                skip = true;
-                                break;
-                            }
-                        }
-                        if (!skip) {
-                            auto key = std::make_pair(hunt.id, hunt.id);
-                            auto& state = aggregates[key];
-                            state.aggregate = &(*rule_kind.aggregate);
-                            state.docs[hash].push_back(document_id);
-                        }
-                    } else {
-                        hits.push_back(Hit{hunt.id, hunt.id, *timestamp});
-                    }
+    /// Выдать закрытые окна в порядке их первых событий
+    void emit(std::vector<Closed>& closed) {
+        std::sort(closed.begin(), closed.end(),
+                  [](const Closed& a, const Closed& b) { return a.sequence < b.sequence; });
+        for (auto& window : closed) {
+            emit_(window.rule->key, std::move(window.documents));
+        }
+    }
+
+    static constexpr std::size_t MIN_SWEEP = 1024;
+
+    Emit emit_;
+    std::vector<RuleWindows> rules_;  // в порядке первого события
+    std::unordered_map<RuleKey, std::size_t, RuleKeyHash> index_;
+    std::uint64_t latest_ = 0;    // самое позднее время события файла
+    std::uint64_t sequence_ = 0;  // счётчик событий
+    std::size_t groups_ = 0;      // групп не больше (точно сразу после sweep)
+    std::size_t sweep_at_ = MIN_SWEEP;
+};
+
+}  // namespace
+
+// ============================================================================
+// Конвейер hunt
+// ============================================================================
+//
+// Текущий поток читает документы пакетами и отдаёт их потокам сопоставления
+// через ограниченную очередь; в работе не больше 2 * matchers пакетов
+// (backpressure: чтение ждёт сборки самого раннего пакета). Сборка
+// детектирований, материализация документов и запись кэша идут в текущем
+// потоке по порядку документов — результат совпадает с последовательным.
+//
+
+bool Hunter::run_pipeline(
+    io::Reader& reader, io::DocumentKind kind, std::size_t matchers,
+    const std::function<bool(io::Document&, DocumentMatch&)>& collect) const {
+    struct Batch {
+        std::vector<io::Document> documents;
+        std::vector<DocumentMatch> matches;
+        std::size_t size = 0;
+        bool done = false;
+        std::exception_ptr error;
+    };
+
+    std::mutex mutex;
+    std::condition_variable queued;  // есть пакет для сопоставления или остановка
+    std::condition_variable matched;
+    std::deque<Batch*> queue;
+    bool stop = false;
+
+    std::deque<std::unique_ptr<Batch>> in_flight;  // в порядке чтения
+    std::vector<std::unique_ptr<Batch>> spare;
+
+    auto match_batches = [&] {
+        MatchScratch scratch(*predicates_, hunts_.size());
+        while (true) {
+            Batch* batch = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queued.wait(lock, [&] { return stop || !queue.empty(); });
+                if (stop) {
+                    return;
+                }
+                batch = queue.front();
+                queue.pop_front();
+            }
+            try {
+                for (std::size_t i = 0; i < batch->size; ++i) {
+                    match_document(batch->documents[i], kind, scratch, batch->matches[i]);
                 }
+            } catch (...) {
+                batch->error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch->done = true;
             }
+            matched.notify_all();
         }
+    };
 
-        // Add detection if we have hits
-        if (!hits.empty()) {
-            Detections det;
-            det.hits = std::move(hits);
+    std::vector<std::thread> threads;
+    // При любом выходе потоки останавливаются до разрушения пакетов
+    struct Join {
+        std::vector<std::thread>& threads;
+        std::mutex& mutex;
+        std::condition_variable& queued;
+        bool& stop;
+        ~Join() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            queued.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    } join{threads, mutex, queued, stop};
+    for (std::size_t i = 0; i < matchers; ++i) {
+        threads.emplace_back(match_batches);
+    }
 
-            if (cache_file) {
-                // Cache-to-disk mode
-                rapidjson::Document json_doc;
-                doc.data.to_rapidjson(json_doc, json_doc.GetAllocator());
+    // Собрать самый ранний пакет и вернуть его в запас
+    auto collect_front = [&]() -> bool {
+        Batch& batch = *in_flight.front();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            matched.wait(lock, [&batch] { return batch.done; });
+        }
+        if (batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+        for (std::size_t i = 0; i < batch.size; ++i) {
+            if (!collect(batch.documents[i], batch.matches[i])) {
+                return false;
+            }
+        }
+        batch.done = false;
+        spare.push_back(std::move(in_flight.front()));
+        in_flight.pop_front();
+        return true;
+    };
 
-                rapidjson::StringBuffer buffer;
-                rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                json_doc.Accept(writer);
+    const std::size_t capacity = 2 * matchers;
+    bool more = true;
+    while (more) {
+        if (in_flight.size() >= capacity && !collect_front()) {
+            return false;
+        }
 
-                std::fwrite(buffer.GetString(), 1, buffer.GetSize(), cache_file);
+        std::unique_ptr<Batch> batch;
+        if (!spare.empty()) {
+            batch = std::move(spare.back());
+            spare.pop_back();
+        } else {
+            batch = std::make_unique<Batch>();
+            batch->documents.resize(batch_size_);
+            batch->matches.resize(batch_size_);
+        }
 
-                KindCached cached;
-                cached.kind = file_kind;
-                cached.path = platform::path_to_utf8(path);
-                cached.offset = cache_offset;
-                cached.size = buffer.GetSize();
-                cache_offset += buffer.GetSize();
+        batch->size = 0;
+        while (batch->size < batch_size_ && reader.next(batch->documents[batch->size])) {
+            ++batch->size;
+        }
+        more = batch->size == batch_size_;
+        if (batch->size == 0) {
+            break;
+        }
 
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(batch.get());
+        }
+        queued.notify_one();
+        in_flight.push_back(std::move(batch));
+    }
+
+    while (!in_flight.empty()) {
+        if (!collect_front()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Hunter::HuntResult Hunter::hunt(const std::filesystem::path& path, DetectionCache* cache,
+                                std::size_t threads) const {
+    std::vector<Detections> detections;
+    rapidjson::StringBuffer record;
+    auto result = hunt_each(
+        path,
+        [&](Detections&& det) {
+            // Собранные детектирования ждут вызывающего: с кэшем документ — на диске
+            auto* ind = std::get_if<KindIndividual>(&det.kind);
+            if (ind && cache && documents_) {
+                KindCached cached;
+                cached.kind = ind->document.kind;
+                cached.path = std::move(ind->document.path);
+                cached.records.push_back(cache_document(*cache, ind->document.data, record));
                 det.kind = std::move(cached);
-            } else {
-                KindIndividual ind;
-                ind.document.kind = file_kind;
-                ind.document.path = platform::path_to_utf8(path);
-                ind.document.data = std::move(doc.data);
-                det.kind = std::move(ind);
             }
+            detections.push_back(std::move(det));
+            return true;
+        },
+        cache, threads);
+    result.detections = std::move(detections);
+    return result;
+}
+
+Hunter::HuntResult Hunter::hunt_each(const std::filesystem::path& path, const DetectionSink& sink,
+                                     DetectionCache* cache, std::size_t threads) const {
+    HuntResult result;
+    result.ok = false;
+
+    // Больше одного потока — конвейер. Потоки делятся, а не умножаются: EVTX
+    // получает половину на декодирование чанков, остальное — сопоставление;
+    // другие форматы читаются текущим потоком, сопоставление — в threads - 1
+    if (threads == 0) {
+        threads = num_threads_;
+    }
+    const bool pipeline = threads > 1;
+    const std::size_t decoders = pipeline ? std::max<std::size_t>(1, threads / 2) : threads;
 
-            result.detections.push_back(std::move(det));
+    // Open file using Reader
+    io::ReaderOptions reader_options;
+    reader_options.load_unknown = load_unknown_;
+    reader_options.skip_errors = skip_errors_;
+    reader_options.evtx_threads = decoders;
+    reader_options.projection = projection_;
+    reader_options.evtx_written_after = evtx_written_after_;
+    // Документы конвейера живут дольше следующего next(): арена читателя не подходит
+    reader_options.value_arena = !pipeline;
+    auto reader_result = io::Reader::open(path, reader_options);
+    if (!reader_result) {
+        if (skip_errors_) {
+            result.ok = true;
+            return result;
         }
+        result.error = reader_result.error.message;
+        return result;
     }
 
-    // Process aggregations (SPEC-SLICE-012 FACT-022-024)
-    for (const auto& [key, state] : aggregates) {
-        const auto& [hid, rid] = key;
-
-        for (const auto& [hash, doc_ids] : state.docs) {
-            // Check count pattern (SPEC-SLICE-012 FACT-023)
-            bool hit = false;
-            std::size_t count = doc_ids.size();
-
-            if (std::holds_alternative<tau::PatternEqual>(state.aggregate->count)) {
-                auto i = std::get<tau::PatternEqual>(state.aggregate->count).value;
-                hit = count == static_cast<std::size_t>(i);
-            } else if (std::holds_alternative<tau::PatternGreaterThan>(state.aggregate->count)) {
-                auto i = std::get<tau::PatternGreaterThan>(state.aggregate->count).value;
-                hit = count > static_cast<std::size_t>(i);
-            } else if (std::holds_alternative<tau::PatternGreaterThanOrEqual>(
-                           state.aggregate->count)) {
-                auto i = std::get<tau::PatternGreaterThanOrEqual>(state.aggregate->count).value;
-                hit = count >= static_cast<std::size_t>(i);
-            } else if (std::holds_alternative<tau::PatternLessThan>(state.aggregate->count)) {
-                auto i = std::get<tau::PatternLessThan>(state.aggregate->count).value;
-                hit = count < static_cast<std::size_t>(i);
-            } else if (std::holds_alternative<tau::PatternLessThanOrEqual>(
-                           state.aggregate->count)) {
-                auto i = std::get<tau::PatternLessThanOrEqual>(state.aggregate->count).value;
-                hit = count <= static_cast<std::size_t>(i);
+    auto& reader = *reader_result.reader;
+    io::DocumentKind file_kind = reader.kind();
+    std::size_t matchers = 0;
+    if (pipeline) {
+        matchers = file_kind == io::DocumentKind::Evtx ? threads - decoders : threads - 1;
+    }
+
+    // Aggregation state (SPEC-SLICE-012 FACT-022): группы по точному ключу значений
+    // полей; агрегации и группы перечисляются в порядке первого документа
+    struct AggregateState {
+        RuleKey key;
+        const rule::Aggregate* aggregate = nullptr;
+        std::unordered_map<std::string, std::size_t> index;  // ключ группы -> groups
+        std::vector<std::vector<std::uint32_t>> groups;      // номера stored_docs
+    };
+    std::vector<AggregateState> aggregates;
+    std::unordered_map<RuleKey, std::size_t, RuleKeyHash> aggregate_index;
+    std::vector<StoredDocument> stored_docs;  // документы агрегаций по порядковому номеру
+
+    // Детектирования уходят в приёмник сразу; false от него останавливает hunt
+    bool stopped = false;
+    auto emit = [&](Detections&& det) {
+        if (!stopped && !sink(std::move(det))) {
+            stopped = true;
+        }
+    };
+
+    // Cache-to-disk (SPEC-SLICE-012 FACT-029): документы агрегаций до их выдачи
+    rapidjson::StringBuffer record;
+
+    // Детектирование агрегации: время — самого раннего документа
+    auto add_aggregate = [&](const RuleKey& key, std::vector<StoredDocument>&& stored) {
+        Detections det;
+        DateTime timestamp = stored.front().timestamp;
+        for (const auto& document : stored) {
+            timestamp = std::min(timestamp, document.timestamp);
+        }
+        if (!documents_) {
+            det.kind = KindAggregate{};
+        } else if (cache) {
+            KindCached cached;
+            cached.kind = file_kind;
+            cached.path = platform::path_to_utf8(path);
+            cached.records.reserve(stored.size());
+            for (const auto& document : stored) {
+                cached.records.push_back(*document.cached);
+            }
+            cached.aggregate = true;
+            det.kind = std::move(cached);
+        } else {
+            KindAggregate agg;
+            agg.documents.reserve(stored.size());
+            for (const auto& document : stored) {
+                Document d;
+                d.kind = file_kind;
+                d.path = platform::path_to_utf8(path);
+                d.data = document.value();
+                agg.documents.push_back(std::move(d));
             }
+            det.kind = std::move(agg);
+        }
+        det.hits.push_back(Hit{key.first, key.second, timestamp});
+        emit(std::move(det));
+    };
 
-            if (hit) {
-                std::vector<Document> documents;
-                std::vector<DateTime> timestamps;
-
-                for (const auto& doc_id : doc_ids) {
-                    auto it = stored_docs.find(doc_id);
-                    if (it != stored_docs.end()) {
-                        Document d;
-                        d.kind = file_kind;
-                        d.path = platform::path_to_utf8(path);
-                        d.data = it->second.first;
-                        documents.push_back(std::move(d));
-                        timestamps.push_back(it->second.second);
-                    }
+    // Агрегации Sigma timeframe выдаются по мере закрытия окон
+    WindowedAggregates windowed(add_aggregate);
+
+    // Сборка по порядку документов: агрегации, детектирования, кэш на диск
+    auto collect = [&](io::Document& doc, DocumentMatch& match) {
+        if (match.error) {
+            result.error = std::move(*match.error);
+            return false;
+        }
+
+        bool grouped = std::any_of(match.aggregations.begin(), match.aggregations.end(),
+                                   [](const auto& aggregation) { return aggregation.group; });
+        if (grouped) {
+            // Store document for aggregation (время — последнего совпавшего hunt)
+            StoredDocument stored;
+            stored.timestamp = match.aggregations.back().timestamp;
+            if (!documents_) {
+                // Документы не выводятся: нужно только время
+            } else if (cache) {
+                // До конца файла или окна в памяти остаётся только ссылка на запись;
+                // копия из арены читателя не нужна
+                stored.cached = cache_document(
+                    *cache, doc.materialize ? doc.materialize() : doc.data, record);
+            } else if (match.hits.empty() && doc.materialize) {
+                // Ссылка на запись: документ собирается заново только для вывода
+                stored.materialize = std::move(doc.materialize);
+            } else {
+                // Документ детектирования собирается сейчас; его данные общие
+                materialize(doc);
+                stored.data = match.hits.empty() ? std::move(doc.data) : doc.data;
+            }
+            auto document_id = static_cast<std::uint32_t>(stored_docs.size());
+            bool whole_file = false;
+
+            for (auto& aggregation : match.aggregations) {
+                if (!aggregation.group) {
+                    continue;
+                }
+                if (aggregation.aggregate->timeframe) {
+                    // Время события окна — hunt этой агрегации
+                    StoredDocument event = stored;
+                    event.timestamp = aggregation.timestamp;
+                    windowed.add(aggregation.key, *aggregation.aggregate,
+                                 std::move(*aggregation.group), std::move(event));
+                    continue;
                 }
+                whole_file = true;
+                auto [it, inserted] =
+                    aggregate_index.try_emplace(aggregation.key, aggregates.size());
+                if (inserted) {
+                    aggregates.push_back({aggregation.key, aggregation.aggregate, {}, {}});
+                }
+                auto& state = aggregates[it->second];
+                auto [group, added] =
+                    state.index.try_emplace(std::move(*aggregation.group), state.groups.size());
+                if (added) {
+                    state.groups.emplace_back();
+                }
+                state.groups[group->second].push_back(document_id);
+            }
+            if (whole_file) {
+                stored_docs.push_back(std::move(stored));
+            }
+        }
 
-                // Sort timestamps
-                std::sort(timestamps.begin(), timestamps.end());
+        // Add detection if we have hits
+        if (match.hits.empty()) {
+            return !stopped;
+        }
+        Detections det;
+        det.hits = std::move(match.hits);
+
+        // Приёмник форматирует детектирование сразу: документ не пишется в кэш
+        KindIndividual ind;
+        ind.document.kind = file_kind;
+        ind.document.path = platform::path_to_utf8(path);
+        if (documents_) {
+            materialize(doc);
+            ind.document.data = std::move(doc.data);
+        }
+        det.kind = std::move(ind);
 
-                Detections det;
-                det.hits.push_back(Hit{hid, rid, timestamps.front()});
+        emit(std::move(det));
+        return !stopped;
+    };
 
-                KindAggregate agg;
-                agg.documents = std::move(documents);
-                det.kind = std::move(agg);
+    // Iterate through documents
+    if (matchers == 0) {
+        MatchScratch scratch(*predicates_, hunts_.size());
+        DocumentMatch match;
+        io::Document doc;
+        while (reader.next(doc)) {
+            match_document(doc, file_kind, scratch, match);
+            if (!collect(doc, match)) {
+                result.ok = stopped;
+                return result;
+            }
+        }
+    } else if (!run_pipeline(reader, file_kind, matchers, collect)) {
+        result.ok = stopped;
+        return result;
+    }
 
-                result.detections.push_back(std::move(det));
+    // Process aggregations (SPEC-SLICE-012 FACT-022-024)
+    windowed.flush();
+    for (const auto& state : aggregates) {
+        for (const auto& doc_ids : state.groups) {
+            if (stopped || !count_matches(state.aggregate->count, doc_ids.size())) {
+                continue;
             }
+            std::vector<StoredDocument> documents;
+            documents.reserve(doc_ids.size());
+            for (auto doc_id : doc_ids) {
+                documents.push_back(stored_docs[doc_id]);
+            }
+            add_aggregate(state.key, std::move(documents));
         }
     }
 
@@ -1072,7 +1930,7 @@ const rule::Rule* find_rule(const std::unordered_map<UUID, rule::Rule, UUID::Has
 
 std::string detections_to_json(const Detections& det, const std::vector<Hunt>& hunts,
                                const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
-                               bool local_time) {
+                               bool local_time, DetectionCache* cache) {
     (void)local_time;  // TODO: implement timezone handling
 
     rapidjson::Document doc;
@@ -1127,6 +1985,25 @@ std::string detections_to_json(const Detections& det, const std::vector<Hunt>& h
         }
         doc.AddMember("documents", docs_arr, alloc);
         doc.AddMember("kind", "aggregate", alloc);
+    } else if (const auto* cached = std::get_if<KindCached>(&det.kind); cached && cache) {
+        // Записи кэша — тот же компактный JSON, что дал бы документ в памяти
+        std::string text;
+        for (std::size_t i = 0; i < cached->records.size(); ++i) {
+            text += i > 0 ? "," : "";
+            text += cache->read(cached->records[i].offset, cached->records[i].size);
+        }
+        if (cached->aggregate) {
+            text = "[" + text + "]";
+        }
+        rapidjson::Document data_doc(&alloc);
+        data_doc.Parse(text.data(), text.size());
+        if (data_doc.HasParseError()) {
+            data_doc.SetNull();
+        }
+        doc.AddMember(rapidjson::StringRef(cached->aggregate ? "documents" : "document"),
+                      static_cast<rapidjson::Value&>(data_doc), alloc);
+        doc.AddMember("kind", rapidjson::StringRef(cached->aggregate ? "aggregate" : "individual"),
+                      alloc);
     }
 
     rapidjson::StringBuffer buffer;
@@ -1138,57 +2015,55 @@ std::string detections_to_json(const Detections& det, const std::vector<Hunt>& h
 
 std::string detections_to_jsonl(const Detections& det, const std::vector<Hunt>& hunts,
                                 const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
-                                bool local_time) {
+                                bool local_time, DetectionCache* cache) {
     // JSONL is just JSON without pretty printing, one per line
-    return detections_to_json(det, hunts, rules, local_time) + "\n";
+    return detections_to_json(det, hunts, rules, local_time, cache) + "\n";
 }
 
-std::string format_table(const std::vector<Detections>& detections, const std::vector<Hunt>& hunts,
-                         const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
-                         std::uint32_t column_width, bool full, bool metadata, bool local_time) {
-    (void)column_width;
-    (void)full;
-    (void)metadata;
-    (void)local_time;
+namespace {
 
-    if (detections.empty()) {
-        return "";
-    }
+// Unicode box-drawing characters
+const char* const top_left = "\xe2\x94\x8c";      // ┌
+const char* const top_right = "\xe2\x94\x90";     // ┐
+const char* const bottom_left = "\xe2\x94\x94";   // └
+const char* const bottom_right = "\xe2\x94\x98";  // ┘
+const char* const horizontal = "\xe2\x94\x80";    // ─
+const char* const vertical = "\xe2\x94\x82";      // │
+const char* const t_down = "\xe2\x94\xac";        // ┬
+const char* const t_up = "\xe2\x94\xb4";          // ┴
+const char* const t_right = "\xe2\x94\x9c";       // ├
+const char* const t_left = "\xe2\x94\xa4";        // ┤
+const char* const cross = "\xe2\x94\xbc";         // ┼
+
+// Column widths
+constexpr int col_timestamp = 24;
+constexpr int col_detections = 50;
+constexpr int col_data = 40;
+
+/// Горизонтальная линия таблицы
+void draw_border(std::stringstream& ss, const char* left, const char* joint, const char* right) {
+    ss << left;
+    for (int i = 0; i < col_timestamp; ++i)
+        ss << horizontal;
+    ss << joint;
+    for (int i = 0; i < col_detections; ++i)
+        ss << horizontal;
+    ss << joint;
+    for (int i = 0; i < col_data; ++i)
+        ss << horizontal;
+    ss << right << "\n";
+}
+
+}  // namespace
 
+std::string format_table_header() {
     std::stringstream ss;
 
     // Header
     ss << "\n";
 
-    // Unicode box-drawing characters
-    const char* top_left = "\xe2\x94\x8c";      // ┌
-    const char* top_right = "\xe2\x94\x90";     // ┐
-    const char* bottom_left = "\xe2\x94\x94";   // └
-    const char* bottom_right = "\xe2\x94\x98";  // ┘
-    const char* horizontal = "\xe2\x94\x80";    // ─
-    const char* vertical = "\xe2\x94\x82";      // │
-    const char* t_down = "\xe2\x94\xac";        // ┬
-    const char* t_up = "\xe2\x94\xb4";          // ┴
-    const char* t_right = "\xe2\x94\x9c";       // ├
-    const char* t_left = "\xe2\x94\xa4";        // ┤
-    const char* cross = "\xe2\x94\xbc";         // ┼
-
-    // Column widths
-    constexpr int col_timestamp = 24;
-    constexpr int col_detections = 50;
-    constexpr int col_data = 40;
-
     // Draw top border
-    ss << top_left;
-    for (int i = 0; i < col_timestamp; ++i)
-        ss << horizontal;
-    ss << t_down;
-    for (int i = 0; i < col_detections; ++i)
-        ss << horizontal;
-    ss << t_down;
-    for (int i = 0; i < col_data; ++i)
-        ss << horizontal;
-    ss << top_right << "\n";
+    draw_border(ss, top_left, t_down, top_right);
 
     // Header row
     ss << vertical << " Timestamp              " << vertical
@@ -1196,76 +2071,91 @@ std::string format_table(const std::vector<Detections>& detections, const std::v
        << " Data                                   " << vertical << "\n";
 
     // Header separator
-    ss << t_right;
-    for (int i = 0; i < col_timestamp; ++i)
-        ss << horizontal;
-    ss << cross;
-    for (int i = 0; i < col_detections; ++i)
-        ss << horizontal;
-    ss << cross;
-    for (int i = 0; i < col_data; ++i)
-        ss << horizontal;
-    ss << t_left << "\n";
+    draw_border(ss, t_right, cross, t_left);
 
-    // Data rows
-    for (const auto& det : detections) {
-        if (det.hits.empty())
-            continue;
+    return ss.str();
+}
 
-        const auto& hit = det.hits.front();
-        const Hunt* hunt = find_hunt(hunts, hit.hunt);
-        const rule::Rule* rule_ptr = find_rule(rules, hit.rule);
+std::string format_table_row(const Detections& det, const std::vector<Hunt>& hunts,
+                             const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
+                             std::uint32_t column_width, bool full, bool metadata,
+                             bool local_time) {
+    (void)column_width;
+    (void)full;
+    (void)metadata;
+    (void)local_time;
 
-        // Timestamp
-        ss << vertical << " " << hit.timestamp.to_string();
+    if (det.hits.empty()) {
+        return "";
+    }
 
-        // Pad timestamp
-        int ts_len = static_cast<int>(hit.timestamp.to_string().size());
-        for (int i = ts_len + 1; i < col_timestamp; ++i)
-            ss << " ";
-        ss << vertical;
+    std::stringstream ss;
 
-        // Detections column
-        std::string det_str;
-        if (hunt) {
-            // ANSI green for group name
-            det_str = "\033[32m" + hunt->group + "\033[0m";
-        }
-        if (rule_ptr) {
-            det_str += " " + std::string(RULE_PREFIX) + " " + rule::rule_name(*rule_ptr);
-        }
+    const auto& hit = det.hits.front();
+    const Hunt* hunt = find_hunt(hunts, hit.hunt);
+    const rule::Rule* rule_ptr = find_rule(rules, hit.rule);
 
-        ss << " " << det_str;
+    // Timestamp
+    ss << vertical << " " << hit.timestamp.to_string();
 
-        // Pad detections (approximation, ANSI codes make this tricky)
-        int det_visible_len = hunt ? static_cast<int>(hunt->group.size()) : 0;
-        if (rule_ptr) {
-            det_visible_len += 3 + static_cast<int>(rule::rule_name(*rule_ptr).size());
-        }
-        for (int i = det_visible_len + 1; i < col_detections; ++i)
-            ss << " ";
-        ss << vertical;
+    // Pad timestamp
+    int ts_len = static_cast<int>(hit.timestamp.to_string().size());
+    for (int i = ts_len + 1; i < col_timestamp; ++i)
+        ss << " ";
+    ss << vertical;
 
-        // Data column (abbreviated)
-        ss << " ...";
-        for (int i = 4; i < col_data; ++i)
-            ss << " ";
-        ss << vertical << "\n";
+    // Detections column
+    std::string det_str;
+    if (hunt) {
+        // ANSI green for group name
+        det_str = "\033[32m" + hunt->group + "\033[0m";
+    }
+    if (rule_ptr) {
+        det_str += " " + std::string(RULE_PREFIX) + " " + rule::rule_name(*rule_ptr);
+    }
+
+    ss << " " << det_str;
+
+    // Pad detections (approximation, ANSI codes make this tricky)
+    int det_visible_len = hunt ? static_cast<int>(hunt->group.size()) : 0;
+    if (rule_ptr) {
+        det_visible_len += 3 + static_cast<int>(rule::rule_name(*rule_ptr).size());
     }
+    for (int i = det_visible_len + 1; i < col_detections; ++i)
+        ss << " ";
+    ss << vertical;
+
+    // Data column (abbreviated)
+    ss << " ...";
+    for (int i = 4; i < col_data; ++i)
+        ss << " ";
+    ss << vertical << "\n";
+
+    return ss.str();
+}
+
+std::string format_table_footer() {
+    std::stringstream ss;
 
     // Bottom border
-    ss << bottom_left;
-    for (int i = 0; i < col_timestamp; ++i)
-        ss << horizontal;
-    ss << t_up;
-    for (int i = 0; i < col_detections; ++i)
-        ss << horizontal;
-    ss << t_up;
-    for (int i = 0; i < col_data; ++i)
-        ss << horizontal;
-    ss << bottom_right << "\n";
+    draw_border(ss, bottom_left, t_up, bottom_right);
 
     return ss.str();
 }
 
+std::string format_table(const std::vector<Detections>& detections, const std::vector<Hunt>& hunts,
+                         const std::unordered_map<UUID, rule::Rule, UUID::Hash>& rules,
+                         std::uint32_t column_width, bool full, bool metadata, bool local_time) {
+    if (detections.empty()) {
+        return "";
+    }
+
+    std::string table = format_table_header();
+    for (const auto& det : detections) {
+        table += format_table_row(det, hunts, rules, column_width, full, metadata, local_time);
+    }
+    table += format_table_footer();
+    return table;
+}
+
 }  // namespace chainsaw::hunt
@@ -0,0 +1,311 @@
+// ==============================================================================
+// rule_index.cpp - Индекс правил по обязательным равенствам полей
+// ==============================================================================
+//
+// MOD-0012 hunt (отбор правил-кандидатов для документа)
+//
+// ==============================================================================
+
+#include <algorithm>
+#include <cctype>
+#include <chainsaw/rule_index.hpp>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+
+namespace chainsaw::hunt {
+
+namespace {
+
+using Equalities = std::vector<Equality>;
+
+Equality* find_field(Equalities& equalities, const tau::FieldPath& field) {
+    for (auto& equality : equalities) {
+        if (equality.field == field.str()) {
+            return &equality;
+        }
+    }
+    return nullptr;
+}
+
+// Search, истинный только при равенстве значения одной из строк
+std::optional<Equality> search_equality(const tau::ExprSearch& search) {
+    if (const auto* exact = std::get_if<tau::SearchExact>(&search.search)) {
+        return Equality{search.field, {exact->value}, {}, {}};
+    }
+    const auto* ac = std::get_if<tau::SearchAhoCorasick>(&search.search);
+    if (ac == nullptr || ac->match_types.empty()) {
+        return std::nullopt;
+    }
+    Equality equality{search.field, {}, {}, {}};
+    for (const auto& entry : ac->match_types) {
+        if (entry.type != tau::MatchType::Exact) {
+            return std::nullopt;
+        }
+        if (ac->ignore_case) {
+            equality.folded.push_back(tau::ascii_lowercase(entry.value));
+        } else {
+            equality.exact.push_back(entry.value);
+        }
+    }
+    return equality;
+}
+
+// Сравнение поля с числом (Field == Integer/Float, в том числе число слева),
+// истинное только при равенстве value_to_double значения поля этому числу
+std::optional<Equality> comparison_equality(const tau::ExprBooleanExpression& comparison) {
+    if (comparison.op != tau::BoolSym::Equal) {
+        return std::nullopt;
+    }
+    const auto* field = comparison.left->get_field();
+    const tau::Expression* number = comparison.right.get();
+    if (field == nullptr) {
+        field = comparison.right->get_field();
+        number = comparison.left.get();
+    }
+    if (field == nullptr) {
+        return std::nullopt;
+    }
+
+    double value = 0;
+    if (const auto* i = number->get_int()) {
+        value = static_cast<double>(i->value);
+    } else if (const auto* f = number->get_float()) {
+        value = f->value;
+    } else {
+        return std::nullopt;
+    }
+    if (std::isnan(value)) {
+        return std::nullopt;
+    }
+    return Equality{field->name, {}, {}, {number_key(value)}};
+}
+
+// Match с числовым равенством: целое (value_to_int) совпадает с полем, только если
+// совпадает и value_to_double
+std::optional<Equality> match_equality(const tau::ExprMatch& match) {
+    const auto* field = match.inner->get_field();
+    if (field == nullptr) {
+        return std::nullopt;
+    }
+    if (const auto* equal = std::get_if<tau::PatternEqual>(&match.pattern)) {
+        return Equality{field->name, {}, {}, {number_key(static_cast<double>(equal->value))}};
+    }
+    const auto* fequal = std::get_if<tau::PatternFEqual>(&match.pattern);
+    if (fequal == nullptr || std::isnan(fequal->value)) {
+        return std::nullopt;
+    }
+    return Equality{field->name, {}, {}, {number_key(fequal->value)}};
+}
+
+Equalities collect_equalities(const tau::Expression& expr) {
+    std::optional<Equality> leaf;
+    if (const auto* search = expr.get_search()) {
+        leaf = search_equality(*search);
+    } else if (const auto* comparison = std::get_if<tau::ExprBooleanExpression>(&expr.data)) {
+        leaf = comparison_equality(*comparison);
+    } else if (const auto* match = std::get_if<tau::ExprMatch>(&expr.data)) {
+        leaf = match_equality(*match);
+    }
+    if (leaf) {
+        return Equalities{std::move(*leaf)};
+    }
+
+    const auto* group = expr.get_boolean_group();
+    if (group == nullptr || group->expressions.empty()) {
+        return {};
+    }
+
+    if (group->op == tau::BoolSym::And) {
+        // Достаточно любого элемента; на одно поле — самое узкое равенство
+        Equalities result;
+        for (const auto& child : group->expressions) {
+            for (auto& equality : collect_equalities(child)) {
+                Equality* existing = find_field(result, equality.field);
+                if (existing == nullptr) {
+                    result.push_back(std::move(equality));
+                } else if (equality.size() < existing->size()) {
+                    *existing = std::move(equality);
+                }
+            }
+        }
+        return result;
+    }
+
+    if (group->op == tau::BoolSym::Or) {
+        // Поле должно быть ограничено в каждой ветви; значения объединяются
+        Equalities result = collect_equalities(group->expressions.front());
+        for (std::size_t i = 1; i < group->expressions.size() && !result.empty(); ++i) {
+            Equalities branch = collect_equalities(group->expressions[i]);
+            Equalities merged;
+            for (auto& equality : result) {
+                Equality* other = find_field(branch, equality.field);
+                if (other == nullptr) {
+                    continue;
+                }
+                equality.exact.insert(equality.exact.end(), other->exact.begin(),
+                                      other->exact.end());
+                equality.folded.insert(equality.folded.end(), other->folded.begin(),
+                                       other->folded.end());
+                equality.numeric.insert(equality.numeric.end(), other->numeric.begin(),
+                                        other->numeric.end());
+                merged.push_back(std::move(equality));
+            }
+            result = std::move(merged);
+        }
+        return result;
+    }
+
+    return {};
+}
+
+void sort_unique(std::vector<std::string>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+}  // namespace
+
+std::string number_key(double value) {
+    if (value == 0) {
+        value = 0;  // -0 == 0
+    }
+    char text[32];
+    auto [end, ec] = std::to_chars(std::begin(text), std::end(text), value);
+    return std::string(text, ec == std::errc{} ? end : text);
+}
+
+std::vector<Equality> required_equalities(const tau::Expression& expression) {
+    auto result = collect_equalities(expression);
+    for (auto& equality : result) {
+        sort_unique(equality.exact);
+        sort_unique(equality.folded);
+        sort_unique(equality.numeric);
+    }
+    return result;
+}
+
+RuleIndex::RuleIndex(const std::vector<const tau::Expression*>& filters) {
+    std::vector<Equalities> per_rule(filters.size());
+    std::unordered_map<std::string, std::size_t> usage;
+    for (std::size_t i = 0; i < filters.size(); ++i) {
+        if (filters[i] == nullptr) {
+            continue;
+        }
+        per_rule[i] = required_equalities(*filters[i]);
+        for (const auto& equality : per_rule[i]) {
+            ++usage[equality.field.str()];
+        }
+    }
+
+    // Поле правила: общее для большего числа правил, затем с меньшим числом значений
+    auto rank = [&usage](const Equality& equality) {
+        return std::make_tuple(usage[equality.field.str()],
+                               -static_cast<std::ptrdiff_t>(equality.size()));
+    };
+
+    std::unordered_map<std::string, std::size_t> field_index;
+    for (std::size_t i = 0; i < per_rule.size(); ++i) {
+        const Equality* best = nullptr;
+        for (const auto& equality : per_rule[i]) {
+            if (best == nullptr || rank(equality) > rank(*best) ||
+                (rank(equality) == rank(*best) && equality.field.str() < best->field.str())) {
+                best = &equality;
+            }
+        }
+
+        auto id = static_cast<std::uint32_t>(i);
+        if (best == nullptr) {
+            residual_.push_back(id);
+            continue;
+        }
+
+        auto [it, inserted] = field_index.try_emplace(best->field.str(), fields_.size());
+        if (inserted) {
+            fields_.push_back(Field{best->field, {}, {}, {}});
+        }
+        Field& field = fields_[it->second];
+        for (const auto& value : best->exact) {
+            field.exact[value].push_back(id);
+        }
+        for (const auto& value : best->folded) {
+            field.folded[value].push_back(id);
+        }
+        for (const auto& value : best->numeric) {
+            field.numeric[value].push_back(id);
+        }
+        ++indexed_;
+    }
+}
+
+void RuleIndex::candidates(const tau::Document& document,
+                           std::vector<std::uint32_t>& out) const {
+    out.clear();
+    std::string folded;
+    for (const auto& field : fields_) {
+        auto value = document.resolve(field.path);
+        if (value) {
+            collect(field, *value, folded, out);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+
+    // Правила из таблиц и residual не пересекаются
+    auto middle = static_cast<std::ptrdiff_t>(out.size());
+    out.insert(out.end(), residual_.begin(), residual_.end());
+    std::inplace_merge(out.begin(), out.begin() + middle, out.end());
+}
+
+void RuleIndex::collect(const Field& field, const Value& value, std::string& folded,
+                        std::vector<std::uint32_t>& out) const {
+    if (value.is_array()) {
+        for (const auto& elem : value.as_array()) {
+            collect(field, elem, folded, out);
+        }
+        return;
+    }
+
+    if (!field.numeric.empty()) {
+        auto number = tau::value_to_double(value);
+        if (number && !std::isnan(*number)) {
+            auto it = field.numeric.find(number_key(*number));
+            if (it != field.numeric.end()) {
+                out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+    if (field.exact.empty() && field.folded.empty()) {
+        return;
+    }
+
+    std::string converted;
+    std::string_view text;
+    if (value.is_string()) {
+        text = value.as_string();
+    } else {
+        converted = tau::value_to_string(value);
+        text = converted;
+    }
+
+    if (!field.exact.empty()) {
+        auto it = field.exact.find(text);
+        if (it != field.exact.end()) {
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+    if (!field.folded.empty()) {
+        folded.assign(text);
+        for (auto& c : folded) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        auto it = field.folded.find(std::string_view(folded));
+        if (it != field.folded.end()) {
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
+
+}  // namespace chainsaw::hunt
@@ -14,13 +14,16 @@
 #include <algorithm>
 #include <chainsaw/evtx.hpp>
 #include <chainsaw/platform.hpp>
+#include <chainsaw/utf16.hpp>
+#include <charconv>
+#include <condition_variable>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 #include <map>
-#include <pugixml.hpp>
-#include <sstream>
-#include <stack>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 
 namespace chainsaw::evtx {
 
@@ -60,31 +63,521 @@ const EvtxRecord& EvtxRecordIterator::operator*() const {
     return *current_;
 }
 
+// ============================================================================
+// Декодирование чанка (общее для последовательного и параллельного режимов)
+// ============================================================================
+
+using StringCache = std::unordered_map<std::uint32_t, std::string>;
+using TemplateMap = std::unordered_map<std::uint32_t, std::shared_ptr<const BinXmlTemplate>>;
+
+// ============================================================================
+// Форматирование значений в буфер вызывающего
+// ============================================================================
+//
+// Значения записей форматируются без потоков и gmtime: цифры пишутся в буфер на
+// стеке, строка результата создаётся один раз. Байты вывода совпадают с прежним
+// форматированием через ostringstream (setw/setfill, std::hex, std::uppercase).
+
+constexpr char HEX_LOWER[] = "0123456789abcdef";
+constexpr char HEX_UPPER[] = "0123456789ABCDEF";
+
+/// Десятичное число, дополненное нулями слева до width цифр (как setw + setfill('0'))
+static char* put_decimal(char* out, std::uint64_t value, int width = 0) {
+    char digits[20];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    for (int count = static_cast<int>(end - digits); width > count; --width) {
+        *out++ = '0';
+    }
+    return std::copy(digits, end, out);
+}
+
+/// Ровно digits шестнадцатеричных цифр по таблице
+static char* put_hex(char* out, std::uint64_t value, int digits, const char* table) {
+    for (int i = digits - 1; i >= 0; --i) {
+        out[i] = table[value & 0xF];
+        value >>= 4;
+    }
+    return out + digits;
+}
+
+/// Целое в десятичной записи (как std::to_string)
+template <typename T>
+static std::string decimal_string(T value) {
+    char text[24];
+    return std::string(text, std::to_chars(text, text + sizeof(text), value).ptr);
+}
+
+/// Целое в шестнадцатеричной записи без ведущих нулей с префиксом "0x"
+static std::string hex_string(std::uint64_t value) {
+    char text[24] = {'0', 'x'};
+    return std::string(text, std::to_chars(text + 2, text + sizeof(text), value, 16).ptr);
+}
+
+/// Дата григорианского календаря по числу дней от 1970-01-01 (civil_from_days
+/// Говарда Хиннанта; дни не отрицательны — FILETIME раньше эпохи Unix не форматируется)
+struct CivilDate {
+    std::uint64_t year;
+    unsigned month;
+    unsigned day;
+};
+
+static CivilDate civil_from_days(std::uint64_t days) {
+    days += 719468;  // Сдвиг к эпохе 0000-03-01
+    const std::uint64_t era = days / 146097;
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    return {yoe + era * 400 + (month <= 2 ? 1 : 0), month, day};
+}
+
+/// Префикс «YYYY-MM-DD» последнего отформатированного дня: записи чанка почти
+/// всегда укладываются в один день, календарь пересчитывается при смене дня
+struct DatePrefix {
+    std::uint64_t day = ~std::uint64_t{0};
+    char text[16];
+    std::size_t size = 0;
+};
+
+/// Максимальная длина FILETIME в ISO 8601 (год FILETIME — не больше пяти цифр)
+constexpr std::size_t FILETIME_TEXT_MAX = 32;
+
+/// FILETIME → "YYYY-MM-DDTHH:MM:SS.ffffffZ" в буфер out
+/// @return Длина текста; 0 — время раньше 1970-01-01
+static std::size_t format_filetime(char* out, std::uint64_t filetime, DatePrefix& prefix) {
+    // Windows FILETIME: 100-наносекундные интервалы с 1601-01-01
+    constexpr std::uint64_t FILETIME_UNIX_DIFF = 116444736000000000ULL;
+    if (filetime < FILETIME_UNIX_DIFF) {
+        return 0;
+    }
+
+    const std::uint64_t unix_100ns = filetime - FILETIME_UNIX_DIFF;
+    const std::uint64_t seconds = unix_100ns / 10000000ULL;
+    const std::uint64_t microseconds = (unix_100ns % 10000000ULL) / 10;
+    const std::uint64_t day = seconds / 86400;
+    if (day != prefix.day) {
+        const CivilDate date = civil_from_days(day);
+        char* p = put_decimal(prefix.text, date.year, 4);
+        *p++ = '-';
+        p = put_decimal(p, date.month, 2);
+        *p++ = '-';
+        p = put_decimal(p, date.day, 2);
+        prefix.size = static_cast<std::size_t>(p - prefix.text);
+        prefix.day = day;
+    }
+
+    const std::uint64_t time = seconds % 86400;
+    char* p = std::copy_n(prefix.text, prefix.size, out);
+    *p++ = 'T';
+    p = put_decimal(p, time / 3600, 2);
+    *p++ = ':';
+    p = put_decimal(p, time / 60 % 60, 2);
+    *p++ = ':';
+    p = put_decimal(p, time % 60, 2);
+    *p++ = '.';
+    p = put_decimal(p, microseconds, 6);
+    *p++ = 'Z';
+    return static_cast<std::size_t>(p - out);
+}
+
+static std::string filetime_string(std::uint64_t filetime, DatePrefix& prefix) {
+    char text[FILETIME_TEXT_MAX];
+    return std::string(text, format_filetime(text, filetime, prefix));
+}
+
+/// План сборки каркаса по проекции полей (определение ниже)
+struct BinXmlProjectionPlan;
+
+/// Кеши чанка: имена и шаблоны по смещению, планы проекции по (шаблон, проекция)
+///
+/// Смещения относятся к чанку, поэтому кеши создаются заново для каждого чанка.
+/// Записи, прочитанные по проекции, держат кеши своего чанка для полной сборки.
+struct BinXmlChunkCaches {
+    StringCache strings;
+    TemplateMap templates;
+    std::map<std::pair<const BinXmlTemplate*, const FieldProjection*>,
+             std::shared_ptr<const BinXmlProjectionPlan>>
+        plans;
+    DatePrefix dates;
+};
+
+/// Проекция «все поля» для узлов, форма которых зависит от всего содержимого
+static const FieldProjection& all_fields() {
+    static const FieldProjection all;
+    return all;
+}
+
+/// Пустая проекция: документ только читается (значения пропускаются)
+static const FieldProjection& no_fields() {
+    static const FieldProjection none(std::vector<std::string>{});
+    return none;
+}
+
+/// Прочитать little-endian значение из данных чанка
+template <typename T>
+static T load_le(const std::uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// Binary XML записи → Value (определение ниже, после парсера токенов)
+/// @param data Данные записи (срез данных чанка)
+/// @param chunk_offset Смещение данных записи относительно начала чанка
+/// @param projection Нужные поля (nullptr — все)
+static Value decode_binxml(std::span<const std::uint8_t> data, std::size_t chunk_offset,
+                           BinXmlChunkCaches& caches, const FieldProjection* projection);
+
+/// Проверить заголовок чанка и прочитать free_space_offset
+/// @return false — не чанк (конец файла или пустое пространство)
+static bool parse_chunk_header(std::span<const std::uint8_t> chunk,
+                               std::uint32_t& free_space_offset) {
+    // Магия "ElfChnk\0" и поля заголовка до free_space_offset включительно
+    constexpr std::size_t FREE_SPACE_OFFSET = 48;
+    if (chunk.size() < FREE_SPACE_OFFSET + 4) {
+        return false;
+    }
+    if (std::memcmp(chunk.data(), CHUNK_HEADER_MAGIC, 8) != 0) {
+        return false;
+    }
+    free_space_offset = load_le<std::uint32_t>(chunk.data() + FREE_SPACE_OFFSET);
+    return true;
+}
+
+// Запись — срез данных чанка: [заголовок 24][Binary XML][копия размера 4]
+constexpr std::size_t RECORD_HEADER_SIZE = 24;
+
+/// Прочитать заголовок записи по смещению offset относительно начала чанка
+/// @return false — невалидная запись (остаток чанка пропускается)
+static bool read_record_header(std::span<const std::uint8_t> chunk, std::size_t offset,
+                               RecordHeader& header) {
+    if (offset + RECORD_HEADER_SIZE > chunk.size()) {
+        return false;
+    }
+    const std::uint8_t* data = chunk.data() + offset;
+
+    // Проверяем сигнатуру записи 0x00002a2a ("**\0\0")
+    header.signature = load_le<std::uint32_t>(data);
+    if (header.signature != 0x00002a2a) {
+        return false;
+    }
+
+    header.size = load_le<std::uint32_t>(data + 4);
+    header.record_id = load_le<std::uint64_t>(data + 8);
+    header.timestamp = load_le<std::uint64_t>(data + 16);
+    return header.size >= RECORD_HEADER_SIZE + 4 && offset + header.size - 4 <= chunk.size();
+}
+
+/// Binary XML записи с проверенным заголовком
+static std::span<const std::uint8_t> record_binxml(std::span<const std::uint8_t> chunk,
+                                                   std::size_t offset,
+                                                   const RecordHeader& header) {
+    return chunk.subspan(offset + RECORD_HEADER_SIZE, header.size - 28);
+}
+
+/// Декодировать запись с проверенным заголовком
+/// @param owner Владелец буфера чанка (nullptr — срез отображения файла)
+static void decode_record(std::span<const std::uint8_t> chunk,
+                          const std::shared_ptr<const void>& owner, std::size_t offset,
+                          const RecordHeader& header,
+                          const std::shared_ptr<BinXmlChunkCaches>& caches,
+                          const FieldProjection* projection, EvtxRecord& record) {
+    // Парсим Binary XML прямо из данных чанка
+    record.data = decode_binxml(record_binxml(chunk, offset, header), offset + RECORD_HEADER_SIZE,
+                                *caches, projection);
+    record.record_id = header.record_id;
+    record.timestamp = filetime_string(header.timestamp, caches->dates);
+
+    // По проекции построена только часть полей: полный документ собирается
+    // повторно из тех же данных чанка, когда он нужен для вывода
+    record.full = nullptr;
+    if (projection) {
+        record.full = [chunk, owner, caches, offset, header] {
+            EvtxRecord full;
+            decode_record(chunk, owner, offset, header, caches, nullptr, full);
+            return std::move(full.data);
+        };
+    }
+}
+
+/// Прочитать запись вне окна времени без сборки документа: следующие записи
+/// чанка ссылаются на определения шаблонов и имена, впервые встреченные в ней
+static void scan_record(std::span<const std::uint8_t> chunk, std::size_t offset,
+                        const RecordHeader& header, BinXmlChunkCaches& caches) {
+    decode_binxml(record_binxml(chunk, offset, header), offset + RECORD_HEADER_SIZE, caches,
+                  &no_fields());
+}
+
+/// Граница записей чанка, которые нужно прочитать для окна времени: конец последней
+/// записи в окне (CHUNK_HEADER_SIZE — в окне нет ни одной записи). Смотрит только
+/// заголовки записей; для неограниченного окна — free_space_offset
+static std::size_t window_end(std::span<const std::uint8_t> chunk,
+                              std::uint32_t free_space_offset, const EvtxTimeWindow& window) {
+    if (window.unbounded()) {
+        return free_space_offset;
+    }
+    std::size_t end = CHUNK_HEADER_SIZE;
+    std::size_t offset = CHUNK_HEADER_SIZE;
+    RecordHeader header{};
+    while (offset < free_space_offset && read_record_header(chunk, offset, header)) {
+        offset += header.size;
+        if (window.contains(header.timestamp)) {
+            end = offset;
+        }
+    }
+    return end;
+}
+
+/// Декодировать все записи чанка, попадающие в окно времени
+/// @return false — невалидный заголовок чанка (конец данных)
+static bool decode_chunk(std::span<const std::uint8_t> chunk,
+                         const std::shared_ptr<const void>& owner,
+                         const FieldProjection* projection, const EvtxTimeWindow& window,
+                         std::vector<EvtxRecord>& records) {
+    std::uint32_t free_space_offset = 0;
+    if (!parse_chunk_header(chunk, free_space_offset)) {
+        return false;
+    }
+
+    std::size_t end = window_end(chunk, free_space_offset, window);
+    if (end == CHUNK_HEADER_SIZE) {
+        return true;  // Чанк целиком вне окна
+    }
+
+    auto caches = std::make_shared<BinXmlChunkCaches>();
+    std::size_t offset = CHUNK_HEADER_SIZE;
+    RecordHeader header{};
+    while (offset < end && read_record_header(chunk, offset, header)) {
+        if (window.contains(header.timestamp)) {
+            EvtxRecord record;
+            decode_record(chunk, owner, offset, header, caches, projection, record);
+            records.push_back(std::move(record));
+        } else {
+            scan_record(chunk, offset, header, *caches);
+        }
+        offset += header.size;
+    }
+    return true;
+}
+
+// ============================================================================
+// EvtxParser::ChunkPipeline - параллельное декодирование чанков
+// ============================================================================
+
+/// Пул потоков, декодирующих чанки в окно слотов
+///
+/// Потоки забирают индексы чанков по порядку и декодируют их с кешами строк
+/// и шаблонов своего чанка (BinXmlTemplateCache общий). Окно ограничивает число
+/// декодированных, но ещё не выданных чанков; потребитель забирает чанки строго
+/// по возрастанию индекса, поэтому порядок записей совпадает с файлом.
+/// С аренами документы чанка строятся в арене чанка; потребитель возвращает её
+/// через recycle(), когда записи чанка больше не нужны.
+class EvtxParser::ChunkPipeline {
+public:
+    /// @param file Отображение файла (пусто — каждый поток читает path через ifstream)
+    ChunkPipeline(std::span<const std::uint8_t> file, std::filesystem::path path,
+                  std::uint64_t file_size, std::size_t chunk_count, std::size_t threads,
+                  const FieldProjection* projection, const EvtxTimeWindow& window,
+                  bool value_arena)
+        : file_(file),
+          path_(std::move(path)),
+          projection_(projection),
+          window_(window),
+          value_arena_(value_arena),
+          file_size_(file_size),
+          chunk_count_(chunk_count),
+          slots_(threads * 2) {
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ChunkPipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        space_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ChunkPipeline(const ChunkPipeline&) = delete;
+    ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+
+    /// Забрать записи следующего по порядку чанка (и арену, в которой они построены)
+    /// @return false — чанки закончились или заголовок чанка невалиден
+    bool next_chunk(std::vector<EvtxRecord>& records, std::unique_ptr<ValueArena>& arena) {
+        if (next_emit_ >= chunk_count_) {
+            return false;
+        }
+
+        bool valid = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto& slot = slots_[next_emit_ % slots_.size()];
+            ready_.wait(lock, [&] { return slot.ready; });
+            records = std::move(slot.records);
+            slot.records.clear();
+            arena = std::move(slot.arena);
+            valid = slot.valid;
+            slot.ready = false;
+            ++next_emit_;
+        }
+        space_.notify_all();
+        return valid;
+    }
+
+    /// Вернуть арену чанка, записи которого уничтожены, для следующих чанков
+    void recycle(std::unique_ptr<ValueArena> arena) {
+        if (arena) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            arenas_.push_back(std::move(arena));
+        }
+    }
+
+private:
+    struct Slot {
+        std::unique_ptr<ValueArena> arena;  // Объявлена раньше записей, которые в ней
+        std::vector<EvtxRecord> records;
+        bool valid = false;
+        bool ready = false;
+    };
+
+    void work() {
+        std::ifstream stream;
+        if (file_.empty()) {
+            stream.open(path_, std::ios::binary);
+        }
+
+        while (true) {
+            std::size_t index = 0;
+            std::unique_ptr<ValueArena> arena;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                space_.wait(lock, [&] {
+                    return stop_ || next_claim_ >= chunk_count_ ||
+                           next_claim_ < next_emit_ + slots_.size();
+                });
+                if (stop_ || next_claim_ >= chunk_count_) {
+                    return;
+                }
+                index = next_claim_++;
+                if (value_arena_) {
+                    if (!arenas_.empty()) {
+                        arena = std::move(arenas_.back());
+                        arenas_.pop_back();
+                    } else {
+                        arena = std::make_unique<ValueArena>();
+                    }
+                }
+            }
+
+            // Данные чанка: срез отображения или буфер, прочитанный одним вызовом
+            std::uint64_t offset = FILE_HEADER_SIZE + index * CHUNK_SIZE;
+            auto size = static_cast<std::size_t>(
+                std::min<std::uint64_t>(CHUNK_SIZE, file_size_ - offset));
+            std::span<const std::uint8_t> chunk;
+            std::shared_ptr<std::vector<std::uint8_t>> buffer;
+            if (!file_.empty()) {
+                chunk = file_.subspan(static_cast<std::size_t>(offset), size);
+            } else {
+                buffer = std::make_shared<std::vector<std::uint8_t>>(size);
+                stream.clear();
+                stream.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+                stream.read(reinterpret_cast<char*>(buffer->data()),
+                            static_cast<std::streamsize>(size));
+                if (stream.gcount() == static_cast<std::streamsize>(size)) {
+                    chunk = *buffer;
+                }
+            }
+
+            std::vector<EvtxRecord> records;
+            bool valid = false;
+            if (arena) {
+                arena->reset();
+                ValueArena::Scope scope(arena.get());
+                valid = decode_chunk(chunk, buffer, projection_, window_, records);
+            } else {
+                valid = decode_chunk(chunk, buffer, projection_, window_, records);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto& slot = slots_[index % slots_.size()];
+                slot.arena = std::move(arena);
+                slot.records = std::move(records);
+                slot.valid = valid;
+                slot.ready = true;
+            }
+            ready_.notify_one();
+        }
+    }
+
+    std::span<const std::uint8_t> file_;
+    std::filesystem::path path_;
+    const FieldProjection* projection_;  // Принадлежит парсеру
+    EvtxTimeWindow window_;
+    bool value_arena_;
+    std::uint64_t file_size_;
+    std::size_t chunk_count_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;  // Слот чанка next_emit_ заполнен
+    std::condition_variable space_;  // В окне освободилось место (или stop_)
+    std::vector<Slot> slots_;
+    std::vector<std::unique_ptr<ValueArena>> arenas_;  // Свободные арены
+    std::size_t next_claim_ = 0;
+    std::size_t next_emit_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
 // ============================================================================
 // EvtxParser - загрузка файла
 // ============================================================================
 
-bool EvtxParser::load(const std::filesystem::path& path) {
+EvtxParser::EvtxParser() = default;
+EvtxParser::~EvtxParser() = default;
+EvtxParser::EvtxParser(EvtxParser&&) noexcept = default;
+EvtxParser& EvtxParser::operator=(EvtxParser&&) noexcept = default;
+
+bool EvtxParser::load(const std::filesystem::path& path, bool memory_map) {
+    pipeline_.reset();
+    decoded_.clear();
+    decoded_arena_.reset();
+    decoded_index_ = 0;
     path_ = path;
     error_.reset();
-    string_cache_.clear();
+    caches_.reset();
+    mapping_.close();
+    file_.close();
+    chunk_ = {};
     current_chunk_ = 0;
     current_chunk_offset_ = 0;
     current_record_offset_ = 0;
     chunk_end_offset_ = 0;
+    chunk_count_ = 0;
     eof_ = false;
 
-    // Открываем файл
-    file_.open(path, std::ios::binary);
-    if (!file_.is_open()) {
-        error_ = EvtxError{"could not open file", 0};
-        return false;
-    }
+    // Отображаем файл в память; если не удалось — читаем чанками через ifstream
+    if (memory_map && mapping_.open(path)) {
+        file_size_ = mapping_.size();
+    } else {
+        file_.open(path, std::ios::binary);
+        if (!file_.is_open()) {
+            error_ = EvtxError{"could not open file", 0};
+            return false;
+        }
 
-    // Получаем размер файла
-    file_.seekg(0, std::ios::end);
-    file_size_ = static_cast<std::uint64_t>(file_.tellg());
-    file_.seekg(0, std::ios::beg);
+        // Получаем размер файла
+        file_.seekg(0, std::ios::end);
+        file_size_ = static_cast<std::uint64_t>(file_.tellg());
+        file_.seekg(0, std::ios::beg);
+    }
 
     // Проверяем минимальный размер
     if (file_size_ < FILE_HEADER_SIZE) {
@@ -99,12 +592,24 @@ bool EvtxParser::load(const std::filesystem::path& path) {
 
     // Готовы к чтению первого чанка
     current_chunk_offset_ = FILE_HEADER_SIZE;
+    chunk_count_ =
+        static_cast<std::size_t>((file_size_ - FILE_HEADER_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE);
     return true;
 }
 
+const FieldProjection* EvtxParser::projection() const {
+    return projection_ && !projection_->all() ? projection_.get() : nullptr;
+}
+
+bool EvtxParser::is_open() const {
+    return mapping_.is_open() || file_.is_open();
+}
+
 bool EvtxParser::read_file_header() {
     char magic[8];
-    if (!read_bytes(magic, 8)) {
+    if (mapping_.is_open()) {
+        std::memcpy(magic, mapping_.data(), sizeof(magic));
+    } else if (!read_bytes(0, magic, sizeof(magic))) {
         error_ = EvtxError{"failed to read file magic", 0};
         return false;
     }
@@ -114,9 +619,6 @@ bool EvtxParser::read_file_header() {
         error_ = EvtxError{"invalid EVTX file magic", 0};
         return false;
     }
-
-    // Пропускаем остаток заголовка, переходим к первому чанку
-    file_.seekg(FILE_HEADER_SIZE, std::ios::beg);
     return true;
 }
 
@@ -125,10 +627,29 @@ bool EvtxParser::read_file_header() {
 // ============================================================================
 
 bool EvtxParser::next(EvtxRecord& record) {
-    if (eof_ || !file_.is_open()) {
+    if (eof_ || !is_open()) {
         return false;
     }
 
+    // Прошлый документ мог быть построен в арене, которая сейчас будет сброшена
+    if (value_arena_) {
+        record.data = Value();
+    }
+
+    // Несколько чанков и потоков — записи берутся из декодированных пулом чанков
+    if (threads_ > 1 && chunk_count_ > 1) {
+        return next_decoded(record);
+    }
+
+    std::optional<ValueArena::Scope> scope;
+    if (value_arena_) {
+        if (!arena_) {
+            arena_ = std::make_unique<ValueArena>();
+        }
+        arena_->reset();
+        scope.emplace(arena_.get());
+    }
+
     while (true) {
         // Проверяем, нужно ли загрузить новый чанк
         if (current_record_offset_ == 0) {
@@ -165,95 +686,92 @@ bool EvtxParser::next(EvtxRecord& record) {
     }
 }
 
+bool EvtxParser::next_decoded(EvtxRecord& record) {
+    while (decoded_index_ >= decoded_.size()) {
+        if (!pipeline_) {
+            std::span<const std::uint8_t> file;
+            if (mapping_.is_open()) {
+                file = mapping_.bytes();
+            }
+            pipeline_ = std::make_unique<ChunkPipeline>(file, path_, file_size_, chunk_count_,
+                                                        std::min(threads_, chunk_count_),
+                                                        projection(), window_, value_arena_);
+        }
+
+        // Те же правила, что и при последовательном чтении: невалидный заголовок
+        // чанка — конец файла, невалидная запись — переход к следующему чанку
+        decoded_.clear();
+        decoded_index_ = 0;
+        pipeline_->recycle(std::move(decoded_arena_));
+        if (!pipeline_->next_chunk(decoded_, decoded_arena_)) {
+            pipeline_.reset();
+            decoded_.clear();
+            decoded_arena_.reset();
+            eof_ = true;
+            return false;
+        }
+    }
+
+    record = std::move(decoded_[decoded_index_++]);
+    return true;
+}
+
 bool EvtxParser::read_chunk_header() {
     // Проверяем, не вышли ли за пределы файла
     if (current_chunk_offset_ >= file_size_) {
         return false;
     }
 
-    // Переходим к началу чанка
-    file_.seekg(static_cast<std::streamoff>(current_chunk_offset_), std::ios::beg);
-
-    // Читаем магию чанка
-    char magic[8];
-    if (!read_bytes(magic, 8)) {
-        return false;
+    // Данные чанка: срез отображения или буфер, прочитанный одним вызовом
+    auto chunk_offset = static_cast<std::size_t>(current_chunk_offset_);
+    auto chunk_size = static_cast<std::size_t>(
+        std::min<std::uint64_t>(CHUNK_SIZE, file_size_ - current_chunk_offset_));
+    if (mapping_.is_open()) {
+        chunk_ = mapping_.bytes().subspan(chunk_offset, chunk_size);
+    } else {
+        // Новый буфер на каждый чанк: записи по проекции ссылаются на свой чанк
+        chunk_buffer_ = std::make_shared<std::vector<std::uint8_t>>(chunk_size);
+        if (!read_bytes(current_chunk_offset_, chunk_buffer_->data(), chunk_size)) {
+            chunk_ = {};
+            return false;
+        }
+        chunk_ = *chunk_buffer_;
     }
 
-    // Проверяем магию "ElfChnk\0"
-    if (std::memcmp(magic, CHUNK_HEADER_MAGIC, 8) != 0) {
+    std::uint32_t free_space_offset = 0;
+    if (!parse_chunk_header(chunk_, free_space_offset)) {
         // Не чанк — возможно, конец файла или пустое пространство
         return false;
     }
 
-    // Читаем остальные поля заголовка чанка
-    std::uint64_t first_event_record_number;
-    std::uint64_t last_event_record_number;
-    std::uint64_t first_event_record_id;
-    std::uint64_t last_event_record_id;
-    std::uint32_t header_size;
-    std::uint32_t last_event_record_data_offset;
-    std::uint32_t free_space_offset;
-
-    if (!read_value(first_event_record_number) || !read_value(last_event_record_number) ||
-        !read_value(first_event_record_id) || !read_value(last_event_record_id) ||
-        !read_value(header_size) || !read_value(last_event_record_data_offset) ||
-        !read_value(free_space_offset)) {
-        return false;
-    }
-
-    // Очищаем кеши при переходе к новому чанку
-    string_cache_.clear();
-    template_cache_.clear();
+    // Новые кеши при переходе к новому чанку
+    caches_ = std::make_shared<BinXmlChunkCaches>();
 
-    // Устанавливаем позицию первой записи (после заголовка чанка)
+    // Устанавливаем позицию первой записи (после заголовка чанка); записи после
+    // последней попадающей в окно времени не читаются
     current_record_offset_ = current_chunk_offset_ + CHUNK_HEADER_SIZE;
-    chunk_end_offset_ = current_chunk_offset_ + free_space_offset;
+    chunk_end_offset_ = current_chunk_offset_ + window_end(chunk_, free_space_offset, window_);
 
     return true;
 }
 
 bool EvtxParser::read_record(EvtxRecord& record) {
-    // Переходим к позиции записи
-    file_.seekg(static_cast<std::streamoff>(current_record_offset_), std::ios::beg);
-
-    // Читаем заголовок записи
-    std::uint32_t signature;
-    std::uint32_t size;
-    std::uint64_t record_id;
-    std::uint64_t timestamp;
-
-    if (!read_value(signature)) {
-        return false;
-    }
-
-    // Проверяем сигнатуру записи 0x00002a2a ("**\0\0")
-    if (signature != 0x00002a2a) {
-        return false;
-    }
-
-    if (!read_value(size) || !read_value(record_id) || !read_value(timestamp)) {
-        return false;
-    }
-
-    // Читаем Binary XML данные
-    // Размер данных = size - 24 (заголовок) - 4 (копия размера в конце)
-    std::size_t data_size = size - 28;
-    std::vector<std::uint8_t> binxml_data(data_size);
+    while (current_record_offset_ < chunk_end_offset_) {
+        auto offset = static_cast<std::size_t>(current_record_offset_ - current_chunk_offset_);
+        RecordHeader header{};
+        if (!read_record_header(chunk_, offset, header)) {
+            return false;
+        }
 
-    if (!read_bytes(binxml_data.data(), data_size)) {
-        return false;
+        // Переходим к следующей записи
+        current_record_offset_ += header.size;
+        if (window_.contains(header.timestamp)) {
+            decode_record(chunk_, chunk_buffer_, offset, header, caches_, projection(), record);
+            return true;
+        }
+        scan_record(chunk_, offset, header, *caches_);
     }
-
-    // Парсим Binary XML
-    record.data = parse_binxml(binxml_data);
-    record.record_id = record_id;
-    record.timestamp = filetime_to_iso8601(timestamp);
-
-    // Переходим к следующей записи
-    current_record_offset_ += size;
-
-    return true;
+    return false;
 }
 
 // ============================================================================
@@ -262,26 +780,46 @@ bool EvtxParser::read_record(EvtxRecord& record) {
 
 /// Контекст парсинга Binary XML
 struct BinXmlContext {
-    const std::vector<std::uint8_t>& data;
+    using TemplateMap = std::unordered_map<std::uint32_t, std::shared_ptr<const BinXmlTemplate>>;
+
+    const std::uint8_t* data;
+    std::size_t size;
     std::size_t offset = 0;
+    std::size_t base = 0;  // Смещение data[0] относительно начала чанка
+    BinXmlChunkCaches& caches;
     std::unordered_map<std::uint32_t, std::string>& string_cache;
-    std::unordered_map<std::uint32_t, BinXmlTemplate>& template_cache;  // BUGFIX: теперь ссылка
+    TemplateMap& template_cache;
+
+    // Проекция полей документа (только для корня записи; nullptr — все поля)
+    const FieldProjection* projection = nullptr;
+
+    BinXmlContext(std::span<const std::uint8_t> bytes, std::size_t chunk_base,
+                  BinXmlChunkCaches& chunk_caches)
+        : data(bytes.data()),
+          size(bytes.size()),
+          base(chunk_base),
+          caches(chunk_caches),
+          string_cache(chunk_caches.strings),
+          template_cache(chunk_caches.templates) {}
+
+    /// Вложенный контекст для [at, at + n) текущих данных (без копирования)
+    BinXmlContext sub(std::size_t at, std::size_t n) const {
+        return BinXmlContext({data + at, n}, base + at, caches);
+    }
 
-    BinXmlContext(const std::vector<std::uint8_t>& d,
-                  std::unordered_map<std::uint32_t, std::string>& str_cache,
-                  std::unordered_map<std::uint32_t, BinXmlTemplate>& tmpl_cache)
-        : data(d), string_cache(str_cache), template_cache(tmpl_cache) {}
+    /// Текущая позиция относительно начала чанка
+    std::size_t position() const { return base + offset; }
 
-    bool eof() const { return offset >= data.size(); }
+    bool eof() const { return offset >= size; }
 
     std::uint8_t read_u8() {
-        if (offset >= data.size())
+        if (offset >= size)
             return 0;
         return data[offset++];
     }
 
     std::uint16_t read_u16() {
-        if (offset + 2 > data.size())
+        if (offset + 2 > size)
             return 0;
         std::uint16_t v = static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8));
         offset += 2;
@@ -289,7 +827,7 @@ struct BinXmlContext {
     }
 
     std::uint32_t read_u32() {
-        if (offset + 4 > data.size())
+        if (offset + 4 > size)
             return 0;
         std::uint32_t v = data[offset] | (static_cast<std::uint32_t>(data[offset + 1]) << 8) |
                           (static_cast<std::uint32_t>(data[offset + 2]) << 16) |
@@ -299,7 +837,7 @@ struct BinXmlContext {
     }
 
     std::uint64_t read_u64() {
-        if (offset + 8 > data.size())
+        if (offset + 8 > size)
             return 0;
         std::uint64_t lo = read_u32();
         std::uint64_t hi = read_u32();
@@ -307,59 +845,60 @@ struct BinXmlContext {
     }
 
     std::string read_utf16_string(std::size_t char_count) {
-        if (offset + char_count * 2 > data.size())
+        if (offset + char_count * 2 > size)
             return "";
         std::string result;
-        result.reserve(char_count);
-        for (std::size_t i = 0; i < char_count; ++i) {
-            std::uint16_t ch = static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8));
-            offset += 2;
-            // Простая конверсия UTF-16 → UTF-8 (только BMP)
-            if (ch < 0x80) {
-                result.push_back(static_cast<char>(ch));
-            } else if (ch < 0x800) {
-                result.push_back(static_cast<char>(0xC0 | (ch >> 6)));
-                result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
-            } else {
-                result.push_back(static_cast<char>(0xE0 | (ch >> 12)));
-                result.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
-                result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
-            }
-        }
+        io::append_utf16le(result, data + offset, char_count);
+        offset += char_count * 2;
         return result;
     }
 
     // Read UTF-16 string, stopping at null terminator or char_count, whichever comes first
     std::string read_utf16_string_until_null(std::size_t char_count) {
-        if (offset + char_count * 2 > data.size()) {
-            char_count = (data.size() - offset) / 2;
-        }
         std::string result;
-        result.reserve(char_count);
-        for (std::size_t i = 0; i < char_count; ++i) {
-            std::uint16_t ch = static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8));
-            offset += 2;
-            if (ch == 0)
-                break;  // Stop at null terminator
-            // Простая конверсия UTF-16 → UTF-8 (только BMP)
-            if (ch < 0x80) {
-                result.push_back(static_cast<char>(ch));
-            } else if (ch < 0x800) {
-                result.push_back(static_cast<char>(0xC0 | (ch >> 6)));
-                result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
-            } else {
-                result.push_back(static_cast<char>(0xE0 | (ch >> 12)));
-                result.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
-                result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
-            }
-        }
+        std::size_t length = utf16_string_until_null(char_count);
+        io::append_utf16le(result, data + offset, length);
+        offset += std::min(length + 1, char_count) * 2;
         return result;
     }
 
+    /// Пропустить строку так же, как её читает read_utf16_string_until_null
+    void skip_utf16_string_until_null(std::size_t char_count) {
+        std::size_t length = utf16_string_until_null(char_count);
+        offset += std::min(length + 1, char_count) * 2;
+    }
+
+    /// Длина строки до NUL; char_count обрезается по концу данных
+    std::size_t utf16_string_until_null(std::size_t& char_count) const {
+        if (offset + char_count * 2 > size) {
+            char_count = (size - offset) / 2;
+        }
+        return io::utf16le_length(data + offset, char_count);
+    }
+
+    /// Прочитать имя (элемента/атрибута): inline при первом использовании в чанке,
+    /// далее — ссылка на уже прочитанную строку
+    std::string read_name() {
+        std::uint32_t string_offset = read_u32();
+        if (string_offset != position()) {
+            auto it = string_cache.find(string_offset);
+            return it != string_cache.end() ? it->second : std::string();
+        }
+        std::uint32_t next_offset = read_u32();
+        (void)next_offset;
+        std::uint16_t hash = read_u16();
+        (void)hash;
+        std::uint16_t string_length = read_u16();
+        std::string name = read_utf16_string(string_length);
+        skip(2);  // null terminator
+        string_cache[string_offset] = name;
+        return name;
+    }
+
     void skip(std::size_t n) {
         offset += n;
-        if (offset > data.size())
-            offset = data.size();
+        if (offset > size)
+            offset = size;
     }
 };
 
@@ -396,67 +935,58 @@ static std::string binxml_value_to_string(BinXmlContext& ctx, BinXmlValueType ty
     }
 
     case BinXmlValueType::Int8:
-        return std::to_string(static_cast<std::int8_t>(ctx.read_u8()));
+        return decimal_string(static_cast<std::int8_t>(ctx.read_u8()));
 
     case BinXmlValueType::UInt8:
-        return std::to_string(ctx.read_u8());
+        return decimal_string(ctx.read_u8());
 
     case BinXmlValueType::Int16:
-        return std::to_string(static_cast<std::int16_t>(ctx.read_u16()));
+        return decimal_string(static_cast<std::int16_t>(ctx.read_u16()));
 
     case BinXmlValueType::UInt16:
-        return std::to_string(ctx.read_u16());
+        return decimal_string(ctx.read_u16());
 
     case BinXmlValueType::Int32:
-        return std::to_string(static_cast<std::int32_t>(ctx.read_u32()));
+        return decimal_string(static_cast<std::int32_t>(ctx.read_u32()));
 
     case BinXmlValueType::UInt32:
-        return std::to_string(ctx.read_u32());
+        return decimal_string(ctx.read_u32());
 
     case BinXmlValueType::Int64:
-        return std::to_string(static_cast<std::int64_t>(ctx.read_u64()));
+        return decimal_string(static_cast<std::int64_t>(ctx.read_u64()));
 
     case BinXmlValueType::UInt64:
-        return std::to_string(ctx.read_u64());
+        return decimal_string(ctx.read_u64());
 
     case BinXmlValueType::Bool:
         return ctx.read_u8() ? "true" : "false";
 
-    case BinXmlValueType::Hex32: {
-        std::uint32_t v = ctx.read_u32();
-        std::ostringstream oss;
-        oss << "0x" << std::hex << v;
-        return oss.str();
-    }
+    case BinXmlValueType::Hex32:
+        return hex_string(ctx.read_u32());
 
-    case BinXmlValueType::Hex64: {
-        std::uint64_t v = ctx.read_u64();
-        std::ostringstream oss;
-        oss << "0x" << std::hex << v;
-        return oss.str();
-    }
+    case BinXmlValueType::Hex64:
+        return hex_string(ctx.read_u64());
 
     case BinXmlValueType::Guid: {
-        std::uint32_t d1 = ctx.read_u32();
-        std::uint16_t d2 = ctx.read_u16();
-        std::uint16_t d3 = ctx.read_u16();
-        std::ostringstream oss;
-        oss << std::hex << std::uppercase << std::setfill('0') << std::setw(8) << d1 << "-"
-            << std::setw(4) << d2 << "-" << std::setw(4) << d3 << "-";
-        for (int i = 0; i < 2; ++i) {
-            oss << std::setw(2) << static_cast<int>(ctx.read_u8());
-        }
-        oss << "-";
-        for (int i = 0; i < 6; ++i) {
-            oss << std::setw(2) << static_cast<int>(ctx.read_u8());
+        // XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX: первые три поля little-endian
+        char text[36];
+        char* p = put_hex(text, ctx.read_u32(), 8, HEX_UPPER);
+        *p++ = '-';
+        p = put_hex(p, ctx.read_u16(), 4, HEX_UPPER);
+        *p++ = '-';
+        p = put_hex(p, ctx.read_u16(), 4, HEX_UPPER);
+        *p++ = '-';
+        for (int i = 0; i < 8; ++i) {
+            if (i == 2) {
+                *p++ = '-';
+            }
+            p = put_hex(p, ctx.read_u8(), 2, HEX_UPPER);
         }
-        return oss.str();
+        return std::string(text, p);
     }
 
-    case BinXmlValueType::FileTime: {
-        std::uint64_t ft = ctx.read_u64();
-        return EvtxParser::filetime_to_iso8601(ft);
-    }
+    case BinXmlValueType::FileTime:
+        return filetime_string(ctx.read_u64(), ctx.caches.dates);
 
     case BinXmlValueType::SystemTime: {
         std::uint16_t year = ctx.read_u16();
@@ -467,11 +997,22 @@ static std::string binxml_value_to_string(BinXmlContext& ctx, BinXmlValueType ty
         std::uint16_t minute = ctx.read_u16();
         std::uint16_t second = ctx.read_u16();
         std::uint16_t ms = ctx.read_u16();
-        std::ostringstream oss;
-        oss << std::setfill('0') << std::setw(4) << year << "-" << std::setw(2) << month << "-"
-            << std::setw(2) << day << "T" << std::setw(2) << hour << ":" << std::setw(2) << minute
-            << ":" << std::setw(2) << second << "." << std::setw(3) << ms << "Z";
-        return oss.str();
+        char text[48];
+        char* p = put_decimal(text, year, 4);
+        *p++ = '-';
+        p = put_decimal(p, month, 2);
+        *p++ = '-';
+        p = put_decimal(p, day, 2);
+        *p++ = 'T';
+        p = put_decimal(p, hour, 2);
+        *p++ = ':';
+        p = put_decimal(p, minute, 2);
+        *p++ = ':';
+        p = put_decimal(p, second, 2);
+        *p++ = '.';
+        p = put_decimal(p, ms, 3);
+        *p++ = 'Z';
+        return std::string(text, p);
     }
 
     case BinXmlValueType::Sid: {
@@ -482,20 +1023,25 @@ static std::string binxml_value_to_string(BinXmlContext& ctx, BinXmlValueType ty
         for (int i = 0; i < 6; ++i) {
             authority = (authority << 8) | ctx.read_u8();
         }
-        std::ostringstream oss;
-        oss << "S-" << static_cast<int>(version) << "-" << authority;
+        // "S-" + версия + authority + до 255 sub-authority по 10 цифр с дефисом
+        char text[2 + 4 + 21 + 255 * 11];
+        char* p = std::copy_n("S-", 2, text);
+        p = put_decimal(p, version);
+        *p++ = '-';
+        p = put_decimal(p, authority);
         for (int i = 0; i < sub_auth_count; ++i) {
-            oss << "-" << ctx.read_u32();
+            *p++ = '-';
+            p = put_decimal(p, ctx.read_u32());
         }
-        return oss.str();
+        return std::string(text, p);
     }
 
     case BinXmlValueType::Binary: {
-        std::ostringstream oss;
+        std::string hex(std::size_t{size} * 2, '\0');
         for (std::size_t i = 0; i < size; ++i) {
-            oss << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(ctx.read_u8());
+            put_hex(hex.data() + i * 2, ctx.read_u8(), 2, HEX_LOWER);
         }
-        return oss.str();
+        return hex;
     }
 
     default:
@@ -505,106 +1051,202 @@ static std::string binxml_value_to_string(BinXmlContext& ctx, BinXmlValueType ty
     }
 }
 
-// Forward declarations
-static Value convert_xml_node(const pugi::xml_node& node);
-static Value xml_document_to_json_with_attributes(const pugi::xml_document& doc);
-
-/// Рекурсивный парсинг Binary XML в XML строку
-static void parse_binxml_to_xml(
-    BinXmlContext& ctx, std::string& xml,
-    std::vector<std::pair<std::string, std::string>>* substitution_values = nullptr,
-    bool /*is_template*/ = false) {
-    std::stack<std::string> element_stack;
-    bool in_attribute = false;
-    std::string current_attr_name;
+/// Пропустить значение без конверсии: позиция контекста сдвигается ровно так же,
+/// как при binxml_value_to_string (значение вне проекции полей)
+static void skip_binxml_value(BinXmlContext& ctx, BinXmlValueType type, std::uint16_t size) {
+    switch (type) {
+    case BinXmlValueType::Null:
+        return;
 
-    while (!ctx.eof()) {
-        std::uint8_t token_byte = ctx.read_u8();
-        bool more_bits = (token_byte & 0x40) != 0;
-        auto token = static_cast<BinXmlToken>(token_byte & 0x0f);
+    case BinXmlValueType::WString: {
+        std::size_t char_count = size / 2;
+        if (char_count == 0 && size > 0)
+            char_count = 1;
+        ctx.skip_utf16_string_until_null(char_count);
+        return;
+    }
 
-        switch (token) {
-        case BinXmlToken::EndOfStream:
-            return;
+    case BinXmlValueType::AnsiString:
+        for (std::size_t i = 0; i < size && ctx.read_u8() != 0; ++i) {
+        }
+        return;
 
-        case BinXmlToken::StartOfStream:
-            ctx.skip(3);  // major/minor version + flags
-            break;
+    case BinXmlValueType::Int8:
+    case BinXmlValueType::UInt8:
+    case BinXmlValueType::Bool:
+        ctx.read_u8();
+        return;
 
-        case BinXmlToken::OpenStartElement: {
-            ctx.skip(2);  // unknown
-            std::uint32_t size = ctx.read_u32();
-            (void)size;
+    case BinXmlValueType::Int16:
+    case BinXmlValueType::UInt16:
+        ctx.read_u16();
+        return;
 
-            // Читаем имя элемента
-            std::uint32_t string_offset = ctx.read_u32();
-            std::string name;
+    case BinXmlValueType::Int32:
+    case BinXmlValueType::UInt32:
+    case BinXmlValueType::Hex32:
+        ctx.read_u32();
+        return;
 
-            auto it = ctx.string_cache.find(string_offset);
-            if (it != ctx.string_cache.end()) {
-                name = it->second;
-            } else {
-                std::uint32_t next_offset = ctx.read_u32();
-                (void)next_offset;
-                std::uint16_t hash = ctx.read_u16();
-                (void)hash;
-                std::uint16_t string_length = ctx.read_u16();
-                name = ctx.read_utf16_string(string_length);
-                ctx.skip(2);  // null terminator
-                ctx.string_cache[string_offset] = name;
-            }
+    case BinXmlValueType::Int64:
+    case BinXmlValueType::UInt64:
+    case BinXmlValueType::Hex64:
+    case BinXmlValueType::FileTime:
+        ctx.read_u64();
+        return;
 
-            if (more_bits) {
-                ctx.skip(4);  // unknown
-            }
+    case BinXmlValueType::Guid:
+        ctx.read_u32();
+        ctx.read_u16();
+        ctx.read_u16();
+        for (int i = 0; i < 8; ++i) {
+            ctx.read_u8();
+        }
+        return;
 
-            xml += "<" + name;
-            element_stack.push(name);
-            break;
+    case BinXmlValueType::SystemTime:
+        for (int i = 0; i < 8; ++i) {
+            ctx.read_u16();
         }
+        return;
 
-        case BinXmlToken::CloseStartElement:
-            xml += ">";
-            break;
+    case BinXmlValueType::Sid: {
+        ctx.read_u8();  // version
+        std::uint8_t sub_auth_count = ctx.read_u8();
+        for (int i = 0; i < 6; ++i) {
+            ctx.read_u8();
+        }
+        for (int i = 0; i < sub_auth_count; ++i) {
+            ctx.read_u32();
+        }
+        return;
+    }
+
+    default:
+        // Binary и неизвестные типы: size байт (не дальше конца данных)
+        ctx.skip(size);
+        return;
+    }
+}
 
+// ============================================================================
+// Обход потока Binary XML
+// ============================================================================
+//
+// Поток токенов разворачивается в события приёмника (Sink):
+//   open_element(name), close_start(), close_empty(), close_element(),
+//   attribute(name), text(value), substitution(index)
+//
+// Приёмники:
+// - BinXmlTemplateRecorder: запись определения шаблона в BinXmlTemplate::tokens
+// - BinXmlValueBuilder: построение Value напрямую, без промежуточного XML текста
+//
+
+/// Значение подстановки экземпляра шаблона
+struct BinXmlSubstitution {
+    std::string text;               // Скалярное значение в строковом виде
+    std::size_t binxml_offset = 0;  // Вложенный Binary XML: смещение в данных контекста
+    std::size_t binxml_size = 0;    // Вложенный Binary XML: размер (0 — скалярное значение)
+};
+
+template <typename Sink>
+static void walk_binxml(BinXmlContext& ctx, Sink& sink);
+
+/// Развернуть шаблон с подстановками в приёмник
+template <typename Sink>
+static void replay_template(BinXmlContext& ctx, const BinXmlTemplate& tmpl,
+                            const std::vector<BinXmlSubstitution>& values, Sink& sink) {
+    for (const auto& tok : tmpl.tokens) {
+        switch (tok.token) {
+        case BinXmlToken::OpenStartElement:
+            sink.open_element(tok.text);
+            break;
+        case BinXmlToken::CloseStartElement:
+            sink.close_start();
+            break;
         case BinXmlToken::CloseEmptyElement:
-            xml += "/>";
-            if (!element_stack.empty())
-                element_stack.pop();
+            sink.close_empty();
             break;
-
         case BinXmlToken::CloseElement:
-            if (!element_stack.empty()) {
-                xml += "</" + element_stack.top() + ">";
-                element_stack.pop();
+            sink.close_element();
+            break;
+        case BinXmlToken::Attribute:
+            sink.attribute(tok.text);
+            break;
+        case BinXmlToken::Value:
+            sink.text(tok.text);
+            break;
+        case BinXmlToken::NormalSubstitution: {
+            if (tok.substitution_index >= values.size()) {
+                sink.substitution(tok.substitution_index);
+                break;
+            }
+            const auto& value = values[tok.substitution_index];
+            if (value.binxml_size > 0) {
+                // Вложенный Binary XML разворачивается на месте подстановки
+                BinXmlContext sub_ctx = ctx.sub(value.binxml_offset, value.binxml_size);
+                walk_binxml(sub_ctx, sink);
+            } else {
+                sink.text(value.text);
             }
             break;
+        }
+        default:
+            break;
+        }
+    }
+}
 
-        case BinXmlToken::Attribute: {
-            // Читаем имя атрибута
-            std::uint32_t string_offset = ctx.read_u32();
-            std::string name;
+/// Обработать TemplateInstance: определение шаблона (или кеш) + значения подстановок
+template <typename Sink>
+static void walk_template_instance(BinXmlContext& ctx, Sink& sink);
 
-            auto it = ctx.string_cache.find(string_offset);
-            if (it != ctx.string_cache.end()) {
-                name = it->second;
-            } else {
-                std::uint32_t next_offset = ctx.read_u32();
-                (void)next_offset;
-                std::uint16_t hash = ctx.read_u16();
-                (void)hash;
-                std::uint16_t string_length = ctx.read_u16();
-                name = ctx.read_utf16_string(string_length);
-                ctx.skip(2);  // null terminator
-                ctx.string_cache[string_offset] = name;
+template <typename Sink>
+static void walk_binxml(BinXmlContext& ctx, Sink& sink) {
+    while (!ctx.eof()) {
+        std::uint8_t token_byte = ctx.read_u8();
+        bool more_bits = (token_byte & 0x40) != 0;
+        auto token = static_cast<BinXmlToken>(token_byte & 0x0f);
+
+        switch (token) {
+        case BinXmlToken::EndOfStream:
+            return;
+
+        case BinXmlToken::StartOfStream:
+            ctx.skip(3);  // major/minor version + flags
+            break;
+
+        case BinXmlToken::OpenStartElement: {
+            ctx.skip(2);  // unknown
+            std::uint32_t size = ctx.read_u32();
+            (void)size;
+
+            std::string name = ctx.read_name();
+
+            if (more_bits) {
+                ctx.skip(4);  // unknown
             }
 
-            xml += " " + name + "=\"";
-            in_attribute = true;
-            current_attr_name = name;
+            sink.open_element(name);
             break;
         }
 
+        case BinXmlToken::CloseStartElement:
+            sink.close_start();
+            break;
+
+        case BinXmlToken::CloseEmptyElement:
+            sink.close_empty();
+            break;
+
+        case BinXmlToken::CloseElement:
+            sink.close_element();
+            break;
+
+        case BinXmlToken::Attribute:
+            sink.attribute(ctx.read_name());
+            break;
+
         case BinXmlToken::Value: {
             std::uint8_t value_type = ctx.read_u8();
             std::uint16_t value_size = ctx.read_u16();
@@ -616,162 +1258,21 @@ static void parse_binxml_to_xml(
                 adjusted_size = static_cast<std::uint16_t>(value_size * 2);
             }
 
-            std::string value = binxml_value_to_string(
-                ctx, static_cast<BinXmlValueType>(value_type), adjusted_size);
-
-            // Escape XML special characters
-            std::string escaped;
-            for (char c : value) {
-                switch (c) {
-                case '<':
-                    escaped += "&lt;";
-                    break;
-                case '>':
-                    escaped += "&gt;";
-                    break;
-                case '&':
-                    escaped += "&amp;";
-                    break;
-                case '"':
-                    escaped += "&quot;";
-                    break;
-                case '\'':
-                    escaped += "&apos;";
-                    break;
-                default:
-                    escaped += c;
-                    break;
-                }
-            }
-
-            xml += escaped;
-            if (in_attribute) {
-                xml += "\"";
-                in_attribute = false;
-            }
+            sink.text(binxml_value_to_string(ctx, static_cast<BinXmlValueType>(value_type),
+                                             adjusted_size));
             break;
         }
 
-        case BinXmlToken::TemplateInstance: {
-            ctx.skip(1);  // unknown
-            std::uint32_t template_id = ctx.read_u32();
-            std::uint32_t template_offset = ctx.read_u32();
-            (void)template_offset;
-            std::uint32_t next_offset = ctx.read_u32();
-            (void)next_offset;
-
-            bool new_template = false;
-            BinXmlTemplate* tmpl = nullptr;
-            std::string tmpl_xml;
-
-            auto it = ctx.template_cache.find(template_id);
-            if (it == ctx.template_cache.end()) {
-                new_template = true;
-                // Читаем определение шаблона
-                std::uint32_t tmpl_id2 = ctx.read_u32();
-                (void)tmpl_id2;
-                ctx.skip(16);  // GUID
-
-                // Парсим шаблон (substitution_values позволяет collect placeholder indices)
-                std::vector<std::pair<std::string, std::string>> subs;
-                parse_binxml_to_xml(ctx, tmpl_xml, &subs, true);
-
-                // Сохраняем шаблон в кеш
-                BinXmlTemplate new_tmpl;
-                new_tmpl.xml_template = tmpl_xml;
-                ctx.template_cache[template_id] = std::move(new_tmpl);
-                tmpl = &ctx.template_cache[template_id];
-            } else {
-                tmpl = &it->second;
-                tmpl_xml = tmpl->xml_template;
-            }
-
-            // Читаем substitution values
-            std::uint32_t sub_count = 0;
-            if (new_template) {
-                sub_count = ctx.read_u32();
-                tmpl->substitution_count = sub_count;
-            } else {
-                sub_count = static_cast<std::uint32_t>(tmpl->substitution_count);
-                if (sub_count == 0)
-                    sub_count = 32;  // reasonable default
-            }
-
-            // Читаем спецификации substitution
-            std::vector<std::pair<std::uint16_t, BinXmlValueType>> sub_specs;
-            for (std::uint32_t i = 0; i < sub_count; ++i) {
-                std::uint16_t size = ctx.read_u16();
-                auto type = static_cast<BinXmlValueType>(ctx.read_u8());
-                ctx.skip(1);  // padding
-                sub_specs.emplace_back(size, type);
-            }
-
-            // Читаем значения substitution
-            std::vector<std::string> sub_values;
-            for (std::size_t vi = 0; vi < sub_specs.size(); ++vi) {
-                const auto& [size, type] = sub_specs[vi];
-                if (type == BinXmlValueType::BinXml) {
-                    // Вложенный Binary XML - use size field directly
-                    if (size > 0 && ctx.offset + size <= ctx.data.size()) {
-                        // Create a sub-context with just the BinXml data
-                        std::vector<std::uint8_t> binxml_data(
-                            ctx.data.begin() + static_cast<std::ptrdiff_t>(ctx.offset),
-                            ctx.data.begin() + static_cast<std::ptrdiff_t>(ctx.offset + size));
-                        ctx.offset += size;
-
-                        // Parse the nested BinXml with its own context (shares template_cache)
-                        BinXmlContext sub_ctx(binxml_data, ctx.string_cache, ctx.template_cache);
-                        std::string nested_xml;
-                        parse_binxml_to_xml(sub_ctx, nested_xml);
-                        sub_values.push_back(std::move(nested_xml));
-                    } else {
-                        sub_values.push_back("");
-                    }
-                } else {
-                    std::string val = binxml_value_to_string(ctx, type, size);
-                    sub_values.push_back(std::move(val));
-                }
-            }
-
-            // Применяем substitution values к шаблону
-            std::string result_xml = tmpl_xml;
-            for (std::size_t i = 0; i < sub_values.size(); ++i) {
-                std::string placeholder = "${" + std::to_string(i) + "}";
-                std::size_t pos = 0;
-                while ((pos = result_xml.find(placeholder, pos)) != std::string::npos) {
-                    result_xml.replace(pos, placeholder.length(), sub_values[i]);
-                    pos += sub_values[i].length();
-                }
-            }
-
-            // Добавляем результат к выходному XML
-            xml += result_xml;
-
-            if (substitution_values) {
-                // Возвращаем значения для родительского контекста
-                for (std::size_t i = 0; i < sub_values.size(); ++i) {
-                    substitution_values->emplace_back(std::to_string(i), sub_values[i]);
-                }
-            }
+        case BinXmlToken::TemplateInstance:
+            walk_template_instance(ctx, sink);
             break;  // Продолжаем парсинг (не return!)
-        }
 
         case BinXmlToken::NormalSubstitution:
         case BinXmlToken::ConditionalSubstitution: {
             std::uint16_t index = ctx.read_u16();
             std::uint8_t type = ctx.read_u8();
             (void)type;
-
-            if (substitution_values && index < substitution_values->size()) {
-                xml += (*substitution_values)[index].second;
-            } else {
-                xml += "${" + std::to_string(index) + "}";
-            }
-
-            if (in_attribute) {
-                xml += "\"";
-                in_attribute = false;
-            }
+            sink.substitution(index);
             break;
         }
 
@@ -782,324 +1283,1355 @@ static void parse_binxml_to_xml(
     }
 }
 
-Value EvtxParser::parse_binxml(const std::vector<std::uint8_t>& data) {
-    if (data.empty()) {
-        return Value();
+/// Приёмник, записывающий определение шаблона в поток токенов
+struct BinXmlTemplateRecorder {
+    std::vector<BinXmlTemplateToken>& tokens;
+
+    void open_element(const std::string& name) {
+        tokens.push_back({BinXmlToken::OpenStartElement, name, 0});
     }
+    void close_start() { tokens.push_back({BinXmlToken::CloseStartElement, {}, 0}); }
+    void close_empty() { tokens.push_back({BinXmlToken::CloseEmptyElement, {}, 0}); }
+    void close_element() { tokens.push_back({BinXmlToken::CloseElement, {}, 0}); }
+    void attribute(const std::string& name) {
+        tokens.push_back({BinXmlToken::Attribute, name, 0});
+    }
+    void text(std::string_view value) {
+        tokens.push_back({BinXmlToken::Value, std::string(value), 0});
+    }
+    void substitution(std::uint16_t index) {
+        tokens.push_back({BinXmlToken::NormalSubstitution, {}, index});
+    }
+};
 
-    BinXmlContext ctx(data, string_cache_, template_cache_);
+/// Экземпляр шаблона: определение + значения подстановок одной записи
+struct BinXmlInstance {
+    std::shared_ptr<const BinXmlTemplate> tmpl;
+    std::vector<BinXmlSubstitution> values;
 
-    // Парсим Binary XML в XML строку
-    std::string xml;
-    parse_binxml_to_xml(ctx, xml);
+    /// План по проекции полей (nullptr — строятся все узлы, все значения прочитаны)
+    std::shared_ptr<const BinXmlProjectionPlan> plan;
 
-    if (xml.empty()) {
-        return Value();
-    }
+    /// Вложенные документы-экземпляры по индексу подстановки (для каркаса)
+    std::vector<BinXmlInstance> nested;
+};
 
-    // Парсим XML с pugixml
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_string(xml.c_str());
+class BinXmlValueBuilder;
 
-    if (!result) {
-        // Ошибка парсинга — возвращаем пустое значение
-        return Value();
+/// Подготовить экземпляр к сборке по каркасу: разобрать вложенные документы в слотах
+/// @return false — экземпляр разворачивается по токенам
+static bool prepare_instance(const BinXmlContext& ctx, BinXmlInstance& instance);
+
+/// Собрать документ по скомпилированному каркасу (только заполнение слотов)
+static Value instantiate_skeleton(const BinXmlInstance& instance);
+
+/// Прочитать определение шаблона, следующее inline за TemplateInstance
+static std::shared_ptr<const BinXmlTemplate> read_template_definition(BinXmlContext& ctx) {
+    ctx.skip(4);  // смещение следующего определения
+    BinXmlTemplate tmpl;
+    if (ctx.offset + tmpl.guid.size() <= ctx.size) {
+        std::memcpy(tmpl.guid.data(), ctx.data + ctx.offset, tmpl.guid.size());
     }
+    ctx.skip(tmpl.guid.size());
+    std::size_t data_size = ctx.read_u32();
+    data_size = std::min(data_size, ctx.size - ctx.offset);
 
-    // Конвертируем в JSON с _attributes семантикой
-    return xml_document_to_json_with_attributes(doc);
+    BinXmlContext def_ctx = ctx.sub(ctx.offset, data_size);
+    BinXmlTemplateRecorder recorder{tmpl.tokens};
+    walk_binxml(def_ctx, recorder);
+    ctx.skip(data_size);
+
+    return BinXmlTemplateCache::global().intern(std::move(tmpl));
 }
 
-// ============================================================================
-// Конверсия XML → JSON с _attributes
-// ============================================================================
+/// План каркаса шаблона для проекции контейнера, в который попадает корень
+static std::shared_ptr<const BinXmlProjectionPlan> projection_plan(
+    BinXmlContext& ctx, const BinXmlTemplate& tmpl, const FieldProjection& container);
+
+/// Нужно ли значение подстановки index по плану
+static bool plan_needs_value(const BinXmlProjectionPlan& plan, std::size_t index);
+
+/// Прочитать TemplateInstance (после байта токена): шаблон и значения подстановок
+/// @param container Проекция контейнера корня: значения вне неё не конвертируются
+///                  (nullptr — все значения)
+/// @return false — определение шаблона не найдено в чанке
+static bool read_template_instance(BinXmlContext& ctx, BinXmlInstance& instance,
+                                   const FieldProjection* container = nullptr) {
+    ctx.skip(1);  // unknown
+    std::uint32_t template_id = ctx.read_u32();
+    (void)template_id;
+    std::uint32_t definition_offset = ctx.read_u32();
+
+    // Определение следует inline при первом использовании шаблона в чанке,
+    // далее экземпляры ссылаются на него по смещению
+    if (definition_offset == ctx.position()) {
+        instance.tmpl = read_template_definition(ctx);
+        ctx.template_cache[definition_offset] = instance.tmpl;
+    } else {
+        auto it = ctx.template_cache.find(definition_offset);
+        if (it != ctx.template_cache.end()) {
+            instance.tmpl = it->second;
+        }
+    }
+
+    std::uint32_t sub_count = ctx.read_u32();
+    if (container && instance.tmpl && instance.tmpl->skeleton) {
+        instance.plan = projection_plan(ctx, *instance.tmpl, *container);
+    }
+
+    // Читаем спецификации substitution
+    std::vector<std::pair<std::uint16_t, BinXmlValueType>> sub_specs;
+    sub_specs.reserve(std::min<std::size_t>(sub_count, (ctx.size - ctx.offset) / 4));
+    for (std::uint32_t i = 0; i < sub_count && !ctx.eof(); ++i) {
+        std::uint16_t size = ctx.read_u16();
+        auto type = static_cast<BinXmlValueType>(ctx.read_u8());
+        ctx.skip(1);  // padding
+        sub_specs.emplace_back(size, type);
+    }
 
-/// Проверка, является ли узел контейнером EventData/UserData (ADR-0012)
-static bool is_event_data_container(const pugi::xml_node& node) {
-    std::string name = node.name();
-    return name == "EventData" || name == "UserData";
+    // Читаем значения substitution
+    auto& values = instance.values;
+    values.resize(sub_specs.size());
+    for (std::size_t vi = 0; vi < sub_specs.size(); ++vi) {
+        const auto& [size, type] = sub_specs[vi];
+        if (type == BinXmlValueType::BinXml) {
+            // Вложенный Binary XML разбирается при развёртывании шаблона
+            if (size > 0 && ctx.offset + size <= ctx.size) {
+                values[vi].binxml_offset = ctx.offset;
+                values[vi].binxml_size = size;
+                ctx.offset += size;
+            }
+        } else if (!instance.plan || plan_needs_value(*instance.plan, vi)) {
+            values[vi].text = binxml_value_to_string(ctx, type, size);
+        } else {
+            skip_binxml_value(ctx, type, size);
+        }
+    }
+
+    return instance.tmpl != nullptr;
 }
 
-/// Конверсия EventData/UserData с flatten-семантикой (ADR-0012)
-/// Превращает <Data Name="X">value</Data> в {"X": "value"}
-static Value convert_event_data_node(const pugi::xml_node& node) {
-    Value::Object obj;
+template <typename Sink>
+static void walk_template_instance(BinXmlContext& ctx, Sink& sink) {
+    // Проекция полей применяется только к корню записи, собираемому по каркасу
+    const FieldProjection* projection = nullptr;
+    if constexpr (std::is_same_v<Sink, BinXmlValueBuilder>) {
+        if (sink.at_document_start()) {
+            projection = ctx.projection;
+        }
+    }
 
-    // Собираем дочерние элементы с flatten-логикой
-    std::map<std::string, std::vector<std::string>> flattened;
+    std::size_t start = ctx.offset;
+    BinXmlInstance instance;
+    if (!read_template_instance(ctx, instance, projection)) {
+        return;
+    }
 
-    for (const auto& child : node.children()) {
-        if (child.type() != pugi::node_element) {
-            continue;
+    // Корень документа из скомпилированного каркаса: без обхода токенов
+    if constexpr (std::is_same_v<Sink, BinXmlValueBuilder>) {
+        if (sink.at_document_start() && prepare_instance(ctx, instance)) {
+            sink.adopt_root(instantiate_skeleton(instance));
+            return;
         }
+    }
 
-        std::string child_name = child.name();
+    // Развёртывание по токенам использует все значения: перечитываем без проекции
+    if (instance.plan) {
+        ctx.offset = start;
+        instance = BinXmlInstance{};
+        read_template_instance(ctx, instance);
+    }
 
-        // Проверяем наличие атрибута Name у элемента Data
-        if (child_name == "Data") {
-            auto name_attr = child.attribute("Name");
-            if (name_attr) {
-                // Используем значение Name как ключ
-                std::string key = name_attr.value();
-                std::string value;
+    replay_template(ctx, *instance.tmpl, instance.values, sink);
+}
 
-                // Получаем текстовое содержимое
-                for (const auto& text_node : child.children()) {
-                    if (text_node.type() == pugi::node_pcdata) {
-                        value += text_node.value();
-                    }
-                }
+// ============================================================================
+// Построение Value из Binary XML с _attributes семантикой
+// ============================================================================
+//
+// SPEC-SLICE-007 FACT-005: separate_json_attributes(true)
+// ADR-0012: flatten EventData/UserData
+//
+// Результат совпадает с прежним путём Binary XML → XML текст → pugixml → Value
+// (parse_default): значения атрибутов нормализуются как parse_wconv_attribute,
+// текст — как parse_eol, текстовые сегменты только из пробелов отбрасываются.
+// Порядок вставки ключей в Value::Object сохранён, поэтому порядок обхода
+// объектов (и JSON вывод) не меняется.
+//
 
-                flattened[key].push_back(value);
-            } else {
-                // Data без Name — используем пустую строку как ключ или пропускаем
-                // В upstream такие элементы обрабатываются по-другому
-                std::string value;
-                for (const auto& text_node : child.children()) {
-                    if (text_node.type() == pugi::node_pcdata) {
-                        value += text_node.value();
-                    }
-                }
-                if (!value.empty()) {
-                    // Добавляем как безымянный Data элемент
-                    flattened["Data"].push_back(value);
-                }
-            }
+/// Пробельный символ XML (ct_space в pugixml)
+static bool is_xml_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/// Попробовать интерпретировать строку целиком как целое число
+static bool parse_xml_integer(const std::string& s, std::int64_t& out) {
+    if (s.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    long long int_val = std::strtoll(s.c_str(), &end, 10);
+    if (end == s.c_str() || *end != '\0') {
+        return false;
+    }
+    out = static_cast<std::int64_t>(int_val);
+    return true;
+}
+
+/// Нормализация значения атрибута (parse_wconv_attribute | parse_eol)
+static std::string normalize_xml_attribute(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (c == '\r') {
+            result.push_back(' ');
+            if (i + 1 < value.size() && value[i + 1] == '\n')
+                ++i;
+        } else if (c == '\n' || c == '\t') {
+            result.push_back(' ');
         } else {
-            // Другие элементы (не Data) — рекурсивно конвертируем
-            // Например, Binary элементы в EventData
-            std::string value;
-            for (const auto& text_node : child.children()) {
-                if (text_node.type() == pugi::node_pcdata) {
-                    value += text_node.value();
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+/// Режим обработки элемента
+enum class BinXmlElementMode {
+    Convert,       // Обычный элемент: _attributes, дочерние, $text
+    Flatten,       // EventData/UserData: <Data Name="X">v</Data> → {"X": "v"}
+    FlattenChild,  // Дочерний элемент EventData/UserData: имя, атрибуты, текст
+    Discard        // Вложенный глубже — в результат не попадает
+};
+
+/// Режим элемента по режиму родителя (parent == nullptr для корня)
+static BinXmlElementMode element_mode(const BinXmlElementMode* parent, const std::string& name) {
+    using Mode = BinXmlElementMode;
+    Mode mode = Mode::Convert;
+    if (parent) {
+        if (*parent == Mode::Flatten) {
+            mode = Mode::FlattenChild;
+        } else if (*parent != Mode::Convert) {
+            mode = Mode::Discard;
+        }
+    }
+    if (mode == Mode::Convert && (name == "EventData" || name == "UserData")) {
+        mode = Mode::Flatten;
+    }
+    return mode;
+}
+
+/// Завершить текстовый сегмент text[segment_start, end) (текст между соседними тегами)
+static void flush_text_segment(std::string& text, std::size_t& segment_start) {
+    std::size_t start = segment_start;
+    if (text.size() > start) {
+        bool whitespace_only = std::all_of(text.begin() + static_cast<std::ptrdiff_t>(start),
+                                           text.end(), is_xml_space);
+        if (whitespace_only) {
+            text.resize(start);
+        } else if (text.find('\r', start) != std::string::npos) {
+            // parse_eol: \r\n → \n, \r → \n
+            std::size_t out = start;
+            for (std::size_t i = start; i < text.size(); ++i) {
+                if (text[i] == '\r') {
+                    text[out++] = '\n';
+                    if (i + 1 < text.size() && text[i + 1] == '\n')
+                        ++i;
+                } else {
+                    text[out++] = text[i];
                 }
             }
-            flattened[child_name].push_back(value);
+            text.resize(out);
+        }
+    }
+    segment_start = text.size();
+}
+
+/// Значение атрибута обычного элемента: числа сохраняем как числа
+static Value attribute_value(std::string value) {
+    std::int64_t int_val = 0;
+    if (parse_xml_integer(value, int_val)) {
+        return Value(int_val);
+    }
+    return Value(std::move(value));
+}
+
+/// Добавить единственный дочерний элемент с именем name
+static void put_child(Value::Object& obj, ValueKey name, Value value) {
+    if (value.is_object() && value.object_size() == 0) {
+        obj[name] = Value(std::string());
+    } else if (value.is_object()) {
+        // Перекладываем значения в новый объект в порядке обхода (как при копировании)
+        auto& child_obj = value.as_object_mut();
+        Value::Object merged;
+        merged.reserve(child_obj.size());
+        for (auto it = child_obj.begin(); it != child_obj.end(); ++it) {
+            merged[it.key()] = std::move(it->second);
+        }
+        obj[name] = Value(std::move(merged));
+    } else {
+        obj[name] = std::move(value);
+    }
+}
+
+/// Завершить обычный элемент текстовым содержимым: число, строка или $text
+static Value finish_element(Value::Object obj, std::string text) {
+    if (!text.empty()) {
+        std::int64_t int_val = 0;
+        if (parse_xml_integer(text, int_val)) {
+            return Value(int_val);
         }
+        if (obj.empty()) {
+            return Value(std::move(text));
+        }
+        obj["$text"] = Value(std::move(text));
+    }
+
+    // Если объект пустой и нет атрибутов — возвращаем null
+    if (obj.empty()) {
+        return Value();
     }
+    return Value(std::move(obj));
+}
 
-    // Формируем результирующий объект
-    for (auto& [key, values] : flattened) {
-        if (values.size() == 1) {
-            obj[key] = Value(values[0]);
+/// Пары (ключ, значение) EventData/UserData, упорядоченные по ключу, → объект
+static Value event_data_object(std::vector<std::pair<std::string, std::string>>& entries) {
+    Value::Object obj;
+    for (std::size_t i = 0; i < entries.size();) {
+        std::size_t j = i + 1;
+        while (j < entries.size() && entries[j].first == entries[i].first)
+            ++j;
+        if (j - i == 1) {
+            obj[entries[i].first] = Value(std::move(entries[i].second));
         } else {
             // Несколько значений с одинаковым ключом — массив
             Value::Array arr;
-            for (auto& v : values) {
-                arr.push_back(Value(v));
+            arr.reserve(j - i);
+            for (std::size_t k = i; k < j; ++k) {
+                arr.push_back(Value(std::move(entries[k].second)));
             }
-            obj[key] = Value(std::move(arr));
+            obj[entries[i].first] = Value(std::move(arr));
         }
+        i = j;
     }
 
     // Если объект пустой — возвращаем null (как upstream)
     if (obj.empty()) {
         return Value();
     }
-
     return Value(std::move(obj));
 }
 
-/// Рекурсивная конверсия XML узла в Value с _attributes семантикой
-/// SPEC-SLICE-007 FACT-005: separate_json_attributes(true)
-/// ADR-0012: flatten EventData/UserData
-static Value convert_xml_node(const pugi::xml_node& node) {
-    // ADR-0012: специальная обработка EventData/UserData
-    if (is_event_data_container(node)) {
-        return convert_event_data_node(node);
+/// Корень документа: {имя: значение, имя_attributes: атрибуты корня строками}
+static Value wrap_root(ValueKey name, ValueKey attributes_key, Value value,
+                       std::vector<std::pair<std::string, std::string>>& attributes) {
+    Value::Object result;
+    result[name] = std::move(value);
+
+    Value::Object root_attrs;
+    for (auto& [attr_name, attr_value] : attributes) {
+        root_attrs[attr_name] = Value(std::move(attr_value));
     }
+    if (!root_attrs.empty()) {
+        result[attributes_key] = Value(std::move(root_attrs));
+    }
+    return Value(std::move(result));
+}
 
-    Value::Object obj;
+/// Приёмник, строящий Value напрямую из событий Binary XML
+class BinXmlValueBuilder {
+public:
+    void open_element(const std::string& name) {
+        finish_attribute();
+
+        const Mode* parent_mode = nullptr;
+        if (depth_ > 0) {
+            Frame& parent = frames_[depth_ - 1];
+            flush_text(parent);
+            parent_mode = &parent.mode;
+        }
+        Mode mode = element_mode(parent_mode, name);
 
-    // Собираем атрибуты в отдельный объект с суффиксом "_attributes"
-    // если есть хотя бы один атрибут
-    Value::Object attrs;
-    for (const auto& attr : node.attributes()) {
-        std::string attr_name = attr.name();
-        std::string attr_value = attr.value();
-
-        // Попытаемся определить тип значения
-        // Числа сохраняем как числа
-        char* end = nullptr;
-        long long int_val = std::strtoll(attr_value.c_str(), &end, 10);
-        if (end != attr_value.c_str() && *end == '\0' && !attr_value.empty()) {
-            attrs[attr_name] = Value(static_cast<std::int64_t>(int_val));
-        } else {
-            attrs[attr_name] = Value(attr_value);
+        if (depth_ == frames_.size()) {
+            frames_.emplace_back();
+        }
+        Frame& frame = frames_[depth_++];
+        frame.reset(name, mode);
+    }
+
+    void close_start() { finish_attribute(); }
+
+    void close_empty() {
+        finish_attribute();
+        close();
+    }
+
+    void close_element() {
+        finish_attribute();
+        close();
+    }
+
+    void attribute(const std::string& name) {
+        finish_attribute();
+        if (depth_ == 0) {
+            return;
+        }
+        frames_[depth_ - 1].attributes.emplace_back(name, std::string());
+        pending_attribute_ = true;
+    }
+
+    void text(std::string_view value) {
+        if (depth_ == 0) {
+            pending_attribute_ = false;
+            return;
+        }
+        Frame& frame = frames_[depth_ - 1];
+        if (pending_attribute_) {
+            // Значение закрывает атрибут (как в прежнем XML представлении)
+            frame.attributes.back().second = normalize_xml_attribute(value);
+            pending_attribute_ = false;
+            return;
+        }
+        if (frame.mode == Mode::Convert || frame.mode == Mode::FlattenChild) {
+            frame.text.append(value);
+        }
+    }
+
+    void substitution(std::uint16_t index) {
+        // Подстановка без значения остаётся placeholder'ом
+        text("${" + std::to_string(index) + "}");
+    }
+
+    /// Документ ещё пуст: корень можно взять из скомпилированного шаблона
+    bool at_document_start() const { return depth_ == 0 && !has_root_; }
+
+    /// Принять готовый корень документа
+    void adopt_root(Value root) {
+        root_ = std::move(root);
+        has_root_ = true;
+    }
+
+    /// Получить результат (null, если документ не сбалансирован или пуст)
+    Value finish() {
+        if (depth_ != 0 || !has_root_) {
+            return Value();
+        }
+        return std::move(root_);
+    }
+
+private:
+    using Mode = BinXmlElementMode;
+
+    struct Frame {
+        std::string name;
+        Mode mode = Mode::Convert;
+        std::vector<std::pair<std::string, std::string>> attributes;
+        std::vector<std::pair<std::string, Value>> children;
+        std::vector<std::pair<std::string, std::string>> flattened;
+        std::string text;
+        std::size_t segment_start = 0;
+
+        void reset(const std::string& n, Mode m) {
+            name = n;
+            mode = m;
+            attributes.clear();
+            children.clear();
+            flattened.clear();
+            text.clear();
+            segment_start = 0;
+        }
+    };
+
+    std::vector<Frame> frames_;
+    std::size_t depth_ = 0;
+    bool pending_attribute_ = false;
+    bool has_root_ = false;
+    Value root_;
+
+    void finish_attribute() { pending_attribute_ = false; }
+
+    /// Завершить текстовый сегмент (текст между соседними тегами)
+    static void flush_text(Frame& frame) { flush_text_segment(frame.text, frame.segment_start); }
+
+    void close() {
+        if (depth_ == 0) {
+            return;
+        }
+        Frame& frame = frames_[depth_ - 1];
+        flush_text(frame);
+        Frame* parent = depth_ > 1 ? &frames_[depth_ - 2] : nullptr;
+
+        switch (frame.mode) {
+        case Mode::Discard:
+            break;
+        case Mode::FlattenChild:
+            flatten_into(*parent, frame);
+            break;
+        case Mode::Flatten:
+            deliver(parent, frame, convert_event_data(frame));
+            break;
+        case Mode::Convert:
+            deliver(parent, frame, convert_element(frame));
+            break;
         }
+        --depth_;
     }
 
-    // Собираем дочерние элементы
-    std::map<std::string, std::vector<Value>> children;
-    std::string text_content;
+    /// Передать значение элемента родителю (или сформировать корень документа)
+    void deliver(Frame* parent, Frame& frame, Value value) {
+        if (parent) {
+            parent->children.emplace_back(std::move(frame.name), std::move(value));
+            return;
+        }
+        if (has_root_) {
+            return;  // Учитывается только первый корневой элемент
+        }
 
-    for (const auto& child : node.children()) {
-        if (child.type() == pugi::node_element) {
-            Value child_value = convert_xml_node(child);
-            children[child.name()].push_back(std::move(child_value));
-        } else if (child.type() == pugi::node_pcdata) {
-            text_content += child.value();
+        // Оборачиваем в объект с именем корня + атрибуты корня строками
+        root_ = wrap_root(ValueKey(frame.name), ValueKey(frame.name + "_attributes"),
+                          std::move(value), frame.attributes);
+        has_root_ = true;
+    }
+
+    /// Дочерний элемент EventData/UserData → пара (ключ, значение)
+    static void flatten_into(Frame& parent, Frame& child) {
+        if (child.name == "Data") {
+            auto name_attr = std::find_if(child.attributes.begin(), child.attributes.end(),
+                                          [](const auto& a) { return a.first == "Name"; });
+            if (name_attr != child.attributes.end()) {
+                // Используем значение Name как ключ
+                parent.flattened.emplace_back(name_attr->second, std::move(child.text));
+            } else if (!child.text.empty()) {
+                // Добавляем как безымянный Data элемент
+                parent.flattened.emplace_back("Data", std::move(child.text));
+            }
+        } else {
+            // Другие элементы (не Data), например Binary
+            parent.flattened.emplace_back(std::move(child.name), std::move(child.text));
         }
     }
 
-    // Если есть атрибуты, добавляем их как {имя_элемента}_attributes
-    if (!attrs.empty()) {
-        obj[std::string(node.name()) + "_attributes"] = Value(std::move(attrs));
+    /// Конверсия EventData/UserData с flatten-семантикой (ADR-0012)
+    static Value convert_event_data(Frame& frame) {
+        auto& entries = frame.flattened;
+        // Порядок ключей как у std::map (стабильно внутри одинаковых ключей)
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        return event_data_object(entries);
     }
 
-    // Добавляем дочерние элементы
-    for (auto& [name, values] : children) {
-        if (values.size() == 1) {
-            // Если один элемент с таким именем — значение
-            const Value& v = values[0];
-            // Если значение — объект только с текстом, разворачиваем его
-            if (v.is_object() && v.object_size() == 0) {
-                obj[name] = Value(std::string());
-            } else if (v.is_object()) {
-                // Копируем содержимое объекта
-                const auto& child_obj = v.as_object();
-                Value::Object merged;
-                for (const auto& [k, val] : child_obj) {
-                    merged[k] = val;
+    /// Конверсия обычного элемента с _attributes семантикой
+    static Value convert_element(Frame& frame) {
+        Value::Object obj;
+
+        // Атрибуты: числа сохраняем как числа
+        Value::Object attrs;
+        for (const auto& [attr_name, attr_value] : frame.attributes) {
+            attrs[attr_name] = attribute_value(attr_value);
+        }
+        if (!attrs.empty()) {
+            obj[frame.name + "_attributes"] = Value(std::move(attrs));
+        }
+
+        // Дочерние элементы в порядке имён (как std::map)
+        auto& children = frame.children;
+        std::stable_sort(children.begin(), children.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (std::size_t i = 0; i < children.size();) {
+            std::size_t j = i + 1;
+            while (j < children.size() && children[j].first == children[i].first)
+                ++j;
+            if (j - i == 1) {
+                put_child(obj, ValueKey(children[i].first), std::move(children[i].second));
+            } else {
+                // Несколько элементов — массив
+                Value::Array arr;
+                arr.reserve(j - i);
+                for (std::size_t k = i; k < j; ++k) {
+                    arr.push_back(std::move(children[k].second));
                 }
-                // Если было текстовое содержимое
-                if (!values[0].has("$text") && child_obj.empty()) {
-                    // Пустой элемент
-                    obj[name] = Value(std::string());
-                } else {
-                    obj[name] = Value(std::move(merged));
+                obj[children[i].first] = Value(std::move(arr));
+            }
+            i = j;
+        }
+
+        // Текстовое содержимое: число, строка или $text
+        return finish_element(std::move(obj), std::move(frame.text));
+    }
+};
+
+// ============================================================================
+// Скомпилированные шаблоны
+// ============================================================================
+//
+// Определение шаблона один раз компилируется в каркас: дерево элементов с
+// заранее разрешёнными режимами, ключами {имя}_attributes, статическими
+// значениями атрибутов и порядком дочерних элементов. Значения подстановок
+// попадают только в слоты: экземпляр записи собирается без обхода токенов,
+// нормализации статического текста и сортировки дочерних элементов.
+// Результат совпадает с BinXmlValueBuilder на том же потоке токенов; шаблоны,
+// которые каркасом не выражаются, разворачиваются по токенам.
+//
+
+struct BinXmlSkeleton {
+    using Mode = BinXmlElementMode;
+
+    /// Текст: статический или значение подстановки
+    struct Part {
+        std::string text;        // Статический текст
+        std::int32_t slot = -1;  // Индекс подстановки; -1 — статический текст
+    };
+
+    struct Attribute {
+        std::string name;
+        ValueKey key;     // Интернированное name
+        Part value;       // Статический текст уже нормализован
+        Value converted;  // Статическое значение для {имя}_attributes (число/строка)
+    };
+
+    /// Элемент содержимого: текст, слот или дочерний элемент (границы сегментов)
+    struct Item {
+        Part part;
+        std::int32_t child = -1;  // Индекс дочернего узла; -1 — текст
+    };
+
+    struct Node {
+        std::string name;
+        std::string attributes_key;  // {имя}_attributes
+        ValueKey key;                // Интернированное name
+        ValueKey attributes_id;      // Интернированное attributes_key
+        Mode mode = Mode::Convert;
+        std::vector<Attribute> attributes;
+        std::vector<Item> content;
+        std::int32_t name_attribute = -1;  // Атрибут Name (FlattenChild)
+        bool has_slots = false;            // В содержимом есть слоты
+
+        // Convert: дочерние элементы, сгруппированные по имени в порядке std::map
+        std::vector<std::vector<std::uint32_t>> groups;
+
+        // Flatten: дочерние элементы; entries_sorted — уже в порядке ключей
+        std::vector<std::uint32_t> entries;
+        bool entries_sorted = false;
+    };
+
+    /// Слот подстановки
+    struct Slot {
+        std::uint16_t index = 0;
+        bool element_only = true;  // Только в содержимом Convert: допускает вложенный документ
+    };
+
+    std::vector<Node> nodes;      // nodes[0] — корень документа
+    std::vector<Slot> slots;      // Таблица слотов: используемые подстановки
+    bool top_level_text = false;  // Текст вне корня (значим для вложенного документа)
+};
+
+/// Скомпилировать поток токенов в каркас (nullptr — не выражается каркасом)
+static std::shared_ptr<const BinXmlSkeleton> compile_skeleton(
+    const std::vector<BinXmlTemplateToken>& tokens) {
+    using Mode = BinXmlElementMode;
+    auto skeleton = std::make_shared<BinXmlSkeleton>();
+    auto& nodes = skeleton->nodes;
+
+    auto use_slot = [&skeleton](std::uint16_t index, bool element_only) {
+        auto& slots = skeleton->slots;
+        auto it = std::find_if(slots.begin(), slots.end(),
+                               [index](const auto& slot) { return slot.index == index; });
+        if (it == slots.end()) {
+            slots.push_back({index, element_only});
+        } else {
+            it->element_only = it->element_only && element_only;
+        }
+    };
+
+    std::vector<std::uint32_t> stack;
+    bool pending_attribute = false;
+    bool has_root = false;
+
+    for (const auto& tok : tokens) {
+        switch (tok.token) {
+        case BinXmlToken::OpenStartElement: {
+            pending_attribute = false;
+            if (stack.empty() && has_root) {
+                return nullptr;  // Несколько корней — только через токены
+            }
+            const Mode* parent_mode = stack.empty() ? nullptr : &nodes[stack.back()].mode;
+            Mode mode = element_mode(parent_mode, tok.text);
+
+            auto index = static_cast<std::uint32_t>(nodes.size());
+            if (!stack.empty()) {
+                BinXmlSkeleton::Item item;
+                item.child = static_cast<std::int32_t>(index);
+                nodes[stack.back()].content.push_back(std::move(item));
+            }
+            BinXmlSkeleton::Node node;
+            node.name = tok.text;
+            node.attributes_key = tok.text + "_attributes";
+            node.key = ValueKey(node.name);
+            node.attributes_id = ValueKey(node.attributes_key);
+            node.mode = mode;
+            nodes.push_back(std::move(node));
+            stack.push_back(index);
+            break;
+        }
+        case BinXmlToken::CloseStartElement:
+            pending_attribute = false;
+            break;
+        case BinXmlToken::CloseEmptyElement:
+        case BinXmlToken::CloseElement:
+            pending_attribute = false;
+            if (stack.empty()) {
+                return nullptr;
+            }
+            stack.pop_back();
+            has_root = true;
+            break;
+        case BinXmlToken::Attribute:
+            if (stack.empty()) {
+                return nullptr;
+            }
+            nodes[stack.back()].attributes.push_back(
+                {tok.text, ValueKey(tok.text), {}, Value()});
+            pending_attribute = true;
+            break;
+        case BinXmlToken::Value:
+        case BinXmlToken::NormalSubstitution: {
+            bool is_slot = tok.token == BinXmlToken::NormalSubstitution;
+            if (stack.empty()) {
+                if (is_slot) {
+                    return nullptr;  // Подстановка вне корня может быть вложенным документом
                 }
+                skeleton->top_level_text = true;
+                pending_attribute = false;
+                break;
+            }
+            auto& node = nodes[stack.back()];
+            bool content = !pending_attribute;
+            if (is_slot) {
+                use_slot(tok.substitution_index, content && node.mode == Mode::Convert);
+            }
+
+            BinXmlSkeleton::Part part;
+            if (is_slot) {
+                part.slot = tok.substitution_index;
             } else {
-                obj[name] = values[0];
+                part.text = content ? tok.text : normalize_xml_attribute(tok.text);
             }
-        } else {
-            // Несколько элементов — массив
-            Value::Array arr;
-            for (auto& v : values) {
-                arr.push_back(std::move(v));
+
+            if (!content) {
+                node.attributes.back().value = std::move(part);
+                pending_attribute = false;
+            } else if (node.mode == Mode::Convert || node.mode == Mode::FlattenChild) {
+                node.has_slots = node.has_slots || is_slot;
+                node.content.push_back({std::move(part), -1});
             }
-            obj[name] = Value(std::move(arr));
+            break;
         }
+        default:
+            break;
+        }
+    }
+    if (!stack.empty() || !has_root) {
+        return nullptr;
     }
 
-    // Если есть текстовое содержимое
-    if (!text_content.empty()) {
-        // Пробуем преобразовать в число
-        char* end = nullptr;
-        long long int_val = std::strtoll(text_content.c_str(), &end, 10);
-        if (end != text_content.c_str() && *end == '\0') {
-            return Value(static_cast<std::int64_t>(int_val));
+    // Всё, что не зависит от значений подстановок, вычисляем заранее
+    for (auto& node : nodes) {
+        for (std::size_t i = 0; i < node.attributes.size(); ++i) {
+            auto& attr = node.attributes[i];
+            if (attr.value.slot < 0) {
+                attr.converted = attribute_value(attr.value.text);
+            }
+            if (node.name_attribute < 0 && attr.name == "Name") {
+                node.name_attribute = static_cast<std::int32_t>(i);
+            }
         }
-        // Иначе возвращаем как строку
-        if (obj.empty()) {
-            return Value(text_content);
+    }
+    for (auto& node : nodes) {
+        std::vector<std::uint32_t> children;
+        for (const auto& item : node.content) {
+            if (item.child >= 0) {
+                children.push_back(static_cast<std::uint32_t>(item.child));
+            }
+        }
+
+        if (node.mode == Mode::Convert) {
+            std::stable_sort(children.begin(), children.end(),
+                             [&nodes](std::uint32_t a, std::uint32_t b) {
+                                 return nodes[a].name < nodes[b].name;
+                             });
+            for (std::uint32_t child : children) {
+                if (node.groups.empty() ||
+                    nodes[node.groups.back().front()].name != nodes[child].name) {
+                    node.groups.emplace_back();
+                }
+                node.groups.back().push_back(child);
+            }
+        } else if (node.mode == Mode::Flatten) {
+            // Ключ известен заранее, если Name у Data статический
+            bool static_keys = std::all_of(children.begin(), children.end(), [&nodes](auto c) {
+                const auto& child = nodes[c];
+                return child.name != "Data" || child.name_attribute < 0 ||
+                       child.attributes[static_cast<std::size_t>(child.name_attribute)]
+                               .value.slot < 0;
+            });
+            if (static_keys) {
+                auto key = [&nodes](std::uint32_t c) -> const std::string& {
+                    static const std::string data_key = "Data";
+                    const auto& child = nodes[c];
+                    if (child.name != "Data") {
+                        return child.name;
+                    }
+                    if (child.name_attribute < 0) {
+                        return data_key;
+                    }
+                    return child.attributes[static_cast<std::size_t>(child.name_attribute)]
+                        .value.text;
+                };
+                std::stable_sort(
+                    children.begin(), children.end(),
+                    [&key](std::uint32_t a, std::uint32_t b) { return key(a) < key(b); });
+            }
+            node.entries = std::move(children);
+            node.entries_sorted = static_keys;
         }
-        obj["$text"] = Value(text_content);
     }
+    return skeleton;
+}
 
-    // Если объект пустой и нет атрибутов — возвращаем null
-    if (obj.empty()) {
-        return Value();
+// ============================================================================
+// Проекция полей
+// ============================================================================
+//
+// Для корня записи по каркасу заранее известно, какие узлы попадут в
+// запрошенные пути и какие подстановки в них используются. Остальные значения
+// только пропускаются (без конверсии FILETIME/GUID/SID и UTF-16), узлы вне
+// проекции не строятся. На путях проекции документ совпадает с полным.
+//
+
+struct BinXmlProjectionPlan {
+    std::vector<const FieldProjection*> nodes;   // Проекция узла; nullptr — не строится
+    std::vector<bool> slots;                      // Нужные значения подстановок
+    std::vector<const FieldProjection*> nested;  // Проекция элемента с вложенным документом
+    bool root_attributes = false;                 // Нужны атрибуты корня
+};
+
+static bool plan_needs_value(const BinXmlProjectionPlan& plan, std::size_t index) {
+    return index < plan.slots.size() && plan.slots[index];
+}
+
+/// Построить план: отметить узлы и подстановки, попадающие в проекцию
+static std::shared_ptr<const BinXmlProjectionPlan> compile_projection_plan(
+    const BinXmlTemplate& tmpl, const FieldProjection& container) {
+    using Mode = BinXmlElementMode;
+    const auto& nodes = tmpl.skeleton->nodes;
+    auto plan = std::make_shared<BinXmlProjectionPlan>();
+    plan->nodes.assign(nodes.size(), nullptr);
+    plan->slots.assign(tmpl.substitution_count, false);
+    plan->nested.assign(tmpl.substitution_count, nullptr);
+
+    auto use = [&plan](const BinXmlSkeleton::Part& part) {
+        auto index = static_cast<std::size_t>(part.slot);
+        if (part.slot >= 0 && index < plan->slots.size()) {
+            plan->slots[index] = true;
+        }
+    };
+    auto use_attributes = [&use](const BinXmlSkeleton::Node& node) {
+        for (const auto& attr : node.attributes) {
+            use(attr.value);
+        }
+    };
+    auto use_content = [&use](const BinXmlSkeleton::Node& node) {
+        for (const auto& item : node.content) {
+            if (item.child < 0) {
+                use(item.part);
+            }
+        }
+    };
+
+    std::function<void(std::size_t, const FieldProjection&)> mark;
+    mark = [&](std::size_t index, const FieldProjection& requested) {
+        const auto& node = nodes[index];
+        // $text есть только при непустом объекте: такой узел строим целиком
+        const FieldProjection& projection =
+            requested.child("$text").empty() ? requested : all_fields();
+        plan->nodes[index] = &projection;
+        use_content(node);
+
+        if (node.mode == Mode::Flatten) {
+            for (std::uint32_t entry : node.entries) {
+                const auto& child = nodes[entry];
+                if (child.name == "Data" && child.name_attribute >= 0) {
+                    const auto& name_attr =
+                        child.attributes[static_cast<std::size_t>(child.name_attribute)];
+                    if (name_attr.value.slot >= 0) {
+                        // Ключ из подстановки: известен только по значению
+                        use(name_attr.value);
+                    } else if (projection.child(name_attr.value.text).empty()) {
+                        continue;
+                    }
+                } else if (projection.child(child.name).empty()) {
+                    continue;
+                }
+                plan->nodes[entry] = &projection;
+                use_content(child);
+            }
+            return;
+        }
+
+        if (!projection.child(node.attributes_key).empty()) {
+            use_attributes(node);
+        }
+        for (const auto& item : node.content) {
+            if (item.child >= 0) {
+                auto child = static_cast<std::size_t>(item.child);
+                const auto& child_projection = projection.child(nodes[child].name);
+                if (!child_projection.empty()) {
+                    mark(child, child_projection);
+                }
+            } else if (item.part.slot >= 0) {
+                // Вложенный документ становится дочерним элементом этого узла
+                auto slot = static_cast<std::size_t>(item.part.slot);
+                if (slot < plan->nested.size()) {
+                    bool shared = plan->nested[slot] && plan->nested[slot] != &projection;
+                    plan->nested[slot] = shared ? &all_fields() : &projection;
+                }
+            }
+        }
+    };
+
+    const auto& root = nodes.front();
+    const auto& root_projection = container.child(root.name);
+    if (!root_projection.empty()) {
+        mark(0, root_projection);
     }
+    plan->root_attributes = !container.child(root.attributes_key).empty();
+    if (plan->root_attributes) {
+        use_attributes(root);
+    }
+    return plan;
+}
 
-    return Value(std::move(obj));
+static std::shared_ptr<const BinXmlProjectionPlan> projection_plan(
+    BinXmlContext& ctx, const BinXmlTemplate& tmpl, const FieldProjection& container) {
+    auto& plan = ctx.caches.plans[{&tmpl, &container}];
+    if (!plan) {
+        plan = compile_projection_plan(tmpl, container);
+    }
+    return plan;
 }
 
-/// Конвертировать XML документ в Value с _attributes семантикой
-static Value xml_document_to_json_with_attributes(const pugi::xml_document& doc) {
-    auto root = doc.document_element();
-    if (!root) {
-        return Value();
+/// Вложенный документ: [StartOfStream] TemplateInstance [EndOfStream]
+static bool read_nested_instance(BinXmlContext& ctx, BinXmlInstance& instance,
+                                 const FieldProjection* container) {
+    auto token = static_cast<BinXmlToken>(ctx.read_u8() & 0x0f);
+    if (token == BinXmlToken::StartOfStream) {
+        ctx.skip(3);
+        token = static_cast<BinXmlToken>(ctx.read_u8() & 0x0f);
+    }
+    if (token != BinXmlToken::TemplateInstance ||
+        !read_template_instance(ctx, instance, container)) {
+        return false;
     }
+    return ctx.eof() || static_cast<BinXmlToken>(ctx.read_u8() & 0x0f) == BinXmlToken::EndOfStream;
+}
 
-    // Конвертируем корневой элемент
-    Value root_value = convert_xml_node(root);
+static bool prepare_instance(const BinXmlContext& ctx, BinXmlInstance& instance) {
+    const auto& skeleton = instance.tmpl->skeleton;
+    if (!skeleton) {
+        return false;
+    }
+    const auto& values = instance.values;
+    for (const auto& slot : skeleton->slots) {
+        if (slot.index >= values.size() || values[slot.index].binxml_size == 0) {
+            continue;
+        }
+        // Вложенный документ (обычно EventData со своим шаблоном) встраивается
+        // как дочерний элемент, если в слоте он стоит на месте содержимого
+        if (!slot.element_only) {
+            return false;
+        }
 
-    // Добавляем атрибуты корневого элемента как {root_name}_attributes
-    // и оборачиваем всё в объект с именем корня
-    Value::Object result;
-    result[root.name()] = std::move(root_value);
+        // По проекции: документ в элементе, который не строится, не собирается,
+        // но читается — определения шаблонов в нём нужны следующим записям чанка
+        const FieldProjection* container = nullptr;
+        bool wanted = true;
+        if (instance.plan) {
+            container = instance.plan->nested[slot.index];
+            if (!container) {
+                container = &no_fields();
+                wanted = false;
+            }
+        }
 
-    // Атрибуты корневого элемента
-    Value::Object root_attrs;
-    for (const auto& attr : root.attributes()) {
-        root_attrs[attr.name()] = Value(std::string(attr.value()));
+        if (instance.nested.empty()) {
+            instance.nested.resize(values.size());
+        }
+        auto& nested = instance.nested[slot.index];
+        BinXmlContext sub_ctx =
+            ctx.sub(values[slot.index].binxml_offset, values[slot.index].binxml_size);
+        bool prepared = read_nested_instance(sub_ctx, nested, container) &&
+                        nested.tmpl->skeleton && !nested.tmpl->skeleton->top_level_text &&
+                        prepare_instance(sub_ctx, nested);
+        if (!prepared && wanted) {
+            return false;
+        }
     }
-    if (!root_attrs.empty()) {
-        result[std::string(root.name()) + "_attributes"] = Value(std::move(root_attrs));
+    return true;
+}
+
+/// Сборка документа по каркасу для значений одной записи
+class BinXmlSkeletonInstance {
+public:
+    explicit BinXmlSkeletonInstance(const BinXmlInstance& instance)
+        : instance_(instance),
+          nodes_(instance.tmpl->skeleton->nodes),
+          plan_(instance.plan.get()) {}
+
+    /// Корень документа с атрибутами корня строками
+    Value root() {
+        const auto& node = nodes_.front();
+        Value value = built(node) ? build(node) : Value();
+
+        std::vector<std::pair<std::string, std::string>> attributes;
+        if (!plan_ || plan_->root_attributes) {
+            attributes.reserve(node.attributes.size());
+            for (const auto& attr : node.attributes) {
+                attributes.emplace_back(attr.name, attribute_text(attr));
+            }
+        }
+        return wrap_root(node.key, node.attributes_id, std::move(value), attributes);
     }
 
-    return Value(std::move(result));
+    /// Корень попадает в проекцию контейнера
+    bool wanted() const { return built(nodes_.front()); }
+
+    /// Корень как дочерний элемент: (имя, значение)
+    std::pair<const std::string*, Value> child() {
+        const auto& node = nodes_.front();
+        return {&node.name, build(node)};
+    }
+
+private:
+    using Mode = BinXmlElementMode;
+    using Node = BinXmlSkeleton::Node;
+
+    const BinXmlInstance& instance_;
+    const std::vector<Node>& nodes_;
+    const BinXmlProjectionPlan* plan_;  // nullptr — строятся все узлы
+    std::string placeholder_;
+
+    /// Узел строится (попадает в проекцию)
+    bool built(const Node& node) const {
+        return !plan_ || plan_->nodes[static_cast<std::size_t>(&node - nodes_.data())];
+    }
+
+    /// Проекция строящегося узла
+    const FieldProjection& projection(const Node& node) const {
+        return plan_ ? *plan_->nodes[static_cast<std::size_t>(&node - nodes_.data())]
+                     : all_fields();
+    }
+
+    /// В слоте вложенный документ
+    bool is_document(const BinXmlSkeleton::Part& part) const {
+        auto index = static_cast<std::size_t>(part.slot);
+        return part.slot >= 0 && index < instance_.values.size() &&
+               instance_.values[index].binxml_size > 0;
+    }
+
+    /// Текст части: статический, значение подстановки или placeholder ${N}
+    const std::string& text(const BinXmlSkeleton::Part& part) {
+        if (part.slot < 0) {
+            return part.text;
+        }
+        auto index = static_cast<std::size_t>(part.slot);
+        if (index < instance_.values.size()) {
+            return instance_.values[index].text;
+        }
+        placeholder_ = "${" + std::to_string(index) + "}";
+        return placeholder_;
+    }
+
+    std::string attribute_text(const BinXmlSkeleton::Attribute& attr) {
+        if (attr.value.slot < 0) {
+            return attr.value.text;
+        }
+        return normalize_xml_attribute(text(attr.value));
+    }
+
+    /// Текстовое содержимое элемента с сегментацией по дочерним элементам
+    std::string element_text(const Node& node) {
+        std::string result;
+        std::size_t segment_start = 0;
+        for (const auto& item : node.content) {
+            if (item.child >= 0 || is_document(item.part)) {
+                flush_text_segment(result, segment_start);
+            } else {
+                result.append(text(item.part));
+            }
+        }
+        flush_text_segment(result, segment_start);
+        return result;
+    }
+
+    Value build(const Node& node) {
+        return node.mode == Mode::Flatten ? event_data(node) : element(node);
+    }
+
+    /// Обычный элемент с _attributes семантикой
+    Value element(const Node& node) {
+        Value::Object obj;
+
+        if (!node.attributes.empty() && !projection(node).child(node.attributes_key).empty()) {
+            Value::Object attrs;
+            for (const auto& attr : node.attributes) {
+                attrs[attr.key] =
+                    attr.value.slot < 0 ? attr.converted : attribute_value(attribute_text(attr));
+            }
+            obj[node.attributes_id] = Value(std::move(attrs));
+        }
+
+        bool has_documents =
+            node.has_slots && std::any_of(node.content.begin(), node.content.end(),
+                                          [this](const auto& item) {
+                                              return is_document(item.part);
+                                          });
+        if (has_documents) {
+            dynamic_children(node, obj);
+        } else {
+            for (const auto& group : node.groups) {
+                if (!built(nodes_[group.front()])) {
+                    continue;
+                }
+                ValueKey name = nodes_[group.front()].key;
+                if (group.size() == 1) {
+                    put_child(obj, name, build(nodes_[group.front()]));
+                } else {
+                    Value::Array arr;
+                    arr.reserve(group.size());
+                    for (std::uint32_t child : group) {
+                        arr.push_back(build(nodes_[child]));
+                    }
+                    obj[name] = Value(std::move(arr));
+                }
+            }
+        }
+
+        return finish_element(std::move(obj), element_text(node));
+    }
+
+    /// Дочерние элементы вперемешку с вложенными документами: порядок известен
+    /// только по значениям, группируем как BinXmlValueBuilder
+    void dynamic_children(const Node& node, Value::Object& obj) {
+        std::vector<std::pair<const std::string*, Value>> children;
+        for (const auto& item : node.content) {
+            if (item.child >= 0) {
+                const auto& child = nodes_[static_cast<std::size_t>(item.child)];
+                if (built(child)) {
+                    children.emplace_back(&child.name, build(child));
+                }
+            } else if (is_document(item.part)) {
+                const auto& nested = instance_.nested[static_cast<std::size_t>(item.part.slot)];
+                BinXmlSkeletonInstance sub(nested);
+                if (sub.wanted()) {
+                    children.push_back(sub.child());
+                }
+            }
+        }
+        std::stable_sort(children.begin(), children.end(),
+                         [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+        for (std::size_t i = 0; i < children.size();) {
+            std::size_t j = i + 1;
+            while (j < children.size() && *children[j].first == *children[i].first)
+                ++j;
+            if (j - i == 1) {
+                put_child(obj, ValueKey(*children[i].first), std::move(children[i].second));
+            } else {
+                Value::Array arr;
+                arr.reserve(j - i);
+                for (std::size_t k = i; k < j; ++k) {
+                    arr.push_back(std::move(children[k].second));
+                }
+                obj[*children[i].first] = Value(std::move(arr));
+            }
+            i = j;
+        }
+    }
+
+    /// EventData/UserData с flatten-семантикой
+    Value event_data(const Node& node) {
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(node.entries.size());
+        const auto& wanted = projection(node);
+        for (std::uint32_t index : node.entries) {
+            const auto& child = nodes_[index];
+            if (!built(child)) {
+                continue;
+            }
+            // Безымянный Data попадает под ключ "Data"
+            bool named = child.name != "Data" || child.name_attribute >= 0;
+            std::string key = "Data";
+            if (child.name != "Data") {
+                key = child.name;
+            } else if (named) {
+                key = attribute_text(
+                    child.attributes[static_cast<std::size_t>(child.name_attribute)]);
+            }
+            if (plan_ && wanted.child(key).empty()) {
+                continue;
+            }
+            std::string value = element_text(child);
+            if (named) {
+                entries.emplace_back(std::move(key), std::move(value));
+            } else if (!value.empty()) {
+                entries.emplace_back("Data", std::move(value));
+            }
+        }
+        if (!node.entries_sorted) {
+            std::stable_sort(entries.begin(), entries.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+        return event_data_object(entries);
+    }
+};
+
+static Value instantiate_skeleton(const BinXmlInstance& instance) {
+    return BinXmlSkeletonInstance(instance).root();
 }
 
 // ============================================================================
-// Утилиты
+// BinXmlTemplateCache
 // ============================================================================
 
-template <typename T>
-bool EvtxParser::read_value(T& value) {
-    return read_bytes(&value, sizeof(T));
+BinXmlTemplateCache& BinXmlTemplateCache::global() {
+    static BinXmlTemplateCache cache;
+    return cache;
 }
 
-bool EvtxParser::read_bytes(void* buffer, std::size_t size) {
-    file_.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
-    return file_.gcount() == static_cast<std::streamsize>(size);
+/// FNV-1a по GUID и потоку токенов определения
+static std::uint64_t template_hash(const BinXmlTemplate& tmpl) {
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(tmpl.guid.data(), tmpl.guid.size());
+    for (const auto& tok : tmpl.tokens) {
+        auto token = static_cast<std::uint8_t>(tok.token);
+        std::uint64_t length = tok.text.size();
+        mix(&token, sizeof(token));
+        mix(&tok.substitution_index, sizeof(tok.substitution_index));
+        mix(&length, sizeof(length));
+        mix(tok.text.data(), tok.text.size());
+    }
+    return hash;
 }
 
-std::string EvtxParser::read_utf16_string(const std::vector<std::uint8_t>& data,
-                                          std::size_t& offset, std::size_t char_count) {
-    std::string result;
-    result.reserve(char_count);
+static bool same_definition(const BinXmlTemplate& a, const BinXmlTemplate& b) {
+    return a.guid == b.guid &&
+           std::equal(a.tokens.begin(), a.tokens.end(), b.tokens.begin(), b.tokens.end(),
+                      [](const BinXmlTemplateToken& x, const BinXmlTemplateToken& y) {
+                          return x.token == y.token &&
+                                 x.substitution_index == y.substitution_index &&
+                                 x.text == y.text;
+                      });
+}
 
-    for (std::size_t i = 0; i < char_count && offset + 1 < data.size(); ++i) {
-        std::uint16_t ch = static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8));
-        offset += 2;
+std::shared_ptr<const BinXmlTemplate> BinXmlTemplateCache::intern(BinXmlTemplate tmpl) {
+    tmpl.hash = template_hash(tmpl);
+    {
+        std::shared_lock lock(mutex_);
+        auto it = templates_.find(tmpl.hash);
+        if (it != templates_.end()) {
+            for (const auto& cached : it->second) {
+                if (same_definition(*cached, tmpl)) {
+                    return cached;
+                }
+            }
+        }
+    }
 
-        // Простая конверсия UTF-16 → UTF-8
-        if (ch < 0x80) {
-            result.push_back(static_cast<char>(ch));
-        } else if (ch < 0x800) {
-            result.push_back(static_cast<char>(0xC0 | (ch >> 6)));
-            result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
-        } else {
-            result.push_back(static_cast<char>(0xE0 | (ch >> 12)));
-            result.push_back(static_cast<char>(0x80 | ((ch >> 6) & 0x3F)));
-            result.push_back(static_cast<char>(0x80 | (ch & 0x3F)));
+    // Компилируем вне блокировки
+    for (const auto& tok : tmpl.tokens) {
+        if (tok.token == BinXmlToken::NormalSubstitution) {
+            tmpl.substitution_count =
+                std::max<std::size_t>(tmpl.substitution_count, tok.substitution_index + 1u);
+        }
+    }
+    tmpl.skeleton = compile_skeleton(tmpl.tokens);
+    auto compiled = std::make_shared<const BinXmlTemplate>(std::move(tmpl));
+
+    std::unique_lock lock(mutex_);
+    auto& bucket = templates_[compiled->hash];
+    for (const auto& cached : bucket) {
+        if (same_definition(*cached, *compiled)) {
+            return cached;  // Другой поток успел раньше
         }
     }
+    bucket.push_back(compiled);
+    ++size_;
+    return compiled;
+}
 
-    return result;
+std::size_t BinXmlTemplateCache::size() const {
+    std::shared_lock lock(mutex_);
+    return size_;
 }
 
-std::string EvtxParser::filetime_to_iso8601(std::uint64_t filetime) {
-    // Windows FILETIME: 100-наносекундные интервалы с 1601-01-01
-    // Unix timestamp: секунды с 1970-01-01
-    // Разница: 11644473600 секунд
+void BinXmlTemplateCache::clear() {
+    std::unique_lock lock(mutex_);
+    templates_.clear();
+    size_ = 0;
+}
 
-    constexpr std::uint64_t FILETIME_UNIX_DIFF = 116444736000000000ULL;
+// ============================================================================
+// EvtxParser - Binary XML → Value
+// ============================================================================
 
-    if (filetime < FILETIME_UNIX_DIFF) {
-        return "";
+static Value decode_binxml(std::span<const std::uint8_t> data, std::size_t chunk_offset,
+                           BinXmlChunkCaches& caches, const FieldProjection* projection) {
+    if (data.empty()) {
+        return Value();
     }
 
-    std::uint64_t unix_100ns = filetime - FILETIME_UNIX_DIFF;
-    std::uint64_t unix_seconds = unix_100ns / 10000000ULL;
-    std::uint64_t microseconds = (unix_100ns % 10000000ULL) / 10;
+    BinXmlContext ctx(data, chunk_offset, caches);
+    ctx.projection = projection;
 
-    std::time_t time = static_cast<std::time_t>(unix_seconds);
-    std::tm* tm = std::gmtime(&time);
+    // Строим Value напрямую из потока токенов
+    BinXmlValueBuilder builder;
+    walk_binxml(ctx, builder);
+    return builder.finish();
+}
 
-    if (!tm) {
-        return "";
-    }
+// ============================================================================
+// Утилиты
+// ============================================================================
 
-    std::ostringstream oss;
-    oss << std::setfill('0') << std::setw(4) << (tm->tm_year + 1900) << "-" << std::setw(2)
-        << (tm->tm_mon + 1) << "-" << std::setw(2) << tm->tm_mday << "T" << std::setw(2)
-        << tm->tm_hour << ":" << std::setw(2) << tm->tm_min << ":" << std::setw(2) << tm->tm_sec
-        << "." << std::setw(6) << microseconds << "Z";
+bool EvtxParser::read_bytes(std::uint64_t offset, void* buffer, std::size_t size) {
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file_.read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+    return file_.gcount() == static_cast<std::streamsize>(size);
+}
 
-    return oss.str();
+std::string EvtxParser::read_utf16_string(std::span<const std::uint8_t> data,
+                                          std::size_t& offset, std::size_t char_count) {
+    std::size_t available = offset < data.size() ? (data.size() - offset) / 2 : 0;
+    std::size_t units = std::min(char_count, available);
+    std::string result;
+    io::append_utf16le(result, data.data() + offset, units);
+    offset += units * 2;
+    return result;
+}
+
+std::string EvtxParser::filetime_to_iso8601(std::uint64_t filetime) {
+    DatePrefix prefix;
+    return filetime_string(filetime, prefix);
 }
 
 // ============================================================================
@@ -1131,7 +2663,7 @@ const Value* find_by_path(const Value& value, std::string_view path) {
         }
 
         // Ищем ключ
-        current = current->get(std::string(segment));
+        current = current->get(segment);
         if (!current) {
             return nullptr;
         }
@@ -1158,4 +2690,10 @@ const Value* find_with_aliases(const Value& value, std::string_view key) {
     return find_by_path(value, key);
 }
 
+bool is_time_created_field(std::string_view key) {
+    return key == "Event.System.TimeCreated" ||
+           key == "Event.System.TimeCreated_attributes.SystemTime" ||
+           key == "Event.System.TimeCreated.TimeCreated_attributes.SystemTime";
+}
+
 }  // namespace chainsaw::evtx
@@ -734,7 +734,14 @@ std::unique_ptr<Reader> create_xml_reader(const std::filesystem::path& path, boo
 
 class EvtxReader : public Reader {
 public:
-    explicit EvtxReader(std::filesystem::path path) : path_(std::move(path)) {}
+    EvtxReader(std::filesystem::path path, const ReaderOptions& options)
+        : path_(std::move(path)) {
+        parser_.set_threads(options.evtx_threads);
+        parser_.set_projection(options.projection);
+        parser_.set_time_window({options.evtx_written_after, std::nullopt});
+        parser_.set_value_arena(options.value_arena);
+        value_arena_ = options.value_arena;
+    }
 
     /// Загрузить EVTX файл
     bool load() {
@@ -752,6 +759,12 @@ public:
         if (!loaded_)
             return false;
 
+        // Прошлый документ живёт в арене парсера, которую сбросит parser_.next()
+        if (value_arena_) {
+            out.data = Value();
+            out.materialize = nullptr;
+        }
+
         evtx::EvtxRecord record;
         if (!parser_.next(record)) {
             // Проверяем ошибку
@@ -768,6 +781,7 @@ public:
         out.source = platform::path_to_utf8(path_);
         out.record_id = record.record_id;
         out.timestamp = record.timestamp;
+        out.materialize = std::move(record.full);
         return true;
     }
 
@@ -782,12 +796,14 @@ private:
     evtx::EvtxParser parser_;
     std::optional<ReaderError> error_;
     bool loaded_ = false;
+    bool value_arena_ = false;
 };
 
 /// Создать EVTX Reader
 /// SPEC-SLICE-007: EVTX parser (evtx.rs)
-std::unique_ptr<Reader> create_evtx_reader(const std::filesystem::path& path, bool skip_errors) {
-    auto reader = std::make_unique<EvtxReader>(path);
+std::unique_ptr<Reader> create_evtx_reader(const std::filesystem::path& path, bool skip_errors,
+                                           const ReaderOptions& options) {
+    auto reader = std::make_unique<EvtxReader>(path, options);
     if (!reader->load()) {
         if (skip_errors) {
             return create_empty_reader(path, DocumentKind::Evtx);
@@ -804,6 +820,15 @@ std::unique_ptr<Reader> create_evtx_reader(const std::filesystem::path& path, bo
 //
 
 ReaderResult Reader::open(const std::filesystem::path& file, bool load_unknown, bool skip_errors) {
+    ReaderOptions options;
+    options.load_unknown = load_unknown;
+    options.skip_errors = skip_errors;
+    return open(file, options);
+}
+
+ReaderResult Reader::open(const std::filesystem::path& file, const ReaderOptions& options) {
+    const bool load_unknown = options.load_unknown;
+    const bool skip_errors = options.skip_errors;
     ReaderResult result;
     result.ok = false;
 
@@ -860,7 +885,7 @@ ReaderResult Reader::open(const std::filesystem::path& file, bool load_unknown,
 
     // SLICE-007: EVTX парсер
     case DocumentKind::Evtx: {
-        result.reader = create_evtx_reader(file, skip_errors);
+        result.reader = create_evtx_reader(file, skip_errors, options);
         if (result.reader->last_error()) {
             result.error = *result.reader->last_error();
             result.ok = skip_errors;
@@ -917,7 +942,7 @@ ReaderResult Reader::open(const std::filesystem::path& file, bool load_unknown,
         // Важно: для fallback НЕ используем skip_errors, чтобы проверить ошибку парсинга
 
         // Позиция 1: EVTX (SPEC-SLICE-007 FACT-013)
-        auto evtx_reader = create_evtx_reader(file, false);  // skip_errors=false
+        auto evtx_reader = create_evtx_reader(file, false, options);
         if (!evtx_reader->last_error()) {
             result.ok = true;
             result.reader = std::move(evtx_reader);
@@ -0,0 +1,362 @@
+// ==============================================================================
+// utf16.cpp - Перекодирование UTF-16LE → UTF-8
+// ==============================================================================
+//
+// MOD-0007 formats (общий код парсеров EVTX, HVE, MFT и shimcache)
+//
+// Почти все строки артефактов Windows — ASCII, записанный в UTF-16LE. Поэтому
+// строка разбивается на ASCII-отрезки и остальные символы:
+// - длина ASCII-отрезка ищется векторно (8 единиц за шаг на SSE2, 16 на AVX2),
+//   отрезок сужается до байтов упаковкой (packus) прямо в строку результата;
+// - символы вне ASCII перекодируются по одному скалярно;
+// - строка результата выделяется один раз точно по размеру (для строк не только
+//   из ASCII размер в UTF-8 считается отдельным проходом).
+// SSE2 — базовый набор x86-64; AVX2 выбирается во время выполнения по CPUID.
+//
+// ==============================================================================
+
+#include <bit>
+#include <chainsaw/utf16.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHAINSAW_UTF16_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define CHAINSAW_UTF16_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace chainsaw::io {
+
+namespace {
+
+inline std::uint16_t load_unit(const std::uint8_t* data) {
+    return static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+}
+
+// ----------------------------------------------------------------------------
+// Скалярная реализация (хвосты векторных циклов и платформы без SSE2)
+// ----------------------------------------------------------------------------
+//
+// ascii_run<StopAtNul> — длина начального ASCII-отрезка; со StopAtNul отрезок
+// заканчивается и на NUL (строки utf16le_to_utf8 обрезаются по NUL за тот же проход).
+
+template <bool StopAtNul>
+inline bool is_ascii(std::uint16_t unit) {
+    return unit < 0x80 && (!StopAtNul || unit != 0);
+}
+
+template <bool StopAtNul>
+std::size_t ascii_run_scalar(const std::uint8_t* data, std::size_t units) {
+    std::size_t i = 0;
+    while (i < units && is_ascii<StopAtNul>(load_unit(data + i * 2))) {
+        ++i;
+    }
+    return i;
+}
+
+std::size_t length_scalar(const std::uint8_t* data, std::size_t units) {
+    std::size_t i = 0;
+    while (i < units && load_unit(data + i * 2) != 0) {
+        ++i;
+    }
+    return i;
+}
+
+void narrow_scalar(char* out, const std::uint8_t* data, std::size_t units) {
+    for (std::size_t i = 0; i < units; ++i) {
+        out[i] = static_cast<char>(data[i * 2]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// SSE2
+// ----------------------------------------------------------------------------
+
+#ifdef CHAINSAW_UTF16_SSE2
+
+/// Число единиц до первой, для которой маска сравнения (по 2 бита на единицу) не выставлена
+inline std::size_t first_clear_unit(unsigned mask) {
+    return static_cast<std::size_t>(std::countr_zero(~mask)) / 2;
+}
+
+template <bool StopAtNul>
+std::size_t ascii_run_sse2(const std::uint8_t* data, std::size_t units) {
+    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= units; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, high), zero);
+        if constexpr (StopAtNul) {
+            ascii = _mm_andnot_si128(_mm_cmpeq_epi16(v, zero), ascii);
+        }
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(ascii));
+        if (mask != 0xFFFF) {
+            return i + first_clear_unit(mask);
+        }
+    }
+    return i + ascii_run_scalar<StopAtNul>(data + i * 2, units - i);
+}
+
+std::size_t length_sse2(const std::uint8_t* data, std::size_t units) {
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= units; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        const auto nonzero =
+            static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero))) ^ 0xFFFF;
+        if (nonzero != 0xFFFF) {
+            return i + first_clear_unit(nonzero);
+        }
+    }
+    return i + length_scalar(data + i * 2, units - i);
+}
+
+void narrow_sse2(char* out, const std::uint8_t* data, std::size_t units) {
+    std::size_t i = 0;
+    for (; i + 16 <= units; i += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2 + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+    }
+    if (i + 8 <= units) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, lo));
+        i += 8;
+    }
+    narrow_scalar(out + i, data + i * 2, units - i);
+}
+
+#endif  // CHAINSAW_UTF16_SSE2
+
+// ----------------------------------------------------------------------------
+// AVX2 (GCC/Clang: функции собираются с target("avx2"), вызываются после CPUID)
+// ----------------------------------------------------------------------------
+//
+// Хвост короче вектора дочитывается SSE2-функцией без VEX-кодирования: перед её
+// вызовом верхние половины регистров обнуляются (vzeroupper), иначе переход между
+// AVX и SSE стоит десятки тактов на каждый вызов.
+
+#ifdef CHAINSAW_UTF16_AVX2
+
+bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+template <bool StopAtNul>
+__attribute__((target("avx2"))) std::size_t ascii_run_avx2(const std::uint8_t* data,
+                                                           std::size_t units) {
+    const __m256i high = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= units; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2));
+        __m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(v, high), zero);
+        if constexpr (StopAtNul) {
+            ascii = _mm256_andnot_si256(_mm256_cmpeq_epi16(v, zero), ascii);
+        }
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(ascii));
+        if (mask != 0xFFFFFFFF) {
+            return i + first_clear_unit(mask);
+        }
+    }
+    _mm256_zeroupper();
+    return i + ascii_run_sse2<StopAtNul>(data + i * 2, units - i);
+}
+
+__attribute__((target("avx2"))) std::size_t length_avx2(const std::uint8_t* data,
+                                                        std::size_t units) {
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= units; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2));
+        const auto nonzero =
+            ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, zero)));
+        if (nonzero != 0xFFFFFFFF) {
+            return i + first_clear_unit(nonzero);
+        }
+    }
+    _mm256_zeroupper();
+    return i + length_sse2(data + i * 2, units - i);
+}
+
+__attribute__((target("avx2"))) void narrow_avx2(char* out, const std::uint8_t* data,
+                                                 std::size_t units) {
+    std::size_t i = 0;
+    for (; i + 32 <= units; i += 32) {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2));
+        const __m256i hi =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2 + 32));
+        // packus упаковывает по 128-битным половинам: восстанавливаем порядок четвертей
+        const __m256i packed =
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    _mm256_zeroupper();
+    narrow_sse2(out + i, data + i * 2, units - i);
+}
+
+#endif  // CHAINSAW_UTF16_AVX2
+
+// ----------------------------------------------------------------------------
+// Выбор реализации
+// ----------------------------------------------------------------------------
+
+template <bool StopAtNul>
+std::size_t ascii_run(const std::uint8_t* data, std::size_t units) {
+#if defined(CHAINSAW_UTF16_AVX2)
+    if (has_avx2()) {
+        return ascii_run_avx2<StopAtNul>(data, units);
+    }
+#endif
+#if defined(CHAINSAW_UTF16_SSE2)
+    return ascii_run_sse2<StopAtNul>(data, units);
+#else
+    return ascii_run_scalar<StopAtNul>(data, units);
+#endif
+}
+
+std::size_t length(const std::uint8_t* data, std::size_t units) {
+#if defined(CHAINSAW_UTF16_AVX2)
+    if (has_avx2()) {
+        return length_avx2(data, units);
+    }
+#endif
+#if defined(CHAINSAW_UTF16_SSE2)
+    return length_sse2(data, units);
+#else
+    return length_scalar(data, units);
+#endif
+}
+
+void narrow(char* out, const std::uint8_t* data, std::size_t units) {
+#if defined(CHAINSAW_UTF16_AVX2)
+    if (has_avx2()) {
+        narrow_avx2(out, data, units);
+        return;
+    }
+#endif
+#if defined(CHAINSAW_UTF16_SSE2)
+    narrow_sse2(out, data, units);
+#else
+    narrow_scalar(out, data, units);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Строки с символами вне ASCII
+// ----------------------------------------------------------------------------
+
+/// ASCII-отрезок короче не сужается векторно: вызов не окупается
+constexpr std::size_t MIN_VECTOR_RUN = 16;
+
+/// Перекодировать units единиц: Write = false — только посчитать байты UTF-8
+/// (результат заранее выделяется точно по размеру, запись идёт без проверок ёмкости)
+template <bool Write>
+std::size_t encode(char* out, const std::uint8_t* data, std::size_t units) {
+    std::size_t n = 0;
+    std::size_t i = 0;
+    while (i < units) {
+        const std::uint16_t unit = load_unit(data + i * 2);
+        if (unit < 0x80) {
+            // Длинный ASCII-отрезок внутри строки (например, путь с одним
+            // не-ASCII каталогом) — векторно; одиночные пробелы — скалярно
+            std::size_t run = 1;
+            if (units - i >= MIN_VECTOR_RUN && load_unit(data + i * 2 + 2) < 0x80) {
+                run = ascii_run<false>(data + i * 2, units - i);
+            }
+            if constexpr (Write) {
+                if (run == 1) {
+                    out[n] = static_cast<char>(unit);
+                } else {
+                    narrow(out + n, data + i * 2, run);
+                }
+            }
+            n += run;
+            i += run;
+            continue;
+        }
+
+        std::uint32_t code_point = unit;
+        ++i;
+        if (unit >= 0xD800 && unit <= 0xDFFF) {
+            // Суррогат: пара «старший + младший» — символ выше U+FFFF, одиночный пропускается
+            if (unit > 0xDBFF || i >= units) {
+                continue;
+            }
+            const std::uint16_t low = load_unit(data + i * 2);
+            if (low < 0xDC00 || low > 0xDFFF) {
+                continue;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10 | (low - 0xDC00u));
+            ++i;
+        }
+
+        if (code_point < 0x800) {
+            if constexpr (Write) {
+                out[n] = static_cast<char>(0xC0 | (code_point >> 6));
+                out[n + 1] = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            n += 2;
+        } else if (code_point < 0x10000) {
+            if constexpr (Write) {
+                out[n] = static_cast<char>(0xE0 | (code_point >> 12));
+                out[n + 1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out[n + 2] = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            n += 3;
+        } else {
+            if constexpr (Write) {
+                out[n] = static_cast<char>(0xF0 | (code_point >> 18));
+                out[n + 1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                out[n + 2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out[n + 3] = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            n += 4;
+        }
+    }
+    return n;
+}
+
+/// Дописать строку, у которой первые ascii единиц — ASCII
+void append(std::string& out, const std::uint8_t* data, std::size_t ascii, std::size_t units) {
+    const std::size_t at = out.size();
+    const std::uint8_t* rest = data + ascii * 2;
+    const std::size_t size = ascii == units ? 0 : encode<false>(nullptr, rest, units - ascii);
+    out.resize(at + ascii + size);
+    narrow(out.data() + at, data, ascii);
+    if (size > 0) {
+        encode<true>(out.data() + at + ascii, rest, units - ascii);
+    }
+}
+
+}  // anonymous namespace
+
+std::size_t utf16le_length(const std::uint8_t* data, std::size_t units) {
+    return length(data, units);
+}
+
+void append_utf16le(std::string& out, const std::uint8_t* data, std::size_t units) {
+    append(out, data, ascii_run<false>(data, units), units);
+}
+
+std::string utf16le_to_utf8(const std::uint8_t* data, std::size_t byte_len) {
+    if (byte_len == 0 || byte_len % 2 != 0) {
+        return {};
+    }
+    // Один проход по типичной ASCII-строке: отрезок заканчивается на NUL или на конце
+    const std::size_t units = byte_len / 2;
+    const std::size_t ascii = ascii_run<true>(data, units);
+    std::string result;
+    if (ascii == units || load_unit(data + ascii * 2) == 0) {
+        append(result, data, ascii, ascii);
+    } else {
+        append(result, data, ascii, ascii + length(data + ascii * 2, units - ascii));
+    }
+    return result;
+}
+
+}  // namespace chainsaw::io
@@ -8,12 +8,18 @@
 //
 // ==============================================================================
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <chainsaw/value.hpp>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <shared_mutex>
 #include <stdexcept>
 
 namespace chainsaw {
@@ -191,4 +197,517 @@ rapidjson::Document Value::to_rapidjson_document() const {
     return doc;
 }
 
+// ----------------------------------------------------------------------------
+// ValueKey - таблица интернированных ключей
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// Таблица ключей: строки лежат в блоках постоянного адреса, поэтому текст
+/// ключа читается без блокировки (номер ключа получен после его публикации)
+class KeyTable {
+public:
+    static constexpr std::size_t BLOCK_BITS = 12;
+    static constexpr std::size_t BLOCK_SIZE = std::size_t{1} << BLOCK_BITS;
+    static constexpr std::size_t MAX_BLOCKS = ValueKey::MAX_INTERNED / BLOCK_SIZE;
+
+    static KeyTable& instance() {
+        static auto* table = new KeyTable();  // Не разрушается: ключи нужны до выхода
+        return *table;
+    }
+
+    const std::string& text(std::uint32_t id) const {
+        return blocks_[id >> BLOCK_BITS].load(std::memory_order_acquire)[id & (BLOCK_SIZE - 1)];
+    }
+
+    std::optional<std::uint32_t> find(std::string_view text) {
+        std::size_t hash = std::hash<std::string_view>{}(text);
+        auto& cached = recent_[hash % recent_.size()];
+        if (cached != 0 && this->text(cached - 1) == text) {
+            return cached - 1;
+        }
+        std::shared_lock lock(mutex_);
+        auto it = ids_.find(text);
+        if (it == ids_.end()) {
+            return std::nullopt;
+        }
+        cached = it->second + 1;
+        return it->second;
+    }
+
+    /// nullopt — таблица заполнена, строка не интернирована
+    std::optional<std::uint32_t> intern(std::string_view text) {
+        if (auto id = find(text)) {
+            return id;
+        }
+        std::unique_lock lock(mutex_);
+        auto it = ids_.find(text);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        if (size_ == ValueKey::MAX_INTERNED) {
+            return std::nullopt;
+        }
+        auto id = static_cast<std::uint32_t>(size_++);
+        auto& block = blocks_[id >> BLOCK_BITS];
+        std::string* strings = block.load(std::memory_order_relaxed);
+        if (strings == nullptr) {
+            strings = new std::string[BLOCK_SIZE];
+        }
+        strings[id & (BLOCK_SIZE - 1)] = std::string(text);
+        block.store(strings, std::memory_order_release);
+        ids_.emplace(strings[id & (BLOCK_SIZE - 1)], id);
+        return id;
+    }
+
+private:
+    KeyTable() { intern({}); }  // Номер 0 — пустой ключ (ValueKey по умолчанию)
+
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string_view, std::uint32_t> ids_;
+    std::size_t size_ = 0;
+    std::array<std::atomic<std::string*>, MAX_BLOCKS> blocks_{};
+
+    /// Недавние ключи потока (номер + 1; 0 — пусто): поиск без блокировки
+    static thread_local std::array<std::uint32_t, 1024> recent_;
+};
+
+thread_local std::array<std::uint32_t, 1024> KeyTable::recent_{};
+
+}  // namespace
+
+ValueKey::ValueKey(std::string_view text) {
+    if (auto id = KeyTable::instance().intern(text)) {
+        bits_ = (std::uintptr_t{*id} << 1) | 1;
+    } else {
+        bits_ = own(text);
+    }
+}
+
+std::optional<ValueKey> ValueKey::find(std::string_view text) {
+    auto id = KeyTable::instance().find(text);
+    if (!id) {
+        return std::nullopt;
+    }
+    return ValueKey(Id{*id});
+}
+
+const std::string& ValueKey::str() const {
+    return interned() ? KeyTable::instance().text(id()) : owned();
+}
+
+// ----------------------------------------------------------------------------
+// ValueObject
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// Порядок обхода объекта из entries
+///
+/// Порядок — тот, что даёт std::unordered_map<std::string, Value> после вставки
+/// ключей в том же порядке: std::hash<std::string_view> совпадает с
+/// std::hash<std::string>, поэтому повтор вставок в unordered_map по string_view
+/// воспроизводит его раскладку по корзинам.
+std::vector<std::uint32_t> replay_order(const ValueObject::Entry* entries, std::size_t size) {
+    std::unordered_map<std::string_view, std::uint32_t> replay;
+    for (std::size_t i = 0; i < size; ++i) {
+        replay.emplace(entries[i].key.str(), static_cast<std::uint32_t>(i));
+    }
+    std::vector<std::uint32_t> order;
+    order.reserve(size);
+    for (const auto& [key, index] : replay) {
+        order.push_back(index);
+    }
+    return order;
+}
+
+/// Порядки обхода по форме объекта (последовательности номеров ключей)
+///
+/// Формы повторяются (шаблоны записей), так что порядок вычисляется один раз на
+/// форму. Формы из данных (ключи-GUID, пути) не повторяются: кеш ограничен
+/// ORDER_CACHE_BYTES, и порядок формы, которая в него не попала, хранит объект.
+class OrderCache {
+public:
+    static OrderCache& instance() {
+        static auto* cache = new OrderCache();
+        return *cache;
+    }
+
+    /// Порядок из кеша; nullptr — форма не кешируется, порядок — в computed
+    const std::uint32_t* order(const ValueObject::Entry* entries, std::size_t size,
+                               std::vector<std::uint32_t>& computed) {
+        std::string shape(size * sizeof(std::uint32_t), '\0');
+        for (std::size_t i = 0; i < size; ++i) {
+            if (!entries[i].key.interned()) {
+                computed = replay_order(entries, size);
+                return nullptr;
+            }
+            std::uint32_t id = entries[i].key.id();
+            std::memcpy(shape.data() + i * sizeof(id), &id, sizeof(id));
+        }
+        {
+            std::shared_lock lock(mutex_);
+            auto it = orders_.find(shape);
+            if (it != orders_.end()) {
+                return it->second.data();
+            }
+        }
+
+        computed = replay_order(entries, size);
+        std::size_t cost = shape.size() + computed.size() * sizeof(std::uint32_t) + ENTRY_BYTES;
+        std::unique_lock lock(mutex_);
+        auto it = orders_.find(shape);
+        if (it != orders_.end()) {
+            return it->second.data();
+        }
+        if (bytes_ + cost > ValueObject::ORDER_CACHE_BYTES) {
+            return nullptr;
+        }
+        bytes_ += cost;
+        return orders_.try_emplace(std::move(shape), std::move(computed)).first->second.data();
+    }
+
+    std::size_t bytes() {
+        std::shared_lock lock(mutex_);
+        return bytes_;
+    }
+
+private:
+    /// Оценка накладных расходов на форму (узел таблицы, заголовки строк и векторов)
+    static constexpr std::size_t ENTRY_BYTES = 96;
+
+    OrderCache() = default;
+
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> orders_;
+    std::size_t bytes_ = 0;
+};
+
+}  // namespace
+
+ValueObject::ValueObject(std::initializer_list<std::pair<const std::string, Value>> init) {
+    entries_.reserve(init.size());
+    for (const auto& [key, value] : init) {
+        ValueKey id(key);
+        if (!lookup(id)) {
+            (*this)[id] = value;
+        }
+    }
+}
+
+ValueObject::ValueObject(const ValueObject& other)
+    : entries_(other.entries_), order_(other.shared_order()) {
+    if (other.index_) {
+        index_ = std::make_unique<Index>(*other.index_);
+    }
+}
+
+ValueObject::ValueObject(const ValueObject& other, const allocator_type& alloc)
+    : entries_(other.entries_, alloc), order_(other.shared_order()) {
+    if (other.index_) {
+        index_ = std::make_unique<Index>(*other.index_);
+    }
+}
+
+ValueObject::ValueObject(ValueObject&& other) noexcept
+    : entries_(std::move(other.entries_)),
+      index_(std::move(other.index_)),
+      order_(other.order_.load(std::memory_order_acquire)),
+      own_order_(other.own_order_.exchange(nullptr, std::memory_order_acq_rel)) {
+    other.clear();
+}
+
+ValueObject& ValueObject::operator=(const ValueObject& other) {
+    if (this != &other) {
+        entries_ = other.entries_;
+        index_ = other.index_ ? std::make_unique<Index>(*other.index_) : nullptr;
+        reset_order();
+        order_.store(other.shared_order(), std::memory_order_release);
+    }
+    return *this;
+}
+
+ValueObject& ValueObject::operator=(ValueObject&& other) noexcept {
+    if (this != &other) {
+        entries_ = std::move(other.entries_);
+        index_ = std::move(other.index_);
+        reset_order();
+        order_.store(other.order_.load(std::memory_order_acquire), std::memory_order_release);
+        own_order_.store(other.own_order_.exchange(nullptr, std::memory_order_acq_rel),
+                         std::memory_order_release);
+        other.clear();
+    }
+    return *this;
+}
+
+ValueObject::~ValueObject() {
+    delete[] own_order_.load(std::memory_order_acquire);
+}
+
+void ValueObject::clear() {
+    entries_.clear();
+    index_.reset();
+    reset_order();
+}
+
+void ValueObject::reset_order() {
+    order_.store(nullptr, std::memory_order_relaxed);
+    delete[] own_order_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+Value& ValueObject::operator[](const ValueKey& key) {
+    auto pos = position(key);
+    if (pos < entries_.size()) {
+        return entries_[pos].value;
+    }
+    reset_order();
+    entries_.emplace_back(key);
+    if (index_) {
+        if (key.interned()) {
+            index_->emplace(key.id(), static_cast<std::uint32_t>(pos));
+        }
+    } else if (entries_.size() > INDEX_THRESHOLD) {
+        build_index();
+    }
+    return entries_.back().value;
+}
+
+ValueObject::size_type ValueObject::position(std::string_view key) const {
+    if (auto id = ValueKey::find(key)) {
+        return position(*id);
+    }
+    // Ключ вне таблицы ключей хранит текст сам
+    size_type pos = 0;
+    while (pos < entries_.size() &&
+           (entries_[pos].key.interned() || entries_[pos].key.str() != key)) {
+        ++pos;
+    }
+    return pos;
+}
+
+const Value* ValueObject::lookup(std::string_view key) const {
+    auto pos = position(key);
+    return pos < entries_.size() ? &entries_[pos].value : nullptr;
+}
+
+void ValueObject::build_index() {
+    index_ = std::make_unique<Index>();
+    index_->reserve(entries_.size());
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].key.interned()) {
+            index_->emplace(entries_[i].key.id(), static_cast<std::uint32_t>(i));
+        }
+    }
+}
+
+const std::uint32_t* ValueObject::order() const {
+    if (entries_.size() < 2) {
+        return nullptr;
+    }
+    const auto* order = order_.load(std::memory_order_acquire);
+    if (order == nullptr) {
+        std::vector<std::uint32_t> computed;
+        order = OrderCache::instance().order(entries_.data(), entries_.size(), computed);
+        if (order == nullptr) {
+            // Форма не в общем кеше: порядок хранит объект (поток, опоздавший
+            // при одновременном обходе, берёт уже сохранённый)
+            auto* own = new std::uint32_t[computed.size()];
+            std::copy(computed.begin(), computed.end(), own);
+            std::uint32_t* stored = nullptr;
+            if (!own_order_.compare_exchange_strong(stored, own, std::memory_order_acq_rel)) {
+                delete[] own;
+                own = stored;
+            }
+            order = own;
+        }
+        order_.store(order, std::memory_order_release);
+    }
+    return order;
+}
+
+const std::uint32_t* ValueObject::shared_order() const {
+    const auto* order = order_.load(std::memory_order_acquire);
+    return order == own_order_.load(std::memory_order_acquire) ? nullptr : order;
+}
+
+ValueObject::size_type ValueObject::order_cache_bytes() {
+    return OrderCache::instance().bytes();
+}
+
+ValueObject::size_type ValueObject::order_position(size_type index) const {
+    const auto* order = this->order();
+    if (order == nullptr || index >= entries_.size()) {
+        return index;
+    }
+    return static_cast<size_type>(std::find(order, order + entries_.size(), index) - order);
+}
+
+ValueObject::iterator ValueObject::find(std::string_view key) {
+    return {entries_.data(), order(), order_position(position(key))};
+}
+
+ValueObject::const_iterator ValueObject::find(std::string_view key) const {
+    return {entries_.data(), order(), order_position(position(key))};
+}
+
+ValueObject::iterator ValueObject::begin() {
+    return {entries_.data(), order(), 0};
+}
+
+ValueObject::iterator ValueObject::end() {
+    return {entries_.data(), nullptr, entries_.size()};
+}
+
+ValueObject::const_iterator ValueObject::begin() const {
+    return {entries_.data(), order(), 0};
+}
+
+ValueObject::const_iterator ValueObject::end() const {
+    return {entries_.data(), nullptr, entries_.size()};
+}
+
+// ----------------------------------------------------------------------------
+// Value::owned - перенос из арены в кучу
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// В поддереве есть контейнер из арены
+bool uses_arena(const Value& value) {
+    if (const auto* arr = value.get_array()) {
+        if (!arr->get_allocator().on_heap()) {
+            return true;
+        }
+        for (const auto& item : *arr) {
+            if (uses_arena(item)) {
+                return true;
+            }
+        }
+    } else if (const auto* obj = value.get_object()) {
+        if (!obj->get_allocator().on_heap()) {
+            return true;
+        }
+        for (const auto& [key, item] : *obj) {
+            if (uses_arena(item)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+Value Value::owned() const {
+    if (!uses_arena(*this)) {
+        return *this;
+    }
+    auto* heap = std::pmr::new_delete_resource();
+    if (const auto* arr = get_array()) {
+        Array copy(*arr, ValueAllocator<Value>(heap));
+        for (auto& item : copy) {
+            item = item.owned();
+        }
+        return Value(std::move(copy));
+    }
+    // Копия сохраняет порядок вставки, а значит и порядок обхода оригинала
+    Object copy(as_object(), Object::allocator_type(heap));
+    for (auto&& [key, item] : copy) {
+        item = item.owned();
+    }
+    return Value(std::move(copy));
+}
+
+// ----------------------------------------------------------------------------
+// ValueArena
+// ----------------------------------------------------------------------------
+
+void ValueArena::reset() {
+    large_.clear();
+    block_ = 0;
+    ptr_ = blocks_.empty() ? nullptr : blocks_.front().get();
+    end_ = blocks_.empty() ? nullptr : ptr_ + block_size_;
+    used_ = 0;
+}
+
+void* ValueArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr_);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (ptr_ != nullptr && bytes + padding <= static_cast<std::size_t>(end_ - ptr_)) {
+        std::byte* result = ptr_ + padding;
+        ptr_ = result + bytes;
+        used_ += bytes + padding;
+        return result;
+    }
+    return allocate_slow(bytes, alignment);
+}
+
+void* ValueArena::allocate_slow(std::size_t bytes, std::size_t alignment) {
+    used_ += bytes;
+    // Блоки из operator new[] выровнены на __STDCPP_DEFAULT_NEW_ALIGNMENT__
+    std::size_t extra = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? alignment : 0;
+    if (bytes + extra > block_size_ / 4) {
+        auto& large = large_.emplace_back(new std::byte[bytes + extra]);
+        void* result = large.get();
+        std::size_t space = bytes + extra;
+        return std::align(alignment, bytes, result, space);
+    }
+    if (ptr_ != nullptr) {
+        ++block_;
+    }
+    if (block_ == blocks_.size()) {
+        blocks_.emplace_back(new std::byte[block_size_]);
+    }
+    void* result = blocks_[block_].get();
+    std::size_t space = block_size_;
+    result = std::align(alignment, bytes, result, space);
+    ptr_ = static_cast<std::byte*>(result) + bytes;
+    end_ = blocks_[block_].get() + block_size_;
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// FieldProjection
+// ----------------------------------------------------------------------------
+
+FieldProjection::FieldProjection(const std::vector<std::string>& paths) : all_(false) {
+    for (const auto& path : paths) {
+        include(path);
+    }
+}
+
+void FieldProjection::include(std::string_view path) {
+    if (all_) {
+        return;
+    }
+    if (path.empty()) {
+        // Путь закончился на этом узле — нужно всё поддерево
+        all_ = true;
+        children_.clear();
+        return;
+    }
+
+    auto dot = path.find('.');
+    std::string_view key = path.substr(0, dot);
+    std::string_view rest =
+        dot == std::string_view::npos ? std::string_view{} : path.substr(dot + 1);
+
+    auto it = children_.find(key);
+    if (it == children_.end()) {
+        auto node = std::make_unique<FieldProjection>();
+        node->all_ = false;
+        it = children_.emplace(std::string(key), std::move(node)).first;
+    }
+    it->second->include(rest);
+}
+
+const FieldProjection& FieldProjection::child(std::string_view key) const {
+    static const FieldProjection none(std::vector<std::string>{});
+    if (all_) {
+        return *this;
+    }
+    auto it = children_.find(key);
+    return it != children_.end() ? *it->second : none;
+}
+
 }  // namespace chainsaw
@@ -10,8 +10,14 @@
 
 #include "chainsaw/platform.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <random>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #ifdef _WIN32
@@ -20,6 +26,9 @@
 #include <windows.h>
 #else
 #include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -180,6 +189,193 @@ std::filesystem::path make_temp_file(std::string_view prefix) {
 #endif
 }
 
+// ----------------------------------------------------------------------------
+// Отображение файлов в память
+// ----------------------------------------------------------------------------
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);  // Отображение удерживает view
+    if (view == nullptr) {
+        return false;
+    }
+    data_ = static_cast<const std::uint8_t*>(view);
+    size_ = static_cast<std::size_t>(file_size.QuadPart);
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    // Чтение в основном последовательное (чанки/записи по порядку)
+    madvise(view, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const std::uint8_t*>(view);
+    size_ = size;
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+    if (data_ == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(const_cast<std::uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Пул потоков
+// ----------------------------------------------------------------------------
+
+struct TaskPool::State {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    std::function<void(std::size_t)> task;
+    std::size_t window = 0;
+    std::vector<Queue> queues;
+
+    std::mutex gate_mutex;
+    std::condition_variable gate;
+    std::size_t released = 0;
+    std::atomic<bool> cancelled{false};
+
+    std::vector<std::thread> threads;
+
+    /// Своя задача, иначе чужая — всегда с начала очереди (наименьший номер):
+    /// задача с конца ещё далеко за окном, и вор ждал бы в admit(), пока
+    /// очередь-жертва стоит. Задачи не добавляются, поэтому пустые очереди
+    /// означают конец работы
+    bool pop(std::size_t self, std::size_t& index) {
+        for (std::size_t k = 0; k < queues.size(); ++k) {
+            Queue& queue = queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            index = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    /// Дождаться, пока задача войдёт в окно; false — пул отменён
+    bool admit(std::size_t index) {
+        if (window == 0) {
+            return !cancelled.load();
+        }
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        gate.wait(lock, [&] { return cancelled.load() || index < released + window; });
+        return !cancelled.load();
+    }
+
+    void run(std::size_t self) {
+        std::size_t index = 0;
+        while (!cancelled.load() && pop(self, index)) {
+            if (!admit(index)) {
+                return;
+            }
+            task(index);
+        }
+    }
+};
+
+TaskPool::TaskPool(std::size_t count, std::size_t threads, std::size_t window,
+                   std::function<void(std::size_t)> task)
+    : state_(std::make_unique<State>()) {
+    threads = std::max<std::size_t>(1, std::min(threads, std::max<std::size_t>(1, count)));
+    state_->task = std::move(task);
+    state_->window = window;
+    state_->queues = std::vector<State::Queue>(threads);
+    for (std::size_t i = 0; i < count; ++i) {
+        state_->queues[i % threads].tasks.push_back(i);
+    }
+
+    state_->threads.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        state_->threads.emplace_back([state = state_.get(), i] { state->run(i); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    cancel();
+    for (auto& thread : state_->threads) {
+        thread.join();
+    }
+}
+
+void TaskPool::release(std::size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(state_->gate_mutex);
+        state_->released = std::max(state_->released, index + 1);
+    }
+    state_->gate.notify_all();
+}
+
+void TaskPool::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(state_->gate_mutex);
+        state_->cancelled.store(true);
+    }
+    state_->gate.notify_all();
+}
+
 // ----------------------------------------------------------------------------
 // Информация о платформе
 // ----------------------------------------------------------------------------
@@ -416,28 +416,31 @@ tau::Expression parse_yaml_identifier_value(const YAML::Node& value, const std::
         if (starts_wild && ends_wild) {
             // Contains
             if (ignore_case) {
-                search = tau::SearchAhoCorasick{{{tau::MatchType::Contains, pattern_str}}, true};
+                search =
+                    tau::SearchAhoCorasick{{{tau::MatchType::Contains, pattern_str}}, true, {}};
             } else {
                 search = tau::SearchContains{pattern_str};
             }
         } else if (starts_wild) {
             // EndsWith
             if (ignore_case) {
-                search = tau::SearchAhoCorasick{{{tau::MatchType::EndsWith, pattern_str}}, true};
+                search =
+                    tau::SearchAhoCorasick{{{tau::MatchType::EndsWith, pattern_str}}, true, {}};
             } else {
                 search = tau::SearchEndsWith{pattern_str};
             }
         } else if (ends_wild) {
             // StartsWith
             if (ignore_case) {
-                search = tau::SearchAhoCorasick{{{tau::MatchType::StartsWith, pattern_str}}, true};
+                search =
+                    tau::SearchAhoCorasick{{{tau::MatchType::StartsWith, pattern_str}}, true, {}};
             } else {
                 search = tau::SearchStartsWith{pattern_str};
             }
         } else {
             // Exact match
             if (ignore_case) {
-                search = tau::SearchAhoCorasick{{{tau::MatchType::Exact, pattern_str}}, true};
+                search = tau::SearchAhoCorasick{{{tau::MatchType::Exact, pattern_str}}, true, {}};
             } else {
                 search = tau::SearchExact{pattern_str};
             }
@@ -824,6 +827,29 @@ bool rule_solve(const Rule& r, const tau::Document& doc) {
         r);
 }
 
+tau::Program rule_program(const Rule& r) {
+    return rule_program(r, nullptr);
+}
+
+tau::Program rule_program(const Rule& r, const std::shared_ptr<tau::Predicates>& shared) {
+    return std::visit(
+        [&shared](const auto& rule) -> tau::Program {
+            using T = std::decay_t<decltype(rule)>;
+
+            if constexpr (std::is_same_v<T, ChainsawRule>) {
+                return std::visit(
+                    [&shared](const auto& filter) -> tau::Program {
+                        return tau::compile_program(filter, shared);
+                    },
+                    rule.filter);
+            } else {
+                static_assert(std::is_same_v<T, SigmaRule>, "Unhandled rule type");
+                return tau::compile_program(rule.detection, shared);
+            }
+        },
+        r);
+}
+
 Status rule_status(const Rule& r) {
     return std::visit([](const auto& rule) -> Status { return rule.status; }, r);
 }
@@ -921,6 +947,7 @@ LoadResult load(Kind kind, const std::filesystem::path& path, const LoadOptions&
                         agg.count = tau::PatternEqual{1};
                     }
                     agg.fields = data.aggregate->fields;
+                    agg.timeframe = data.aggregate->timeframe;
                     rule.aggregate = agg;
                 }
 
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chainsaw/regex.hpp>
 #include <chainsaw/rule.hpp>
 #include <chainsaw/sigma.hpp>
 #include <fstream>
@@ -188,10 +189,9 @@ std::optional<std::string> as_regex(const std::string& value, bool convert) {
     } else {
         // Проверяем валидность regex
         try {
-            std::regex re(value);
-            (void)re;  // Suppress unused variable warning
+            tau::compile_regex(value);
             return "?" + value;
-        } catch (const std::regex_error&) {
+        } catch (const tau::RegexError&) {
             return std::nullopt;
         }
     }
@@ -235,6 +235,40 @@ bool is_condition_unsupported(const std::string& condition) {
            condition.find(" sum ") != std::string::npos;
 }
 
+// ============================================================================
+// Timeframe
+// ============================================================================
+
+std::optional<std::chrono::seconds> parse_timeframe(std::string_view value) {
+    if (value.size() < 2) {
+        return std::nullopt;
+    }
+
+    std::int64_t amount = 0;
+    for (char c : value.substr(0, value.size() - 1)) {
+        if (!std::isdigit(static_cast<unsigned char>(c)) || amount > 1'000'000'000) {
+            return std::nullopt;
+        }
+        amount = amount * 10 + (c - '0');
+    }
+    if (amount == 0) {
+        return std::nullopt;
+    }
+
+    switch (value.back()) {
+    case 's':
+        return std::chrono::seconds(amount);
+    case 'm':
+        return std::chrono::minutes(amount);
+    case 'h':
+        return std::chrono::hours(amount);
+    case 'd':
+        return std::chrono::hours(24 * amount);
+    default:
+        return std::nullopt;
+    }
+}
+
 // ============================================================================
 // Internal parsing helpers
 // ============================================================================
@@ -522,6 +556,19 @@ Result<std::pair<Detection, std::optional<SigmaAggregate>>> prepare(
             }
         }
 
+        // SPEC-SLICE-010 FACT-015: timeframe ограничивает агрегацию окном времени
+        const YAML::Node& merged = identifiers;
+        if (aggregate && merged["timeframe"]) {
+            auto timeframe = merged["timeframe"].IsScalar()
+                                 ? parse_timeframe(merged["timeframe"].Scalar())
+                                 : std::nullopt;
+            if (!timeframe) {
+                return Result<std::pair<Detection, std::optional<SigmaAggregate>>>::failure(
+                    "invalid timeframe");
+            }
+            aggregate->timeframe = timeframe;
+        }
+
         Detection result;
         result.condition = YAML::Node(condition_str);
         result.identifiers = identifiers;
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chainsaw/evtx.hpp>
 #include <chainsaw/platform.hpp>
 #include <chainsaw/search.hpp>
 #include <cstring>
@@ -176,6 +177,26 @@ std::string DateTime::to_string() const {
     return buf;
 }
 
+std::uint64_t DateTime::to_filetime() const {
+    // Дни от 1970-01-01 по григорианскому календарю (days_from_civil)
+    std::int64_t y = month <= 2 ? year - 1 : year;
+    std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    std::int64_t yoe = y - era * 400;
+    std::int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    std::int64_t days = era * 146097 + doe - 719468;
+
+    // 1601-01-01 — за 134774 дня до 1970-01-01
+    constexpr std::int64_t FILETIME_EPOCH_DAYS = 134774;
+    std::int64_t seconds =
+        (days + FILETIME_EPOCH_DAYS) * 86400 + hour * 3600 + minute * 60 + second;
+    if (seconds < 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(seconds) * 10000000u +
+           static_cast<std::uint64_t>(microsecond) * 10u;
+}
+
 // ============================================================================
 // JSON serialization helper
 // ============================================================================
@@ -226,7 +247,7 @@ std::string normalize_json_for_search(const Value& value) {
     return result;
 }
 
-bool value_matches_patterns(const Value& value, const std::vector<std::regex>& patterns,
+bool value_matches_patterns(const Value& value, const std::vector<tau::RegexPtr>& patterns,
                             bool match_any) {
     if (patterns.empty()) {
         return true;  // Нет паттернов = всё совпадает
@@ -237,7 +258,7 @@ bool value_matches_patterns(const Value& value, const std::vector<std::regex>& p
     if (match_any) {
         // OR семантика: любой паттерн совпал = true
         for (const auto& pattern : patterns) {
-            if (std::regex_search(json, pattern)) {
+            if (pattern->search(json)) {
                 return true;
             }
         }
@@ -245,7 +266,7 @@ bool value_matches_patterns(const Value& value, const std::vector<std::regex>& p
     } else {
         // AND семантика: все паттерны должны совпасть
         for (const auto& pattern : patterns) {
-            if (!std::regex_search(json, pattern)) {
+            if (!pattern->search(json)) {
                 return false;
             }
         }
@@ -275,7 +296,7 @@ std::optional<DateTime> extract_timestamp(const Value& value, std::string_view f
             return std::nullopt;
         }
 
-        const Value* next = current->get(std::string(part));
+        const Value* next = current->get(part);
         if (!next) {
             return std::nullopt;
         }
@@ -343,6 +364,11 @@ SearcherBuilder& SearcherBuilder::skip_errors(bool skip) {
     return *this;
 }
 
+SearcherBuilder& SearcherBuilder::num_threads(std::size_t threads) {
+    num_threads_ = threads;
+    return *this;
+}
+
 SearcherBuilder::BuildResult SearcherBuilder::build() {
     BuildResult result;
     result.ok = false;
@@ -353,12 +379,8 @@ SearcherBuilder::BuildResult SearcherBuilder::build() {
     // SPEC-SLICE-011 FACT-002: case-insensitive через (?i) prefix
     for (const auto& pattern : patterns_) {
         try {
-            std::regex::flag_type flags = std::regex::ECMAScript;
-            if (ignore_case_) {
-                flags |= std::regex::icase;
-            }
-            searcher->regex_patterns_.emplace_back(pattern, flags);
-        } catch (const std::regex_error& e) {
+            searcher->regex_patterns_.push_back(tau::compile_regex(pattern, ignore_case_));
+        } catch (const tau::RegexError& e) {
             result.error = std::string("invalid regex pattern '") + pattern + "': " + e.what();
             return result;
         }
@@ -399,6 +421,7 @@ SearcherBuilder::BuildResult SearcherBuilder::build() {
     searcher->match_any_ = match_any_;
     searcher->load_unknown_ = load_unknown_;
     searcher->skip_errors_ = skip_errors_;
+    searcher->num_threads_ = num_threads_;
 
     result.ok = true;
     result.searcher = std::move(searcher);
@@ -409,11 +432,21 @@ SearcherBuilder::BuildResult SearcherBuilder::build() {
 // Searcher implementation
 // ============================================================================
 
-std::vector<SearchResult> Searcher::search(const std::filesystem::path& path) const {
+std::vector<SearchResult> Searcher::search(const std::filesystem::path& path,
+                                           std::size_t threads) const {
     std::vector<SearchResult> results;
 
     // Открываем файл через Reader
-    auto reader_result = io::Reader::open(path, load_unknown_, skip_errors_);
+    io::ReaderOptions reader_options;
+    reader_options.load_unknown = load_unknown_;
+    reader_options.skip_errors = skip_errors_;
+    reader_options.evtx_threads = threads != 0 ? threads : num_threads_;
+    reader_options.value_arena = true;
+
+    if (skips_evtx_by_written_time()) {
+        reader_options.evtx_written_after = evtx::written_after_bound(from_->to_filetime());
+    }
+    auto reader_result = io::Reader::open(path, reader_options);
     if (!reader_result) {
         // Ошибка открытия - если skip_errors, молча пропускаем
         return results;
@@ -424,7 +457,7 @@ std::vector<SearchResult> Searcher::search(const std::filesystem::path& path) co
     while (reader_result.reader->next(doc)) {
         if (matches(doc)) {
             SearchResult hit;
-            hit.data = std::move(doc.data);
+            hit.data = doc.data.owned();
             hit.source = std::move(doc.source);
             hit.record_id = doc.record_id;
             hit.timestamp = doc.timestamp;
@@ -468,6 +501,12 @@ bool Searcher::matches(const io::Document& doc) const {
     return true;
 }
 
+bool Searcher::skips_evtx_by_written_time() const {
+    // --from по System/TimeCreated: запись EVTX, записанная в журнал раньше from с
+    // запасом на расхождение часов, не прошла бы фильтр времени — её можно не декодировать
+    return from_ && timestamp_ && evtx::is_time_created_field(*timestamp_);
+}
+
 bool Searcher::matches_patterns(const Value& value) const {
     return value_matches_patterns(value, regex_patterns_, match_any_);
 }
@@ -0,0 +1,228 @@
+// ==============================================================================
+// aho_corasick.cpp - Автомат Ахо-Корасик для SearchAhoCorasick
+// ==============================================================================
+//
+// MOD-0009 tau (Tau Engine)
+//
+// Построение: бор по паттернам (после case folding), затем обход в ширину
+// достраивает переходы по суффиксным ссылкам до полного ДКА. Записи одного
+// состояния хранятся плоским массивом; записи суффиксов достижимы по dict_.
+//
+// ==============================================================================
+
+#include <cctype>
+#include <chainsaw/aho_corasick.hpp>
+#include <limits>
+
+namespace chainsaw::tau {
+
+namespace {
+
+constexpr std::uint32_t NO_STATE = std::numeric_limits<std::uint32_t>::max();
+
+}  // namespace
+
+AhoCorasick::AhoCorasick(const std::vector<MatchTypeEntry>& entries, bool ignore_case) {
+    auto fold = [ignore_case](unsigned char c) -> unsigned char {
+        return ignore_case ? static_cast<unsigned char>(std::tolower(c)) : c;
+    };
+
+    // Классы байтов: у каждого байта паттернов свой класс, остальные — класс 0
+    std::array<std::uint16_t, 256> folded_class{};
+    for (const auto& entry : entries) {
+        for (char c : entry.value) {
+            folded_class[fold(static_cast<unsigned char>(c))] = 1;
+        }
+    }
+    std::uint16_t next_class = 1;
+    for (auto& cls : folded_class) {
+        if (cls != 0) {
+            cls = next_class++;
+        }
+    }
+    classes_count_ = next_class;
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+        classes_[byte] = folded_class[fold(static_cast<unsigned char>(byte))];
+    }
+
+    // Бор
+    std::vector<std::vector<std::uint32_t>> own(1);
+    delta_.assign(classes_count_, NO_STATE);
+    depth_.assign(1, 0);
+    types_.reserve(entries.size());
+
+    for (const auto& entry : entries) {
+        auto id = static_cast<std::uint32_t>(types_.size());
+        types_.push_back(entry.type);
+        if (entry.type == MatchType::Contains || entry.type == MatchType::EndsWith) {
+            anchored_only_ = false;
+        }
+
+        if (entry.value.empty()) {
+            empty_.push_back(id);
+            if (entry.type == MatchType::Exact) {
+                empty_exact_ = true;
+            } else {
+                always_ = true;
+            }
+            continue;
+        }
+
+        std::uint32_t state = 0;
+        for (char c : entry.value) {
+            std::size_t slot = state * classes_count_ + classes_[static_cast<unsigned char>(c)];
+            if (delta_[slot] == NO_STATE) {
+                auto created = static_cast<std::uint32_t>(depth_.size());
+                delta_[slot] = created;
+                delta_.resize(delta_.size() + classes_count_, NO_STATE);
+                depth_.push_back(depth_[state] + 1);
+                own.emplace_back();
+            }
+            state = delta_[slot];
+        }
+        own[state].push_back(id);
+    }
+
+    // Флаги собственных записей
+    std::size_t count = depth_.size();
+    flags_.assign(count, 0);
+    for (std::size_t state = 0; state < count; ++state) {
+        for (std::uint32_t id : own[state]) {
+            switch (types_[id]) {
+            case MatchType::Contains:
+                flags_[state] |= CONTAINS;
+                break;
+            case MatchType::EndsWith:
+                flags_[state] |= ENDS_WITH;
+                break;
+            case MatchType::Exact:
+                flags_[state] |= EXACT;
+                break;
+            case MatchType::StartsWith:
+                flags_[state] |= STARTS_WITH;
+                break;
+            }
+        }
+    }
+
+    // Суффиксные ссылки и полный ДКА (обход в ширину: ссылка ведёт на меньшую глубину)
+    std::vector<std::uint32_t> fail(count, 0);
+    dict_.assign(count, 0);
+    std::vector<std::uint32_t> queue;
+    queue.reserve(count);
+    for (std::size_t cls = 0; cls < classes_count_; ++cls) {
+        std::uint32_t& target = delta_[cls];
+        if (target == NO_STATE) {
+            target = 0;
+        } else {
+            queue.push_back(target);
+        }
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        std::uint32_t state = queue[head];
+        std::uint32_t link = fail[state];
+        dict_[state] = own[link].empty() ? dict_[link] : link;
+        flags_[state] |= static_cast<std::uint8_t>(flags_[link] & (CONTAINS | ENDS_WITH));
+
+        for (std::size_t cls = 0; cls < classes_count_; ++cls) {
+            std::uint32_t& target = delta_[state * classes_count_ + cls];
+            std::uint32_t fallback = delta_[link * classes_count_ + cls];
+            if (target == NO_STATE) {
+                target = fallback;
+            } else {
+                fail[target] = fallback;
+                queue.push_back(target);
+            }
+        }
+    }
+
+    output_begin_.reserve(count + 1);
+    for (const auto& ids : own) {
+        output_begin_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+        outputs_.insert(outputs_.end(), ids.begin(), ids.end());
+    }
+    output_begin_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+}
+
+bool AhoCorasick::find_any(std::string_view text) const {
+    if (always_) {
+        return true;
+    }
+    if (text.empty()) {
+        return empty_exact_;
+    }
+
+    std::uint32_t state = 0;
+    bool anchored = true;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        state = step(state, static_cast<unsigned char>(text[i]));
+        if (anchored && depth_[state] != i + 1) {
+            anchored = false;
+            if (anchored_only_) {
+                return false;
+            }
+        }
+        std::uint8_t flags = flags_[state];
+        if ((flags & CONTAINS) || (anchored && (flags & STARTS_WITH))) {
+            return true;
+        }
+    }
+
+    std::uint8_t flags = flags_[state];
+    return (flags & ENDS_WITH) || (anchored && (flags & EXACT));
+}
+
+void AhoCorasick::find_all(std::string_view text, std::vector<bool>& matched) const {
+    matched.assign(types_.size(), false);
+    for (std::uint32_t id : empty_) {
+        matched[id] = types_[id] != MatchType::Exact || text.empty();
+    }
+
+    std::uint32_t state = 0;
+    bool anchored = true;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        state = step(state, static_cast<unsigned char>(text[i]));
+        if (anchored && depth_[state] != i + 1) {
+            anchored = false;
+        }
+        if (flags_[state] != 0) {
+            mark(state, anchored, i + 1 == text.size(), matched);
+        }
+    }
+}
+
+void AhoCorasick::mark(std::uint32_t state, bool anchored, bool at_end,
+                       std::vector<bool>& matched) const {
+    // Собственные записи: StartsWith и Exact — только при привязке к началу
+    for (std::uint32_t k = output_begin_[state]; k < output_begin_[state + 1]; ++k) {
+        std::uint32_t id = outputs_[k];
+        switch (types_[id]) {
+        case MatchType::Contains:
+            matched[id] = true;
+            break;
+        case MatchType::EndsWith:
+            matched[id] = matched[id] || at_end;
+            break;
+        case MatchType::Exact:
+            matched[id] = matched[id] || (anchored && at_end);
+            break;
+        case MatchType::StartsWith:
+            matched[id] = matched[id] || anchored;
+            break;
+        }
+    }
+
+    // Записи суффиксов короче прочитанного, к началу не привязаны
+    for (std::uint32_t link = dict_[state]; link != 0; link = dict_[link]) {
+        for (std::uint32_t k = output_begin_[link]; k < output_begin_[link + 1]; ++k) {
+            std::uint32_t id = outputs_[k];
+            if (types_[id] == MatchType::Contains) {
+                matched[id] = true;
+            } else if (types_[id] == MatchType::EndsWith) {
+                matched[id] = matched[id] || at_end;
+            }
+        }
+    }
+}
+
+}  // namespace chainsaw::tau
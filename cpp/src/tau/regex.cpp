@@ -0,0 +1,1391 @@
+// ==============================================================================
+// regex.cpp - Регулярные выражения: НКА Томпсона и ленивый ДКА
+// ==============================================================================
+//
+// MOD-0009 tau (общий движок для tau, search, shimcache и sigma)
+//
+// Компиляция: Parser строит дерево (Node), Compiler разворачивает его в
+// программу НКА. Перед программой добавляется цикл по любому байту, поэтому
+// поиск не привязан к началу текста (кроме паттернов, начинающихся с ^).
+//
+// Поиск: состояние ДКА — отсортированное множество инструкций НКА, в которые
+// пришли после прочитанного байта, плюс признаки предыдущего байта для якорей.
+// Замыкание по split/jmp/assert строится при переходе, когда известен
+// следующий байт: от него зависят $, \b и \B.
+//
+// Префильтр: Literals выделяет из дерева подстроки, которые входят в любое
+// совпадение; самая длинная ищется до ДКА.
+//
+// ==============================================================================
+
+#include <algorithm>
+#include <cctype>
+#include <chainsaw/regex.hpp>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHAINSAW_REGEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace chainsaw::tau {
+
+namespace {
+
+using ByteSet = std::array<std::uint64_t, 4>;
+
+/// Предел числа инструкций (защита от {n,m} с большими n, m)
+constexpr std::size_t MAX_INSTS = 1u << 20;
+/// Предел счётчика в {n,m}
+constexpr std::size_t MAX_REPEAT = 1000;
+/// Предел памяти кэша ДКА; при переполнении кэш сбрасывается
+constexpr std::size_t MAX_CACHE_BYTES = 4u << 20;
+/// Число кэшей ДКА на паттерн: потоки hunt по разным файлам ищут параллельно
+constexpr std::size_t CACHE_SLOTS = 8;
+/// Минимальная длина подстроки префильтра (кроме паттерна из одной подстроки)
+constexpr std::size_t MIN_LITERAL = 2;
+/// Предел длины точной строки узла при разворачивании {n}
+constexpr std::size_t MAX_LITERAL = 256;
+
+constexpr std::uint32_t UNKNOWN = 0xFFFFFFFFu;
+constexpr std::uint32_t MATCH = 0xFFFFFFFEu;
+constexpr std::uint32_t DEAD = 0xFFFFFFFDu;
+
+// Признаки состояния ДКА
+constexpr std::uint8_t AT_START = 1;
+constexpr std::uint8_t PREV_WORD = 2;
+constexpr std::uint8_t PREV_LINE = 4;
+
+void set_add(ByteSet& set, unsigned byte) {
+    set[byte >> 6] |= std::uint64_t{1} << (byte & 63);
+}
+
+bool set_has(const ByteSet& set, unsigned byte) {
+    return (set[byte >> 6] >> (byte & 63)) & 1;
+}
+
+void set_range(ByteSet& set, unsigned lo, unsigned hi) {
+    for (unsigned byte = lo; byte <= hi; ++byte) {
+        set_add(set, byte);
+    }
+}
+
+void set_merge(ByteSet& set, const ByteSet& other) {
+    for (std::size_t i = 0; i < set.size(); ++i) {
+        set[i] |= other[i];
+    }
+}
+
+void set_invert(ByteSet& set) {
+    for (auto& word : set) {
+        word = ~word;
+    }
+}
+
+/// Добавить вторую форму регистра для ASCII-букв
+void set_fold(ByteSet& set) {
+    for (unsigned byte = 'A'; byte <= 'Z'; ++byte) {
+        if (set_has(set, byte) || set_has(set, byte + 32)) {
+            set_add(set, byte);
+            set_add(set, byte + 32);
+        }
+    }
+}
+
+bool is_word_byte(unsigned byte) {
+    return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') ||
+           (byte >= '0' && byte <= '9') || byte == '_';
+}
+
+ByteSet digit_set() {
+    ByteSet set{};
+    set_range(set, '0', '9');
+    return set;
+}
+
+ByteSet word_set() {
+    ByteSet set{};
+    for (unsigned byte = 0; byte < 256; ++byte) {
+        if (is_word_byte(byte)) {
+            set_add(set, byte);
+        }
+    }
+    return set;
+}
+
+ByteSet space_set() {
+    ByteSet set{};
+    for (char byte : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+        set_add(set, static_cast<unsigned char>(byte));
+    }
+    return set;
+}
+
+unsigned char fold_byte(unsigned char byte) {
+    return byte >= 'A' && byte <= 'Z' ? static_cast<unsigned char>(byte + 32) : byte;
+}
+
+// ----------------------------------------------------------------------------
+// Поиск подстроки префильтра
+// ----------------------------------------------------------------------------
+//
+// Icase: needle уже в нижнем регистре, байты текста приводятся при сравнении.
+
+template <bool Icase>
+bool equal_at(const char* text, std::string_view needle) {
+    for (std::size_t i = 0; i < needle.size(); ++i) {
+        auto byte = static_cast<unsigned char>(text[i]);
+        if ((Icase ? fold_byte(byte) : byte) != static_cast<unsigned char>(needle[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <bool Icase>
+bool contains_scalar(std::string_view text, std::size_t from, std::string_view needle) {
+    for (std::size_t i = from; i + needle.size() <= text.size(); ++i) {
+        if (equal_at<Icase>(text.data() + i, needle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef CHAINSAW_REGEX_SSE2
+
+/// ASCII A-Z → a-z для 16 байт
+inline __m128i fold_sse2(__m128i v) {
+    const __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+    const __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + 26)));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+/// Кандидаты — позиции, где совпали первый и последний байт needle
+template <bool Icase>
+bool contains_sse2(std::string_view text, std::string_view needle) {
+    const std::size_t last = needle.size() - 1;
+    const __m128i first_byte = _mm_set1_epi8(needle.front());
+    const __m128i last_byte = _mm_set1_epi8(needle.back());
+    std::size_t i = 0;
+    for (; i + last + 16 <= text.size(); i += 16) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + last));
+        if constexpr (Icase) {
+            head = fold_sse2(head);
+            tail = fold_sse2(tail);
+        }
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first_byte), _mm_cmpeq_epi8(tail, last_byte))));
+        while (mask != 0) {
+            auto offset = static_cast<std::size_t>(__builtin_ctz(mask));
+            if (equal_at<Icase>(text.data() + i + offset + 1, needle.substr(1))) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return contains_scalar<Icase>(text, i, needle);
+}
+
+#endif  // CHAINSAW_REGEX_SSE2
+
+template <bool Icase>
+bool contains(std::string_view text, std::string_view needle) {
+    if (needle.size() > text.size()) {
+        return false;
+    }
+#ifdef CHAINSAW_REGEX_SSE2
+    return contains_sse2<Icase>(text, needle);
+#else
+    return contains_scalar<Icase>(text, 0, needle);
+#endif
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+}  // namespace
+
+// ============================================================================
+// Дерево разбора
+// ============================================================================
+
+struct Regex::Node {
+    enum class Kind { Empty, Bytes, Concat, Alternate, Repeat, Assert };
+
+    Kind kind = Kind::Empty;
+    ByteSet set{};                                // Bytes
+    Assertion assertion = Assertion::BeginText;  // Assert
+    std::size_t min = 0;                          // Repeat
+    std::size_t max = 0;                          // Repeat (если не unbounded)
+    bool unbounded = false;                       // Repeat
+    std::vector<Node> children;                   // Concat, Alternate; Repeat — один
+
+    static Node bytes(const ByteSet& set) {
+        Node node;
+        node.kind = Kind::Bytes;
+        node.set = set;
+        return node;
+    }
+
+    static Node assert_at(Assertion assertion) {
+        Node node;
+        node.kind = Kind::Assert;
+        node.assertion = assertion;
+        return node;
+    }
+};
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+class Regex::Parser {
+public:
+    Parser(std::string_view pattern, bool ignore_case)
+        : pattern_(pattern), icase_(ignore_case) {}
+
+    Node parse() {
+        Node node = parse_alternation();
+        if (pos_ < pattern_.size()) {
+            fail("unmatched ')'");
+        }
+        return node;
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw RegexError(message + " at position " + std::to_string(pos_));
+    }
+
+    bool at_end() const { return pos_ >= pattern_.size(); }
+    char peek() const { return pattern_[pos_]; }
+    bool consume(char c) {
+        if (!at_end() && peek() == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    Node parse_alternation() {
+        std::vector<Node> branches;
+        branches.push_back(parse_concat());
+        while (consume('|')) {
+            branches.push_back(parse_concat());
+        }
+        if (branches.size() == 1) {
+            return std::move(branches.front());
+        }
+        Node node;
+        node.kind = Node::Kind::Alternate;
+        node.children = std::move(branches);
+        return node;
+    }
+
+    Node parse_concat() {
+        Node node;
+        node.kind = Node::Kind::Concat;
+        while (!at_end() && peek() != '|' && peek() != ')') {
+            Node atom = parse_atom();
+            parse_quantifier(atom);
+            node.children.push_back(std::move(atom));
+        }
+        if (node.children.size() == 1) {
+            return std::move(node.children.front());
+        }
+        return node;
+    }
+
+    Node parse_atom() {
+        char c = pattern_[pos_++];
+        switch (c) {
+        case '(':
+            return parse_group();
+        case '[':
+            return parse_class();
+        case '.': {
+            ByteSet set{};
+            set_invert(set);
+            if (!dotall_) {
+                set[0] &= ~((std::uint64_t{1} << '\n') | (std::uint64_t{1} << '\r'));
+            }
+            return Node::bytes(set);
+        }
+        case '^':
+            return Node::assert_at(multiline_ ? Assertion::BeginLine : Assertion::BeginText);
+        case '$':
+            return Node::assert_at(multiline_ ? Assertion::EndLine : Assertion::EndText);
+        case '\\':
+            return parse_escape();
+        case '*':
+        case '+':
+        case '?':
+            --pos_;
+            fail("nothing to repeat");
+        case '{':
+            --pos_;
+            fail("unexpected '{'");
+        default:
+            return literal(static_cast<unsigned char>(c));
+        }
+    }
+
+    Node literal(unsigned byte) const {
+        ByteSet set{};
+        set_add(set, byte);
+        if (icase_) {
+            set_fold(set);
+        }
+        return Node::bytes(set);
+    }
+
+    /// Квантификатор после атома (не больше одного, ленивая форма допускается)
+    void parse_quantifier(Node& atom) {
+        if (at_end()) {
+            return;
+        }
+        std::size_t min = 0;
+        std::size_t max = 0;
+        bool unbounded = false;
+        switch (peek()) {
+        case '*':
+            unbounded = true;
+            break;
+        case '+':
+            min = 1;
+            unbounded = true;
+            break;
+        case '?':
+            max = 1;
+            break;
+        case '{':
+            ++pos_;
+            min = parse_count();
+            max = min;
+            if (consume(',')) {
+                if (!at_end() && peek() == '}') {
+                    unbounded = true;
+                } else {
+                    max = parse_count();
+                }
+            }
+            if (!consume('}')) {
+                fail("invalid repetition");
+            }
+            if (!unbounded && max < min) {
+                fail("invalid repetition range");
+            }
+            --pos_;
+            break;
+        default:
+            return;
+        }
+        ++pos_;
+        consume('?');  // ленивая форма: для поиска совпадения не важна
+
+        Node node;
+        node.kind = Node::Kind::Repeat;
+        node.min = min;
+        node.max = max;
+        node.unbounded = unbounded;
+        node.children.push_back(std::move(atom));
+        atom = std::move(node);
+    }
+
+    std::size_t parse_count() {
+        std::size_t value = 0;
+        std::size_t digits = 0;
+        while (!at_end() && peek() >= '0' && peek() <= '9') {
+            value = value * 10 + static_cast<std::size_t>(peek() - '0');
+            if (value > MAX_REPEAT) {
+                fail("repetition count too large");
+            }
+            ++pos_;
+            ++digits;
+        }
+        if (digits == 0) {
+            fail("invalid repetition");
+        }
+        return value;
+    }
+
+    Node parse_group() {
+        bool saved_icase = icase_;
+        bool saved_dotall = dotall_;
+        bool saved_multiline = multiline_;
+
+        if (consume('?')) {
+            if (at_end()) {
+                fail("unterminated group");
+            }
+            char c = peek();
+            if (c == '=' || c == '!' ||
+                (c == '<' && pos_ + 1 < pattern_.size() &&
+                 (pattern_[pos_ + 1] == '=' || pattern_[pos_ + 1] == '!'))) {
+                fail("look-around is not supported");
+            }
+            if (c == ':') {
+                ++pos_;
+            } else if (c == '<' || c == 'P') {
+                // Именованная группа: (?P<name>...) или (?<name>...)
+                if (c == 'P') {
+                    ++pos_;
+                }
+                if (!consume('<')) {
+                    fail("invalid group name");
+                }
+                std::size_t close = pattern_.find('>', pos_);
+                if (close == std::string_view::npos || close == pos_) {
+                    fail("invalid group name");
+                }
+                pos_ = close + 1;
+            } else if (parse_flags()) {
+                // (?flags) — до конца объемлющей группы
+                return Node{};
+            }
+        }
+
+        Node inner = parse_alternation();
+        if (!consume(')')) {
+            fail("missing ')'");
+        }
+        icase_ = saved_icase;
+        dotall_ = saved_dotall;
+        multiline_ = saved_multiline;
+        return inner;
+    }
+
+    /// Флаги после "(?": true — форма (?flags), false — (?flags: уже разобрано до ':'
+    bool parse_flags() {
+        bool negate = false;
+        while (!at_end()) {
+            char c = pattern_[pos_++];
+            switch (c) {
+            case 'i':
+                icase_ = !negate;
+                break;
+            case 's':
+                dotall_ = !negate;
+                break;
+            case 'm':
+                multiline_ = !negate;
+                break;
+            case '-':
+                if (negate) {
+                    fail("invalid flags");
+                }
+                negate = true;
+                break;
+            case ')':
+                return true;
+            case ':':
+                return false;
+            default:
+                --pos_;
+                fail("unsupported group or flag");
+            }
+        }
+        fail("unterminated group");
+    }
+
+    Node parse_escape() {
+        if (at_end()) {
+            fail("trailing backslash");
+        }
+        char c = pattern_[pos_++];
+        switch (c) {
+        case 'b':
+            return Node::assert_at(Assertion::WordBoundary);
+        case 'B':
+            return Node::assert_at(Assertion::NotWordBoundary);
+        case 'u': {
+            unsigned code = parse_hex(4);
+            if (code < 0x80) {
+                return literal(code);
+            }
+            // Кодовая точка BMP → последовательность байтов UTF-8
+            std::string utf8;
+            if (code < 0x800) {
+                utf8 += static_cast<char>(0xC0 | (code >> 6));
+            } else {
+                utf8 += static_cast<char>(0xE0 | (code >> 12));
+                utf8 += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            }
+            utf8 += static_cast<char>(0x80 | (code & 0x3F));
+            Node node;
+            node.kind = Node::Kind::Concat;
+            for (char byte : utf8) {
+                node.children.push_back(literal(static_cast<unsigned char>(byte)));
+            }
+            return node;
+        }
+        default:
+            break;
+        }
+        if (c >= '1' && c <= '9') {
+            fail("backreferences are not supported");
+        }
+        if (c == 'k') {
+            fail("backreferences are not supported");
+        }
+        ByteSet set{};
+        if (class_escape(c, set)) {
+            return Node::bytes(set);
+        }
+        return literal(escaped_byte(c));
+    }
+
+    /// \d \D \w \W \s \S
+    static bool class_escape(char c, ByteSet& set) {
+        switch (c) {
+        case 'd':
+        case 'D':
+            set = digit_set();
+            break;
+        case 'w':
+        case 'W':
+            set = word_set();
+            break;
+        case 's':
+        case 'S':
+            set = space_set();
+            break;
+        default:
+            return false;
+        }
+        if (c == 'D' || c == 'W' || c == 'S') {
+            set_invert(set);
+        }
+        return true;
+    }
+
+    /// Байт одиночного экранирования (c уже прочитан)
+    unsigned escaped_byte(char c) {
+        switch (c) {
+        case 'n':
+            return '\n';
+        case 't':
+            return '\t';
+        case 'r':
+            return '\r';
+        case 'f':
+            return '\f';
+        case 'v':
+            return '\v';
+        case '0':
+            return 0;
+        case 'x':
+            return parse_hex(2);
+        case 'c':
+            if (!at_end() && std::isalpha(static_cast<unsigned char>(peek()))) {
+                return static_cast<unsigned>(pattern_[pos_++]) % 32;
+            }
+            return '\\';
+        default:
+            return static_cast<unsigned char>(c);
+        }
+    }
+
+    unsigned parse_hex(std::size_t digits) {
+        unsigned value = 0;
+        for (std::size_t i = 0; i < digits; ++i) {
+            int digit = at_end() ? -1 : hex_value(peek());
+            if (digit < 0) {
+                fail("invalid hex escape");
+            }
+            value = value * 16 + static_cast<unsigned>(digit);
+            ++pos_;
+        }
+        return value;
+    }
+
+    Node parse_class() {
+        ByteSet set{};
+        bool negate = consume('^');
+
+        // Как в ECMAScript: [] — пустой класс, [^] — любой байт
+        while (true) {
+            if (at_end()) {
+                fail("missing ']'");
+            }
+            char c = pattern_[pos_++];
+            if (c == ']') {
+                break;
+            }
+
+            // [:name:]
+            if (c == '[' && !at_end() && peek() == ':') {
+                std::size_t close = pattern_.find(":]", pos_ + 1);
+                if (close != std::string_view::npos) {
+                    std::string_view name = pattern_.substr(pos_ + 1, close - pos_ - 1);
+                    set_merge(set, posix_class(name));
+                    pos_ = close + 2;
+                    continue;
+                }
+            }
+
+            unsigned lo = 0;
+            if (c == '\\') {
+                if (at_end()) {
+                    fail("missing ']'");
+                }
+                char e = pattern_[pos_++];
+                ByteSet escape_set{};
+                if (class_escape(e, escape_set)) {
+                    set_merge(set, escape_set);
+                    continue;
+                }
+                lo = e == 'b' ? '\b' : class_escaped_byte(e);
+            } else {
+                lo = static_cast<unsigned char>(c);
+            }
+
+            // Диапазон lo-hi ('-' перед ']' — литерал)
+            if (pos_ + 1 < pattern_.size() && peek() == '-' && pattern_[pos_ + 1] != ']') {
+                ++pos_;
+                char h = pattern_[pos_++];
+                unsigned hi = 0;
+                if (h == '\\') {
+                    if (at_end()) {
+                        fail("missing ']'");
+                    }
+                    char e = pattern_[pos_++];
+                    ByteSet escape_set{};
+                    if (class_escape(e, escape_set)) {
+                        fail("invalid character class range");
+                    }
+                    hi = e == 'b' ? '\b' : class_escaped_byte(e);
+                } else if (h == '[' && !at_end() && peek() == ':') {
+                    fail("invalid character class range");
+                } else {
+                    hi = static_cast<unsigned char>(h);
+                }
+                if (hi < lo) {
+                    fail("invalid character class range");
+                }
+                set_range(set, lo, hi);
+            } else {
+                set_add(set, lo);
+            }
+        }
+
+        if (icase_) {
+            set_fold(set);
+        }
+        if (negate) {
+            set_invert(set);
+        }
+        return Node::bytes(set);
+    }
+
+    unsigned class_escaped_byte(char e) {
+        if (e == 'u') {
+            unsigned code = parse_hex(4);
+            if (code >= 0x80) {
+                fail("non-ASCII \\u escape in character class is not supported");
+            }
+            return code;
+        }
+        if (e >= '1' && e <= '9') {
+            fail("backreferences are not supported");
+        }
+        return escaped_byte(e);
+    }
+
+    ByteSet posix_class(std::string_view name) {
+        ByteSet set{};
+        auto add_if = [&set](auto predicate) {
+            for (unsigned byte = 0; byte < 128; ++byte) {
+                if (predicate(static_cast<int>(byte))) {
+                    set_add(set, byte);
+                }
+            }
+        };
+        if (name == "alpha") {
+            add_if([](int c) { return std::isalpha(c); });
+        } else if (name == "digit") {
+            add_if([](int c) { return std::isdigit(c); });
+        } else if (name == "alnum") {
+            add_if([](int c) { return std::isalnum(c); });
+        } else if (name == "space") {
+            add_if([](int c) { return std::isspace(c); });
+        } else if (name == "upper") {
+            add_if([](int c) { return std::isupper(c); });
+        } else if (name == "lower") {
+            add_if([](int c) { return std::islower(c); });
+        } else if (name == "punct") {
+            add_if([](int c) { return std::ispunct(c); });
+        } else if (name == "xdigit") {
+            add_if([](int c) { return std::isxdigit(c); });
+        } else if (name == "print") {
+            add_if([](int c) { return std::isprint(c); });
+        } else if (name == "graph") {
+            add_if([](int c) { return std::isgraph(c); });
+        } else if (name == "cntrl") {
+            add_if([](int c) { return std::iscntrl(c); });
+        } else if (name == "blank") {
+            add_if([](int c) { return c == ' ' || c == '\t'; });
+        } else if (name == "word") {
+            set = word_set();
+        } else {
+            fail("unknown character class");
+        }
+        return set;
+    }
+
+    std::string_view pattern_;
+    std::size_t pos_ = 0;
+    bool icase_;
+    bool dotall_ = false;
+    bool multiline_ = false;
+};
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+class Regex::Compiler {
+public:
+    explicit Compiler(Regex& regex) : regex_(regex) {}
+
+    /// Развернуть дерево в программу; возвращает первую инструкцию
+    std::uint32_t compile(const Node& root) {
+        Fragment body = emit(root);
+        std::uint32_t match = push({Op::Match, Assertion::BeginText, 0, 0, 0});
+        patch(body.holes, match);
+        if (anchored(root)) {
+            return body.start;
+        }
+
+        // Поиск в любом месте: L: split(body, any → L)
+        ByteSet any{};
+        set_invert(any);
+        std::uint32_t loop = push({Op::Split, Assertion::BeginText, body.start, 0, 0});
+        std::uint32_t skip = push({Op::Bytes, Assertion::BeginText, set_index(any), 0, loop});
+        regex_.program_[loop].y = skip;
+        return loop;
+    }
+
+private:
+    /// Незаполненная ссылка: индекс инструкции * 4 + поле (0 — x, 1 — y, 2 — next)
+    using Hole = std::uint32_t;
+
+    struct Fragment {
+        std::uint32_t start;
+        std::vector<Hole> holes;
+    };
+
+    std::uint32_t push(const Inst& inst) {
+        if (regex_.program_.size() >= MAX_INSTS) {
+            throw RegexError("regex too large");
+        }
+        regex_.program_.push_back(inst);
+        return static_cast<std::uint32_t>(regex_.program_.size() - 1);
+    }
+
+    void patch(const std::vector<Hole>& holes, std::uint32_t target) {
+        for (Hole hole : holes) {
+            Inst& inst = regex_.program_[hole >> 2];
+            switch (hole & 3) {
+            case 0:
+                inst.x = target;
+                break;
+            case 1:
+                inst.y = target;
+                break;
+            default:
+                inst.next = target;
+                break;
+            }
+        }
+    }
+
+    std::uint32_t set_index(const ByteSet& set) {
+        auto [it, inserted] =
+            set_ids_.emplace(set, static_cast<std::uint32_t>(regex_.sets_.size()));
+        if (inserted) {
+            regex_.sets_.push_back(set);
+        }
+        return it->second;
+    }
+
+    Fragment empty() {
+        std::uint32_t jmp = push({Op::Jmp, Assertion::BeginText, 0, 0, 0});
+        return {jmp, {jmp << 2}};
+    }
+
+    Fragment emit(const Node& node) {
+        switch (node.kind) {
+        case Node::Kind::Empty:
+            return empty();
+        case Node::Kind::Bytes: {
+            std::uint32_t id = set_index(node.set);
+            std::uint32_t pc = push({Op::Bytes, Assertion::BeginText, id, 0, 0});
+            return {pc, {(pc << 2) | 2}};
+        }
+        case Node::Kind::Assert: {
+            if (node.assertion == Assertion::WordBoundary ||
+                node.assertion == Assertion::NotWordBoundary) {
+                regex_.track_word_ = true;
+            } else if (node.assertion == Assertion::BeginLine ||
+                       node.assertion == Assertion::EndLine) {
+                regex_.track_line_ = true;
+            }
+            std::uint32_t pc = push({Op::Assert, node.assertion, 0, 0, 0});
+            return {pc, {(pc << 2) | 2}};
+        }
+        case Node::Kind::Concat: {
+            if (node.children.empty()) {
+                return empty();
+            }
+            Fragment result = emit(node.children.front());
+            for (std::size_t i = 1; i < node.children.size(); ++i) {
+                Fragment next = emit(node.children[i]);
+                patch(result.holes, next.start);
+                result.holes = std::move(next.holes);
+            }
+            return result;
+        }
+        case Node::Kind::Alternate: {
+            // split(a, split(b, ... z))
+            Fragment last = emit(node.children.back());
+            for (std::size_t i = node.children.size() - 1; i-- > 0;) {
+                Fragment branch = emit(node.children[i]);
+                std::uint32_t split =
+                    push({Op::Split, Assertion::BeginText, branch.start, last.start, 0});
+                branch.holes.insert(branch.holes.end(), last.holes.begin(), last.holes.end());
+                last = {split, std::move(branch.holes)};
+            }
+            return last;
+        }
+        case Node::Kind::Repeat:
+            return emit_repeat(node);
+        }
+        return empty();
+    }
+
+    Fragment emit_repeat(const Node& node) {
+        const Node& child = node.children.front();
+        std::optional<Fragment> result;
+        auto append = [this, &result](Fragment next) {
+            if (result) {
+                patch(result->holes, next.start);
+                result->holes = std::move(next.holes);
+            } else {
+                result = std::move(next);
+            }
+        };
+
+        // Обязательные повторения; при x{n,} последнее из них зацикливается (x+)
+        std::size_t required = node.min;
+        if (node.unbounded && required > 0) {
+            --required;
+        }
+        for (std::size_t i = 0; i < required; ++i) {
+            append(emit(child));
+        }
+
+        if (node.unbounded) {
+            // x* : L: split(x → L, out); x+ : x, split(→ x, out)
+            Fragment body = emit(child);
+            std::uint32_t split = push({Op::Split, Assertion::BeginText, body.start, 0, 0});
+            patch(body.holes, split);
+            Hole out = (split << 2) | 1;
+            if (node.min > 0) {
+                append({body.start, {out}});
+            } else {
+                append({split, {out}});
+            }
+        } else {
+            // Необязательные повторения: (x(x(x)?)?)?
+            std::vector<Hole> skips;
+            for (std::size_t i = node.min; i < node.max; ++i) {
+                Fragment body = emit(child);
+                std::uint32_t split = push({Op::Split, Assertion::BeginText, body.start, 0, 0});
+                skips.push_back((split << 2) | 1);
+                append({split, std::move(body.holes)});
+            }
+            if (result) {
+                result->holes.insert(result->holes.end(), skips.begin(), skips.end());
+            }
+        }
+
+        if (!result) {
+            return empty();  // x{0}
+        }
+        return std::move(*result);
+    }
+
+    /// Все совпадения начинаются с начала текста (^ без (?m))
+    static bool anchored(const Node& node) {
+        switch (node.kind) {
+        case Node::Kind::Assert:
+            return node.assertion == Assertion::BeginText;
+        case Node::Kind::Concat:
+            return !node.children.empty() && anchored(node.children.front());
+        case Node::Kind::Alternate:
+            return std::all_of(node.children.begin(), node.children.end(),
+                               [](const Node& child) { return anchored(child); });
+        case Node::Kind::Repeat:
+            return node.min > 0 && anchored(node.children.front());
+        default:
+            return false;
+        }
+    }
+
+    Regex& regex_;
+    std::map<ByteSet, std::uint32_t> set_ids_;
+};
+
+// ============================================================================
+// Литералы префильтра
+// ============================================================================
+
+struct Regex::Literals {
+    bool exact = true;     // узел совпадает ровно со строкой text
+    bool anchors = false;  // в точной строке есть якоря (нулевой ширины)
+    std::string text;      // при exact
+    bool icase = false;    // text содержит буквы обоих регистров
+    bool cased = false;    // text содержит букву только одного регистра
+    std::string best;      // самая длинная обязательная подстрока (кроме text)
+    bool best_icase = false;
+
+    void offer(const std::string& candidate, bool candidate_icase) {
+        if (candidate.size() > best.size()) {
+            best = candidate;
+            best_icase = candidate_icase;
+        }
+    }
+
+    void make_inexact() {
+        if (exact) {
+            offer(text, icase);
+        }
+        exact = false;
+        text.clear();
+    }
+
+    static Literals of(const Node& node) {
+        Literals result;
+        switch (node.kind) {
+        case Node::Kind::Empty:
+            break;
+        case Node::Kind::Assert:
+            result.anchors = true;
+            break;
+        case Node::Kind::Bytes:
+            result.exact = single_byte(node.set, result.text, result.icase);
+            result.cased = result.exact && !result.icase &&
+                           std::isalpha(static_cast<unsigned char>(result.text.front()));
+            break;
+        case Node::Kind::Concat: {
+            // Соседние точные узлы склеиваются в одну строку
+            std::string run;
+            bool run_icase = false;
+            for (const auto& child : node.children) {
+                Literals inner = of(child);
+                result.anchors = result.anchors || inner.anchors;
+                result.cased = result.cased || inner.cased;
+                result.offer(inner.best, inner.best_icase);
+                if (inner.exact) {
+                    run += inner.text;
+                    run_icase = run_icase || inner.icase;
+                } else {
+                    result.offer(run, run_icase);
+                    result.exact = false;
+                    run.clear();
+                    run_icase = false;
+                }
+            }
+            if (result.exact) {
+                result.text = std::move(run);
+                result.icase = run_icase;
+            } else {
+                result.offer(run, run_icase);
+            }
+            break;
+        }
+        case Node::Kind::Alternate:
+            result.exact = false;
+            break;
+        case Node::Kind::Repeat: {
+            Literals inner = of(node.children.front());
+            if (node.min == 0) {
+                result.exact = false;
+                break;
+            }
+            result.anchors = inner.anchors;
+            result.cased = inner.cased;
+            result.offer(inner.best, inner.best_icase);
+            if (!inner.exact || inner.text.size() * node.min > MAX_LITERAL) {
+                result.exact = false;
+                result.offer(inner.text, inner.icase);
+                break;
+            }
+            for (std::size_t i = 0; i < node.min; ++i) {
+                result.text += inner.text;
+            }
+            result.icase = inner.icase;
+            if (node.unbounded || node.max != node.min) {
+                result.make_inexact();
+            }
+            break;
+        }
+        }
+        if (result.icase) {
+            for (auto& c : result.text) {
+                c = static_cast<char>(fold_byte(static_cast<unsigned char>(c)));
+            }
+        }
+        if (result.best_icase) {
+            for (auto& c : result.best) {
+                c = static_cast<char>(fold_byte(static_cast<unsigned char>(c)));
+            }
+        }
+        return result;
+    }
+
+    /// Множество из одного байта или из двух регистров одной буквы
+    static bool single_byte(const ByteSet& set, std::string& text, bool& icase) {
+        int count = 0;
+        unsigned found = 0;
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            if (set_has(set, byte)) {
+                if (++count > 2) {
+                    return false;
+                }
+                found = count == 1 ? byte : found;
+            }
+        }
+        if (count == 1) {
+            text.assign(1, static_cast<char>(found));
+            return true;
+        }
+        // Два байта: A-Z (первый) и a-z
+        if (count == 2 && found >= 'A' && found <= 'Z' && set_has(set, found + 32)) {
+            text.assign(1, static_cast<char>(found + 32));
+            icase = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+// ============================================================================
+// Кэш ДКА
+// ============================================================================
+
+struct Regex::Cache {
+    struct State {
+        std::uint8_t flags;
+        std::int8_t accepts_at_end;  // -1 — ещё не вычислено
+        std::vector<std::uint32_t> pcs;
+    };
+
+    std::mutex mutex;
+    std::vector<State> states;
+    std::vector<std::uint32_t> transitions;  // states × classes_count_
+    std::unordered_map<std::string, std::uint32_t> index;
+    std::size_t memory = 0;
+
+    // Рабочие буферы замыкания
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> seen;  // поколение посещения по инструкциям
+    std::uint32_t generation = 0;
+    std::vector<std::uint32_t> consuming;
+    std::vector<std::uint32_t> next;
+    std::string key;
+
+    /// Найти или добавить состояние ДКА
+    std::uint32_t intern(std::size_t classes, std::uint8_t flags,
+                         const std::vector<std::uint32_t>& pcs) {
+        key.assign(1, static_cast<char>(flags));
+        key.append(reinterpret_cast<const char*>(pcs.data()), pcs.size() * sizeof(pcs[0]));
+        auto it = index.find(key);
+        if (it != index.end()) {
+            return it->second;
+        }
+        auto id = static_cast<std::uint32_t>(states.size());
+        memory += classes * sizeof(std::uint32_t) + key.size() * 2 + sizeof(State);
+        index.emplace(key, id);
+        states.push_back({flags, -1, pcs});
+        transitions.resize(transitions.size() + classes, UNKNOWN);
+        return id;
+    }
+};
+
+// ============================================================================
+// Regex
+// ============================================================================
+
+Regex::Regex(std::string_view pattern, bool ignore_case)
+    : pattern_(pattern),
+      ignore_case_(ignore_case),
+      caches_(std::make_unique<Cache[]>(CACHE_SLOTS)) {
+    Node root = Parser(pattern, ignore_case).parse();
+    start_ = Compiler(*this).compile(root);
+
+    // Префильтр: паттерн целиком — подстрока, иначе самая длинная обязательная.
+    // Подстрока без учёта регистра с буквами одного регистра — только условие
+    Literals literals = Literals::of(root);
+    if (literals.exact && !literals.anchors && !literals.text.empty() &&
+        !(literals.icase && literals.cased)) {
+        literal_ = std::move(literals.text);
+        literal_icase_ = literals.icase;
+        literal_only_ = true;
+    } else {
+        if (literals.exact) {
+            literals.make_inexact();
+        }
+        if (literals.best.size() >= MIN_LITERAL) {
+            literal_ = std::move(literals.best);
+            literal_icase_ = literals.best_icase;
+        }
+    }
+
+    // Классы байтов: разбиение по всем множествам и признакам якорей
+    std::array<std::uint16_t, 256> classes{};
+    std::size_t count = 1;
+    auto refine = [&classes, &count](auto&& has) {
+        std::array<std::int16_t, 512> renumber;
+        renumber.fill(-1);
+        std::size_t next = 0;
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            std::size_t key = classes[byte] * 2u + (has(byte) ? 1u : 0u);
+            if (renumber[key] < 0) {
+                renumber[key] = static_cast<std::int16_t>(next++);
+            }
+            classes[byte] = static_cast<std::uint16_t>(renumber[key]);
+        }
+        count = next;
+    };
+    for (const auto& set : sets_) {
+        refine([&set](unsigned byte) { return set_has(set, byte); });
+    }
+    if (track_word_) {
+        refine([](unsigned byte) { return is_word_byte(byte); });
+    }
+    if (track_line_) {
+        refine([](unsigned byte) { return byte == '\n'; });
+    }
+    for (std::size_t byte = 0; byte < 256; ++byte) {
+        classes_[byte] = static_cast<std::uint8_t>(classes[byte]);
+    }
+    classes_count_ = count;
+}
+
+Regex::~Regex() = default;
+Regex::Regex(Regex&&) noexcept = default;
+Regex& Regex::operator=(Regex&&) noexcept = default;
+
+bool Regex::search(std::string_view text) const {
+    if (!literal_.empty()) {
+        bool found =
+            literal_icase_ ? contains<true>(text, literal_) : contains<false>(text, literal_);
+        if (!found || literal_only_) {
+            return found;
+        }
+    }
+
+    // Поток начинает со своего кэша, занятые пропускает
+    static thread_local const std::size_t home =
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+    for (std::size_t i = 0; i < CACHE_SLOTS; ++i) {
+        Cache& cache = caches_[(home + i) % CACHE_SLOTS];
+        std::unique_lock<std::mutex> lock(cache.mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            return run(cache, text);
+        }
+    }
+    // Все кэши заняты другими потоками: отдельный временный ДКА (тоже линейный)
+    Cache local;
+    return run(local, text);
+}
+
+bool Regex::run(Cache& cache, std::string_view text) const {
+    const std::size_t classes = classes_count_;
+
+    if (cache.seen.size() != program_.size()) {
+        cache.seen.assign(program_.size(), 0);
+        cache.generation = 0;
+    }
+
+    // Замыкание по split/jmp/assert; next_byte < 0 — конец текста.
+    // Инструкции Bytes собираются в cache.consuming; true — достигнут Match.
+    auto closure = [this, &cache](const Cache::State& state, int next_byte) {
+        if (++cache.generation == 0) {
+            std::fill(cache.seen.begin(), cache.seen.end(), 0);
+            cache.generation = 1;
+        }
+        const std::uint32_t gen = cache.generation;
+        bool prev_word = (state.flags & PREV_WORD) != 0;
+        bool next_word = next_byte >= 0 && is_word_byte(static_cast<unsigned>(next_byte));
+
+        cache.consuming.clear();
+        cache.stack.assign(state.pcs.rbegin(), state.pcs.rend());
+        while (!cache.stack.empty()) {
+            std::uint32_t pc = cache.stack.back();
+            cache.stack.pop_back();
+            if (cache.seen[pc] == gen) {
+                continue;
+            }
+            cache.seen[pc] = gen;
+            const Inst& inst = program_[pc];
+            switch (inst.op) {
+            case Op::Match:
+                return true;
+            case Op::Bytes:
+                cache.consuming.push_back(pc);
+                break;
+            case Op::Jmp:
+                cache.stack.push_back(inst.x);
+                break;
+            case Op::Split:
+                cache.stack.push_back(inst.y);
+                cache.stack.push_back(inst.x);
+                break;
+            case Op::Assert: {
+                bool holds = false;
+                switch (inst.assertion) {
+                case Assertion::BeginText:
+                    holds = (state.flags & AT_START) != 0;
+                    break;
+                case Assertion::EndText:
+                    holds = next_byte < 0;
+                    break;
+                case Assertion::BeginLine:
+                    holds = (state.flags & (AT_START | PREV_LINE)) != 0;
+                    break;
+                case Assertion::EndLine:
+                    holds = next_byte < 0 || next_byte == '\n';
+                    break;
+                case Assertion::WordBoundary:
+                    holds = prev_word != next_word;
+                    break;
+                case Assertion::NotWordBoundary:
+                    holds = prev_word == next_word;
+                    break;
+                }
+                if (holds) {
+                    cache.stack.push_back(inst.next);
+                }
+                break;
+            }
+            }
+        }
+        return false;
+    };
+
+    auto start_state = [this, &cache, classes]() {
+        std::vector<std::uint32_t> pcs{start_};
+        return cache.intern(classes, AT_START, pcs);
+    };
+
+    // Переход из state по байту: MATCH, DEAD или номер состояния
+    auto step = [&](std::uint32_t& state, unsigned char byte) -> std::uint32_t {
+        if (cache.memory > MAX_CACHE_BYTES) {
+            // Сброс кэша: текущее состояние переносится в новый кэш
+            Cache::State current = std::move(cache.states[state]);
+            cache.states.clear();
+            cache.transitions.clear();
+            cache.index.clear();
+            cache.memory = 0;
+            start_state();
+            state = cache.intern(classes, current.flags, current.pcs);
+        }
+
+        if (closure(cache.states[state], byte)) {
+            return cache.transitions[state * classes + classes_[byte]] = MATCH;
+        }
+        ++cache.generation;
+        if (cache.generation == 0) {
+            std::fill(cache.seen.begin(), cache.seen.end(), 0);
+            cache.generation = 1;
+        }
+        cache.next.clear();
+        for (std::uint32_t pc : cache.consuming) {
+            const Inst& inst = program_[pc];
+            if (set_has(sets_[inst.x], byte) && cache.seen[inst.next] != cache.generation) {
+                cache.seen[inst.next] = cache.generation;
+                cache.next.push_back(inst.next);
+            }
+        }
+        std::uint32_t target = DEAD;
+        if (!cache.next.empty()) {
+            std::sort(cache.next.begin(), cache.next.end());
+            std::uint8_t flags = 0;
+            if (track_word_ && is_word_byte(byte)) {
+                flags |= PREV_WORD;
+            }
+            if (track_line_ && byte == '\n') {
+                flags |= PREV_LINE;
+            }
+            target = cache.intern(classes, flags, cache.next);
+        }
+        return cache.transitions[state * classes + classes_[byte]] = target;
+    };
+
+    if (cache.states.empty()) {
+        start_state();
+    }
+    std::uint32_t state = 0;  // начальное состояние всегда первое
+    for (char c : text) {
+        auto byte = static_cast<unsigned char>(c);
+        std::uint32_t next = cache.transitions[state * classes + classes_[byte]];
+        if (next == UNKNOWN) {
+            next = step(state, byte);
+        }
+        if (next == MATCH) {
+            return true;
+        }
+        if (next == DEAD) {
+            return false;
+        }
+        state = next;
+    }
+
+    Cache::State& last = cache.states[state];
+    if (last.accepts_at_end < 0) {
+        last.accepts_at_end = closure(last, -1) ? 1 : 0;
+    }
+    return last.accepts_at_end == 1;
+}
+
+// ============================================================================
+// Общий кэш скомпилированных паттернов
+// ============================================================================
+
+RegexPtr compile_regex(std::string_view pattern, bool ignore_case) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const Regex>> compiled;
+
+    std::string key;
+    key.reserve(pattern.size() + 1);
+    key += ignore_case ? 'i' : '-';
+    key += pattern;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = compiled[key];
+    if (auto existing = slot.lock()) {
+        return existing;
+    }
+    auto regex = std::make_shared<const Regex>(pattern, ignore_case);
+    slot = regex;
+    return regex;
+}
+
+}  // namespace chainsaw::tau
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chainsaw/aho_corasick.hpp>
 #include <chainsaw/tau.hpp>
 #include <charconv>
 #include <cstring>
@@ -71,46 +72,7 @@ bool iends_with(std::string_view str, std::string_view suffix) {
 // Deep copy (clone)
 // ============================================================================
 
-namespace {
-
-Pattern clone_pattern(const Pattern& p) {
-    return std::visit(
-        [](const auto& pat) -> Pattern {
-            using T = std::decay_t<decltype(pat)>;
-            if constexpr (std::is_same_v<T, PatternRegex>) {
-                PatternRegex result;
-                result.pattern = pat.pattern;
-                result.regex = std::regex(pat.pattern, std::regex::ECMAScript);
-                return result;
-            } else {
-                return pat;
-            }
-        },
-        p);
-}
-
-Search clone_search(const Search& s) {
-    return std::visit(
-        [](const auto& search) -> Search {
-            using T = std::decay_t<decltype(search)>;
-            if constexpr (std::is_same_v<T, SearchRegex>) {
-                SearchRegex result;
-                result.pattern = search.pattern;
-                result.ignore_case = search.ignore_case;
-                auto flags = std::regex::ECMAScript;
-                if (search.ignore_case) {
-                    flags |= std::regex::icase;
-                }
-                result.regex = std::regex(search.pattern, flags);
-                return result;
-            } else {
-                return search;
-            }
-        },
-        s);
-}
-
-}  // namespace
+// Regex в Pattern/Search разделяется между копиями (скомпилирован один раз)
 
 Expression clone(const Expression& expr) {
     return std::visit(
@@ -141,25 +103,19 @@ Expression clone(const Expression& expr) {
                 return Expression(std::move(result));
             } else if constexpr (std::is_same_v<T, ExprMatch>) {
                 ExprMatch result;
-                result.pattern = clone_pattern(e.pattern);
+                result.pattern = e.pattern;
                 result.inner = std::make_unique<Expression>(clone(*e.inner));
                 return Expression(std::move(result));
             } else if constexpr (std::is_same_v<T, ExprSearch>) {
                 ExprSearch result;
-                result.search = clone_search(e.search);
+                result.search = e.search;
                 result.field = e.field;
                 result.cast_to_str = e.cast_to_str;
                 return Expression(std::move(result));
             } else if constexpr (std::is_same_v<T, ExprMatrix>) {
                 ExprMatrix result;
                 result.fields = e.fields;
-                for (const auto& [patterns, flag] : e.rows) {
-                    std::vector<Pattern> cloned_patterns;
-                    for (const auto& p : patterns) {
-                        cloned_patterns.push_back(clone_pattern(p));
-                    }
-                    result.rows.emplace_back(std::move(cloned_patterns), flag);
-                }
+                result.rows = e.rows;
                 return Expression(std::move(result));
             } else {
                 // Simple types: Field, Cast, Boolean, Float, Integer, Null, Identifier
@@ -169,13 +125,31 @@ Expression clone(const Expression& expr) {
         expr.data);
 }
 
+// ============================================================================
+// FieldPath
+// ============================================================================
+
+FieldPath::FieldPath(std::string path) : path_(std::move(path)), key_(path_) {
+    // Разбиение как в ValueDocument::lookup: завершающая точка не даёт сегмента
+    std::string_view remaining = path_;
+    while (!remaining.empty()) {
+        auto dot_pos = remaining.find('.');
+        if (dot_pos == std::string_view::npos) {
+            segments_.emplace_back(remaining);
+            break;
+        }
+        segments_.emplace_back(remaining.substr(0, dot_pos));
+        remaining = remaining.substr(dot_pos + 1);
+    }
+}
+
 // ============================================================================
 // ValueDocument
 // ============================================================================
 
-std::optional<Value> ValueDocument::find(std::string_view key) const {
+FieldRef ValueDocument::lookup(std::string_view key) const {
     if (!value_.is_object()) {
-        return std::nullopt;
+        return FieldRef();
     }
 
     // Поддержка dot-notation: a.b.c
@@ -194,32 +168,43 @@ std::optional<Value> ValueDocument::find(std::string_view key) const {
         }
 
         if (!current->is_object()) {
-            return std::nullopt;
+            return FieldRef();
         }
 
-        std::string key_str(part);
-        const Value* found = current->get(key_str);
+        const Value* found = current->get(part);
         if (!found) {
-            return std::nullopt;
+            return FieldRef();
         }
 
         if (remaining.empty()) {
-            return *found;
+            return FieldRef(found);
         }
 
         current = found;
     }
 
-    return std::nullopt;
+    return FieldRef();
+}
+
+FieldRef ValueDocument::resolve(const FieldPath& path) const {
+    if (!value_.is_object() || path.segments().empty()) {
+        return FieldRef();
+    }
+
+    const Value* current = &value_;
+    for (const ValueKey& segment : path.segments()) {
+        current = current->get(segment);
+        if (!current) {
+            return FieldRef();
+        }
+    }
+    return FieldRef(current);
 }
 
 // ============================================================================
 // Solver - Pattern matching
 // ============================================================================
 
-namespace {
-
-// Преобразование Value в строку
 std::string value_to_string(const Value& v) {
     if (v.is_string()) {
         return v.as_string();
@@ -239,6 +224,25 @@ std::string value_to_string(const Value& v) {
     return "";
 }
 
+std::optional<double> value_to_double(const Value& v) {
+    if (v.is_double()) {
+        return v.as_double();
+    } else if (v.is_int()) {
+        return static_cast<double>(v.as_int());
+    } else if (v.is_uint()) {
+        return static_cast<double>(v.as_uint());
+    } else if (v.is_string()) {
+        try {
+            return std::stod(v.as_string());
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+namespace {
+
 // Преобразование Value в int64
 std::optional<std::int64_t> value_to_int(const Value& v) {
     if (v.is_int()) {
@@ -259,24 +263,6 @@ std::optional<std::int64_t> value_to_int(const Value& v) {
     return std::nullopt;
 }
 
-// Преобразование Value в double
-std::optional<double> value_to_double(const Value& v) {
-    if (v.is_double()) {
-        return v.as_double();
-    } else if (v.is_int()) {
-        return static_cast<double>(v.as_int());
-    } else if (v.is_uint()) {
-        return static_cast<double>(v.as_uint());
-    } else if (v.is_string()) {
-        try {
-            return std::stod(v.as_string());
-        } catch (...) {
-            return std::nullopt;
-        }
-    }
-    return std::nullopt;
-}
-
 // Применить Pattern к Value
 bool match_pattern(const Pattern& pattern, const Value& value) {
     return std::visit(
@@ -317,7 +303,7 @@ bool match_pattern(const Pattern& pattern, const Value& value) {
                 return !value.is_null();
             } else if constexpr (std::is_same_v<T, PatternRegex>) {
                 std::string str = value_to_string(value);
-                return std::regex_search(str, pat.regex);
+                return pat.regex->search(str);
             } else if constexpr (std::is_same_v<T, PatternContains>) {
                 std::string str = value_to_string(value);
                 return str.find(pat.value) != std::string::npos;
@@ -348,9 +334,12 @@ bool match_search(const Search& search, std::string_view value_str) {
             if constexpr (std::is_same_v<T, SearchAny>) {
                 return true;  // поле существует
             } else if constexpr (std::is_same_v<T, SearchRegex>) {
-                return std::regex_search(value_str.begin(), value_str.end(), s.regex);
+                return s.regex->search(value_str);
             } else if constexpr (std::is_same_v<T, SearchAhoCorasick>) {
-                // Реализация через простые string операции с case folding
+                if (s.automaton) {
+                    return s.automaton->find_any(value_str);
+                }
+                // Без автомата (выражение не прошло shake): записи по одной
                 for (const auto& mt : s.match_types) {
                     bool matched = false;
                     switch (mt.type) {
@@ -469,13 +458,13 @@ bool solve_expr(const Expression& expr, const Document& doc) {
                         return f->value;
                     }
                     if (auto* field = exp.get_field()) {
-                        auto val = doc.find(field->name);
+                        auto val = doc.resolve(field->name);
                         if (val) {
                             return value_to_double(*val);
                         }
                     }
                     if (auto* cast = std::get_if<ExprCast>(&exp.data)) {
-                        auto val = doc.find(cast->field);
+                        auto val = doc.resolve(cast->field);
                         if (val) {
                             if (cast->mod == ModSym::Int) {
                                 auto i = value_to_int(*val);
@@ -513,10 +502,10 @@ bool solve_expr(const Expression& expr, const Document& doc) {
             } else if constexpr (std::is_same_v<T, ExprNegate>) {
                 return !solve_expr(*e.inner, doc);
             } else if constexpr (std::is_same_v<T, ExprField>) {
-                auto val = doc.find(e.name);
+                auto val = doc.resolve(e.name);
                 return val.has_value() && !val->is_null();
             } else if constexpr (std::is_same_v<T, ExprCast>) {
-                auto val = doc.find(e.field);
+                auto val = doc.resolve(e.field);
                 if (!val)
                     return false;
 
@@ -534,7 +523,7 @@ bool solve_expr(const Expression& expr, const Document& doc) {
                 }
                 return false;
             } else if constexpr (std::is_same_v<T, ExprNested>) {
-                auto val = doc.find(e.field);
+                auto val = doc.resolve(e.field);
                 if (!val || !val->is_object())
                     return false;
                 ValueDocument nested_doc(*val);
@@ -542,7 +531,7 @@ bool solve_expr(const Expression& expr, const Document& doc) {
             } else if constexpr (std::is_same_v<T, ExprMatch>) {
                 // Вычислить inner и применить pattern
                 if (auto* field = e.inner->get_field()) {
-                    auto val = doc.find(field->name);
+                    auto val = doc.resolve(field->name);
                     if (!val)
                         return false;
 
@@ -559,7 +548,7 @@ bool solve_expr(const Expression& expr, const Document& doc) {
                 }
                 return false;
             } else if constexpr (std::is_same_v<T, ExprSearch>) {
-                auto val = doc.find(e.field);
+                auto val = doc.resolve(e.field);
                 if (!val) {
                     // SearchAny требует существования поля
                     if (std::holds_alternative<SearchAny>(e.search)) {
@@ -576,7 +565,7 @@ bool solve_expr(const Expression& expr, const Document& doc) {
 
                     bool row_matched = true;
                     for (std::size_t i = 0; i < e.fields.size(); ++i) {
-                        auto val = doc.find(e.fields[i]);
+                        auto val = doc.resolve(e.fields[i]);
                         if (!val) {
                             row_matched = false;
                             break;
@@ -627,6 +616,532 @@ bool solve(const Expression& expression, const Document& document) {
     return solve_expr(expression, document);
 }
 
+// ============================================================================
+// Program - байткод выражения
+// ============================================================================
+
+namespace {
+
+// Search по значению поля: массив — любой элемент, строка — без копирования
+template <typename Match>
+bool search_value(const Value& value, const Match& match) {
+    if (value.is_array()) {
+        for (const auto& elem : value.as_array()) {
+            if (search_value(elem, match)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (value.is_string()) {
+        return match(std::string_view(value.as_string()));
+    }
+    return match(std::string_view(value_to_string(value)));
+}
+
+// Часть ключа проверки: длина и байты, чтобы части не сливались
+void append_key(std::string& key, std::string_view part) {
+    key += std::to_string(part.size());
+    key += ':';
+    key += part;
+}
+
+void append_key(std::string& key, const void* pointer) {
+    key += std::to_string(reinterpret_cast<std::uintptr_t>(pointer));
+    key += ';';
+}
+
+std::string pattern_key(const Pattern& pattern) {
+    std::string key = std::to_string(pattern.index()) + '/';
+    std::visit(
+        [&key](const auto& p) {
+            using T = std::decay_t<decltype(p)>;
+
+            if constexpr (std::is_same_v<T, PatternAny>) {
+                // без значения
+            } else if constexpr (std::is_same_v<T, PatternRegex>) {
+                append_key(key, p.regex.get());
+            } else if constexpr (std::is_same_v<T, PatternEqual> ||
+                                 std::is_same_v<T, PatternGreaterThan> ||
+                                 std::is_same_v<T, PatternGreaterThanOrEqual> ||
+                                 std::is_same_v<T, PatternLessThan> ||
+                                 std::is_same_v<T, PatternLessThanOrEqual>) {
+                append_key(key, std::to_string(p.value));
+            } else if constexpr (std::is_same_v<T, PatternFEqual> ||
+                                 std::is_same_v<T, PatternFGreaterThan> ||
+                                 std::is_same_v<T, PatternFGreaterThanOrEqual> ||
+                                 std::is_same_v<T, PatternFLessThan> ||
+                                 std::is_same_v<T, PatternFLessThanOrEqual>) {
+                append_key(key, std::string_view(reinterpret_cast<const char*>(&p.value),
+                                                 sizeof(p.value)));
+            } else {
+                append_key(key, p.value);
+            }
+        },
+        pattern);
+    return key;
+}
+
+std::string search_key(const Search& search) {
+    std::string key = std::to_string(search.index()) + '/';
+    std::visit(
+        [&key](const auto& s) {
+            using T = std::decay_t<decltype(s)>;
+
+            if constexpr (std::is_same_v<T, SearchAny>) {
+                // без значения
+            } else if constexpr (std::is_same_v<T, SearchRegex>) {
+                // compile_regex кэширует: один паттерн — один объект
+                append_key(key, s.regex.get());
+            } else if constexpr (std::is_same_v<T, SearchAhoCorasick>) {
+                key += s.ignore_case ? 'i' : 'c';
+                for (const auto& entry : s.match_types) {
+                    key += static_cast<char>('0' + static_cast<int>(entry.type));
+                    append_key(key, entry.value);
+                }
+            } else {
+                append_key(key, s.value);
+            }
+        },
+        search);
+    return key;
+}
+
+// Сравнение поля с числом (Field <op> Integer/Float) как числовой Pattern
+struct FieldComparison {
+    const FieldPath* field;
+    Pattern pattern;
+};
+
+// Pattern F* приводит значение через value_to_double, как solve_expr для
+// ExprBooleanExpression (nullopt — другая форма: приведение, два поля)
+std::optional<FieldComparison> field_comparison(const ExprBooleanExpression& e) {
+    const ExprField* field = e.left->get_field();
+    const Expression* number = e.right.get();
+    BoolSym op = e.op;
+    if (field == nullptr) {
+        // Число слева: сравнение зеркалится
+        field = e.right->get_field();
+        number = e.left.get();
+        switch (op) {
+        case BoolSym::GreaterThan:
+            op = BoolSym::LessThan;
+            break;
+        case BoolSym::GreaterThanOrEqual:
+            op = BoolSym::LessThanOrEqual;
+            break;
+        case BoolSym::LessThan:
+            op = BoolSym::GreaterThan;
+            break;
+        case BoolSym::LessThanOrEqual:
+            op = BoolSym::GreaterThanOrEqual;
+            break;
+        default:
+            break;
+        }
+    }
+    if (field == nullptr) {
+        return std::nullopt;
+    }
+
+    double value = 0;
+    if (const auto* i = number->get_int()) {
+        value = static_cast<double>(i->value);
+    } else if (const auto* f = number->get_float()) {
+        value = f->value;
+    } else {
+        return std::nullopt;
+    }
+
+    switch (op) {
+    case BoolSym::Equal:
+        return FieldComparison{&field->name, PatternFEqual{value}};
+    case BoolSym::GreaterThan:
+        return FieldComparison{&field->name, PatternFGreaterThan{value}};
+    case BoolSym::GreaterThanOrEqual:
+        return FieldComparison{&field->name, PatternFGreaterThanOrEqual{value}};
+    case BoolSym::LessThan:
+        return FieldComparison{&field->name, PatternFLessThan{value}};
+    case BoolSym::LessThanOrEqual:
+        return FieldComparison{&field->name, PatternFLessThanOrEqual{value}};
+    default:
+        return std::nullopt;
+    }
+}
+
+// Ключ атомарной проверки для Predicates (nullopt — проверка не общая)
+std::optional<std::string> predicate_key(const Expression& expr) {
+    std::string key;
+    if (const auto* field = expr.get_field()) {
+        key = "F";
+        append_key(key, field->name.str());
+        return key;
+    }
+    if (const auto* search = expr.get_search()) {
+        key = "S";
+        append_key(key, search->field.str());
+        return key + search_key(search->search);
+    }
+    if (const auto* match = std::get_if<ExprMatch>(&expr.data)) {
+        const auto* inner = match->inner->get_field();
+        if (inner == nullptr) {
+            return std::nullopt;
+        }
+        key = "M";
+        append_key(key, inner->name.str());
+        return key + pattern_key(match->pattern);
+    }
+    if (const auto* comparison = std::get_if<ExprBooleanExpression>(&expr.data)) {
+        // EventID: 4688 и зеркальные формы (4688 == EventID) — одна проверка
+        auto compared = field_comparison(*comparison);
+        if (!compared) {
+            return std::nullopt;
+        }
+        key = "C";
+        append_key(key, compared->field->str());
+        return key + pattern_key(compared->pattern);
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+/// Компилятор: выражение обходится один раз, для каждого узла известны
+/// метки переходов при истинном и ложном результате. Метки разрешаются в
+/// адреса после обхода.
+class Program::Compiler {
+public:
+    /// shared — набор общих проверок (nullptr — все проверки в программе)
+    Compiler(Program& program, Predicates* shared)
+        : program_(program), shared_(shared), field_index_(&own_fields_) {}
+
+    /// Компилятор одной проверки набора: поля общие для всех проверок
+    Compiler(Program& pool, std::unordered_map<std::string, std::uint32_t>& fields)
+        : program_(pool), shared_(nullptr), field_index_(&fields) {}
+
+    void compile(const Expression& expression) {
+        emit(expression, ACCEPT, REJECT);
+
+        auto end = static_cast<std::uint32_t>(program_.code_.size());
+        labels_[ACCEPT] = end;
+        labels_[REJECT] = end + 1;
+        for (auto& inst : program_.code_) {
+            inst.on_true = labels_[inst.on_true];
+            inst.on_false = labels_[inst.on_false];
+        }
+    }
+
+private:
+    static constexpr std::uint32_t ACCEPT = 0;
+    static constexpr std::uint32_t REJECT = 1;
+
+    std::uint32_t label() {
+        labels_.push_back(0);
+        return static_cast<std::uint32_t>(labels_.size() - 1);
+    }
+
+    /// Метка указывает на следующую инструкцию
+    void bind(std::uint32_t label) {
+        labels_[label] = static_cast<std::uint32_t>(program_.code_.size());
+    }
+
+    void push(Op op, std::uint32_t field, std::uint32_t arg, std::uint32_t on_true,
+              std::uint32_t on_false) {
+        program_.code_.push_back(Inst{op, field, arg, on_true, on_false});
+    }
+
+    void push_const(bool value, std::uint32_t on_true, std::uint32_t on_false) {
+        push(Op::Const, 0, value ? 1 : 0, on_true, on_false);
+    }
+
+    std::uint32_t field(const FieldPath& path) {
+        auto [it, inserted] = field_index_->try_emplace(
+            path.str(), static_cast<std::uint32_t>(program_.fields_.size()));
+        if (inserted) {
+            program_.fields_.push_back(path);
+        }
+        return it->second;
+    }
+
+    template <typename T>
+    static std::uint32_t add(std::vector<T>& table, T value) {
+        table.push_back(std::move(value));
+        return static_cast<std::uint32_t>(table.size() - 1);
+    }
+
+    /// Номер проверки в наборе; новая проверка компилируется в pool_
+    std::uint32_t intern(std::string key, const Expression& leaf) {
+        auto [it, inserted] = shared_->index_.try_emplace(
+            std::move(key), static_cast<std::uint32_t>(shared_->pool_.code_.size()));
+        if (inserted) {
+            Compiler(shared_->pool_, shared_->fields_).emit(leaf, ACCEPT, REJECT);
+        }
+        return it->second;
+    }
+
+    void emit(const Expression& expr, std::uint32_t on_true, std::uint32_t on_false) {
+        if (shared_ != nullptr) {
+            if (auto key = predicate_key(expr)) {
+                push(Op::Shared, 0, intern(std::move(*key), expr), on_true, on_false);
+                return;
+            }
+        }
+
+        std::visit(
+            [&](const auto& e) {
+                using T = std::decay_t<decltype(e)>;
+
+                if constexpr (std::is_same_v<T, ExprBooleanGroup>) {
+                    if (e.op != BoolSym::And && e.op != BoolSym::Or) {
+                        push_const(false, on_true, on_false);
+                        return;
+                    }
+                    if (e.expressions.empty()) {
+                        push_const(e.op == BoolSym::And, on_true, on_false);
+                        return;
+                    }
+                    // And: ложный элемент — сразу on_false; Or: истинный — сразу on_true
+                    bool is_and = e.op == BoolSym::And;
+                    for (std::size_t i = 0; i + 1 < e.expressions.size(); ++i) {
+                        std::uint32_t next = label();
+                        if (is_and) {
+                            emit(e.expressions[i], next, on_false);
+                        } else {
+                            emit(e.expressions[i], on_true, next);
+                        }
+                        bind(next);
+                    }
+                    emit(e.expressions.back(), on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprNegate>) {
+                    emit(*e.inner, on_false, on_true);
+                } else if constexpr (std::is_same_v<T, ExprField>) {
+                    push(Op::Exists, field(e.name), 0, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprSearch>) {
+                    emit_search(e, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprMatch>) {
+                    const auto* inner = e.inner->get_field();
+                    if (inner == nullptr) {
+                        push_const(false, on_true, on_false);
+                        return;
+                    }
+                    push(Op::Match, field(inner->name), add(program_.patterns_, e.pattern),
+                         on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprNested>) {
+                    push(Op::Nested, field(e.field),
+                         add(program_.nested_, compile_program(*e.inner)), on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprBoolean>) {
+                    push_const(e.value, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprFloat> ||
+                                     std::is_same_v<T, ExprInteger>) {
+                    push_const(true, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprNull> ||
+                                     std::is_same_v<T, ExprIdentifier>) {
+                    push_const(false, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, ExprBooleanExpression>) {
+                    auto comparison = field_comparison(e);
+                    if (!comparison) {
+                        push(Op::Tree, 0, add(program_.leaves_, clone(expr)), on_true, on_false);
+                        return;
+                    }
+                    push(Op::Compare, field(*comparison->field),
+                         add(program_.patterns_, std::move(comparison->pattern)), on_true,
+                         on_false);
+                } else {
+                    // ExprCast, ExprMatrix
+                    push(Op::Tree, 0, add(program_.leaves_, clone(expr)), on_true, on_false);
+                }
+            },
+            expr.data);
+    }
+
+    void emit_search(const ExprSearch& e, std::uint32_t on_true, std::uint32_t on_false) {
+        std::uint32_t path = field(e.field);
+        std::visit(
+            [&](const auto& s) {
+                using T = std::decay_t<decltype(s)>;
+
+                if constexpr (std::is_same_v<T, SearchAny>) {
+                    push(Op::SearchAny, path, 0, on_true, on_false);
+                } else if constexpr (std::is_same_v<T, SearchRegex>) {
+                    push(Op::SearchRegex, path, add(program_.regexes_, s.regex), on_true,
+                         on_false);
+                } else if constexpr (std::is_same_v<T, SearchAhoCorasick>) {
+                    auto automaton = s.automaton;
+                    if (!automaton) {
+                        automaton = std::make_shared<const AhoCorasick>(s.match_types,
+                                                                        s.ignore_case);
+                    }
+                    push(Op::SearchAho, path, add(program_.automata_, std::move(automaton)),
+                         on_true, on_false);
+                } else if constexpr (std::is_same_v<T, SearchContains>) {
+                    push(Op::SearchContains, path, add(program_.strings_, s.value), on_true,
+                         on_false);
+                } else if constexpr (std::is_same_v<T, SearchEndsWith>) {
+                    push(Op::SearchEndsWith, path, add(program_.strings_, s.value), on_true,
+                         on_false);
+                } else if constexpr (std::is_same_v<T, SearchExact>) {
+                    push(Op::SearchExact, path, add(program_.strings_, s.value), on_true,
+                         on_false);
+                } else {
+                    static_assert(std::is_same_v<T, SearchStartsWith>, "Unhandled search type");
+                    push(Op::SearchStartsWith, path, add(program_.strings_, s.value), on_true,
+                         on_false);
+                }
+            },
+            e.search);
+    }
+
+    Program& program_;
+    Predicates* shared_;
+    std::vector<std::uint32_t> labels_{0, 0};  // ACCEPT, REJECT
+    std::unordered_map<std::string, std::uint32_t> own_fields_;
+    std::unordered_map<std::string, std::uint32_t>* field_index_;
+};
+
+PredicateMemo::PredicateMemo(const Predicates& predicates)
+    : known_((predicates.size() + 63) / 64), value_(known_.size()) {}
+
+void PredicateMemo::clear() {
+    std::fill(known_.begin(), known_.end(), 0);
+}
+
+bool Program::test(const Inst& inst, const Document& document, PredicateMemo* memo) const {
+    if (inst.op == Op::Const) {
+        return inst.arg != 0;
+    }
+    if (inst.op == Op::Tree) {
+        return solve_expr(leaves_[inst.arg], document);
+    }
+    if (inst.op == Op::Shared) {
+        const Program& pool = shared_->pool_;
+        if (memo == nullptr) {
+            return pool.test(pool.code_[inst.arg], document, nullptr);
+        }
+        std::size_t word = inst.arg / 64;
+        std::uint64_t bit = std::uint64_t{1} << (inst.arg % 64);
+        if ((memo->known_[word] & bit) != 0) {
+            return (memo->value_[word] & bit) != 0;
+        }
+        bool result = pool.test(pool.code_[inst.arg], document, nullptr);
+        memo->known_[word] |= bit;
+        memo->value_[word] = result ? memo->value_[word] | bit : memo->value_[word] & ~bit;
+        return result;
+    }
+
+    auto val = document.resolve(fields_[inst.field]);
+    if (!val) {
+        return false;
+    }
+    const Value& value = *val;
+
+    switch (inst.op) {
+    case Op::Exists:
+        return !value.is_null();
+    case Op::SearchAny:
+        return search_value(value, [](std::string_view) { return true; });
+    case Op::SearchRegex: {
+        const Regex& regex = *regexes_[inst.arg];
+        return search_value(value, [&regex](std::string_view str) { return regex.search(str); });
+    }
+    case Op::SearchAho: {
+        const AhoCorasick& automaton = *automata_[inst.arg];
+        return search_value(value, [&automaton](std::string_view str) {
+            return automaton.find_any(str);
+        });
+    }
+    case Op::SearchContains: {
+        std::string_view needle = strings_[inst.arg];
+        return search_value(value, [needle](std::string_view str) {
+            return str.find(needle) != std::string_view::npos;
+        });
+    }
+    case Op::SearchEndsWith: {
+        std::string_view suffix = strings_[inst.arg];
+        return search_value(value, [suffix](std::string_view str) {
+            return str.size() >= suffix.size() &&
+                   str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+        });
+    }
+    case Op::SearchExact: {
+        std::string_view exact = strings_[inst.arg];
+        return search_value(value, [exact](std::string_view str) { return str == exact; });
+    }
+    case Op::SearchStartsWith: {
+        std::string_view prefix = strings_[inst.arg];
+        return search_value(value, [prefix](std::string_view str) {
+            return str.compare(0, prefix.size(), prefix) == 0;
+        });
+    }
+    case Op::Match: {
+        const Pattern& pattern = patterns_[inst.arg];
+        if (value.is_array()) {
+            for (const auto& elem : value.as_array()) {
+                if (match_pattern(pattern, elem)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        return match_pattern(pattern, value);
+    }
+    case Op::Compare:
+        return match_pattern(patterns_[inst.arg], value);
+    case Op::Nested: {
+        if (!value.is_object()) {
+            return false;
+        }
+        ValueDocument nested_doc(value);
+        return solve(nested_[inst.arg], nested_doc);
+    }
+    case Op::Const:
+    case Op::Tree:
+    case Op::Shared:
+        break;
+    }
+    return false;
+}
+
+bool Program::run(const Document& document, PredicateMemo* memo) const {
+    const auto end = static_cast<std::uint32_t>(code_.size());
+    std::uint32_t pc = 0;
+    while (pc < end) {
+        const Inst& inst = code_[pc];
+        pc = test(inst, document, memo) ? inst.on_true : inst.on_false;
+    }
+    return pc == end;
+}
+
+Program compile_program(const Expression& expression) {
+    return compile_program(expression, nullptr);
+}
+
+Program compile_program(const Expression& expression, const std::shared_ptr<Predicates>& shared) {
+    Program program;
+    Program::Compiler(program, shared.get()).compile(expression);
+    program.shared_ = shared;
+    return program;
+}
+
+Program compile_program(const Detection& detection) {
+    return compile_program(detection, nullptr);
+}
+
+Program compile_program(const Detection& detection, const std::shared_ptr<Predicates>& shared) {
+    if (!detection.identifiers.empty()) {
+        return compile_program(coalesce(clone(detection.expression), detection.identifiers),
+                               shared);
+    }
+    return compile_program(detection.expression, shared);
+}
+
+bool solve(const Program& program, const Document& document) {
+    return program.run(document, nullptr);
+}
+
+bool solve(const Program& program, const Document& document, PredicateMemo& memo) {
+    return program.run(document, &memo);
+}
+
 // ============================================================================
 // Parser
 // ============================================================================
@@ -656,11 +1171,7 @@ std::optional<IdentifierResult> parse_identifier_string(std::string_view str) {
         PatternRegex result;
         result.pattern = pattern;
         try {
-            auto flags = std::regex::ECMAScript;
-            if (ignore_case) {
-                flags |= std::regex::icase;
-            }
-            result.regex = std::regex(pattern, flags);
+            result.regex = compile_regex(pattern, ignore_case);
         } catch (...) {
             return std::nullopt;
         }
@@ -849,11 +1360,7 @@ std::optional<Expression> parse_kv(std::string_view kv) {
                 SearchRegex sr;
                 sr.pattern = pat.pattern;
                 sr.ignore_case = id_result->ignore_case;
-                auto flags = std::regex::ECMAScript;
-                if (id_result->ignore_case) {
-                    flags |= std::regex::icase;
-                }
-                sr.regex = std::regex(pat.pattern, flags);
+                sr.regex = pat.regex;
                 es.search = std::move(sr);
                 es.field = field_name;
                 es.cast_to_str = cast_to_str;
@@ -882,6 +1389,7 @@ std::optional<Expression> parse_kv(std::string_view kv) {
                     }
                     ac.match_types.push_back(std::move(entry));
                     ac.ignore_case = true;
+                    compile(ac);
                     es.search = std::move(ac);
                 } else {
                     // Case-sensitive
@@ -917,6 +1425,91 @@ std::optional<Expression> parse_kv(std::string_view kv) {
 // Optimiser
 // ============================================================================
 
+void compile(SearchAhoCorasick& search) {
+    search.automaton = std::make_shared<AhoCorasick>(search.match_types, search.ignore_case);
+}
+
+namespace {
+
+/// Запись автомата для простого поиска (регистр учитывается)
+std::optional<MatchTypeEntry> match_type_entry(const Search& search) {
+    if (const auto* s = std::get_if<SearchContains>(&search)) {
+        return MatchTypeEntry{MatchType::Contains, s->value};
+    }
+    if (const auto* s = std::get_if<SearchEndsWith>(&search)) {
+        return MatchTypeEntry{MatchType::EndsWith, s->value};
+    }
+    if (const auto* s = std::get_if<SearchExact>(&search)) {
+        return MatchTypeEntry{MatchType::Exact, s->value};
+    }
+    if (const auto* s = std::get_if<SearchStartsWith>(&search)) {
+        return MatchTypeEntry{MatchType::StartsWith, s->value};
+    }
+    return std::nullopt;
+}
+
+/// Объединить строковые поиски одного поля в OR группе в один автомат
+///
+/// Поиски сливаются, если совпадают поле, cast_to_str и учёт регистра. OR по
+/// записям и OR по элементам массива перестановочны, поэтому результат тот же.
+/// Объединённый поиск занимает место первого из слитых.
+ExpressionVec merge_or_searches(ExpressionVec expressions) {
+    struct Merged {
+        std::size_t position;  // объединённый поиск в result
+        bool ignore_case;
+        SearchAhoCorasick search;
+        std::size_t count;
+    };
+    std::vector<Merged> merged;
+    ExpressionVec result;
+    result.reserve(expressions.size());
+
+    for (auto& expr : expressions) {
+        auto* search = std::get_if<ExprSearch>(&expr.data);
+        auto* ac = search ? std::get_if<SearchAhoCorasick>(&search->search) : nullptr;
+        std::optional<MatchTypeEntry> plain;
+        if (search && !ac) {
+            plain = match_type_entry(search->search);
+        }
+        if (!ac && !plain) {
+            result.push_back(std::move(expr));
+            continue;
+        }
+
+        bool ignore_case = ac && ac->ignore_case;
+        auto it = std::find_if(merged.begin(), merged.end(), [&](const Merged& m) {
+            const auto& first = std::get<ExprSearch>(result[m.position].data);
+            return m.ignore_case == ignore_case && first.cast_to_str == search->cast_to_str &&
+                   first.field.str() == search->field.str();
+        });
+        if (it == merged.end()) {
+            it = merged.insert(merged.end(), Merged{result.size(), ignore_case, {}, 0});
+            it->search.ignore_case = ignore_case;
+        }
+        if (ac) {
+            it->search.match_types.insert(it->search.match_types.end(), ac->match_types.begin(),
+                                          ac->match_types.end());
+        } else {
+            it->search.match_types.push_back(std::move(*plain));
+        }
+        // Первый поиск поля остаётся на своём месте, следующие в него сливаются
+        if (++it->count == 1) {
+            result.push_back(std::move(expr));
+        }
+    }
+
+    for (auto& m : merged) {
+        if (m.count < 2) {
+            continue;
+        }
+        compile(m.search);
+        std::get<ExprSearch>(result[m.position].data).search = std::move(m.search);
+    }
+    return result;
+}
+
+}  // namespace
+
 Expression coalesce(Expression expr,
                     const std::unordered_map<std::string, Expression>& identifiers) {
     return std::visit(
@@ -1023,6 +1616,10 @@ Expression shake(Expression expr) {
                     new_exprs.push_back(std::move(shaken));
                 }
 
+                if (e.op == BoolSym::Or) {
+                    new_exprs = merge_or_searches(std::move(new_exprs));
+                }
+
                 // Single element -> unwrap
                 if (new_exprs.size() == 1) {
                     return std::move(new_exprs[0]);
@@ -1053,6 +1650,13 @@ Expression shake(Expression expr) {
                 result.pattern = std::move(e.pattern);
                 result.inner = std::make_unique<Expression>(shake(std::move(*e.inner)));
                 return Expression(std::move(result));
+            } else if constexpr (std::is_same_v<T, ExprSearch>) {
+                if (auto* ac = std::get_if<SearchAhoCorasick>(&e.search)) {
+                    if (!ac->automaton) {
+                        compile(*ac);
+                    }
+                }
+                return Expression(std::move(e));
             } else {
                 return Expression(std::move(e));
             }
@@ -1238,9 +1842,8 @@ Expression update_fields(Expression expr,
                 return Expression(std::move(e));
             } else if constexpr (std::is_same_v<T, ExprNested>) {
                 auto it = lookup.find(e.field);
-                std::string new_field = (it != lookup.end()) ? it->second : e.field;
                 ExprNested result;
-                result.field = std::move(new_field);
+                result.field = (it != lookup.end()) ? FieldPath(it->second) : std::move(e.field);
                 result.inner =
                     std::make_unique<Expression>(update_fields(std::move(*e.inner), lookup));
                 return Expression(std::move(result));
@@ -1261,10 +1864,10 @@ Expression update_fields(Expression expr,
                 }
                 return Expression(std::move(e));
             } else if constexpr (std::is_same_v<T, ExprMatrix>) {
-                std::vector<std::string> new_fields;
-                for (const auto& f : e.fields) {
+                std::vector<FieldPath> new_fields;
+                for (auto& f : e.fields) {
                     auto it = lookup.find(f);
-                    new_fields.push_back(it != lookup.end() ? it->second : f);
+                    new_fields.push_back(it != lookup.end() ? FieldPath(it->second) : std::move(f));
                 }
                 ExprMatrix result;
                 result.fields = std::move(new_fields);
@@ -1333,7 +1936,7 @@ std::string make_indent(int level) {
 void serialize_expr_to_stream(std::ostream& os, const Expression& expr, int indent);
 
 void serialize_search_to_stream(std::ostream& os, const ExprSearch& search, int indent_level) {
-    os << make_indent(indent_level) << search.field << ": ";
+    os << make_indent(indent_level) << search.field.str() << ": ";
 
     std::visit(
         [&os, indent_level](const auto& s) {
@@ -1437,7 +2040,7 @@ void serialize_expr_to_stream(std::ostream& os, const Expression& expr, int inde
                 // Pattern match on inner expression
                 serialize_expr_to_stream(os, *e.inner, indent);
             } else if constexpr (std::is_same_v<T, ExprField>) {
-                os << make_indent(indent) << e.name << ": *\n";
+                os << make_indent(indent) << e.name.str() << ": *\n";
             } else if constexpr (std::is_same_v<T, ExprBoolean>) {
                 os << make_indent(indent) << (e.value ? "true" : "false") << "\n";
             } else if constexpr (std::is_same_v<T, ExprInteger>) {
@@ -1457,9 +2060,9 @@ void serialize_expr_to_stream(std::ostream& os, const Expression& expr, int inde
                 std::string cast_name = (e.mod == ModSym::Int)   ? "int"
                                         : (e.mod == ModSym::Str) ? "str"
                                                                  : "flt";
-                os << make_indent(indent) << cast_name << "(" << e.field << ")\n";
+                os << make_indent(indent) << cast_name << "(" << e.field.str() << ")\n";
             } else if constexpr (std::is_same_v<T, ExprNested>) {
-                os << make_indent(indent) << e.field << ":\n";
+                os << make_indent(indent) << e.field.str() << ":\n";
                 serialize_expr_to_stream(os, *e.inner, indent + 1);
             } else if constexpr (std::is_same_v<T, ExprMatrix>) {
                 // Matrix - multi-field match
@@ -1470,7 +2073,7 @@ void serialize_expr_to_stream(std::ostream& os, const Expression& expr, int inde
                     for (size_t j = 0; j < patterns.size() && j < e.fields.size(); ++j) {
                         if (j > 0)
                             os << ", ";
-                        os << e.fields[j] << "=" << pattern_to_string(patterns[j]);
+                        os << e.fields[j].str() << "=" << pattern_to_string(patterns[j]);
                     }
                     os << "\n";
                 }
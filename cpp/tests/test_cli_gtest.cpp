@@ -139,6 +139,34 @@ TEST(CliTest, Parse_NoBanner_SetsGlobalOption) {
     EXPECT_TRUE(result.global.no_banner);
 }
 
+TEST(CliTest, Parse_NumThreads_SetsGlobalOption) {
+    // Arrange
+    // CLI-0001: --num-threads <NUM_THREADS> — значение не должно считаться подкомандой
+    Args args{"chainsaw", "--num-threads", "4", "dump", "test.evtx"};
+    Args inline_args{"chainsaw", "--num-threads=2", "dump", "test.evtx"};
+
+    // Act
+    ParseResult result = parse(args.argc(), args.argv());
+    ParseResult inline_result = parse(inline_args.argc(), inline_args.argv());
+
+    // Assert
+    EXPECT_TRUE(result.ok);
+    EXPECT_EQ(result.global.num_threads, 4);
+    EXPECT_TRUE(std::holds_alternative<DumpCommand>(result.command));
+    EXPECT_TRUE(inline_result.ok);
+    EXPECT_EQ(inline_result.global.num_threads, 2);
+}
+
+TEST(CliTest, Parse_NumThreads_InvalidValue) {
+    Args args{"chainsaw", "--num-threads", "many", "dump", "test.evtx"};
+    ParseResult result = parse(args.argc(), args.argv());
+    EXPECT_FALSE(result.ok);
+    EXPECT_EQ(result.diagnostic.exit_code, 2);
+    EXPECT_NE(result.diagnostic.stderr_message.find(
+                  "error: invalid value 'many' for '--num-threads <NUM_THREADS>'"),
+              std::string::npos);
+}
+
 // ==============================================================================
 // TST-CLI-004: Команда dump
 // ==============================================================================
@@ -2,14 +2,17 @@
 // test_hunt_gtest.cpp - Unit Tests for SLICE-012 Hunt Command
 // ==============================================================================
 //
-// Tests: TST-HUNT-001..025 from SPEC-SLICE-012
+// Tests: TST-HUNT-001..033 from SPEC-SLICE-012
 //
 // ==============================================================================
 
+#include <chainsaw/detection_cache.hpp>
 #include <chainsaw/hunt.hpp>
 #include <chainsaw/platform.hpp>
 #include <chainsaw/rule.hpp>
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -18,6 +21,7 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
 
@@ -409,6 +413,764 @@ TEST_F(HuntTestFixture, TST_HUNT_015_ContainerKvParsing) {
     EXPECT_EQ(mapper.mode(), hunt::MapperMode::Full);
 }
 
+// ============================================================================
+// TST-HUNT-026: Mapper::find — ссылка при переименовании, значение при cast
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_026_MapperFindBorrows) {
+    Value value = Value::make_object();
+    value.set("Image", Value(std::string("cmd.exe")));
+    value.set("EventID", Value(std::string("4688")));
+    value.set("kv_container", Value(std::string("a=1;kv_value=2")));
+    tau::ValueDocument doc(value);
+
+    std::vector<rule::Field> fields;
+    rule::Field rename;
+    rename.from = "Process";
+    rename.to = "Image";
+    fields.push_back(rename);
+    rule::Field cast;
+    cast.from = "EventID";
+    cast.to = "EventID";
+    cast.cast = tau::ModSym::Int;
+    fields.push_back(cast);
+    rule::Field kv_field;
+    kv_field.from = "kv_value";
+    kv_field.to = "kv_value";
+    rule::Container c;
+    c.field = "kv_container";
+    c.format = rule::ContainerFormat::Kv;
+    rule::KvFormat kv;
+    kv.delimiter = ";";
+    kv.separator = "=";
+    c.kv_params = kv;
+    kv_field.container = c;
+    fields.push_back(kv_field);
+
+    auto mapper = hunt::Mapper::from(std::move(fields));
+    hunt::MappedDocument mapped(doc, mapper);
+
+    // Переименование и поле без отображения — ссылки на значения документа
+    EXPECT_EQ(mapped.lookup("Process").get(), value.get("Image"));
+    EXPECT_EQ(mapped.lookup("Image").get(), value.get("Image"));
+
+    // Cast и container — вычисленные значения
+    auto event_id = mapped.lookup("EventID");
+    ASSERT_TRUE(event_id);
+    EXPECT_NE(event_id.get(), value.get("EventID"));
+    EXPECT_EQ(event_id->as_int(), 4688);
+    auto kv_value = mapped.lookup("kv_value");
+    ASSERT_TRUE(kv_value);
+    EXPECT_EQ(kv_value->as_string(), "2");
+
+    EXPECT_FALSE(mapped.lookup("Missing"));
+
+    // Разобранный путь: отображение по номеру ключа, тот же результат
+    EXPECT_EQ(mapped.resolve(tau::FieldPath("Process")).get(), value.get("Image"));
+    EXPECT_EQ(mapped.resolve(tau::FieldPath("EventID"))->as_int(), 4688);
+    EXPECT_EQ(mapped.resolve(tau::FieldPath("kv_value"))->as_string(), "2");
+    EXPECT_FALSE(mapped.resolve(tau::FieldPath("Missing")));
+}
+
+// ============================================================================
+// TST-HUNT-027: RuleIndex - отбор правил по обязательным равенствам
+// ============================================================================
+
+namespace {
+
+tau::Expression exact(const char* field, const char* value) {
+    return tau::Expression(
+        tau::ExprSearch{tau::SearchExact{value}, tau::FieldPath(field), false});
+}
+
+tau::Expression group(tau::BoolSym op, tau::Expression left, tau::Expression right) {
+    std::vector<tau::Expression> exprs;
+    exprs.push_back(std::move(left));
+    exprs.push_back(std::move(right));
+    return tau::Expression(tau::ExprBooleanGroup{op, std::move(exprs)});
+}
+
+}  // namespace
+
+TEST_F(HuntTestFixture, TST_HUNT_027_RuleIndexCandidates) {
+    tau::SearchAhoCorasick channels{{{tau::MatchType::Exact, "security"},
+                                     {tau::MatchType::Exact, "system"}},
+                                    true,
+                                    nullptr};
+    tau::SearchAhoCorasick images{{{tau::MatchType::EndsWith, "cmd.exe"}}, false, nullptr};
+
+    std::vector<tau::Expression> exprs;
+    // 0: And - равенство EventID
+    tau::Expression image(tau::ExprSearch{images, tau::FieldPath("Image"), false});
+    exprs.push_back(group(tau::BoolSym::And, exact("EventID", "4688"), std::move(image)));
+    // 1: Or по одному полю - значения объединяются
+    exprs.push_back(group(tau::BoolSym::Or, exact("EventID", "1"), exact("EventID", "4688")));
+    // 2: Or по разным полям - равенства нет
+    exprs.push_back(group(tau::BoolSym::Or, exact("EventID", "1"), exact("Image", "x")));
+    // 3: без учёта регистра
+    exprs.push_back(tau::Expression(
+        tau::ExprSearch{channels, tau::FieldPath("Channel"), false}));
+
+    auto equalities = hunt::required_equalities(exprs[1]);
+    ASSERT_EQ(equalities.size(), 1u);
+    EXPECT_EQ(equalities[0].field.str(), "EventID");
+    EXPECT_EQ(equalities[0].exact, (std::vector<std::string>{"1", "4688"}));
+    EXPECT_TRUE(hunt::required_equalities(exprs[2]).empty());
+    equalities = hunt::required_equalities(exprs[3]);
+    ASSERT_EQ(equalities.size(), 1u);
+    EXPECT_EQ(equalities[0].folded, (std::vector<std::string>{"security", "system"}));
+
+    std::vector<const tau::Expression*> filters;
+    for (const auto& expr : exprs) {
+        filters.push_back(&expr);
+    }
+    filters.push_back(nullptr);  // 4: не разбирается
+    hunt::RuleIndex index(filters);
+    EXPECT_EQ(index.indexed(), 3u);
+    EXPECT_EQ(index.residual(), 2u);
+
+    auto candidates = [&index](const Value& value) {
+        tau::ValueDocument doc(value);
+        std::vector<std::uint32_t> out;
+        index.candidates(doc, out);
+        return out;
+    };
+    using Ids = std::vector<std::uint32_t>;
+
+    Value event = Value::make_object();
+    event.set("EventID", Value(std::int64_t{4688}));
+    event.set("Channel", Value(std::string("Security")));
+    EXPECT_EQ(candidates(event), (Ids{0, 1, 2, 3, 4}));
+
+    event.set("EventID", Value(std::string("1")));
+    event.set("Channel", Value(std::string("Application")));
+    EXPECT_EQ(candidates(event), (Ids{1, 2, 4}));
+
+    // Массив: любой элемент
+    Value ids = Value::make_array();
+    ids.push_back(Value(std::string("7")));
+    ids.push_back(Value(std::string("4688")));
+    Value multi = Value::make_object();
+    multi.set("EventID", std::move(ids));
+    EXPECT_EQ(candidates(multi), (Ids{0, 1, 2, 4}));
+
+    EXPECT_EQ(candidates(Value::make_object()), (Ids{2, 4}));
+
+    // Правило из YAML: EventID: 4688 — сравнение с числом, равенство по тексту числа
+    auto rule_path = create_json_file(R"(
+title: Process Creation
+group: Test
+description: EventID-gated rule
+authors: [Test]
+kind: evtx
+level: info
+status: stable
+timestamp: Event.System.TimeCreated
+fields:
+  - name: Event ID
+    to: Event.System.EventID
+filter:
+  condition: selection
+  selection:
+    Event.System.EventID: 4688
+    Event.EventData.CommandLine: '*whoami*'
+)",
+                                      "rule.yml");
+    auto loaded = rule::load(rule::Kind::Chainsaw, rule_path);
+    ASSERT_TRUE(loaded.ok) << loaded.error.format();
+    ASSERT_EQ(loaded.rules.size(), 1u);
+    const auto& filter = std::get<rule::ChainsawRule>(loaded.rules[0]).filter;
+    const auto* detection = std::get_if<tau::Detection>(&filter);
+    const tau::Expression& loaded_expr =
+        detection ? detection->expression : std::get<tau::Expression>(filter);
+    ASSERT_TRUE(detection == nullptr || detection->identifiers.empty());
+
+    equalities = hunt::required_equalities(loaded_expr);
+    ASSERT_EQ(equalities.size(), 1u);
+    EXPECT_EQ(equalities[0].field.str(), "Event.System.EventID");
+    EXPECT_EQ(equalities[0].numeric, (std::vector<std::string>{"4688"}));
+
+    hunt::RuleIndex loaded_index({&loaded_expr});
+    EXPECT_EQ(loaded_index.indexed(), 1u);
+    auto loaded_candidates = [&loaded_index](Value event_id_value) {
+        Value system = Value::make_object();
+        system.set("EventID", std::move(event_id_value));
+        Value root = Value::make_object();
+        root.set("System", std::move(system));
+        Value document = Value::make_object();
+        document.set("Event", std::move(root));
+        tau::ValueDocument doc(document);
+        std::vector<std::uint32_t> out;
+        loaded_index.candidates(doc, out);
+        return out.size();
+    };
+    // Число сравнивается через value_to_double: целое, строка, 4688.0
+    EXPECT_EQ(loaded_candidates(Value(std::uint64_t{4688})), 1u);
+    EXPECT_EQ(loaded_candidates(Value(std::string("4688"))), 1u);
+    EXPECT_EQ(loaded_candidates(Value(4688.0)), 1u);
+    EXPECT_EQ(loaded_candidates(Value(std::int64_t{4624})), 0u);
+    EXPECT_EQ(hunt::number_key(-0.0), "0");
+    EXPECT_EQ(hunt::number_key(1.5), "1.5");
+}
+
+// ============================================================================
+// TST-HUNT-028: MapperCache - контейнеры и поля разбираются раз на документ
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_028_MapperCache) {
+    std::vector<rule::Field> fields;
+    auto add = [&fields](const char* from, const char* to, std::optional<rule::Container> c,
+                         std::optional<tau::ModSym> cast) {
+        rule::Field field;
+        field.from = from;
+        field.to = to;
+        field.container = std::move(c);
+        field.cast = cast;
+        fields.push_back(std::move(field));
+    };
+    rule::Container json;
+    json.field = "payload";
+    json.format = rule::ContainerFormat::Json;
+    rule::Container kv;
+    kv.field = "kv";
+    kv.format = rule::ContainerFormat::Kv;
+    kv.kv_params = rule::KvFormat{";", "=", true};
+    add("User", "user", json, std::nullopt);
+    add("Host", "host", json, std::nullopt);
+    add("First", "a", kv, std::nullopt);
+    add("Count", "count", std::nullopt, tau::ModSym::Int);
+    auto mapper = hunt::Mapper::from(std::move(fields));
+    ASSERT_EQ(mapper.mode(), hunt::MapperMode::Full);
+
+    auto make = [](const char* payload, const char* pairs, const char* count) {
+        Value value = Value::make_object();
+        value.set("payload", Value(std::string(payload)));
+        value.set("kv", Value(std::string(pairs)));
+        value.set("count", Value(std::string(count)));
+        return value;
+    };
+
+    hunt::MapperCache cache;
+    Value first = make(R"({"user": "alice", "host": "ws1"})", " a=1 ; b=2 ; a=3", "7");
+    tau::ValueDocument first_doc(first);
+    hunt::MappedDocument plain(first_doc, mapper);
+    cache.clear();
+    hunt::MappedDocument cached(first_doc, mapper, cache);
+
+    // Результаты совпадают с вычислением без кэша
+    for (const char* key : {"User", "Host", "First", "Count", "payload", "Missing"}) {
+        auto expected = plain.lookup(key);
+        auto actual = cached.lookup(key);
+        ASSERT_EQ(static_cast<bool>(expected), static_cast<bool>(actual)) << key;
+        if (expected) {
+            EXPECT_EQ(tau::value_to_string(*expected), tau::value_to_string(*actual)) << key;
+        }
+    }
+    EXPECT_EQ(cached.resolve(tau::FieldPath("First"))->as_string(), "1");
+    EXPECT_EQ(cached.resolve(tau::FieldPath("Count"))->as_int(), 7);
+
+    // Повторный поиск — ссылка на то же значение в кэше
+    EXPECT_EQ(cached.lookup("User").get(), cached.resolve(tau::FieldPath("User")).get());
+    EXPECT_EQ(cached.lookup("Count").get(), cached.lookup("Count").get());
+
+    // После clear() - значения следующего документа
+    Value second = make("not json", "b=5", "x");
+    tau::ValueDocument second_doc(second);
+    cache.clear();
+    hunt::MappedDocument next(second_doc, mapper, cache);
+    EXPECT_FALSE(next.lookup("User"));
+    EXPECT_FALSE(next.lookup("First"));
+    EXPECT_EQ(next.lookup("Count")->as_string(), "x");
+}
+
+// ============================================================================
+// TST-HUNT-029: Конвейер hunt - тот же результат, что и последовательно
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_029_PipelineMatchesSerial) {
+    rule::ChainsawRule single;
+    single.name = "Single";
+    single.group = "Test";
+    single.kind = io::DocumentKind::Json;
+    single.filter = exact("kind", "a");
+    single.timestamp = "@timestamp";
+
+    rule::Aggregate agg;
+    agg.fields = {"user"};
+    agg.count = tau::PatternGreaterThanOrEqual{2};
+    rule::ChainsawRule grouped;
+    grouped.name = "Grouped";
+    grouped.group = "Test";
+    grouped.kind = io::DocumentKind::Json;
+    grouped.filter = exact("kind", "b");
+    grouped.timestamp = "@timestamp";
+    grouped.aggregate = agg;
+
+    std::vector<rule::Rule> rules;
+    rules.emplace_back(std::move(single));
+    rules.emplace_back(std::move(grouped));
+    auto result = hunt::HunterBuilder::create().rules(std::move(rules)).batch_size(4).build();
+    ASSERT_TRUE(result.ok);
+    const auto& hunter = *result.hunter;
+    EXPECT_EQ(hunter.batch_size(), 4u);
+
+    // 41 документ: неполный последний пакет, совпадения в разных пакетах
+    std::string content = "[";
+    for (int i = 0; i < 41; ++i) {
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "2024-01-01T00:%02d:%02dZ", i / 60, i % 60);
+        content += std::string(i > 0 ? "," : "") + R"({"@timestamp": ")" + timestamp +
+                   R"(", "kind": ")" + (i % 3 == 0 ? "a" : "b") + R"(", "user": "u)" +
+                   std::to_string(i % 5) + R"(", "n": )" + std::to_string(i) + "}";
+    }
+    content += "]";
+    auto json_path = create_json_file(content);
+
+    auto render = [&hunter](const hunt::Hunter::HuntResult& hunt_result) {
+        std::vector<std::string> lines;
+        for (const auto& det : hunt_result.detections) {
+            lines.push_back(hunt::detections_to_jsonl(det, hunter.hunts(), hunter.rules()));
+        }
+        return lines;
+    };
+
+    auto serial = hunter.hunt(json_path, nullptr, 1);
+    ASSERT_TRUE(serial.ok) << serial.error;
+    EXPECT_EQ(serial.detections.size(), 14u + 5u);  // i % 3 == 0 и группы user
+    for (std::size_t threads : {2u, 3u, 8u}) {
+        auto piped = hunter.hunt(json_path, nullptr, threads);
+        ASSERT_TRUE(piped.ok) << piped.error;
+        EXPECT_EQ(render(piped), render(serial)) << "threads " << threads;
+    }
+
+    // Ошибка документа останавливает hunt так же, как последовательный
+    auto broken = content;
+    broken.replace(broken.find("2024-01-01T00:00:30Z"), 20, "not-a-timestamp-here");
+    auto broken_path = create_json_file(broken, "broken.json");
+    auto serial_error = hunter.hunt(broken_path, nullptr, 1);
+    auto piped_error = hunter.hunt(broken_path, nullptr, 3);
+    EXPECT_FALSE(serial_error.ok);
+    EXPECT_FALSE(piped_error.ok);
+    EXPECT_EQ(piped_error.error, serial_error.error);
+}
+
+// ============================================================================
+// TST-HUNT-030: Группы агрегации - точный ключ по всем полям
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_030_AggregationGroupsByExactKey) {
+    rule::Aggregate agg;
+    agg.fields = {"a", "b"};
+    agg.count = tau::PatternGreaterThanOrEqual{2};
+    rule::ChainsawRule grouped;
+    grouped.name = "Grouped";
+    grouped.group = "Test";
+    grouped.kind = io::DocumentKind::Json;
+    grouped.filter = exact("kind", "b");
+    grouped.timestamp = "@timestamp";
+    grouped.aggregate = agg;
+
+    std::vector<rule::Rule> rules;
+    rules.emplace_back(std::move(grouped));
+    auto result = hunt::HunterBuilder::create().rules(std::move(rules)).build();
+    ASSERT_TRUE(result.ok);
+
+    auto document = [](int n, const std::string& a, const std::string& b) {
+        return std::string(n > 0 ? "," : "") + R"({"@timestamp": "2024-01-01T00:00:0)" +
+               std::to_string(n) + R"(Z", "kind": "b", "a": ")" + a + R"(", "b": ")" + b +
+               R"(", "n": ")" + std::to_string(n) + R"("})";
+    };
+
+    // Переставленные и попарно равные значения — разные группы
+    auto distinct_path = create_json_file("[" + document(0, "x", "y") + document(1, "y", "x") +
+                                              document(2, "x", "x") + document(3, "y", "y") +
+                                              document(4, "xy", "") + document(5, "x", "y:") +
+                                              "]",
+                                          "distinct.json");
+    auto distinct = result.hunter->hunt(distinct_path);
+    ASSERT_TRUE(distinct.ok) << distinct.error;
+    EXPECT_TRUE(distinct.detections.empty());
+
+    // Группы выдаются в порядке первого документа, документы — в порядке чтения
+    auto same_path = create_json_file("[" + document(0, "p", "q") + document(1, "x", "y") +
+                                          document(2, "p", "q") + document(3, "x", "y") + "]",
+                                      "same.json");
+    auto same = result.hunter->hunt(same_path);
+    ASSERT_TRUE(same.ok) << same.error;
+    ASSERT_EQ(same.detections.size(), 2u);
+    std::vector<std::vector<std::string>> groups;
+    for (const auto& det : same.detections) {
+        const auto* aggregate = std::get_if<hunt::KindAggregate>(&det.kind);
+        ASSERT_NE(aggregate, nullptr);
+        groups.emplace_back();
+        for (const auto& doc : aggregate->documents) {
+            groups.back().push_back(doc.data.get("a")->as_string() +
+                                    doc.data.get("n")->as_string());
+        }
+    }
+    EXPECT_EQ(groups, (std::vector<std::vector<std::string>>{{"p0", "p2"}, {"x1", "x3"}}));
+}
+
+// ============================================================================
+// TST-HUNT-031: Агрегация с окном времени (Sigma timeframe)
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_031_WindowedAggregation) {
+    auto windowed = [](const char* name, tau::Pattern count) {
+        rule::Aggregate agg;
+        agg.fields = {"user"};
+        agg.count = count;
+        agg.timeframe = std::chrono::minutes(1);
+        rule::ChainsawRule rule;
+        rule.name = name;
+        rule.group = "Test";
+        rule.kind = io::DocumentKind::Json;
+        rule.filter = exact("kind", name);
+        rule.timestamp = "@timestamp";
+        rule.aggregate = agg;
+        return rule;
+    };
+
+    std::vector<rule::Rule> rules;
+    rules.emplace_back(windowed("burst", tau::PatternGreaterThan{2}));
+    rules.emplace_back(windowed("quiet", tau::PatternLessThan{2}));
+    auto result = hunt::HunterBuilder::create().rules(std::move(rules)).build();
+    ASSERT_TRUE(result.ok);
+    const auto& hunter = *result.hunter;
+
+    // Секунды от 00:00:00 — время события
+    std::string content = "[";
+    auto add = [&content](const char* kind, const char* user, int seconds) {
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "2024-01-01T00:%02d:%02dZ", seconds / 60,
+                      seconds % 60);
+        content += std::string(content.size() > 1 ? "," : "") + R"({"@timestamp": ")" +
+                   timestamp + R"(", "kind": ")" + kind + R"(", "user": ")" + user +
+                   R"(", "n": ")" + std::to_string(seconds) + R"("})";
+    };
+    // a: три события за минуту, b: столько же, но реже; в весь файл попали бы обе
+    add("burst", "a", 0);
+    add("burst", "b", 0);
+    add("burst", "a", 20);
+    add("burst", "b", 70);
+    add("burst", "a", 40);
+    add("burst", "a", 50);
+    add("burst", "b", 140);
+    // c: окно [0, 60] — два события, [200, 260] — одно
+    add("quiet", "c", 0);
+    add("quiet", "c", 30);
+    add("quiet", "c", 200);
+    content += "]";
+    auto json_path = create_json_file(content);
+
+    for (std::size_t threads : {1u, 3u}) {
+        auto hunted = hunter.hunt(json_path, nullptr, threads);
+        ASSERT_TRUE(hunted.ok) << hunted.error;
+
+        std::vector<std::vector<std::string>> windows;
+        for (const auto& det : hunted.detections) {
+            const auto* aggregate = std::get_if<hunt::KindAggregate>(&det.kind);
+            ASSERT_NE(aggregate, nullptr);
+            windows.emplace_back();
+            for (const auto& doc : aggregate->documents) {
+                windows.back().push_back(doc.data.get("user")->as_string() +
+                                         doc.data.get("n")->as_string());
+            }
+        }
+        // Окно a закрывается на третьем событии; четвёртое начинает новое
+        EXPECT_EQ(windows, (std::vector<std::vector<std::string>>{{"a0", "a20", "a40"},
+                                                                  {"c200"}}))
+            << "threads " << threads;
+        ASSERT_EQ(hunted.detections.size(), 2u);
+        EXPECT_EQ(hunted.detections[0].hits[0].timestamp.second, 0);
+        EXPECT_EQ(hunted.detections[1].hits[0].timestamp.minute, 3);
+    }
+}
+
+// ============================================================================
+// TST-HUNT-032: Cache-to-disk - документы в файле, вывод тот же
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_032_DetectionCache) {
+    auto make_rules = [] {
+        rule::ChainsawRule single;
+        single.name = "Single";
+        single.group = "Test";
+        single.kind = io::DocumentKind::Json;
+        single.filter = exact("kind", "a");
+        single.timestamp = "@timestamp";
+
+        rule::Aggregate agg;
+        agg.fields = {"user"};
+        agg.count = tau::PatternGreaterThanOrEqual{2};
+        rule::ChainsawRule grouped;
+        grouped.name = "Grouped";
+        grouped.group = "Test";
+        grouped.kind = io::DocumentKind::Json;
+        grouped.filter = exact("kind", "b");
+        grouped.timestamp = "@timestamp";
+        grouped.aggregate = agg;
+
+        std::vector<rule::Rule> rules;
+        rules.emplace_back(std::move(single));
+        rules.emplace_back(std::move(grouped));
+        return rules;
+    };
+    auto result = hunt::HunterBuilder::create().rules(make_rules()).batch_size(4).build();
+    ASSERT_TRUE(result.ok);
+    const auto& hunter = *result.hunter;
+
+    std::string content = "[";
+    for (int i = 0; i < 20; ++i) {
+        content += std::string(i > 0 ? "," : "") + R"({"@timestamp": "2024-01-01T00:00:)" +
+                   (i < 10 ? "0" : "") + std::to_string(i) + R"(Z", "kind": ")" +
+                   (i % 3 == 0 ? "a" : "b") + R"(", "user": "u)" + std::to_string(i % 4) +
+                   R"(", "n": )" + std::to_string(i) + R"(, "x": 0.1})";
+    }
+    content += "]";
+    auto json_path = create_json_file(content);
+
+    auto render = [&hunter](const hunt::Hunter::HuntResult& hunt_result,
+                            hunt::DetectionCache* cache) {
+        std::vector<std::string> lines;
+        for (const auto& det : hunt_result.detections) {
+            lines.push_back(
+                hunt::detections_to_jsonl(det, hunter.hunts(), hunter.rules(), false, cache));
+        }
+        return lines;
+    };
+
+    auto in_memory = hunter.hunt(json_path, nullptr, 1);
+    ASSERT_TRUE(in_memory.ok) << in_memory.error;
+    auto expected = render(in_memory, nullptr);
+    ASSERT_EQ(expected.size(), 7u + 4u);
+
+    fs::path cache_path;
+    {
+        hunt::DetectionCache cache;
+        cache_path = cache.path();
+        for (std::size_t threads : {1u, 3u}) {
+            auto cached = hunter.hunt(json_path, &cache, threads);
+            ASSERT_TRUE(cached.ok) << cached.error;
+            std::size_t aggregates = 0;
+            ASSERT_EQ(cached.detections.size(), in_memory.detections.size());
+            for (std::size_t i = 0; i < cached.detections.size(); ++i) {
+                const auto* kind = std::get_if<hunt::KindCached>(&cached.detections[i].kind);
+                ASSERT_NE(kind, nullptr);
+                aggregates += kind->aggregate ? 1 : 0;
+                // Документ агрегации — своя запись кэша, а не копия в памяти
+                const auto* group = std::get_if<hunt::KindAggregate>(&in_memory.detections[i].kind);
+                EXPECT_EQ(kind->records.size(), group ? group->documents.size() : 1u);
+            }
+            EXPECT_EQ(aggregates, 4u);
+            EXPECT_EQ(render(cached, &cache), expected) << "threads " << threads;
+        }
+
+        // Потоковая выдача: отдельные детектирования — с документом, мимо кэша
+        std::vector<hunt::Detections> streamed;
+        auto each = hunter.hunt_each(
+            json_path,
+            [&streamed](hunt::Detections&& det) {
+                streamed.push_back(std::move(det));
+                return true;
+            },
+            &cache, 3);
+        ASSERT_TRUE(each.ok) << each.error;
+        std::size_t individual = 0;
+        for (const auto& det : streamed) {
+            individual += std::holds_alternative<hunt::KindIndividual>(det.kind) ? 1u : 0u;
+        }
+        EXPECT_EQ(individual, 7u);
+        hunt::Hunter::HuntResult streamed_result;
+        streamed_result.detections = std::move(streamed);
+        EXPECT_EQ(render(streamed_result, &cache), expected);
+
+        // Записи вперемешку с чтением: и из отображения, и из хвоста файла
+        for (int i = 0; i < 100; ++i) {
+            std::string late = "{\"late\":" + std::to_string(i) + "}";
+            auto offset = cache.append(late);
+            EXPECT_EQ(cache.read(offset, late.size()), late);
+        }
+        EXPECT_TRUE(fs::exists(cache_path));
+    }
+    EXPECT_FALSE(fs::exists(cache_path));
+
+    // Без документов (вывод таблицей) остаются только hits
+    auto bare = hunt::HunterBuilder::create().rules(make_rules()).documents(false).build();
+    ASSERT_TRUE(bare.ok);
+    auto hits_only = bare.hunter->hunt(json_path, nullptr, 1);
+    ASSERT_TRUE(hits_only.ok) << hits_only.error;
+    ASSERT_EQ(hits_only.detections.size(), expected.size());
+    for (const auto& det : hits_only.detections) {
+        EXPECT_FALSE(det.hits.empty());
+        if (const auto* ind = std::get_if<hunt::KindIndividual>(&det.kind)) {
+            EXPECT_TRUE(ind->document.data.is_null());
+        } else {
+            EXPECT_TRUE(std::get<hunt::KindAggregate>(det.kind).documents.empty());
+        }
+    }
+}
+
+// ============================================================================
+// TST-HUNT-033: Потоковая выдача детектирований (hunt_each)
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_033_StreamingDetections) {
+    rule::ChainsawRule single;
+    single.name = "Single";
+    single.group = "Test";
+    single.kind = io::DocumentKind::Json;
+    single.filter = exact("kind", "a");
+    single.timestamp = "@timestamp";
+
+    rule::Aggregate agg;
+    agg.fields = {"user"};
+    agg.count = tau::PatternGreaterThanOrEqual{2};
+    rule::ChainsawRule grouped;
+    grouped.name = "Grouped";
+    grouped.group = "Test";
+    grouped.kind = io::DocumentKind::Json;
+    grouped.filter = exact("kind", "b");
+    grouped.timestamp = "@timestamp";
+    grouped.aggregate = agg;
+
+    std::vector<rule::Rule> rules;
+    rules.emplace_back(std::move(single));
+    rules.emplace_back(std::move(grouped));
+    auto result = hunt::HunterBuilder::create().rules(std::move(rules)).batch_size(4).build();
+    ASSERT_TRUE(result.ok);
+    const auto& hunter = *result.hunter;
+
+    std::string content = "[";
+    for (int i = 0; i < 20; ++i) {
+        content += std::string(i > 0 ? "," : "") + R"({"@timestamp": "2024-01-01T00:00:)" +
+                   (i < 10 ? "0" : "") + std::to_string(i) + R"(Z", "kind": ")" +
+                   (i % 3 == 0 ? "a" : "b") + R"(", "user": "u)" + std::to_string(i % 4) +
+                   R"("})";
+    }
+    content += "]";
+    auto json_path = create_json_file(content);
+
+    auto render = [&hunter](const hunt::Detections& det) {
+        return hunt::detections_to_jsonl(det, hunter.hunts(), hunter.rules());
+    };
+
+    for (std::size_t threads : {1u, 3u}) {
+        auto whole = hunter.hunt(json_path, nullptr, threads);
+        ASSERT_TRUE(whole.ok) << whole.error;
+        ASSERT_EQ(whole.detections.size(), 7u + 4u);
+
+        // Порядок выдачи совпадает с hunt(): отдельные по документам, затем агрегации
+        std::vector<std::string> streamed;
+        auto each = hunter.hunt_each(
+            json_path,
+            [&](hunt::Detections&& det) {
+                streamed.push_back(render(det));
+                return true;
+            },
+            nullptr, threads);
+        ASSERT_TRUE(each.ok) << each.error;
+        EXPECT_TRUE(each.detections.empty());
+        ASSERT_EQ(streamed.size(), whole.detections.size());
+        for (std::size_t i = 0; i < streamed.size(); ++i) {
+            EXPECT_EQ(streamed[i], render(whole.detections[i])) << "threads " << threads;
+        }
+
+        // false от приёмника останавливает hunt без ошибки
+        std::size_t received = 0;
+        auto stopped = hunter.hunt_each(
+            json_path, [&](hunt::Detections&&) { return ++received < 2; }, nullptr, threads);
+        EXPECT_TRUE(stopped.ok) << stopped.error;
+        EXPECT_EQ(received, 2u) << "threads " << threads;
+    }
+
+    // Таблица по частям совпадает с format_table
+    auto whole = hunter.hunt(json_path, nullptr, 1);
+    std::string table = hunt::format_table_header();
+    for (const auto& det : whole.detections) {
+        std::string row = hunt::format_table_row(det, hunter.hunts(), hunter.rules());
+        EXPECT_EQ(std::count(row.begin(), row.end(), '\n'), 1);
+        table += row;
+    }
+    table += hunt::format_table_footer();
+    EXPECT_EQ(table, hunt::format_table(whole.detections, hunter.hunts(), hunter.rules()));
+    EXPECT_EQ(hunt::format_table({}, hunter.hunts(), hunter.rules()), "");
+}
+
+// ============================================================================
+// TST-HUNT-034: Команда hunt с --skip-errors — строки файла до ошибки выводятся
+// ============================================================================
+
+TEST_F(HuntTestFixture, TST_HUNT_034_SkipErrorsCommand) {
+    std::ofstream(temp_dir_ / "rule.yml") << R"yaml(
+title: Logon
+group: Test
+description: Logon
+authors:
+  - Test
+kind: json
+level: low
+status: stable
+timestamp: time
+fields:
+  - name: User
+    to: user
+filter:
+  condition: logon
+  logon:
+    id: 4624
+)yaml";
+    create_json_file(R"([{"time": "2024-01-01T00:00:00Z", "id": 4624, "user": "alpha"},
+                         {"time": "bad", "id": 4624, "user": "bravo"},
+                         {"time": "2024-01-01T00:00:02Z", "id": 4624, "user": "charlie"}])",
+                     "mixed.json");
+    create_json_file(R"([{"time": "2024-01-01T00:00:03Z", "id": 4624, "user": "delta"}])",
+                     "good.json");
+
+    // Код возврата, stdout и stderr команды
+    struct Run {
+        int status = -1;
+        std::string out;
+        std::string err;
+    };
+    auto run = [this](const std::string& options) {
+        auto slurp = [](const fs::path& path) {
+            std::ifstream in(path, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(in), {});
+        };
+        std::string command = std::string("\"") + CHAINSAW_EXECUTABLE + "\" hunt --jsonl -r \"" +
+                              (temp_dir_ / "rule.yml").string() + "\" \"" +
+                              (temp_dir_ / "mixed.json").string() + "\" \"" +
+                              (temp_dir_ / "good.json").string() + "\" " + options + " > \"" +
+                              (temp_dir_ / "out.txt").string() + "\" 2> \"" +
+                              (temp_dir_ / "err.txt").string() + "\"";
+        Run result;
+        result.status = std::system(command.c_str());
+#ifndef _WIN32
+        result.status = WIFEXITED(result.status) ? WEXITSTATUS(result.status) : -1;
+#endif
+        result.out = slurp(temp_dir_ / "out.txt");
+        result.err = slurp(temp_dir_ / "err.txt");
+        return result;
+    };
+
+    // Без --skip-errors hunt прекращается на ошибке, строки до неё уже выведены
+    auto strict = run("");
+    EXPECT_EQ(strict.status, 1);
+    EXPECT_NE(strict.out.find("alpha"), std::string::npos);
+    EXPECT_EQ(strict.out.find("charlie"), std::string::npos);
+    EXPECT_NE(strict.err.find("failed to parse timestamp: bad"), std::string::npos);
+
+    // --skip-errors: документ с ошибкой пропускается, файл учитывается один раз
+    auto skipped = run("--skip-errors");
+    EXPECT_EQ(skipped.status, 0);
+    for (const char* user : {"alpha", "charlie", "delta"}) {
+        EXPECT_NE(skipped.out.find(user), std::string::npos) << user;
+    }
+    EXPECT_EQ(skipped.out.find("bravo"), std::string::npos);
+    EXPECT_NE(skipped.err.find("3 detections in 2 files"), std::string::npos) << skipped.err;
+}
+
 // ============================================================================
 // TST-HUNT-016: HuntKind::Group matching
 // ============================================================================
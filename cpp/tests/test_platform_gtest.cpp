@@ -12,11 +12,17 @@
 
 #include "chainsaw/platform.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace chainsaw::platform::test {
 
@@ -324,4 +330,145 @@ TEST(PlatformTest, MakeTempFile_EmptyPrefix) {
     std::filesystem::remove(temp_path);
 }
 
+// ==============================================================================
+// TST-PLATFORM-008: Отображение файлов в память (MappedFile)
+// ==============================================================================
+
+TEST(PlatformTest, MappedFile_MapsContent) {
+    // Arrange
+    std::filesystem::path temp_path = make_temp_file("chainsaw_mmap");
+    {
+        std::ofstream out(temp_path, std::ios::binary);
+        out << "ElfFile";
+    }
+
+    // Act
+    MappedFile mapped;
+    ASSERT_TRUE(mapped.open(temp_path));
+
+    // Assert
+    EXPECT_TRUE(mapped.is_open());
+    ASSERT_EQ(mapped.size(), 7u);
+    EXPECT_EQ(std::memcmp(mapped.data(), "ElfFile", 7), 0);
+    EXPECT_EQ(mapped.bytes().size(), 7u);
+
+    // Перемещение передаёт отображение
+    MappedFile moved(std::move(mapped));
+    EXPECT_FALSE(mapped.is_open());
+    EXPECT_TRUE(moved.is_open());
+
+    moved.close();
+    EXPECT_FALSE(moved.is_open());
+    EXPECT_EQ(moved.size(), 0u);
+
+    // Cleanup
+    std::filesystem::remove(temp_path);
+}
+
+TEST(PlatformTest, MappedFile_EmptyOrMissingFile) {
+    // Пустой файл не отображается — вызывающий переходит на буферное чтение
+    std::filesystem::path temp_path = make_temp_file("chainsaw_mmap_empty");
+    MappedFile mapped;
+    EXPECT_FALSE(mapped.open(temp_path));
+    EXPECT_FALSE(mapped.is_open());
+    std::filesystem::remove(temp_path);
+
+    EXPECT_FALSE(mapped.open(temp_path));
+}
+
+// ==============================================================================
+// TST-PLATFORM-009: Пул потоков (TaskPool)
+// ==============================================================================
+
+TEST(PlatformTest, TaskPool_RunsEachTaskOnce) {
+    std::vector<std::atomic<int>> runs(100);
+    {
+        TaskPool pool(runs.size(), 4, 0, [&](std::size_t i) { ++runs[i]; });
+        // Без release: окно 0 не ограничивает задачи, деструктор не отменяет начатое
+        while (true) {
+            bool done = true;
+            for (const auto& count : runs) {
+                done = done && count.load() == 1;
+            }
+            if (done) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    for (const auto& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(PlatformTest, TaskPool_WindowBoundsRunAhead) {
+    // Задачи завершаются в обратном порядке внутри окна, потребитель идёт по порядку
+    constexpr std::size_t kCount = 64;
+    constexpr std::size_t kWindow = 3;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<bool> done(kCount, false);
+    std::atomic<std::size_t> released{0};
+    std::atomic<bool> violated{false};
+
+    TaskPool pool(kCount, 8, kWindow, [&](std::size_t i) {
+        if (i >= released.load() + kWindow) {
+            violated = true;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds((kCount - i) % 5 * 100));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done[i] = true;
+        }
+        ready.notify_all();
+    });
+
+    for (std::size_t i = 0; i < kCount; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return done[i]; });
+        }
+        released = i + 1;
+        pool.release(i);
+    }
+    EXPECT_FALSE(violated.load());
+}
+
+TEST(PlatformTest, TaskPool_StealsEarliestPendingTask) {
+    // Очереди {0, 2, 4, 6} и {1, 3, 5, 7}; задача 0 держит свой поток,
+    // второй поток после своих задач забирает из чужой очереди задачу 2, а не 6
+    constexpr std::size_t kCount = 8;
+    std::mutex mutex;
+    std::condition_variable stolen;
+    std::size_t first_stolen = kCount;
+
+    TaskPool pool(kCount, 2, 0, [&](std::size_t i) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (i == 0) {
+            stolen.wait(lock, [&] { return first_stolen != kCount; });
+        } else if (i % 2 == 0 && first_stolen == kCount) {
+            first_stolen = i;
+            stolen.notify_all();
+        }
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stolen.wait(lock, [&] { return first_stolen != kCount; });
+    }
+    EXPECT_EQ(first_stolen, 2u);
+}
+
+TEST(PlatformTest, TaskPool_CancelSkipsPendingTasks) {
+    std::atomic<std::size_t> started{0};
+    {
+        TaskPool pool(1000, 2, 1, [&](std::size_t) { ++started; });
+        // Окно 1 без release допускает только задачу 0
+        while (started.load() == 0) {
+            std::this_thread::yield();
+        }
+        pool.cancel();
+    }
+    EXPECT_EQ(started.load(), 1u);
+}
+
 }  // namespace chainsaw::platform::test
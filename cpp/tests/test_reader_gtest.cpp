@@ -11,18 +11,24 @@
 // - TST-RDR-001..009: Reader API
 // - TST-JSON-001..004: JSON parsing
 // - TST-JSONL-001..003: JSONL parsing
-// - TST-VALUE-001..004: Value conversion
+// - TST-VALUE-001..006: Value conversion, арена, компактные объекты
 //
 // ==============================================================================
 
 #include <algorithm>
+#include <chainsaw/evtx.hpp>
 #include <chainsaw/platform.hpp>
 #include <chainsaw/reader.hpp>
+#include <chainsaw/utf16.hpp>
 #include <chainsaw/value.hpp>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <random>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <unordered_map>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -81,6 +87,15 @@ protected:
     fs::path temp_dir_;
 };
 
+/// JSON-текст значения (ключи — в порядке обхода Value::Object)
+static std::string value_to_json(const Value& value) {
+    auto doc = value.to_rapidjson_document();
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+    return buffer.GetString();
+}
+
 // ============================================================================
 // TST-VALUE-*: Value conversion tests
 // ============================================================================
@@ -211,6 +226,179 @@ TEST(ValueTest, AllTypes) {
     EXPECT_EQ(obj_val.object_size(), 1u);
 }
 
+// TST-VALUE-005: контейнеры в арене; owned() переносит дерево в кучу
+// с тем же порядком ключей, и копия переживает сброс арены
+TEST(ValueTest, TST_VALUE_005_ArenaOwned) {
+    ValueArena arena(1024);
+    Value built;
+    {
+        ValueArena::Scope scope(&arena);
+        Value::Object obj;
+        for (int i = 0; i < 50; ++i) {
+            obj["key" + std::to_string(i)] = Value(static_cast<std::int64_t>(i));
+        }
+        Value::Array list;
+        for (int i = 0; i < 300; ++i) {
+            list.push_back(Value(Value::Object{{"n", Value(std::string(40, 'x'))}}));
+        }
+        obj["list"] = Value(std::move(list));
+        built = Value(std::move(obj));
+    }
+    EXPECT_FALSE(built.as_object().get_allocator().on_heap());
+    EXPECT_GT(arena.used(), 1024u);
+
+    Value copy = built.owned();
+    EXPECT_TRUE(copy.as_object().get_allocator().on_heap());
+    EXPECT_TRUE(copy.get("list")->as_array().get_allocator().on_heap());
+    EXPECT_TRUE(copy.get("list")->at(0)->as_object().get_allocator().on_heap());
+    std::vector<std::string> built_keys;
+    std::vector<std::string> copy_keys;
+    for (const auto& [key, value] : built.as_object()) {
+        built_keys.push_back(key);
+    }
+    for (const auto& [key, value] : copy.as_object()) {
+        copy_keys.push_back(key);
+    }
+    EXPECT_EQ(copy_keys, built_keys);
+    auto expected = built.to_rapidjson_document();
+
+    // Вне Scope контейнеры снова в куче; owned() от дерева в куче — то же дерево
+    Value heap(Value::Array{Value("a")});
+    EXPECT_TRUE(heap.as_array().get_allocator().on_heap());
+    EXPECT_EQ(&heap.owned().as_array(), &heap.as_array());
+
+    built = Value();
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_TRUE(copy.to_rapidjson_document() == expected);
+}
+
+// TST-VALUE-006: порядок обхода объекта — как у std::unordered_map после тех же
+// вставок (JSON вывод не зависит от представления); поиск по строке и ключу
+TEST(ValueTest, TST_VALUE_006_CompactObject) {
+    std::mt19937 rng(7);
+    for (std::size_t size : {0u, 1u, 2u, 3u, 7u, 15u, 16u, 40u, 64u, 65u, 200u}) {
+        Value::Object obj;
+        std::unordered_map<std::string, int> reference;
+        std::vector<std::string> keys;
+        for (std::size_t i = 0; i < size; ++i) {
+            std::string key = "field" + std::to_string(rng() % 1000);
+            obj[key] = Value(static_cast<std::int64_t>(i));
+            reference[key] = static_cast<int>(i);
+            keys.push_back(key);
+        }
+        ASSERT_EQ(obj.size(), reference.size());
+
+        std::vector<std::string> order;
+        for (const auto& [key, value] : obj) {
+            order.push_back(key);
+            EXPECT_EQ(value.as_int(), reference.at(key));
+        }
+        std::vector<std::string> expected;
+        for (const auto& [key, value] : reference) {
+            expected.push_back(key);
+        }
+        EXPECT_EQ(order, expected) << "size " << size;
+
+        Value::Object copy(obj);
+        std::vector<std::string> copy_order;
+        for (const auto& [key, value] : copy) {
+            copy_order.push_back(key);
+        }
+        EXPECT_EQ(copy_order, expected);
+
+        Value value(std::move(copy));
+        for (const auto& key : keys) {
+            ASSERT_NE(value.get(key), nullptr);
+            EXPECT_EQ(value.get(key)->as_int(), reference.at(key));
+            EXPECT_EQ(value.get(ValueKey(key)), value.get(key));
+            auto it = obj.find(key);
+            ASSERT_NE(it, obj.end());
+            EXPECT_EQ(it->first, key);
+        }
+        EXPECT_EQ(value.get("field-missing"), nullptr);
+        EXPECT_EQ(obj.find("field-missing"), obj.end());
+        EXPECT_EQ(obj.count("field-missing"), 0u);
+    }
+
+    EXPECT_EQ(ValueKey("EventID"), ValueKey(std::string("Event") + "ID"));
+    EXPECT_EQ(ValueKey("EventID").str(), "EventID");
+    EXPECT_EQ(ValueKey().str(), "");
+    EXPECT_FALSE(ValueKey::find("TST_VALUE_006 never interned").has_value());
+}
+
+// TST-VALUE-007: ключи из данных — кеш порядков обхода и таблица ключей не растут
+// без предела, порядок обхода и поиск остаются прежними
+TEST(ValueTest, TST_VALUE_007_DataShapedKeys) {
+    auto check_order = [](const Value::Object& obj, const std::vector<std::string>& keys) {
+        std::unordered_map<std::string, int> reference;
+        for (const auto& key : keys) {
+            reference.try_emplace(key, 0);
+        }
+        std::vector<std::string> expected;
+        for (const auto& [key, value] : reference) {
+            expected.push_back(key);
+        }
+        std::vector<std::string> order;
+        for (const auto& [key, value] : obj) {
+            order.push_back(key);
+        }
+        return order == expected;
+    };
+
+    // Много различных форм из небольшого словаря: кеш заполняется до предела
+    for (std::size_t i = 0; i < 60000; ++i) {
+        Value::Object obj;
+        std::vector<std::string> keys;
+        for (std::size_t n = i; keys.size() < 3; n /= 64) {
+            keys.push_back("shape" + std::to_string(n % 64 + keys.size() * 64));
+            obj[keys.back()] = Value(static_cast<std::int64_t>(n));
+        }
+        obj.begin();
+        if (i % 997 == 0) {
+            EXPECT_TRUE(check_order(obj, keys)) << "shape " << i;
+            Value::Object copy(obj);
+            EXPECT_TRUE(check_order(copy, keys)) << "shape " << i;
+        }
+    }
+    EXPECT_GT(Value::Object::order_cache_bytes(), Value::Object::ORDER_CACHE_BYTES / 2);
+    EXPECT_LE(Value::Object::order_cache_bytes(), Value::Object::ORDER_CACHE_BYTES);
+
+    // Таблица ключей заполняется до предела; дальше ключи хранят текст сами
+    std::size_t interned = 0;
+    while (ValueKey("TST_VALUE_007 key " + std::to_string(interned)).interned()) {
+        ++interned;
+        ASSERT_LE(interned, ValueKey::MAX_INTERNED);
+    }
+    std::string text = "TST_VALUE_007 uninterned";
+    ValueKey key(text);
+    EXPECT_FALSE(key.interned());
+    EXPECT_EQ(key.id(), ValueKey::UNINTERNED);
+    EXPECT_EQ(key.str(), text);
+    EXPECT_EQ(key, ValueKey(text));
+    EXPECT_FALSE(key == ValueKey("EventID"));
+    EXPECT_FALSE(ValueKey::find(text).has_value());
+
+    Value::Object obj;
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < 100; ++i) {
+        keys.push_back(i % 2 == 0 ? "EventID" + std::to_string(i) : text + std::to_string(i));
+        obj[keys.back()] = Value(static_cast<std::int64_t>(i));
+    }
+    obj[ValueKey(text + "1")] = Value(std::int64_t{-1});
+    ASSERT_EQ(obj.size(), 100u);
+    EXPECT_TRUE(check_order(obj, keys));
+    Value value(obj);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        std::int64_t expected = i == 1 ? -1 : static_cast<std::int64_t>(i);
+        ASSERT_NE(value.get(keys[i]), nullptr) << keys[i];
+        EXPECT_EQ(value.get(keys[i])->as_int(), expected);
+        EXPECT_EQ(value.get(ValueKey(keys[i])), value.get(keys[i]));
+        EXPECT_EQ(obj.find(keys[i])->first, keys[i]);
+    }
+    EXPECT_EQ(value.get(text + "missing"), nullptr);
+}
+
 // ============================================================================
 // TST-RDR-*: Reader API tests
 // ============================================================================
@@ -1292,3 +1480,611 @@ TEST_F(ReaderTestFixture, TST_EVTX_016_ReaderPath) {
 
     EXPECT_EQ(result.reader->path(), path);
 }
+
+/// TST-EVTX-017: форма документа (Event/*_attributes/EventData) при прямом построении Value
+TEST_F(ReaderTestFixture, TST_EVTX_017_DocumentShape) {
+    // SPEC-SLICE-007 FACT-005: separate_json_attributes(true)
+    // ADR-0012: flatten EventData/UserData
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    auto result = Reader::open(path);
+    ASSERT_TRUE(result.ok) << result.error.format();
+
+    Document doc;
+    ASSERT_TRUE(result.reader->next(doc));
+
+    // Атрибуты корня дублируются снаружи строками
+    const auto* root_attrs = doc.data.get("Event_attributes");
+    ASSERT_NE(root_attrs, nullptr);
+    ASSERT_NE(root_attrs->get("xmlns"), nullptr);
+    EXPECT_TRUE(root_attrs->get("xmlns")->is_string());
+
+    const auto* event = doc.data.get("Event");
+    ASSERT_NE(event, nullptr);
+    EXPECT_NE(event->get("Event_attributes"), nullptr);
+
+    const auto* system = event->get("System");
+    ASSERT_NE(system, nullptr);
+
+    // Текст элемента из цифр → число
+    const auto* event_id = system->get("EventID");
+    ASSERT_NE(event_id, nullptr);
+    ASSERT_TRUE(event_id->is_int());
+    EXPECT_EQ(event_id->as_int(), 5058);
+
+    // Атрибуты элемента → {имя}_attributes, числовые атрибуты → числа
+    const auto* provider = system->get("Provider");
+    ASSERT_NE(provider, nullptr);
+    const auto* provider_attrs = provider->get("Provider_attributes");
+    ASSERT_NE(provider_attrs, nullptr);
+    ASSERT_NE(provider_attrs->get("Name"), nullptr);
+    EXPECT_EQ(provider_attrs->get("Name")->as_string(), "Microsoft-Windows-Security-Auditing");
+
+    const auto* execution = system->get("Execution");
+    ASSERT_NE(execution, nullptr);
+    const auto* process_id = execution->get("Execution_attributes")->get("ProcessID");
+    ASSERT_NE(process_id, nullptr);
+    EXPECT_TRUE(process_id->is_int());
+
+    // Пустое значение атрибута остаётся пустой строкой
+    const auto* correlation = system->get("Correlation");
+    ASSERT_NE(correlation, nullptr);
+    const auto* related = correlation->get("Correlation_attributes")->get("RelatedActivityID");
+    ASSERT_NE(related, nullptr);
+    EXPECT_EQ(related->as_string(), "");
+
+    // EventData: <Data Name="X">v</Data> → {"X": "v"}, значения остаются строками
+    const auto* event_data = event->get("EventData");
+    ASSERT_NE(event_data, nullptr);
+    ASSERT_TRUE(event_data->is_object());
+    ASSERT_NE(event_data->get("SubjectUserName"), nullptr);
+    EXPECT_EQ(event_data->get("SubjectUserName")->as_string(), "analysis");
+    ASSERT_NE(event_data->get("ClientProcessId"), nullptr);
+    EXPECT_EQ(event_data->get("ClientProcessId")->as_string(), "6136");
+}
+
+/// TST-EVTX-018: скомпилированные шаблоны общие для чанков и файлов
+TEST_F(ReaderTestFixture, TST_EVTX_018_TemplateCacheSharedAcrossChunks) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    // Файл из двух одинаковых чанков: строки и шаблоны второго чанка
+    // снова определяются inline и должны совпасть с уже скомпилированными
+    std::string bytes(static_cast<std::size_t>(fs::file_size(path)), '\0');
+    std::ifstream in(path, std::ios::binary);
+    in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    ASSERT_GE(bytes.size(), evtx::FILE_HEADER_SIZE + evtx::CHUNK_SIZE);
+    std::string chunk = bytes.substr(evtx::FILE_HEADER_SIZE, evtx::CHUNK_SIZE);
+    auto doubled = create_temp_file(
+        "doubled.evtx", bytes.substr(0, evtx::FILE_HEADER_SIZE) + chunk + chunk);
+
+    auto read_all = [](const fs::path& file) {
+        std::vector<Document> docs;
+        auto result = Reader::open(file);
+        EXPECT_TRUE(result.ok) << result.error.format();
+        if (result.ok) {
+            Document doc;
+            while (result.reader->next(doc)) {
+                docs.push_back(doc);
+            }
+        }
+        return docs;
+    };
+
+    auto& cache = evtx::BinXmlTemplateCache::global();
+    cache.clear();
+
+    auto first = read_all(path);
+    ASSERT_FALSE(first.empty());
+    std::size_t compiled = cache.size();
+    EXPECT_GT(compiled, 0u);
+
+    auto docs = read_all(doubled);
+    ASSERT_EQ(docs.size(), first.size() * 2);
+    EXPECT_EQ(cache.size(), compiled);
+
+    for (std::size_t i = 0; i < first.size(); ++i) {
+        EXPECT_TRUE(docs[i].data.to_rapidjson_document() ==
+                    first[i].data.to_rapidjson_document());
+        EXPECT_TRUE(docs[i + first.size()].data.to_rapidjson_document() ==
+                    first[i].data.to_rapidjson_document());
+    }
+}
+
+/// TST-EVTX-019: отображение в память и буферное чтение дают одинаковые записи
+TEST_F(ReaderTestFixture, TST_EVTX_019_MemoryMappedMatchesBuffered) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    evtx::EvtxParser mapped;
+    ASSERT_TRUE(mapped.load(path));
+    EXPECT_TRUE(mapped.memory_mapped());
+
+    evtx::EvtxParser buffered;
+    ASSERT_TRUE(buffered.load(path, false));
+    EXPECT_FALSE(buffered.memory_mapped());
+
+    std::size_t count = 0;
+    evtx::EvtxRecord a;
+    evtx::EvtxRecord b;
+    while (mapped.next(a)) {
+        ASSERT_TRUE(buffered.next(b));
+        EXPECT_EQ(a.record_id, b.record_id);
+        EXPECT_EQ(a.timestamp, b.timestamp);
+        EXPECT_TRUE(a.data.to_rapidjson_document() == b.data.to_rapidjson_document());
+        ++count;
+    }
+    EXPECT_FALSE(buffered.next(b));
+    EXPECT_EQ(count, 10u);
+}
+
+/// TST-EVTX-020: параллельное декодирование чанков сохраняет порядок записей
+TEST_F(ReaderTestFixture, TST_EVTX_020_ParallelChunksKeepOrder) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    std::string bytes(static_cast<std::size_t>(fs::file_size(path)), '\0');
+    std::ifstream in(path, std::ios::binary);
+    in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    ASSERT_GE(bytes.size(), evtx::FILE_HEADER_SIZE + evtx::CHUNK_SIZE);
+    std::string chunk = bytes.substr(evtx::FILE_HEADER_SIZE, evtx::CHUNK_SIZE);
+
+    // Шесть чанков; в третьем испорчена сигнатура второй записи —
+    // остаток этого чанка пропускается так же, как при последовательном чтении
+    std::string broken = chunk;
+    std::uint32_t first_size = 0;
+    std::memcpy(&first_size, broken.data() + evtx::CHUNK_HEADER_SIZE + 4, sizeof(first_size));
+    broken[evtx::CHUNK_HEADER_SIZE + first_size] = '\0';
+    std::string content = bytes.substr(0, evtx::FILE_HEADER_SIZE);
+    for (int i = 0; i < 6; ++i) {
+        content += i == 2 ? broken : chunk;
+    }
+    auto file = create_temp_file("parallel.evtx", content);
+
+    auto read_all = [&](std::size_t threads, bool memory_map) {
+        std::vector<evtx::EvtxRecord> records;
+        evtx::EvtxParser parser;
+        parser.set_threads(threads);
+        EXPECT_TRUE(parser.load(file, memory_map));
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            records.push_back(record);
+        }
+        return records;
+    };
+
+    auto sequential = read_all(1, true);
+    ASSERT_EQ(sequential.size(), 51u);
+    for (bool memory_map : {true, false}) {
+        auto parallel = read_all(4, memory_map);
+        ASSERT_EQ(parallel.size(), sequential.size());
+        for (std::size_t i = 0; i < sequential.size(); ++i) {
+            EXPECT_EQ(parallel[i].record_id, sequential[i].record_id);
+            EXPECT_EQ(parallel[i].timestamp, sequential[i].timestamp);
+            EXPECT_TRUE(parallel[i].data.to_rapidjson_document() ==
+                        sequential[i].data.to_rapidjson_document());
+        }
+    }
+
+    // Reader::open передаёт число потоков парсеру EVTX
+    ReaderOptions options;
+    options.evtx_threads = 3;
+    auto result = Reader::open(file, options);
+    ASSERT_TRUE(result.ok) << result.error.format();
+    std::size_t count = 0;
+    Document doc;
+    while (result.reader->next(doc)) {
+        EXPECT_EQ(doc.record_id, sequential[count].record_id);
+        ++count;
+    }
+    EXPECT_EQ(count, sequential.size());
+}
+
+// TST-EVTX-021: Проекция полей — пути проекции как в полном документе,
+// остальное не собирается; full() возвращает полный документ
+TEST_F(ReaderTestFixture, TST_EVTX_021_FieldProjection) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    const std::vector<std::string> paths = {
+        "Event.System.EventID",
+        "Event.System.TimeCreated.TimeCreated_attributes.SystemTime",
+        "Event.System.Provider.Provider_attributes.Name",
+        "Event.EventData.SubjectUserName",
+        "Event.EventData.Missing",
+        "Event_attributes",
+    };
+    auto lookup = [](const Value& value, const std::string& key) {
+        const Value* current = &value;
+        std::size_t start = 0;
+        while (current && current->is_object()) {
+            auto dot = key.find('.', start);
+            current = current->get(key.substr(start, dot - start));
+            if (dot == std::string::npos) {
+                return current;
+            }
+            start = dot + 1;
+        }
+        return static_cast<const Value*>(nullptr);
+    };
+
+    // full() ссылается на данные парсера: вызываем, пока он жив
+    std::vector<Value> materialized;
+    auto read_all = [&](std::shared_ptr<const FieldProjection> projection) {
+        std::vector<evtx::EvtxRecord> records;
+        evtx::EvtxParser parser;
+        parser.set_projection(std::move(projection));
+        EXPECT_TRUE(parser.load(path));
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            if (record.full) {
+                materialized.push_back(record.full());
+            }
+            records.push_back(record);
+        }
+        return records;
+    };
+
+    auto full = read_all(nullptr);
+    EXPECT_TRUE(materialized.empty());
+    auto projected = read_all(std::make_shared<const FieldProjection>(paths));
+    ASSERT_FALSE(full.empty());
+    ASSERT_EQ(projected.size(), full.size());
+    ASSERT_EQ(materialized.size(), full.size());
+
+    for (std::size_t i = 0; i < full.size(); ++i) {
+        for (const auto& key : paths) {
+            const Value* expected = lookup(full[i].data, key);
+            const Value* actual = lookup(projected[i].data, key);
+            ASSERT_EQ(actual != nullptr, expected != nullptr) << key;
+            if (expected) {
+                EXPECT_TRUE(actual->to_rapidjson_document() == expected->to_rapidjson_document())
+                    << key;
+            }
+        }
+        EXPECT_EQ(lookup(projected[i].data, "Event.EventData.SubjectUserSid"), nullptr);
+        EXPECT_EQ(lookup(projected[i].data, "Event.System.Computer"), nullptr);
+
+        EXPECT_TRUE(materialized[i].to_rapidjson_document() ==
+                    full[i].data.to_rapidjson_document());
+    }
+
+    // Вложенный EventData вне проекции: шаблоны, определённые в пропущенных
+    // поддеревьях, остаются в кешах чанка для следующих записей
+    {
+        evtx::EvtxParser parser;
+        parser.set_projection(
+            std::make_shared<const FieldProjection>(std::vector<std::string>{"Event_attributes"}));
+        ASSERT_TRUE(parser.load(path));
+        evtx::EvtxRecord record;
+        std::vector<evtx::EvtxRecord> records;
+        while (parser.next(record)) {
+            EXPECT_EQ(lookup(record.data, "Event.System"), nullptr);
+            records.push_back(record);
+        }
+        ASSERT_EQ(records.size(), full.size());
+        EXPECT_TRUE(records.back().full().to_rapidjson_document() ==
+                    full.back().data.to_rapidjson_document());
+    }
+
+    // Reader::open передаёт проекцию; materialize собирает полный документ
+    ReaderOptions options;
+    options.projection = std::make_shared<const FieldProjection>(paths);
+    auto result = Reader::open(path, options);
+    ASSERT_TRUE(result.ok) << result.error.format();
+    Document doc;
+    ASSERT_TRUE(result.reader->next(doc));
+    ASSERT_TRUE(doc.materialize);
+    EXPECT_TRUE(doc.materialize().to_rapidjson_document() ==
+                full.front().data.to_rapidjson_document());
+}
+
+// TST-EVTX-022: Окно времени по FILETIME заголовка — записи и чанки вне окна
+// не декодируются, записи в окне совпадают с полным чтением
+TEST_F(ReaderTestFixture, TST_EVTX_022_TimeWindow) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    std::string bytes(static_cast<std::size_t>(fs::file_size(path)), '\0');
+    std::ifstream in(path, std::ios::binary);
+    in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    ASSERT_GE(bytes.size(), evtx::FILE_HEADER_SIZE + evtx::CHUNK_SIZE);
+    std::string chunk = bytes.substr(evtx::FILE_HEADER_SIZE, evtx::CHUNK_SIZE);
+
+    // Времена записей чанка; во втором чанке все записи на год раньше
+    std::vector<std::uint64_t> times;
+    std::string old = chunk;
+    constexpr std::uint64_t YEAR = 365ULL * 24 * 3600 * 10000000ULL;
+    for (std::size_t offset = evtx::CHUNK_HEADER_SIZE; offset + 24 <= old.size();) {
+        std::uint32_t signature = 0;
+        std::uint32_t size = 0;
+        std::uint64_t timestamp = 0;
+        std::memcpy(&signature, old.data() + offset, sizeof(signature));
+        if (signature != 0x00002a2a) {
+            break;
+        }
+        std::memcpy(&size, old.data() + offset + 4, sizeof(size));
+        std::memcpy(&timestamp, old.data() + offset + 16, sizeof(timestamp));
+        times.push_back(timestamp);
+        timestamp -= YEAR;
+        std::memcpy(old.data() + offset + 16, &timestamp, sizeof(timestamp));
+        offset += size;
+    }
+    ASSERT_GE(times.size(), 6u);
+
+    std::string content = bytes.substr(0, evtx::FILE_HEADER_SIZE);
+    for (int i = 0; i < 4; ++i) {
+        content += i == 1 ? old : chunk;
+    }
+    auto file = create_temp_file("window.evtx", content);
+
+    auto read_all = [&](std::size_t threads, evtx::EvtxTimeWindow window) {
+        std::vector<evtx::EvtxRecord> records;
+        evtx::EvtxParser parser;
+        parser.set_threads(threads);
+        parser.set_time_window(window);
+        EXPECT_TRUE(parser.load(file));
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            records.push_back(record);
+        }
+        return records;
+    };
+
+    // Все записи чанка до from — пропущены, но их определения шаблонов прочитаны
+    const std::size_t skipped = 4;
+    auto all = read_all(1, {});
+    ASSERT_EQ(all.size(), times.size() * 4);
+    for (std::size_t threads : {1u, 3u}) {
+        auto window = read_all(threads, {times[skipped - 1], std::nullopt});
+        ASSERT_EQ(window.size(), (times.size() - skipped) * 3);
+        std::size_t i = 0;
+        for (std::size_t c : {0u, 2u, 3u}) {
+            for (std::size_t r = skipped; r < times.size(); ++r, ++i) {
+                const auto& expected = all[c * times.size() + r];
+                EXPECT_EQ(window[i].record_id, expected.record_id);
+                EXPECT_EQ(window[i].timestamp, expected.timestamp);
+                EXPECT_TRUE(window[i].data.to_rapidjson_document() ==
+                            expected.data.to_rapidjson_document());
+            }
+        }
+
+        // Верхняя граница: только старый чанк
+        auto before = read_all(threads, {std::nullopt, times.front() - YEAR / 2});
+        EXPECT_EQ(before.size(), times.size());
+    }
+
+    // Заголовки записаны раньше TimeCreated на skew (расхождение часов)
+    auto read_skewed = [&](std::uint64_t skew, std::optional<std::uint64_t> from) {
+        std::string skewed = chunk;
+        for (std::size_t offset = evtx::CHUNK_HEADER_SIZE, r = 0; r < times.size(); ++r) {
+            std::uint32_t size = 0;
+            std::memcpy(&size, skewed.data() + offset + 4, sizeof(size));
+            std::uint64_t timestamp = times[r] - skew;
+            std::memcpy(skewed.data() + offset + 16, &timestamp, sizeof(timestamp));
+            offset += size;
+        }
+        auto skewed_file =
+            create_temp_file("skewed.evtx", bytes.substr(0, evtx::FILE_HEADER_SIZE) + skewed);
+        evtx::EvtxParser parser;
+        parser.set_time_window({from, std::nullopt});
+        EXPECT_TRUE(parser.load(skewed_file));
+        std::size_t count = 0;
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            ++count;
+        }
+        return count;
+    };
+    const std::uint64_t first = *std::min_element(times.begin(), times.end());
+    const std::uint64_t bound = evtx::written_after_bound(first);
+
+    // Расхождение в час: граница --from с запасом не отбрасывает записи,
+    // созданные после from
+    constexpr std::uint64_t HOUR = 3600ULL * 10000000ULL;
+    EXPECT_LT(read_skewed(HOUR, first), times.size());
+    EXPECT_EQ(read_skewed(HOUR, bound), times.size());
+    EXPECT_EQ(evtx::written_after_bound(evtx::WRITTEN_AFTER_MARGIN / 2), 0u);
+
+    // Расхождение больше запаса: записи, созданные после from, пропускаются по
+    // времени заголовка (hunt и search предупреждают об этом); без границы читаются
+    const std::uint64_t beyond = evtx::WRITTEN_AFTER_MARGIN + HOUR;
+    EXPECT_EQ(read_skewed(beyond, bound), 0u);
+    EXPECT_EQ(read_skewed(beyond, std::nullopt), times.size());
+
+    // Reader::open передаёт границу парсеру EVTX
+    ReaderOptions options;
+    options.evtx_written_after = times.back();
+    auto result = Reader::open(file, options);
+    ASSERT_TRUE(result.ok) << result.error.format();
+    Document doc;
+    EXPECT_FALSE(result.reader->next(doc));
+}
+
+// TST-EVTX-023: FILETIME → ISO 8601 без gmtime (календарь по числу дней)
+TEST(EvtxFormatTest, TST_EVTX_023_FiletimeToIso8601) {
+    using evtx::EvtxParser;
+    EXPECT_EQ(EvtxParser::filetime_to_iso8601(116444736000000000ULL),
+              "1970-01-01T00:00:00.000000Z");
+    EXPECT_EQ(EvtxParser::filetime_to_iso8601(116444735999999999ULL), "");
+    EXPECT_EQ(EvtxParser::filetime_to_iso8601(133099900120458892ULL),
+              "2022-10-11T19:26:52.045889Z");
+    // Високосный день и последняя микросекунда суток
+    EXPECT_EQ(EvtxParser::filetime_to_iso8601(133537247999999990ULL),
+              "2024-02-29T23:59:59.999999Z");
+    // Год из пяти цифр не обрезается
+    EXPECT_EQ(EvtxParser::filetime_to_iso8601(~0ULL), "60056-05-28T05:36:10.955161Z");
+}
+
+// TST-EVTX-024: Документы в арене парсера совпадают с построенными в куче;
+// owned() сохраняет их после перехода к следующим записям
+TEST_F(ReaderTestFixture, TST_EVTX_024_ValueArena) {
+    auto path = get_evtx_fixture_path();
+    if (!fs::exists(path)) {
+        GTEST_SKIP() << "EVTX fixture not found";
+    }
+
+    std::string bytes(static_cast<std::size_t>(fs::file_size(path)), '\0');
+    std::ifstream in(path, std::ios::binary);
+    in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    ASSERT_GE(bytes.size(), evtx::FILE_HEADER_SIZE + evtx::CHUNK_SIZE);
+    std::string content = bytes.substr(0, evtx::FILE_HEADER_SIZE);
+    for (int i = 0; i < 4; ++i) {
+        content += bytes.substr(evtx::FILE_HEADER_SIZE, evtx::CHUNK_SIZE);
+    }
+    auto file = create_temp_file("arena.evtx", content);
+
+    std::vector<std::string> expected;
+    {
+        evtx::EvtxParser parser;
+        ASSERT_TRUE(parser.load(file));
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            EXPECT_TRUE(record.data.as_object().get_allocator().on_heap());
+            expected.push_back(value_to_json(record.data));
+        }
+    }
+    ASSERT_FALSE(expected.empty());
+
+    for (std::size_t threads : {1u, 3u}) {
+        evtx::EvtxParser parser;
+        parser.set_threads(threads);
+        parser.set_value_arena(true);
+        ASSERT_TRUE(parser.load(file));
+        std::vector<Value> kept;
+        evtx::EvtxRecord record;
+        while (parser.next(record)) {
+            EXPECT_FALSE(record.data.as_object().get_allocator().on_heap());
+            ASSERT_LT(kept.size(), expected.size());
+            EXPECT_EQ(value_to_json(record.data), expected[kept.size()]);
+            kept.push_back(record.data.owned());
+        }
+        ASSERT_EQ(kept.size(), expected.size());
+        for (std::size_t i = 0; i < kept.size(); ++i) {
+            EXPECT_EQ(value_to_json(kept[i]), expected[i]);
+        }
+    }
+
+    // Reader::open передаёт флаг парсеру EVTX
+    ReaderOptions options;
+    options.value_arena = true;
+    auto result = Reader::open(file, options);
+    ASSERT_TRUE(result.ok) << result.error.format();
+    Document doc;
+    std::size_t count = 0;
+    while (result.reader->next(doc)) {
+        EXPECT_EQ(value_to_json(doc.data), expected[count]);
+        ++count;
+    }
+    EXPECT_EQ(count, expected.size());
+}
+
+// ============================================================================
+// TST-UTF16: перекодирование UTF-16LE → UTF-8
+// ============================================================================
+
+namespace {
+
+std::vector<std::uint8_t> utf16le(const std::vector<std::uint16_t>& units) {
+    std::vector<std::uint8_t> bytes;
+    for (std::uint16_t unit : units) {
+        bytes.push_back(static_cast<std::uint8_t>(unit & 0xFF));
+        bytes.push_back(static_cast<std::uint8_t>(unit >> 8));
+    }
+    return bytes;
+}
+
+/// Посимвольная эталонная реализация
+std::string utf16_reference(const std::vector<std::uint16_t>& units) {
+    std::string out;
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        std::uint32_t cp = units[i];
+        if (cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp > 0xDBFF || i + 1 >= units.size() || units[i + 1] < 0xDC00 ||
+                units[i + 1] > 0xDFFF) {
+                continue;
+            }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (units[++i] - 0xDC00);
+        }
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+// TST-UTF16-001: ASCII, 2/3-байтовые символы, суррогатные пары и одиночные суррогаты
+TEST(Utf16Test, TST_UTF16_001_CodePoints) {
+    auto bytes = utf16le({'A', 0x00E9, 0x0416, 0x20AC, 0xD83D, 0xDE00, 'z'});
+    EXPECT_EQ(utf16le_to_utf8(bytes.data(), bytes.size()),
+              "A\xC3\xA9\xD0\x96\xE2\x82\xAC\xF0\x9F\x98\x80z");
+
+    // Одиночные суррогаты (в том числе старший в конце строки) пропускаются
+    bytes = utf16le({'a', 0xDE00, 'b', 0xD83D, 'c', 0xD83D});
+    EXPECT_EQ(utf16le_to_utf8(bytes.data(), bytes.size()), "abc");
+
+    // Нечётная длина и пустые данные — пустая строка
+    EXPECT_EQ(utf16le_to_utf8(bytes.data(), 3), "");
+    EXPECT_EQ(utf16le_to_utf8(bytes.data(), 0), "");
+}
+
+// TST-UTF16-002: NUL завершает строку в utf16le_to_utf8, но не в append_utf16le
+TEST(Utf16Test, TST_UTF16_002_Nul) {
+    std::vector<std::uint16_t> units(40, 'x');
+    units[37] = 0;
+    auto bytes = utf16le(units);
+    EXPECT_EQ(utf16le_length(bytes.data(), units.size()), 37u);
+    EXPECT_EQ(utf16le_length(bytes.data(), 20), 20u);
+    EXPECT_EQ(utf16le_to_utf8(bytes.data(), bytes.size()), std::string(37, 'x'));
+
+    std::string out = "prefix:";
+    append_utf16le(out, bytes.data(), units.size());
+    EXPECT_EQ(out, "prefix:" + std::string(37, 'x') + std::string(1, '\0') + "xx");
+}
+
+// TST-UTF16-003: векторный путь на границах блоков совпадает с эталоном
+TEST(Utf16Test, TST_UTF16_003_MatchesReference) {
+    std::mt19937 rng(7);
+    const std::uint16_t alphabet[] = {'a', '0', 0x7F, 0x80, 0x7FF, 0x800, 0xFFFF,
+                                      0xD800, 0xDBFF, 0xDC00, 0xDFFF, 0x4E2D};
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        std::vector<std::uint16_t> units(rng() % 100);
+        // Длинные ASCII-отрезки со вставками других символов в случайных позициях
+        auto rare = rng() % 40 + 1;
+        for (auto& unit : units) {
+            unit = static_cast<std::uint16_t>(
+                rng() % rare == 0 ? alphabet[rng() % std::size(alphabet)] : 'A' + rng() % 26);
+        }
+        auto bytes = utf16le(units);
+        std::string out;
+        append_utf16le(out, bytes.data(), units.size());
+        ASSERT_EQ(out, utf16_reference(units)) << "iteration " << iteration;
+    }
+}
@@ -386,3 +386,22 @@ TEST(SearchCombined, TST_SEARCH_021_PatternAndTimeFilter) {
                                 {"timestamp", Value(std::string("2024-06-15T10:00:00Z"))}}));
     EXPECT_FALSE(result.searcher->matches(doc3));
 }
+
+// ============================================================================
+// TST-SEARCH-022: DateTime → FILETIME
+// ============================================================================
+
+TEST(SearchDateTime, TST_SEARCH_022_ToFiletime) {
+    auto epoch = search::DateTime::parse("1970-01-01T00:00:00Z");
+    ASSERT_TRUE(epoch.has_value());
+    EXPECT_EQ(epoch->to_filetime(), 116444736000000000ULL);
+
+    // Время заголовка записи из security_sample.evtx (с точностью до микросекунд)
+    auto dt = search::DateTime::parse("2022-10-11T19:26:52.045889Z");
+    ASSERT_TRUE(dt.has_value());
+    EXPECT_EQ(dt->to_filetime(), 133099900120458890ULL);
+
+    auto before = search::DateTime::parse("1600-12-31T23:59:59Z");
+    ASSERT_TRUE(before.has_value());
+    EXPECT_EQ(before->to_filetime(), 0u);
+}
@@ -3,13 +3,14 @@
 // ==============================================================================
 //
 // SPEC-SLICE-010: micro-spec поведения
-// TST-SIGMA-001..028: unit-тесты для модуля Sigma
+// TST-SIGMA-001..029: unit-тесты для модуля Sigma
 //
 // Покрытие:
 // - Match functions (as_contains, as_endswith, as_startswith, as_match, as_regex)
 // - Base64 encoding (base64_encode, base64_offset_encode)
 // - Modifier support (is_modifier_supported, get_unsupported_modifiers)
 // - Condition checking (is_condition_unsupported)
+// - Timeframe (parse_timeframe)
 // - load (single rules and Rule Collections)
 //
 // ==============================================================================
@@ -188,6 +189,26 @@ TEST(SigmaCondition, IsUnsupported) {
     EXPECT_FALSE(sigma::is_condition_unsupported("not selection"));
 }
 
+// ============================================================================
+// Timeframe Tests (TST-SIGMA-029)
+// ============================================================================
+
+// TST-SIGMA-029: detection.timeframe
+TEST(SigmaTimeframe, Parse) {
+    EXPECT_EQ(sigma::parse_timeframe("30s"), std::chrono::seconds(30));
+    EXPECT_EQ(sigma::parse_timeframe("5m"), std::chrono::minutes(5));
+    EXPECT_EQ(sigma::parse_timeframe("12h"), std::chrono::hours(12));
+    EXPECT_EQ(sigma::parse_timeframe("7d"), std::chrono::hours(7 * 24));
+
+    EXPECT_FALSE(sigma::parse_timeframe(""));
+    EXPECT_FALSE(sigma::parse_timeframe("m"));
+    EXPECT_FALSE(sigma::parse_timeframe("0m"));
+    EXPECT_FALSE(sigma::parse_timeframe("5"));
+    EXPECT_FALSE(sigma::parse_timeframe("5w"));
+    EXPECT_FALSE(sigma::parse_timeframe("-5m"));
+    EXPECT_FALSE(sigma::parse_timeframe("99999999999999999999s"));
+}
+
 // ============================================================================
 // Load Tests (TST-0007, TST-0008, TST-SIGMA-001..006)
 // ============================================================================
@@ -431,7 +452,7 @@ detection:
 }
 
 // ============================================================================
-// rule::load integration tests (TST-SIGMA-026, TST-SIGMA-027, TST-SIGMA-028)
+// rule::load integration tests (TST-SIGMA-026..029)
 // ============================================================================
 
 TEST_F(SigmaLoadTest, RuleLoadIntegration) {
@@ -462,6 +483,56 @@ detection:
     EXPECT_EQ(sigma_rule->status, rule::Status::Stable);
 }
 
+// TST-SIGMA-029: timeframe агрегации доходит до rule::Aggregate
+TEST_F(SigmaLoadTest, AggregateTimeframe) {
+    const char* rule_str = R"(---
+title: Brute Force
+description: Test
+detection:
+  selection:
+    EventID: 4625
+  timeframe: 5m
+  condition: selection | count() by TargetUserName > 10
+)";
+
+    WriteFile("timeframe.yml", rule_str);
+
+    auto result = rule::load(rule::Kind::Sigma, temp_dir_ / "timeframe.yml");
+    ASSERT_TRUE(result.ok);
+    ASSERT_EQ(result.rules.size(), 1u);
+    const auto& aggregate = rule::rule_aggregate(result.rules[0]);
+    ASSERT_TRUE(aggregate.has_value());
+    EXPECT_EQ(aggregate->fields, std::vector<std::string>{"TargetUserName"});
+    EXPECT_EQ(aggregate->timeframe, std::chrono::minutes(5));
+
+    // Без агрегации timeframe ни на что не влияет; неверный — ошибка правила
+    WriteFile("plain.yml", R"(---
+title: Plain
+description: Test
+detection:
+  selection:
+    EventID: 4625
+  timeframe: 5m
+  condition: selection
+)");
+    auto plain = sigma::load(temp_dir_ / "plain.yml");
+    ASSERT_TRUE(plain.ok);
+    EXPECT_FALSE(plain.rules[0].aggregate.has_value());
+
+    WriteFile("invalid.yml", R"(---
+title: Invalid
+description: Test
+detection:
+  selection:
+    EventID: 4625
+  timeframe: soon
+  condition: selection | count() > 10
+)");
+    auto invalid = sigma::load(temp_dir_ / "invalid.yml");
+    EXPECT_FALSE(invalid.ok);
+    EXPECT_EQ(invalid.error.message, "invalid timeframe");
+}
+
 // TST-SIGMA-028: rule_types() returns Unknown for Sigma
 TEST_F(SigmaLoadTest, RuleTypes) {
     const char* rule_content = R"(---
@@ -3,13 +3,17 @@
 // ==============================================================================
 //
 // SPEC-SLICE-008: Tau Engine micro-spec
-// TST-TAU-001..022: тесты Expression IR, Solver, Parser, Optimiser
+// TST-TAU-001..031: тесты Expression IR, Solver, Parser, Optimiser
 //
 // ==============================================================================
 
+#include <chainsaw/aho_corasick.hpp>
 #include <chainsaw/tau.hpp>
 #include <chainsaw/value.hpp>
 #include <gtest/gtest.h>
+#include <memory>
+#include <optional>
+#include <regex>
 #include <string>
 
 namespace tau = chainsaw::tau;
@@ -27,7 +31,7 @@ public:
 
     void set(const std::string& key, Value val) { value_.set(key, std::move(val)); }
 
-    std::optional<Value> find(std::string_view key) const override {
+    tau::FieldRef lookup(std::string_view key) const override {
         // Поддержка dot-notation
         std::string_view remaining = key;
         const Value* current = &value_;
@@ -44,23 +48,23 @@ public:
             }
 
             if (!current->is_object()) {
-                return std::nullopt;
+                return tau::FieldRef();
             }
 
             std::string key_str(part);
             const Value* found = current->get(key_str);
             if (!found) {
-                return std::nullopt;
+                return tau::FieldRef();
             }
 
             if (remaining.empty()) {
-                return *found;
+                return tau::FieldRef(found);
             }
 
             current = found;
         }
 
-        return std::nullopt;
+        return tau::FieldRef();
     }
 
 private:
@@ -284,7 +288,7 @@ TEST(TauSolver, TST_TAU_010_SearchRegex) {
     tau::ExprSearch search_rx;
     tau::SearchRegex srx;
     srx.pattern = "-encodedcommand\\s+\\w+";
-    srx.regex = std::regex(srx.pattern, std::regex::ECMAScript);
+    srx.regex = tau::compile_regex(srx.pattern);
     srx.ignore_case = false;
     search_rx.search = std::move(srx);
     search_rx.field = "CommandLine";
@@ -295,7 +299,7 @@ TEST(TauSolver, TST_TAU_010_SearchRegex) {
     tau::ExprSearch search_no;
     tau::SearchRegex srx_no;
     srx_no.pattern = "\\d{10}";
-    srx_no.regex = std::regex(srx_no.pattern, std::regex::ECMAScript);
+    srx_no.regex = tau::compile_regex(srx_no.pattern);
     srx_no.ignore_case = false;
     search_no.search = std::move(srx_no);
     search_no.field = "CommandLine";
@@ -568,6 +572,578 @@ TEST(TauUtils, TST_TAU_022_UpdateFields) {
     EXPECT_EQ(field->name, "NewFieldName");
 }
 
+// ============================================================================
+// TST-TAU-023: ValueDocument::lookup возвращает ссылку без копирования
+// ============================================================================
+
+TEST(TauSolver, TST_TAU_023_LookupBorrows) {
+    Value value = Value::make_object();
+    Value event = Value::make_object();
+    event.set("Image", Value(std::string("C:\\Windows\\cmd.exe")));
+    value.set("Event", std::move(event));
+
+    tau::ValueDocument doc(value);
+    auto found = doc.lookup("Event.Image");
+    ASSERT_TRUE(found);
+    EXPECT_EQ(found.get(), value.get("Event")->get("Image"));
+    EXPECT_FALSE(doc.lookup("Event.Missing"));
+    EXPECT_FALSE(doc.lookup("Event.Image.Deeper"));
+
+    // find — копия того же значения
+    auto copy = doc.find("Event.Image");
+    ASSERT_TRUE(copy.has_value());
+    EXPECT_EQ(copy->as_string(), "C:\\Windows\\cmd.exe");
+
+    // Nested вычисляется поверх ссылки на поддерево
+    tau::ExprSearch inner;
+    inner.search = tau::SearchEndsWith{"cmd.exe"};
+    inner.field = "Image";
+    inner.cast_to_str = false;
+    tau::ExprNested nested;
+    nested.field = "Event";
+    nested.inner = std::make_unique<tau::Expression>(std::move(inner));
+    EXPECT_TRUE(tau::solve(tau::Expression(std::move(nested)), doc));
+}
+
+// ============================================================================
+// TST-TAU-024: FieldPath разбирается один раз, resolve совпадает с lookup
+// ============================================================================
+
+TEST(TauSolver, TST_TAU_024_FieldPath) {
+    tau::FieldPath path("Event.EventData.Image");
+    ASSERT_EQ(path.segments().size(), 3u);
+    EXPECT_EQ(path.segments()[0].str(), "Event");
+    EXPECT_EQ(path.segments()[2].str(), "Image");
+    EXPECT_EQ(path.key().str(), "Event.EventData.Image");
+    EXPECT_TRUE(path == "Event.EventData.Image");
+
+    // Завершающая точка не даёт сегмента, пустой путь — без сегментов
+    EXPECT_EQ(tau::FieldPath("Event.").segments().size(), 1u);
+    EXPECT_TRUE(tau::FieldPath("").segments().empty());
+    EXPECT_EQ(tau::FieldPath("a..b").segments().size(), 3u);
+
+    Value value = Value::make_object();
+    Value data = Value::make_object();
+    data.set("Image", Value(std::string("cmd.exe")));
+    Value event = Value::make_object();
+    event.set("EventData", std::move(data));
+    value.set("Event", std::move(event));
+
+    tau::ValueDocument doc(value);
+    for (const char* key : {"Event.EventData.Image", "Event.EventData", "Event.", "Event..Image",
+                            "Event.EventData.Image.x", "Missing", ""}) {
+        EXPECT_EQ(doc.resolve(tau::FieldPath(key)).get(), doc.lookup(key).get()) << key;
+    }
+
+    // Документ без resolve ищет по строке пути
+    TestDocument test_doc(value);
+    EXPECT_TRUE(tau::solve(tau::Expression(tau::ExprField{"Event.EventData.Image"}), test_doc));
+}
+
+// ============================================================================
+// TST-TAU-025: AhoCorasick совпадает с проверкой записей по одной
+// ============================================================================
+
+namespace {
+
+bool match_entry(const tau::MatchTypeEntry& entry, const std::string& text, bool ignore_case) {
+    switch (entry.type) {
+    case tau::MatchType::Contains:
+        return ignore_case ? tau::icontains(text, entry.value)
+                           : text.find(entry.value) != std::string::npos;
+    case tau::MatchType::EndsWith:
+        return ignore_case ? tau::iends_with(text, entry.value)
+                           : text.size() >= entry.value.size() &&
+                                 text.compare(text.size() - entry.value.size(),
+                                              entry.value.size(), entry.value) == 0;
+    case tau::MatchType::Exact:
+        return ignore_case ? tau::iequals(text, entry.value) : text == entry.value;
+    case tau::MatchType::StartsWith:
+        return ignore_case ? tau::istarts_with(text, entry.value)
+                           : text.compare(0, entry.value.size(), entry.value) == 0;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(TauSolver, TST_TAU_025_AhoCorasick) {
+    // Детерминированный генератор: маленький алфавит даёт много перекрытий
+    std::uint32_t seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) & 0x7fff;
+    };
+    const std::string alphabet = "aAbB.";
+    auto random_string = [&](std::size_t max_len) {
+        std::string s(next() % (max_len + 1), ' ');
+        for (auto& c : s) {
+            c = alphabet[next() % alphabet.size()];
+        }
+        return s;
+    };
+    const tau::MatchType types[] = {tau::MatchType::Contains, tau::MatchType::EndsWith,
+                                    tau::MatchType::Exact, tau::MatchType::StartsWith};
+
+    std::vector<bool> matched;
+    for (int round = 0; round < 300; ++round) {
+        bool ignore_case = round % 2 == 0;
+        std::vector<tau::MatchTypeEntry> entries;
+        std::size_t count = 1 + next() % 6;
+        for (std::size_t i = 0; i < count; ++i) {
+            entries.push_back({types[next() % 4], random_string(4)});
+        }
+        tau::AhoCorasick automaton(entries, ignore_case);
+
+        for (int probe = 0; probe < 40; ++probe) {
+            std::string text = random_string(8);
+            bool any = false;
+            automaton.find_all(text, matched);
+            ASSERT_EQ(matched.size(), entries.size());
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                bool expected = match_entry(entries[i], text, ignore_case);
+                EXPECT_EQ(matched[i], expected) << entries[i].value << " / " << text;
+                any = any || expected;
+            }
+            EXPECT_EQ(automaton.find_any(text), any) << text;
+        }
+    }
+
+    // Перекрывающиеся паттерны и привязка к началу
+    tau::AhoCorasick ac({{tau::MatchType::StartsWith, "ab"},
+                         {tau::MatchType::Exact, "abc"},
+                         {tau::MatchType::EndsWith, "bc"},
+                         {tau::MatchType::Contains, "c.e"}},
+                        true);
+    ac.find_all("ABC", matched);
+    EXPECT_EQ(matched, (std::vector<bool>{true, true, true, false}));
+    ac.find_all("xabc", matched);
+    EXPECT_EQ(matched, (std::vector<bool>{false, false, true, false}));
+    EXPECT_TRUE(ac.find_any("calc.exe"));
+    EXPECT_FALSE(ac.find_any("cmd.exe"));
+    EXPECT_FALSE(ac.find_any("xab"));
+}
+
+// ============================================================================
+// TST-TAU-026: shake объединяет поиски по одному полю в один автомат
+// ============================================================================
+
+TEST(TauOptimiser, TST_TAU_026_MergeSearches) {
+    auto search = [](tau::Search s, const char* field) {
+        return tau::Expression(tau::ExprSearch{std::move(s), field, false});
+    };
+    auto ac = [](tau::MatchType type, const char* value) {
+        return tau::SearchAhoCorasick{{{type, value}}, true, {}};
+    };
+
+    tau::ExpressionVec exprs;
+    exprs.push_back(search(ac(tau::MatchType::Contains, "powershell"), "Image"));
+    exprs.push_back(search(tau::SearchContains{"cmd"}, "Image"));
+    exprs.push_back(search(ac(tau::MatchType::EndsWith, ".EXE"), "Image"));
+    exprs.push_back(search(ac(tau::MatchType::Exact, "x"), "CommandLine"));
+    exprs.push_back(search(tau::SearchEndsWith{".bat"}, "Image"));
+    tau::Expression original(tau::ExprBooleanGroup{tau::BoolSym::Or, std::move(exprs)});
+    tau::Expression shaken = tau::shake(tau::clone(original));
+
+    // Image без учёта регистра, Image с учётом регистра, CommandLine
+    auto* group = std::get_if<tau::ExprBooleanGroup>(&shaken.data);
+    ASSERT_NE(group, nullptr);
+    ASSERT_EQ(group->expressions.size(), 3u);
+    auto* first = std::get_if<tau::ExprSearch>(&group->expressions[0].data);
+    ASSERT_NE(first, nullptr);
+    auto* merged = std::get_if<tau::SearchAhoCorasick>(&first->search);
+    ASSERT_NE(merged, nullptr);
+    EXPECT_EQ(merged->match_types.size(), 2u);
+    EXPECT_TRUE(merged->ignore_case);
+    EXPECT_NE(merged->automaton, nullptr);
+    auto* sensitive = std::get_if<tau::ExprSearch>(&group->expressions[1].data);
+    ASSERT_NE(sensitive, nullptr);
+    auto* sensitive_ac = std::get_if<tau::SearchAhoCorasick>(&sensitive->search);
+    ASSERT_NE(sensitive_ac, nullptr);
+    EXPECT_FALSE(sensitive_ac->ignore_case);
+
+    for (const char* image : {"C:\\PowerShell.exe", "cmd", "CMD", "run.bat", "run.BAT", "a.txt"}) {
+        TestDocument doc;
+        doc.set("Image", Value(std::string(image)));
+        doc.set("CommandLine", Value(std::string("X")));
+        EXPECT_EQ(tau::solve(shaken, doc), tau::solve(original, doc)) << image;
+        doc.set("CommandLine", Value(std::string("y")));
+        EXPECT_EQ(tau::solve(shaken, doc), tau::solve(original, doc)) << image;
+    }
+}
+
+// ============================================================================
+// TST-TAU-027: Regex совпадает с std::regex (ECMAScript) на поддерживаемом подмножестве
+// ============================================================================
+
+TEST(TauRegex, TST_TAU_027_MatchesStdRegex) {
+    const std::vector<std::string> patterns = {
+        "abc", "a.c", "^abc", "abc$", "^$", "a+b", "(a|b)*c", "[a-c]+d", "[^a-c]x", "\\d{2,3}",
+        "\\w+\\s\\w+", "\\bfoo\\b", "\\Bfoo", "colou?r", "(ab){2}", "a{0}b", "x{2,}", "(?:a|bc)+$",
+        "^(a|ab)(c|bcd)$", "\\.exe$", "a|", "(a*)*b", "[]a]", "[a-]", "\\x41", "\\u0041",
+        "[[:digit:]]+", "^.{3}$", "x*?y", "\\\\windows\\\\", "[\\d\\s]+", "\\W\\S", "a\\-b",
+        "[\\]]", "ab|cd|ef"};
+    const std::vector<std::string> texts = {
+        "", "a", "abc", "xabcx", "ac", "abbc", "12", "1234", "foo", "a foo b", "afoo", "colour",
+        "abab", "ab", "abcd", "abcbcd", "cmd.exe", "A", "a-b", "]", "abc\n", "a\nb", "xxy", "ABC",
+        "y", "C:\\Windows\\x", "c:\\windows\\x"};
+
+    for (bool ignore_case : {false, true}) {
+        auto flags = std::regex::ECMAScript;
+        if (ignore_case) {
+            flags |= std::regex::icase;
+        }
+        for (const auto& pattern : patterns) {
+            std::regex expected(pattern, flags);
+            tau::Regex regex(pattern, ignore_case);
+            for (const auto& text : texts) {
+                EXPECT_EQ(regex.search(text), std::regex_search(text, expected))
+                    << "/" << pattern << "/ on \"" << text << "\" icase=" << ignore_case;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// TST-TAU-028: Regex — флаги, ошибки, общий кэш, линейное время
+// ============================================================================
+
+TEST(TauRegex, TST_TAU_028_EngineProperties) {
+    // Флаги (?i), (?i:...), (?s), (?m) и именованные группы
+    EXPECT_TRUE(tau::Regex("(?i)powershell").search("C:\\PowerShell.exe"));
+    EXPECT_TRUE(tau::Regex("(?i:a)b").search("Ab"));
+    EXPECT_FALSE(tau::Regex("(?i:a)b").search("AB"));
+    EXPECT_TRUE(tau::Regex("a(?s).b").search("a\nb"));
+    EXPECT_TRUE(tau::Regex("(?m)^b$").search("a\nb\nc"));
+    EXPECT_FALSE(tau::Regex("^b$").search("a\nb\nc"));
+    EXPECT_TRUE(tau::Regex("(?P<name>ab)+c").search("ababc"));
+
+    // Ошибки: синтаксис, обратные ссылки и lookaround
+    for (const char* pattern : {"(a", "[a", "a)", "*a", "a**", "a{", "a{3,1}", "\\x4", "(a)\\1",
+                                "(?=a)", "(?!a)", "(?<=a)b", "a{1001}"}) {
+        EXPECT_THROW(tau::Regex{pattern}, tau::RegexError) << pattern;
+    }
+
+    // Общий кэш: один объект на паттерн и режим регистра
+    auto first = tau::compile_regex("cmd\\.exe$", true);
+    EXPECT_EQ(first, tau::compile_regex("cmd\\.exe$", true));
+    EXPECT_NE(first, tau::compile_regex("cmd\\.exe$", false));
+
+    // Без экспоненциального перебора: (a+)+b на длинной строке из 'a'
+    std::string text(100000, 'a');
+    EXPECT_FALSE(tau::Regex("(a+)+b").search(text));
+    text += 'b';
+    EXPECT_TRUE(tau::Regex("(a+)+b").search(text));
+    EXPECT_TRUE(tau::Regex("(x+x+)+y|a{50}").search(text));
+
+    // Сброс кэша ДКА не меняет результат: состояний больше, чем помещается в кэш
+    tau::Regex wide("[ab]*a[ab]{18}c");
+    std::string mixed;
+    std::uint32_t seed = 1;
+    for (int i = 0; i < 50000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        mixed += (seed >> 16) & 1 ? 'a' : 'b';
+    }
+    EXPECT_FALSE(wide.search(mixed));
+    EXPECT_TRUE(wide.search(mixed + "c"));
+}
+
+// ============================================================================
+// TST-TAU-029: Regex — обязательная подстрока префильтра
+// ============================================================================
+
+TEST(TauRegex, TST_TAU_029_LiteralPrefilter) {
+    EXPECT_EQ(tau::Regex("\\\\powershell\\.exe.*-enc").literal(), "\\powershell.exe");
+    EXPECT_EQ(tau::Regex("(cmd|powershell)\\.exe").literal(), ".exe");
+    EXPECT_EQ(tau::Regex("\\bfoo\\b").literal(), "foo");
+    EXPECT_EQ(tau::Regex("(ab){2,}").literal(), "abab");
+    EXPECT_EQ(tau::Regex("Cmd\\.EXE", true).literal(), "cmd.exe");
+    EXPECT_EQ(tau::Regex("[cC]md").literal(), "cmd");
+    EXPECT_EQ(tau::Regex("x(ab)?y").literal(), "");
+    EXPECT_EQ(tau::Regex("a\\.b|c\\.d").literal(), "");
+
+    // Подстрока проверяется до ДКА и не меняет результат
+    tau::Regex encoded("\\\\powershell\\.exe.*-enc", true);
+    EXPECT_TRUE(encoded.search("C:\\Windows\\PowerShell.EXE -ENC abc"));
+    EXPECT_FALSE(encoded.search("C:\\Windows\\PowerShell.EXE -nop"));
+    EXPECT_FALSE(encoded.search("C:\\Windows\\cmd.exe -enc"));
+
+    // Паттерн-подстрока: совпадения на границах 16-байтовых блоков
+    tau::Regex plain("needle", true);
+    for (std::size_t offset = 0; offset < 40; ++offset) {
+        std::string text(offset, 'x');
+        text += "NeeDle";
+        text += std::string(offset % 7, 'y');
+        EXPECT_TRUE(plain.search(text)) << offset;
+        text[offset + 5] = 'f';
+        EXPECT_FALSE(plain.search(text)) << offset;
+    }
+}
+
+// ============================================================================
+// TST-TAU-030: Program (байткод) совпадает с solve по дереву
+// ============================================================================
+
+namespace {
+
+tau::Expression program_leaf(std::uint32_t kind) {
+    auto search = [](tau::Search s, const char* field, bool cast_to_str = false) {
+        return tau::Expression(tau::ExprSearch{std::move(s), field, cast_to_str});
+    };
+    auto match = [](tau::Pattern pattern, const char* field) {
+        return tau::Expression(
+            tau::ExprMatch{std::move(pattern),
+                           std::make_unique<tau::Expression>(tau::Expression::make_field(field))});
+    };
+
+    auto compare = [](tau::Expression left, tau::BoolSym op, tau::Expression right) {
+        return tau::Expression(
+            tau::ExprBooleanExpression{std::make_unique<tau::Expression>(std::move(left)), op,
+                                       std::make_unique<tau::Expression>(std::move(right))});
+    };
+
+    switch (kind % 23) {
+    case 0:
+        return tau::Expression::make_field("A");
+    case 1:
+        return search(tau::SearchContains{"ab"}, "A");
+    case 2:
+        return search(tau::SearchExact{"1"}, "B", true);
+    case 3:
+        return search(tau::SearchAny{}, "C");
+    case 4:
+        return search(tau::SearchRegex{tau::compile_regex("^a.b"), "^a.b", false}, "A");
+    case 5:
+        // Без автомата: Program строит его сам
+        return search(tau::SearchAhoCorasick{{{tau::MatchType::Contains, "b"},
+                                              {tau::MatchType::StartsWith, "A"}},
+                                             true,
+                                             {}},
+                      "A");
+    case 6: {
+        tau::SearchAhoCorasick ac{{{tau::MatchType::Exact, "x"}, {tau::MatchType::EndsWith, "C"}},
+                                  false,
+                                  {}};
+        tau::compile(ac);
+        return search(std::move(ac), "A");
+    }
+    case 7:
+        return search(tau::SearchEndsWith{"c"}, "A");
+    case 8:
+        return search(tau::SearchStartsWith{"a"}, "A");
+    case 9:
+        return match(tau::PatternEqual{1}, "B");
+    case 10:
+        return match(tau::PatternContains{"a"}, "A");
+    case 11:
+        return tau::Expression(tau::ExprCast{"B", tau::ModSym::Int});
+    case 12:
+        return tau::Expression(tau::ExprBooleanExpression{
+            std::make_unique<tau::Expression>(tau::Expression::make_field("B")),
+            tau::BoolSym::GreaterThan,
+            std::make_unique<tau::Expression>(tau::Expression::make_int(0))});
+    case 13: {
+        tau::ExprMatrix matrix;
+        matrix.fields = {"A", "B"};
+        matrix.rows.push_back({{tau::PatternExact{"ab"}, tau::PatternEqual{1}}, false});
+        return tau::Expression(std::move(matrix));
+    }
+    case 14:
+        return tau::Expression(tau::ExprNested{
+            "N", std::make_unique<tau::Expression>(search(tau::SearchContains{"x"}, "x"))});
+    case 15:
+        return tau::Expression::make_bool(true);
+    case 16:
+        return tau::Expression::make_bool(false);
+    case 17:
+        return tau::Expression::make_null();
+    case 18:
+        return tau::Expression::make_int(7);
+    case 19:
+        return compare(tau::Expression::make_field("B"), tau::BoolSym::Equal,
+                       tau::Expression::make_int(1));
+    case 20:
+        // Число слева: сравнение зеркалится
+        return compare(tau::Expression::make_float(0.5), tau::BoolSym::LessThan,
+                       tau::Expression::make_field("B"));
+    case 21:
+        // Приведение остаётся деревом
+        return compare(tau::Expression(tau::ExprCast{"B", tau::ModSym::Int}),
+                       tau::BoolSym::LessThanOrEqual, tau::Expression::make_int(0));
+    default:
+        return tau::Expression::make_identifier("missing");
+    }
+}
+
+/// Псевдослучайные выражения и документы для сверки Program с деревом
+class ProgramCases {
+public:
+    /// Случайные And/Or/Not (в том числе пустые группы) над листьями всех видов
+    tau::Expression expression(int depth) {
+        std::uint32_t roll = next() % 10;
+        if (depth == 0 || roll < 4) {
+            return program_leaf(next());
+        }
+        if (roll < 6) {
+            return tau::Expression(
+                tau::ExprNegate{std::make_unique<tau::Expression>(expression(depth - 1))});
+        }
+        tau::ExpressionVec children;
+        std::size_t count = next() % 4;
+        for (std::size_t i = 0; i < count; ++i) {
+            children.push_back(expression(depth - 1));
+        }
+        return tau::Expression(tau::ExprBooleanGroup{
+            roll < 8 ? tau::BoolSym::And : tau::BoolSym::Or, std::move(children)});
+    }
+
+    /// Документы: отсутствующие поля, null, числа, массивы, вложенные объекты
+    std::vector<TestDocument> documents(std::size_t count) {
+        auto array = [](std::vector<Value> items) {
+            Value v = Value::make_array();
+            for (auto& item : items) {
+                v.push_back(std::move(item));
+            }
+            return v;
+        };
+        auto nested = [](const char* x) {
+            Value v = Value::make_object();
+            v.set("x", Value(std::string(x)));
+            return v;
+        };
+        std::vector<std::optional<Value>> a_values = {
+            Value(std::string("ab")),  Value(std::string("xaYbc")), Value(std::string("A")),
+            Value(std::string("")),    std::nullopt,
+            array({Value(std::string("q")), Value(std::string("aab"))}),
+            Value(std::int64_t{5})};
+        std::vector<std::optional<Value>> b_values = {
+            Value(std::int64_t{1}), Value(std::string("1")), Value(std::int64_t{0}),
+            Value(std::int64_t{-3}), Value::make_null(), std::nullopt, Value(std::string("1x")),
+            Value(0.75),
+            array({Value(std::int64_t{0}), Value(std::int64_t{1})})};
+        std::vector<std::optional<Value>> c_values = {Value::make_null(), Value(std::string("x")),
+                                                      array({}), std::nullopt};
+        std::vector<std::optional<Value>> n_values = {nested("xx"), nested("y"),
+                                                      Value(std::string("x")), std::nullopt};
+
+        std::vector<TestDocument> docs;
+        for (std::size_t i = 0; i < count; ++i) {
+            TestDocument doc;
+            auto put = [&doc](const char* key, const std::optional<Value>& value) {
+                if (value) {
+                    doc.set(key, *value);
+                }
+            };
+            put("A", a_values[next() % a_values.size()]);
+            put("B", b_values[next() % b_values.size()]);
+            put("C", c_values[next() % c_values.size()]);
+            put("N", n_values[next() % n_values.size()]);
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+private:
+    std::uint32_t next() {
+        seed_ = seed_ * 1103515245u + 12345u;
+        return (seed_ >> 16) & 0x7fff;
+    }
+
+    std::uint32_t seed_ = 2024;
+};
+
+}  // namespace
+
+TEST(TauSolver, TST_TAU_030_ProgramMatchesTree) {
+    ProgramCases cases;
+    std::vector<TestDocument> docs = cases.documents(64);
+
+    for (int round = 0; round < 400; ++round) {
+        tau::Expression expr = cases.expression(4);
+        tau::Program program = tau::compile_program(expr);
+        for (std::size_t i = 0; i < docs.size(); ++i) {
+            ASSERT_EQ(tau::solve(program, docs[i]), tau::solve(expr, docs[i]))
+                << "round " << round << " doc " << i << "\n"
+                << tau::expression_to_yaml(expr);
+        }
+    }
+
+    // Detection с identifiers подставляется так же, как в solve
+    tau::Detection detection;
+    detection.expression = tau::Expression(tau::ExprBooleanGroup{tau::BoolSym::And, {}});
+    std::get<tau::ExprBooleanGroup>(detection.expression.data)
+        .expressions.push_back(tau::Expression::make_identifier("selection"));
+    detection.identifiers.emplace("selection", program_leaf(1));
+    tau::Program program = tau::compile_program(detection);
+    for (const auto& doc : docs) {
+        EXPECT_EQ(tau::solve(program, doc), tau::solve(detection, doc));
+    }
+
+    // Пустая программа истинна; константы не читают документ
+    EXPECT_TRUE(tau::solve(tau::Program{}, docs[0]));
+    EXPECT_EQ(tau::compile_program(tau::Expression::make_bool(false)).size(), 1u);
+}
+
+// ============================================================================
+// TST-TAU-031: общие проверки (Predicates) и их результаты на документ
+// ============================================================================
+
+TEST(TauSolver, TST_TAU_031_SharedPredicates) {
+    ProgramCases cases;
+    std::vector<TestDocument> docs = cases.documents(64);
+
+    // Много выражений над одними листьями: проверки повторяются
+    auto predicates = std::make_shared<tau::Predicates>();
+    std::vector<tau::Expression> exprs;
+    std::vector<tau::Program> programs;
+    std::size_t instructions = 0;
+    for (int i = 0; i < 200; ++i) {
+        exprs.push_back(cases.expression(4));
+        programs.push_back(tau::compile_program(exprs.back(), predicates));
+        instructions += programs.back().size();
+    }
+    EXPECT_GT(predicates->size(), 0u);
+    EXPECT_LT(predicates->size(), instructions);
+
+    // Результаты запоминаются в memo до clear(); без memo — вычисляются заново
+    tau::PredicateMemo memo(*predicates);
+    for (std::size_t d = 0; d < docs.size(); ++d) {
+        memo.clear();
+        for (std::size_t i = 0; i < programs.size(); ++i) {
+            bool expected = tau::solve(exprs[i], docs[d]);
+            ASSERT_EQ(tau::solve(programs[i], docs[d], memo), expected)
+                << "expr " << i << " doc " << d << "\n"
+                << tau::expression_to_yaml(exprs[i]);
+            ASSERT_EQ(tau::solve(programs[i], docs[d]), expected);
+        }
+    }
+
+    // Одинаковые Search/Match/Exists/сравнения разных выражений — одна проверка
+    auto shared = std::make_shared<tau::Predicates>();
+    tau::Program first = tau::compile_program(program_leaf(1), shared);
+    tau::Program second = tau::compile_program(
+        tau::Expression(tau::ExprNegate{std::make_unique<tau::Expression>(program_leaf(1))}),
+        shared);
+    tau::compile_program(program_leaf(9), shared);
+    tau::compile_program(program_leaf(9), shared);
+    tau::compile_program(program_leaf(12), shared);
+    tau::compile_program(program_leaf(12), shared);
+    // 0 < B — то же сравнение, что B > 0
+    tau::compile_program(
+        tau::Expression(tau::ExprBooleanExpression{
+            std::make_unique<tau::Expression>(tau::Expression::make_int(0)),
+            tau::BoolSym::LessThan,
+            std::make_unique<tau::Expression>(tau::Expression::make_field("B"))}),
+        shared);
+    tau::compile_program(program_leaf(21), shared);  // приведение вычисляется деревом
+    EXPECT_EQ(shared->size(), 3u);
+    tau::PredicateMemo shared_memo(*shared);
+    for (const auto& doc : docs) {
+        shared_memo.clear();
+        EXPECT_NE(tau::solve(first, doc, shared_memo), tau::solve(second, doc, shared_memo));
+    }
+}
+
 // ============================================================================
 // Дополнительные тесты
 // ============================================================================